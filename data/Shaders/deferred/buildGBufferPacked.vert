@@ -0,0 +1,56 @@
+#version 430 core
+
+layout (location = 0) in vec3 position; // Float, or unorm16 relative to the mesh bounds which modelViewTf scales back
+layout (location = 1) in vec4 normalTangent; // snorm16 octahedral normal in xy and tangent in zw, handedness in the lowest bit of w
+layout (location = 2) in vec2 texcoord; // Half float
+
+uniform mat4 modelViewTf;
+uniform mat3 normalTf;
+uniform mat4 projectionTf;
+
+out VS_OUT
+{
+	mat3 tangentToViewTf;
+	vec4 viewPosition;
+	vec4 viewNormal;
+	vec2 uv;
+} vs_out;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec3 octDecode(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	
+	if (v.z < 0.0)
+	{
+		v.xy = (1.0 - abs(v.yx)) * signNotZero(v.xy);
+	}
+	
+	return normalize(v);
+}
+
+void main()
+{
+	vec3 normal = octDecode(normalTangent.xy);
+	vec3 tangent = octDecode(normalTangent.zw);
+	
+	int packedW = int(round(normalTangent.w * 32767.0));
+	float handedness = (packedW & 1) != 0 ? -1.0 : 1.0;
+
+	vs_out.viewNormal = vec4(normalTf * normal, 0.0);
+	vs_out.viewPosition = modelViewTf * vec4(position, 1.0);
+	vs_out.uv = texcoord;
+	
+	vec3 bitangent = cross(normal, tangent) * handedness;
+	
+	vec3 viewT = normalize(normalTf * tangent);
+	vec3 viewB = normalize(normalTf * bitangent);
+	
+	vs_out.tangentToViewTf = mat3(viewT, viewB, vs_out.viewNormal);
+	
+	gl_Position = projectionTf * vs_out.viewPosition;
+}
\ No newline at end of file
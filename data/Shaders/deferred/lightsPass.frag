@@ -4,23 +4,54 @@ uniform sampler2D normalRGBRoughnessA_tex;
 uniform sampler2D kDiffuseRGBDepthA_tex;
 uniform sampler2D metallicR_tex;
 
-const int MAX_DIR = 32;
-
-const int MAX_POINT = 64;
-
-const int MAX_SPOT = 64;
+// Must match ClusteredLightCuller.
+const uint NUM_CLUSTERS_X = 16;
+const uint NUM_CLUSTERS_Y = 8;
+const uint NUM_CLUSTERS_Z = 32;
 
 layout(std140, binding = 1) uniform LightDataBuffer
 {
-	vec3 dl_directionEye[MAX_DIR];
-	vec3 dl_color[MAX_DIR];
-	int  dl_numLights;
-	
-	vec4 pl_positionEyeRadius[MAX_POINT];
-	vec4 pl_colorIntensity[MAX_POINT];
-	int  pl_numLights;
+	uint  dl_numLights;
+	uint  pl_numLights;
+	float sliceScale;
+	float sliceBias;
+	vec2  tileScale;
+	vec2  pad;
 } lights;
 
+struct DirectionalLight
+{
+	vec4 directionEye;
+	vec4 color;
+};
+
+struct PointLight
+{
+	vec4 positionEyeRadius;
+	vec4 colorIntensity;
+};
+
+layout(std430, binding = 1) readonly buffer DirectionalLights
+{
+	DirectionalLight dirLights[];
+};
+
+layout(std430, binding = 2) readonly buffer PointLights
+{
+	PointLight pointLights[];
+};
+
+// Offset and count of the lights of each cluster in clusterLightIndices.
+layout(std430, binding = 3) readonly buffer ClusterRanges
+{
+	uvec2 clusterRanges[];
+};
+
+layout(std430, binding = 4) readonly buffer ClusterLightIndices
+{
+	uint clusterLightIndices[];
+};
+
 in vec2 texCoord;
 in vec4 rayEye;
 
@@ -96,11 +127,11 @@ vec3 shade(vec3 N, vec3 V, vec3 L, float metallic, float roughness, vec3 kDiffus
 		return (kd * kDiffuse / PI + specularBRDF) * n_dot_l;
 }
 
-vec3 shadeDirectionalLight(int lightIdx, vec3 N, vec3 V, float metallic, float roughness, vec3 kDiffuse)
+vec3 shadeDirectionalLight(uint lightIdx, vec3 N, vec3 V, float metallic, float roughness, vec3 kDiffuse)
 {
-	vec3 L = normalize(-lights.dl_directionEye[lightIdx]);
+	vec3 L = normalize(-dirLights[lightIdx].directionEye.xyz);
 	
-	vec3 lightColor = lights.dl_color[lightIdx];
+	vec3 lightColor = dirLights[lightIdx].color.xyz;
 	float intensity = length(lightColor);
 	lightColor = normalize(lightColor);
 	
@@ -125,21 +156,30 @@ float distanceAtten(vec3 lightVector, float radius)
 	return attenuation;
 }
 
-vec3 shadePointLight(int lightIdx, vec3 N, vec3 V, vec3 positionEye, float metallic, float roughness, vec3 kDiffuse)
+vec3 shadePointLight(uint lightIdx, vec3 N, vec3 V, vec3 positionEye, float metallic, float roughness, vec3 kDiffuse)
 {
-	vec3 lightPosEye = lights.pl_positionEyeRadius[lightIdx].xyz;
-	float radius = lights.pl_positionEyeRadius[lightIdx].w;
+	vec3 lightPosEye = pointLights[lightIdx].positionEyeRadius.xyz;
+	float radius = pointLights[lightIdx].positionEyeRadius.w;
 
 	vec3 L = lightPosEye - positionEye;
 	float attenuation = distanceAtten(L, radius);
 	L = normalize(L);
 	
-	vec3 lightColor = lights.pl_colorIntensity[lightIdx].xyz;
-	float intensity = lights.pl_colorIntensity[lightIdx].w;
+	vec3 lightColor = pointLights[lightIdx].colorIntensity.xyz;
+	float intensity = pointLights[lightIdx].colorIntensity.w;
 	
 	return shade(N, V, L, metallic, roughness, kDiffuse) * ((intensity * normalize(lightColor)) / (4 * PI)) * attenuation;
 }
 
+uint getCluster(float distance)
+{
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * lights.tileScale), uvec2(NUM_CLUSTERS_X - 1, NUM_CLUSTERS_Y - 1));
+	float slice = floor(log(max(distance, 1e-6)) * lights.sliceScale + lights.sliceBias);
+	uint z = uint(clamp(slice, 0.0, float(NUM_CLUSTERS_Z - 1)));
+	
+	return (z * NUM_CLUSTERS_Y + tile.y) * NUM_CLUSTERS_X + tile.x;
+}
+
 void main()
 {
 	vec4 diffsuseDepth = texture(kDiffuseRGBDepthA_tex, texCoord);
@@ -160,14 +200,17 @@ void main()
 	
 	//lightOut += kDiffuse * ambientFactor;
 	
-	for (int i = 0; i < lights.dl_numLights; i++)
+	for (uint i = 0; i < lights.dl_numLights; i++)
 	{	
 		lightOut += shadeDirectionalLight(i, N, V, metallic, roughness, kDiffuse);
 	}
 	
-	for (int i = 0; i < lights.pl_numLights; i++)
+	uvec2 range = clusterRanges[getCluster(-zEye)];
+	
+	for (uint i = 0; i < range.y; i++)
 	{
-		lightOut += shadePointLight(i, N, V, positionEye.xyz, metallic, roughness, kDiffuse);
+		uint lightIdx = clusterLightIndices[range.x + i];
+		lightOut += shadePointLight(lightIdx, N, V, positionEye.xyz, metallic, roughness, kDiffuse);
 	}
 	
 	color = vec4(lightOut, 1.0);
@@ -0,0 +1,600 @@
+#include "AabbTree.hpp"
+
+#include <Math/Plane.hpp>
+#include <Math/Ray.hpp>
+#include <Render/FrustumCulling.hpp>
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+namespace Phoenix
+{
+	bool Aabb::contains(const Aabb& other) const
+	{
+		return m_min.x <= other.m_min.x && m_min.y <= other.m_min.y && m_min.z <= other.m_min.z
+			&& m_max.x >= other.m_max.x && m_max.y >= other.m_max.y && m_max.z >= other.m_max.z;
+	}
+
+	bool Aabb::overlaps(const Aabb& other) const
+	{
+		return m_min.x <= other.m_max.x && m_min.y <= other.m_max.y && m_min.z <= other.m_max.z
+			&& m_max.x >= other.m_min.x && m_max.y >= other.m_min.y && m_max.z >= other.m_min.z;
+	}
+
+	float Aabb::surfaceArea() const
+	{
+		Vec3 size = m_max - m_min;
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	Aabb combine(const Aabb& a, const Aabb& b)
+	{
+		return Aabb(
+			Vec3(std::min(a.m_min.x, b.m_min.x), std::min(a.m_min.y, b.m_min.y), std::min(a.m_min.z, b.m_min.z)),
+			Vec3(std::max(a.m_max.x, b.m_max.x), std::max(a.m_max.y, b.m_max.y), std::max(a.m_max.z, b.m_max.z)));
+	}
+
+	AabbTree::AabbTree(float margin)
+		: m_root(NULL_NODE)
+		, m_freeList(NULL_NODE)
+		, m_numProxies(0)
+		, m_margin(margin)
+	{}
+
+	void AabbTree::clear()
+	{
+		m_nodes.clear();
+		m_root = NULL_NODE;
+		m_freeList = NULL_NODE;
+		m_numProxies = 0;
+	}
+
+	int32_t AabbTree::allocNode()
+	{
+		int32_t node = m_freeList;
+
+		if (node == NULL_NODE)
+		{
+			node = static_cast<int32_t>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+		else
+		{
+			m_freeList = m_nodes[node].m_parent;
+		}
+
+		Node& n = m_nodes[node];
+		n.m_userData = 0;
+		n.m_parent = NULL_NODE;
+		n.m_child1 = NULL_NODE;
+		n.m_child2 = NULL_NODE;
+		n.m_height = 0;
+
+		return node;
+	}
+
+	void AabbTree::freeNode(int32_t node)
+	{
+		m_nodes[node].m_parent = m_freeList;
+		m_nodes[node].m_height = -1;
+		m_freeList = node;
+	}
+
+	int32_t AabbTree::createProxy(const Aabb& bounds, uint32_t userData)
+	{
+		int32_t proxy = allocNode();
+
+		Vec3 margin(m_margin);
+		m_nodes[proxy].m_bounds = Aabb(bounds.m_min - margin, bounds.m_max + margin);
+		m_nodes[proxy].m_userData = userData;
+
+		insertLeaf(proxy);
+		++m_numProxies;
+
+		return proxy;
+	}
+
+	void AabbTree::destroyProxy(int32_t proxy)
+	{
+		assert(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()));
+		assert(m_nodes[proxy].isLeaf() && m_nodes[proxy].m_height == 0);
+
+		removeLeaf(proxy);
+		freeNode(proxy);
+		--m_numProxies;
+	}
+
+	bool AabbTree::moveProxy(int32_t proxy, const Aabb& bounds)
+	{
+		assert(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()));
+		assert(m_nodes[proxy].isLeaf() && m_nodes[proxy].m_height == 0);
+
+		if (m_nodes[proxy].m_bounds.contains(bounds))
+		{
+			return false;
+		}
+
+		removeLeaf(proxy);
+
+		Vec3 margin(m_margin);
+		m_nodes[proxy].m_bounds = Aabb(bounds.m_min - margin, bounds.m_max + margin);
+
+		insertLeaf(proxy);
+		return true;
+	}
+
+	uint32_t AabbTree::getUserData(int32_t proxy) const
+	{
+		assert(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()));
+		return m_nodes[proxy].m_userData;
+	}
+
+	const Aabb& AabbTree::getFatBounds(int32_t proxy) const
+	{
+		assert(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()));
+		return m_nodes[proxy].m_bounds;
+	}
+
+	size_t AabbTree::getNumProxies() const
+	{
+		return m_numProxies;
+	}
+
+	int32_t AabbTree::getHeight() const
+	{
+		return m_root == NULL_NODE ? 0 : m_nodes[m_root].m_height;
+	}
+
+	void AabbTree::insertLeaf(int32_t leaf)
+	{
+		if (m_root == NULL_NODE)
+		{
+			m_root = leaf;
+			m_nodes[leaf].m_parent = NULL_NODE;
+			return;
+		}
+
+		// Descend towards the sibling with the lowest cost, the area of the new parent plus the
+		// area every ancestor grows by.
+		Aabb leafBounds = m_nodes[leaf].m_bounds;
+		int32_t index = m_root;
+
+		while (!m_nodes[index].isLeaf())
+		{
+			const Node& node = m_nodes[index];
+
+			float area = node.m_bounds.surfaceArea();
+			float combinedArea = combine(node.m_bounds, leafBounds).surfaceArea();
+
+			// Cost of making the leaf a sibling of this node.
+			float cost = 2.f * combinedArea;
+
+			// Minimum cost of pushing the leaf further down.
+			float inheritanceCost = 2.f * (combinedArea - area);
+
+			float childCosts[2];
+			int32_t children[2] = { node.m_child1, node.m_child2 };
+
+			for (int i = 0; i < 2; ++i)
+			{
+				const Node& child = m_nodes[children[i]];
+				float childCombinedArea = combine(child.m_bounds, leafBounds).surfaceArea();
+
+				if (child.isLeaf())
+				{
+					childCosts[i] = childCombinedArea + inheritanceCost;
+				}
+				else
+				{
+					childCosts[i] = childCombinedArea - child.m_bounds.surfaceArea() + inheritanceCost;
+				}
+			}
+
+			if (cost < childCosts[0] && cost < childCosts[1])
+			{
+				break;
+			}
+
+			index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+		}
+
+		int32_t sibling = index;
+		int32_t oldParent = m_nodes[sibling].m_parent;
+		int32_t newParent = allocNode();
+
+		Node& parent = m_nodes[newParent];
+		parent.m_parent = oldParent;
+		parent.m_bounds = combine(leafBounds, m_nodes[sibling].m_bounds);
+		parent.m_height = m_nodes[sibling].m_height + 1;
+		parent.m_child1 = sibling;
+		parent.m_child2 = leaf;
+
+		if (oldParent != NULL_NODE)
+		{
+			if (m_nodes[oldParent].m_child1 == sibling)
+			{
+				m_nodes[oldParent].m_child1 = newParent;
+			}
+			else
+			{
+				m_nodes[oldParent].m_child2 = newParent;
+			}
+		}
+		else
+		{
+			m_root = newParent;
+		}
+
+		m_nodes[sibling].m_parent = newParent;
+		m_nodes[leaf].m_parent = newParent;
+
+		refitUpwards(newParent);
+	}
+
+	void AabbTree::removeLeaf(int32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = NULL_NODE;
+			return;
+		}
+
+		int32_t parent = m_nodes[leaf].m_parent;
+		int32_t grandParent = m_nodes[parent].m_parent;
+		int32_t sibling = m_nodes[parent].m_child1 == leaf ? m_nodes[parent].m_child2 : m_nodes[parent].m_child1;
+
+		// The sibling takes the place of the parent.
+		if (grandParent != NULL_NODE)
+		{
+			if (m_nodes[grandParent].m_child1 == parent)
+			{
+				m_nodes[grandParent].m_child1 = sibling;
+			}
+			else
+			{
+				m_nodes[grandParent].m_child2 = sibling;
+			}
+
+			m_nodes[sibling].m_parent = grandParent;
+			freeNode(parent);
+
+			refitUpwards(grandParent);
+		}
+		else
+		{
+			m_root = sibling;
+			m_nodes[sibling].m_parent = NULL_NODE;
+			freeNode(parent);
+		}
+	}
+
+	void AabbTree::refitUpwards(int32_t node)
+	{
+		int32_t index = node;
+
+		while (index != NULL_NODE)
+		{
+			index = balance(index);
+
+			Node& n = m_nodes[index];
+			const Node& child1 = m_nodes[n.m_child1];
+			const Node& child2 = m_nodes[n.m_child2];
+
+			n.m_height = 1 + std::max(child1.m_height, child2.m_height);
+			n.m_bounds = combine(child1.m_bounds, child2.m_bounds);
+
+			index = n.m_parent;
+		}
+	}
+
+	// Rotates the higher child of node a up if the heights of its children differ by more than one.
+	// Returns the node that is now at the position of a.
+	int32_t AabbTree::balance(int32_t a)
+	{
+		Node& nodeA = m_nodes[a];
+
+		if (nodeA.isLeaf() || nodeA.m_height < 2)
+		{
+			return a;
+		}
+
+		int32_t b = nodeA.m_child1;
+		int32_t c = nodeA.m_child2;
+		Node& nodeB = m_nodes[b];
+		Node& nodeC = m_nodes[c];
+
+		int32_t heightDiff = nodeC.m_height - nodeB.m_height;
+
+		if (heightDiff > 1 || heightDiff < -1)
+		{
+			// The higher child r replaces a and a takes the place of its lower child.
+			int32_t r = heightDiff > 1 ? c : b;
+			Node& nodeR = m_nodes[r];
+			const Node& nodeOther = heightDiff > 1 ? nodeB : nodeC;
+
+			int32_t f = nodeR.m_child1;
+			int32_t g = nodeR.m_child2;
+			Node& nodeF = m_nodes[f];
+			Node& nodeG = m_nodes[g];
+
+			nodeR.m_child1 = a;
+			nodeR.m_parent = nodeA.m_parent;
+			nodeA.m_parent = r;
+
+			if (nodeR.m_parent != NULL_NODE)
+			{
+				Node& parent = m_nodes[nodeR.m_parent];
+
+				if (parent.m_child1 == a)
+				{
+					parent.m_child1 = r;
+				}
+				else
+				{
+					parent.m_child2 = r;
+				}
+			}
+			else
+			{
+				m_root = r;
+			}
+
+			// The higher grandchild stays with r, the lower one moves to a.
+			int32_t keep = nodeF.m_height > nodeG.m_height ? f : g;
+			int32_t move = keep == f ? g : f;
+
+			nodeR.m_child2 = keep;
+
+			if (r == c)
+			{
+				nodeA.m_child2 = move;
+			}
+			else
+			{
+				nodeA.m_child1 = move;
+			}
+
+			m_nodes[move].m_parent = a;
+
+			nodeA.m_bounds = combine(nodeOther.m_bounds, m_nodes[move].m_bounds);
+			nodeA.m_height = 1 + std::max(nodeOther.m_height, m_nodes[move].m_height);
+
+			nodeR.m_bounds = combine(nodeA.m_bounds, m_nodes[keep].m_bounds);
+			nodeR.m_height = 1 + std::max(nodeA.m_height, m_nodes[keep].m_height);
+
+			return r;
+		}
+
+		return a;
+	}
+
+	void AabbTree::collectLeaves(int32_t node, std::vector<uint32_t>* outUserData) const
+	{
+		int32_t stack[MAX_QUERY_DEPTH];
+		int32_t stackSize = 0;
+		stack[stackSize++] = node;
+
+		while (stackSize > 0)
+		{
+			const Node& n = m_nodes[stack[--stackSize]];
+
+			if (n.isLeaf())
+			{
+				outUserData->push_back(n.m_userData);
+			}
+			else
+			{
+				assert(stackSize + 2 <= MAX_QUERY_DEPTH);
+				stack[stackSize++] = n.m_child1;
+				stack[stackSize++] = n.m_child2;
+			}
+		}
+	}
+
+	void AabbTree::queryFrustum(const Plane* planes, std::vector<uint32_t>* outUserData) const
+	{
+		outUserData->clear();
+
+		if (m_root == NULL_NODE)
+		{
+			return;
+		}
+
+		// Planes a node is fully in front of don't need to be tested for its children.
+		const uint32_t allPlanesMask = (1u << NUM_FRUSTUM_PLANES) - 1;
+
+		struct Entry
+		{
+			int32_t m_node;
+			uint32_t m_planeMask;
+		};
+
+		Entry stack[MAX_QUERY_DEPTH];
+		int32_t stackSize = 0;
+		stack[stackSize++] = { m_root, allPlanesMask };
+
+		while (stackSize > 0)
+		{
+			Entry entry = stack[--stackSize];
+			const Node& node = m_nodes[entry.m_node];
+
+			Vec3 center = (node.m_bounds.m_min + node.m_bounds.m_max) * 0.5f;
+			Vec3 extent = (node.m_bounds.m_max - node.m_bounds.m_min) * 0.5f;
+
+			uint32_t planeMask = entry.m_planeMask;
+			bool bCulled = false;
+
+			for (int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+			{
+				if (!(planeMask & (1u << i)))
+				{
+					continue;
+				}
+
+				const Plane& plane = planes[i];
+				float distance = plane.dot(center);
+				float radius = fabsf(plane.n.x) * extent.x + fabsf(plane.n.y) * extent.y + fabsf(plane.n.z) * extent.z;
+
+				if (distance + radius < 0.f)
+				{
+					bCulled = true;
+					break;
+				}
+
+				if (distance - radius >= 0.f)
+				{
+					planeMask &= ~(1u << i);
+				}
+			}
+
+			if (bCulled)
+			{
+				continue;
+			}
+
+			if (planeMask == 0 || node.isLeaf())
+			{
+				collectLeaves(entry.m_node, outUserData);
+			}
+			else
+			{
+				assert(stackSize + 2 <= MAX_QUERY_DEPTH);
+				stack[stackSize++] = { node.m_child1, planeMask };
+				stack[stackSize++] = { node.m_child2, planeMask };
+			}
+		}
+	}
+
+	void AabbTree::queryAabb(const Aabb& bounds, std::vector<uint32_t>* outUserData) const
+	{
+		outUserData->clear();
+
+		if (m_root == NULL_NODE)
+		{
+			return;
+		}
+
+		int32_t stack[MAX_QUERY_DEPTH];
+		int32_t stackSize = 0;
+		stack[stackSize++] = m_root;
+
+		while (stackSize > 0)
+		{
+			const Node& node = m_nodes[stack[--stackSize]];
+
+			if (!node.m_bounds.overlaps(bounds))
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				outUserData->push_back(node.m_userData);
+			}
+			else
+			{
+				assert(stackSize + 2 <= MAX_QUERY_DEPTH);
+				stack[stackSize++] = node.m_child1;
+				stack[stackSize++] = node.m_child2;
+			}
+		}
+	}
+
+	bool AabbTree::raycast(const Ray& ray, float maxDistance, const RaycastCallback& callback, uint32_t* outUserData, float* outDistance) const
+	{
+		if (m_root == NULL_NODE)
+		{
+			return false;
+		}
+
+		float closest = maxDistance;
+		bool bHit = false;
+
+		int32_t stack[MAX_QUERY_DEPTH];
+		int32_t stackSize = 0;
+		stack[stackSize++] = m_root;
+
+		while (stackSize > 0)
+		{
+			const Node& node = m_nodes[stack[--stackSize]];
+
+			std::pair<bool, float> boxHit = ray.intersect(node.m_bounds.m_min, node.m_bounds.m_max);
+
+			if (!boxHit.first || boxHit.second > closest)
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				float distance = callback(node.m_userData, ray, closest);
+
+				if (distance >= 0.f && distance <= closest)
+				{
+					closest = distance;
+					*outUserData = node.m_userData;
+					bHit = true;
+				}
+			}
+			else
+			{
+				assert(stackSize + 2 <= MAX_QUERY_DEPTH);
+				stack[stackSize++] = node.m_child1;
+				stack[stackSize++] = node.m_child2;
+			}
+		}
+
+		if (bHit)
+		{
+			*outDistance = closest;
+		}
+
+		return bHit;
+	}
+
+	void AabbTree::validate() const
+	{
+		if (m_root != NULL_NODE)
+		{
+			assert(m_nodes[m_root].m_parent == NULL_NODE);
+			validateNode(m_root);
+		}
+
+		size_t numFree = 0;
+
+		for (int32_t node = m_freeList; node != NULL_NODE; node = m_nodes[node].m_parent)
+		{
+			assert(m_nodes[node].m_height == -1);
+			++numFree;
+		}
+
+		// Every used node is a leaf or has two children.
+		size_t numUsed = m_nodes.size() - numFree;
+		assert(m_numProxies == 0 ? numUsed == 0 : numUsed == 2 * m_numProxies - 1);
+	}
+
+	int32_t AabbTree::validateNode(int32_t node) const
+	{
+		const Node& n = m_nodes[node];
+
+		if (n.isLeaf())
+		{
+			assert(n.m_child2 == NULL_NODE);
+			assert(n.m_height == 0);
+			return 0;
+		}
+
+		assert(m_nodes[n.m_child1].m_parent == node);
+		assert(m_nodes[n.m_child2].m_parent == node);
+		assert(n.m_bounds.contains(m_nodes[n.m_child1].m_bounds));
+		assert(n.m_bounds.contains(m_nodes[n.m_child2].m_bounds));
+
+		int32_t height1 = validateNode(n.m_child1);
+		int32_t height2 = validateNode(n.m_child2);
+
+		assert(n.m_height == 1 + std::max(height1, height2));
+
+		return n.m_height;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <Math/Vec3.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+namespace Phoenix
+{
+	class Plane;
+	class Ray;
+
+	struct Aabb
+	{
+		Aabb() {}
+
+		Aabb(const Vec3& min, const Vec3& max)
+			: m_min(min)
+			, m_max(max)
+		{}
+
+		bool contains(const Aabb& other) const;
+		bool overlaps(const Aabb& other) const;
+		float surfaceArea() const;
+
+		Vec3 m_min;
+		Vec3 m_max;
+	};
+
+	Aabb combine(const Aabb& a, const Aabb& b);
+
+	// Called with the user data of every leaf the ray hits and the current closest distance. Returns the
+	// distance of an exact hit with the object, or a negative value if the ray misses it.
+	typedef std::function<float(uint32_t userData, const Ray& ray, float maxDistance)> RaycastCallback;
+
+	// Dynamic bounding volume hierarchy with one leaf per object (proxy). Leaves store bounds enlarged
+	// by a margin so objects can move a little without touching the tree. New leaves are inserted next
+	// to the sibling that least increases the total surface area, and the tree is rebalanced with
+	// rotations on the way back up (as the dynamic tree of Box2D).
+	class AabbTree
+	{
+	public:
+		enum
+		{
+			NULL_NODE = -1
+		};
+
+		AabbTree(float margin = 0.1f);
+
+		void clear();
+
+		int32_t createProxy(const Aabb& bounds, uint32_t userData);
+		void destroyProxy(int32_t proxy);
+
+		// Reinserts the proxy if the new bounds leave its enlarged bounds, returns true if it did.
+		bool moveProxy(int32_t proxy, const Aabb& bounds);
+
+		uint32_t getUserData(int32_t proxy) const;
+		const Aabb& getFatBounds(int32_t proxy) const;
+
+		size_t getNumProxies() const;
+
+		// Height of the root, 0 for a single leaf.
+		int32_t getHeight() const;
+
+		// Writes the user data of all proxies that are not completely behind one of the
+		// NUM_FRUSTUM_PLANES planes. Subtrees fully inside the frustum are taken without testing.
+		void queryFrustum(const Plane* planes, std::vector<uint32_t>* outUserData) const;
+
+		void queryAabb(const Aabb& bounds, std::vector<uint32_t>* outUserData) const;
+
+		// Closest hit within maxDistance as reported by the callback. Returns false if there is none.
+		bool raycast(const Ray& ray, float maxDistance, const RaycastCallback& callback, uint32_t* outUserData, float* outDistance) const;
+
+		// Asserts the structure, heights and bounds of the tree are consistent. For tests.
+		void validate() const;
+
+	private:
+		enum
+		{
+			MAX_QUERY_DEPTH = 256
+		};
+
+		struct Node
+		{
+			bool isLeaf() const
+			{
+				return m_child1 == NULL_NODE;
+			}
+
+			Aabb m_bounds;
+			uint32_t m_userData;
+			int32_t m_parent; // Next free node while on the free list.
+			int32_t m_child1;
+			int32_t m_child2;
+			int32_t m_height; // 0 for leaves, -1 for free nodes.
+		};
+
+		int32_t allocNode();
+		void freeNode(int32_t node);
+
+		void insertLeaf(int32_t leaf);
+		void removeLeaf(int32_t leaf);
+
+		// Refits and rebalances the ancestors of a node after it changed.
+		void refitUpwards(int32_t node);
+		int32_t balance(int32_t node);
+
+		void collectLeaves(int32_t node, std::vector<uint32_t>* outUserData) const;
+
+		int32_t validateNode(int32_t node) const;
+
+		std::vector<Node> m_nodes;
+		int32_t m_root;
+		int32_t m_freeList;
+		size_t m_numProxies;
+		float m_margin;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "Archetype.hpp"
+
+namespace Phoenix
+{
+	Archetype::Archetype(ComponentMask mask, const ComponentTypeInfo* typeInfos)
+		: m_mask(mask)
+		, m_typeInfos(typeInfos)
+		, m_entities(ENTITIES_PER_CHUNK)
+	{
+		for (size_t type = 0; type < ECType::CT_Max; ++type)
+		{
+			m_addEdges[type] = nullptr;
+			m_columnOfType[type] = NO_COLUMN;
+
+			if (mask & componentBit(static_cast<ECType>(type)))
+			{
+				size_t sizeBytes = typeInfos[type].m_sizeBytes;
+				assert(sizeBytes > 0 && "Component type was not registered with the World.");
+
+				m_columnOfType[type] = static_cast<int8_t>(m_columns.size());
+				m_columnTypes.push_back(static_cast<ECType>(type));
+				m_columns.push_back(new ChunkArrayBase(sizeBytes, ENTITIES_PER_CHUNK * sizeBytes));
+				m_changeVersions.push_back(new ChunkArray<uint32_t>(ENTITIES_PER_CHUNK));
+				m_chunkChangeVersions.push_back(std::vector<uint32_t>());
+			}
+		}
+	}
+
+	Archetype::~Archetype()
+	{
+		const size_t numRows = size();
+
+		for (size_t column = 0; column < m_columns.size(); ++column)
+		{
+			const ComponentTypeInfo& info = m_typeInfos[m_columnTypes[column]];
+
+			for (size_t row = 0; row < numRows; ++row)
+			{
+				info.m_destruct(m_columns[column]->at(row));
+			}
+
+			delete m_columns[column];
+			delete m_changeVersions[column];
+		}
+	}
+
+	ComponentMask Archetype::getMask() const
+	{
+		return m_mask;
+	}
+
+	bool Archetype::hasType(ECType type) const
+	{
+		return (m_mask & componentBit(type)) != 0;
+	}
+
+	size_t Archetype::size() const
+	{
+		return m_entities.size();
+	}
+
+	size_t Archetype::addRow(EntityHandle entity, uint32_t version)
+	{
+		size_t row = size();
+		*m_entities.add() = entity;
+
+		for (size_t column = 0; column < m_columns.size(); ++column)
+		{
+			m_typeInfos[m_columnTypes[column]].m_construct(m_columns[column]->alloc());
+			*m_changeVersions[column]->add() = version;
+			raiseChunkChangeVersion(column, row, version);
+		}
+
+		return row;
+	}
+
+	size_t Archetype::addRowMovedFrom(Archetype* source, size_t sourceRow, uint32_t version)
+	{
+		size_t row = size();
+		*m_entities.add() = source->getEntity(sourceRow);
+
+		for (size_t column = 0; column < m_columns.size(); ++column)
+		{
+			ECType type = m_columnTypes[column];
+			void* component = m_columns[column]->alloc();
+			void* from = source->getComponent(type, sourceRow);
+
+			uint32_t componentVersion = version;
+
+			if (from)
+			{
+				m_typeInfos[type].m_moveConstruct(component, from);
+				componentVersion = source->getChangeVersion(type, sourceRow);
+			}
+			else
+			{
+				m_typeInfos[type].m_construct(component);
+			}
+
+			*m_changeVersions[column]->add() = componentVersion;
+			raiseChunkChangeVersion(column, row, componentVersion);
+		}
+
+		return row;
+	}
+
+	EntityHandle Archetype::removeRow(size_t row)
+	{
+		assert(row < size());
+		const size_t last = size() - 1;
+
+		for (size_t column = 0; column < m_columns.size(); ++column)
+		{
+			const ComponentTypeInfo& info = m_typeInfos[m_columnTypes[column]];
+			ChunkArrayBase* components = m_columns[column];
+
+			info.m_destruct(components->at(row));
+
+			if (row != last)
+			{
+				info.m_moveConstruct(components->at(row), components->at(last));
+				info.m_destruct(components->at(last));
+			}
+
+			components->popBack();
+
+			ChunkArray<uint32_t>& versions = *m_changeVersions[column];
+
+			if (row != last)
+			{
+				versions[row] = versions[last];
+				raiseChunkChangeVersion(column, row, versions[row]);
+			}
+
+			versions.popBack();
+
+			// An emptied chunk starts over without changes.
+			m_chunkChangeVersions[column].resize(getNumChunks(last));
+		}
+
+		EntityHandle moved = m_entities[last];
+		m_entities[row] = moved;
+		m_entities.popBack();
+		return moved;
+	}
+
+	EntityHandle Archetype::getEntity(size_t row) const
+	{
+		return m_entities[row];
+	}
+
+	void* Archetype::getComponent(ECType type, size_t row)
+	{
+		int8_t column = m_columnOfType[type];
+		return column == NO_COLUMN ? nullptr : m_columns[column]->at(row);
+	}
+
+	size_t Archetype::getNumChunks() const
+	{
+		return getNumChunks(size());
+	}
+
+	size_t Archetype::getNumChunks(size_t numRows)
+	{
+		return (numRows + ENTITIES_PER_CHUNK - 1) / ENTITIES_PER_CHUNK;
+	}
+
+	size_t Archetype::getChunkSize(size_t chunk) const
+	{
+		size_t first = chunk * ENTITIES_PER_CHUNK;
+		assert(first < size());
+		return size() - first < ENTITIES_PER_CHUNK ? size() - first : ENTITIES_PER_CHUNK;
+	}
+
+	const EntityHandle* Archetype::getEntities(size_t chunk) const
+	{
+		return &m_entities[chunk * ENTITIES_PER_CHUNK];
+	}
+
+	void* Archetype::getColumn(ECType type, size_t chunk)
+	{
+		return getComponent(type, chunk * ENTITIES_PER_CHUNK);
+	}
+	void Archetype::setChanged(ECType type, size_t row, uint32_t version)
+	{
+		int8_t column = m_columnOfType[type];
+		assert(column != NO_COLUMN && row < size());
+
+		(*m_changeVersions[column])[row] = version;
+		raiseChunkChangeVersion(column, row, version);
+	}
+
+	uint32_t Archetype::getChangeVersion(ECType type, size_t row) const
+	{
+		int8_t column = m_columnOfType[type];
+		assert(column != NO_COLUMN);
+		return (*m_changeVersions[column])[row];
+	}
+
+	uint32_t Archetype::getChunkChangeVersion(ECType type, size_t chunk) const
+	{
+		int8_t column = m_columnOfType[type];
+		return column == NO_COLUMN ? 0 : m_chunkChangeVersions[column][chunk];
+	}
+
+	const uint32_t* Archetype::getChangeVersions(ECType type, size_t chunk) const
+	{
+		int8_t column = m_columnOfType[type];
+		return column == NO_COLUMN ? nullptr : &(*m_changeVersions[column])[chunk * ENTITIES_PER_CHUNK];
+	}
+
+	void Archetype::raiseChunkChangeVersion(size_t column, size_t row, uint32_t version)
+	{
+		std::vector<uint32_t>& chunkVersions = m_chunkChangeVersions[column];
+		const size_t chunk = row / ENTITIES_PER_CHUNK;
+
+		if (chunk >= chunkVersions.size())
+		{
+			chunkVersions.resize(chunk + 1, 0);
+		}
+
+		if (version > chunkVersions[chunk])
+		{
+			chunkVersions[chunk] = version;
+		}
+	}
+}
\ No newline at end of file
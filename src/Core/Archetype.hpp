@@ -0,0 +1,152 @@
+#pragma once
+
+#include <Core/ECType.hpp>
+#include <Core/EntityHandle.hpp>
+#include <Memory/ChunkArray.hpp>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Phoenix
+{
+	typedef uint32_t ComponentMask;
+
+	static_assert(ECType::CT_Max <= 32, "ComponentMask has one bit per ECType.");
+
+	inline ComponentMask componentBit(ECType type)
+	{
+		return 1u << type;
+	}
+
+	template <typename... C>
+	ComponentMask makeComponentMask()
+	{
+		ComponentMask bits[] = { 0u, componentBit(C::staticType())... };
+		ComponentMask mask = 0;
+
+		for (ComponentMask bit : bits)
+		{
+			mask |= bit;
+		}
+
+		return mask;
+	}
+
+	// What an archetype needs to know to keep components of a type it only knows by ECType.
+	struct ComponentTypeInfo
+	{
+		size_t m_sizeBytes;
+		void (*m_construct)(void* at);
+		void (*m_moveConstruct)(void* at, void* from);
+		void (*m_destruct)(void* at);
+	};
+
+	template <typename C>
+	ComponentTypeInfo makeComponentTypeInfo()
+	{
+		ComponentTypeInfo info;
+		info.m_sizeBytes = sizeof(C);
+		info.m_construct = [](void* at) { new (at) C(); };
+		info.m_moveConstruct = [](void* at, void* from) { new (at) C(std::move(*static_cast<C*>(from))); };
+		info.m_destruct = [](void* at) { static_cast<C*>(at)->~C(); };
+		return info;
+	}
+
+	// Stores all entities with the same set of component types. Each type has its own column, and
+	// the columns and the entity list are chunked the same way, so chunk k of every column holds
+	// the components of the same ENTITIES_PER_CHUNK entities. Rows are kept dense by moving the
+	// last row into removed ones. Component pointers stay valid until their entity changes archetype
+	// or another row of the archetype is removed.
+	// Every component has the World change version it was last changed in, and every chunk of a
+	// column the highest of those, so chunks without changes can be skipped as a whole.
+	class Archetype
+	{
+	public:
+		enum
+		{
+			ENTITIES_PER_CHUNK = 256
+		};
+
+		// typeInfos is indexed by ECType and has to outlive the archetype.
+		Archetype(ComponentMask mask, const ComponentTypeInfo* typeInfos);
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		ComponentMask getMask() const;
+
+		bool hasType(ECType type) const;
+
+		size_t size() const;
+
+		// Appends a row with default constructed components, changed in the version.
+		size_t addRow(EntityHandle entity, uint32_t version);
+
+		// Appends a row for an entity in another archetype, move constructing the components both
+		// have and default constructing the rest. Moved components keep their change version, new
+		// ones are changed in the version. The source row is left to be removed.
+		size_t addRowMovedFrom(Archetype* source, size_t sourceRow, uint32_t version);
+
+		// Moves the last row into the removed one. Returns the entity that now has the row,
+		// or the removed entity if it was the last.
+		EntityHandle removeRow(size_t row);
+
+		EntityHandle getEntity(size_t row) const;
+
+		// Null if the archetype has no such column.
+		void* getComponent(ECType type, size_t row);
+
+		size_t getNumChunks() const;
+
+		// Number of rows in a chunk, ENTITIES_PER_CHUNK except for the last one.
+		size_t getChunkSize(size_t chunk) const;
+
+		const EntityHandle* getEntities(size_t chunk) const;
+
+		// Contiguous components of a chunk, null if the archetype has no such column.
+		void* getColumn(ECType type, size_t chunk);
+
+		template <typename C>
+		C* getColumn(size_t chunk)
+		{
+			return static_cast<C*>(getColumn(C::staticType(), chunk));
+		}
+
+		void setChanged(ECType type, size_t row, uint32_t version);
+
+		uint32_t getChangeVersion(ECType type, size_t row) const;
+
+		// Highest change version of the components of the type in the chunk, 0 if there is no column.
+		uint32_t getChunkChangeVersion(ECType type, size_t chunk) const;
+
+		// Change versions of the components of the type in the chunk, null if there is no column.
+		const uint32_t* getChangeVersions(ECType type, size_t chunk) const;
+
+		// Archetype with one more type, cached by World when an entity first moves along this edge.
+		Archetype* m_addEdges[ECType::CT_Max];
+
+	private:
+		enum
+		{
+			NO_COLUMN = -1
+		};
+
+		static size_t getNumChunks(size_t numRows);
+		void raiseChunkChangeVersion(size_t column, size_t row, uint32_t version);
+
+		ComponentMask m_mask;
+		const ComponentTypeInfo* m_typeInfos;
+
+		int8_t m_columnOfType[ECType::CT_Max];
+		std::vector<ECType> m_columnTypes;
+		std::vector<ChunkArrayBase*> m_columns;
+		std::vector<ChunkArray<uint32_t>*> m_changeVersions; // Per column.
+		std::vector<std::vector<uint32_t>> m_chunkChangeVersions; // Per column and chunk.
+		ChunkArray<EntityHandle> m_entities;
+	};
+}
\ No newline at end of file
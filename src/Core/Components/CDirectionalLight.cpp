@@ -0,0 +1,19 @@
+#include "CDirectionalLight.hpp"
+
+#include <Core/Serialize.hpp>
+#include <Core/SerialUtil.hpp>
+
+namespace Phoenix
+{
+	void CDirectionalLight::save(Archive* ar)
+	{
+		serialize(ar, m_direction);
+		serialize(ar, m_color);
+	}
+
+	void CDirectionalLight::load(Archive* ar, LoadResources* resources)
+	{
+		serialize(ar, m_direction);
+		serialize(ar, m_color);
+	}
+}
\ No newline at end of file
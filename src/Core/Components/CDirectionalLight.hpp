@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Core/Component.hpp>
+#include <Math/Vec3.hpp>
+
+namespace Phoenix
+{
+	class CDirectionalLight : public Component
+	{
+	public:
+		Vec3 m_direction;
+		Vec3 m_color;
+
+		virtual void save(Archive* ar) override;
+		virtual void load(Archive* ar, LoadResources* resources) override;
+
+		IMPL_EC_TYPE_ID(ECType::CT_DirectionalLight, "DirectionalLight");
+	};
+}
\ No newline at end of file
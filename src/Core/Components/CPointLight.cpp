@@ -0,0 +1,21 @@
+#include "CPointLight.hpp"
+
+#include <Core/Serialize.hpp>
+#include <Core/SerialUtil.hpp>
+
+namespace Phoenix
+{
+	void CPointLight::save(Archive* ar)
+	{
+		serialize(ar, m_color);
+		serialize(ar, m_radius);
+		serialize(ar, m_intensity);
+	}
+
+	void CPointLight::load(Archive* ar, LoadResources* resources)
+	{
+		serialize(ar, m_color);
+		serialize(ar, m_radius);
+		serialize(ar, m_intensity);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Core/Component.hpp>
+#include <Math/Vec3.hpp>
+
+namespace Phoenix
+{
+	class CPointLight : public Component
+	{
+	public:
+		CPointLight() : m_radius(0.f), m_intensity(0.f) {}
+
+		Vec3 m_color;
+		float m_radius;
+		float m_intensity;
+
+		virtual void save(Archive* ar) override;
+		virtual void load(Archive* ar, LoadResources* resources) override;
+
+		IMPL_EC_TYPE_ID(ECType::CT_PointLight, "PointLight");
+	};
+}
\ No newline at end of file
@@ -8,10 +8,17 @@ namespace Phoenix
 	class CStaticMesh : public Component
 	{
 	public:
-		CStaticMesh() : m_mesh(nullptr) {}
+		CStaticMesh() : m_mesh(nullptr), m_lod(0), m_proxy(-1) {}
 
 		StaticMesh* m_mesh;
 
+		// LOD drawn last frame, the starting point for the next LOD selection.
+		uint8_t m_lod;
+
+		// Leaf of the StaticMeshSystem bounding volume tree, -1 until the mesh is added to it.
+		// Kept in the component so it moves with the entity between archetypes.
+		int32_t m_proxy;
+
 		virtual void save(Archive* ar) override;
 		virtual void load(Archive* ar, LoadResources* resources) override;
 
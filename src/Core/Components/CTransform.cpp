@@ -2,48 +2,59 @@
 
 #include "CTransform.hpp"
 #include <Core/Serialize.hpp>
-#include <Core/SerialUtil.hpp>
+
+#include <type_traits>
 
 namespace Phoenix
 {
 	void CTransform::serial(Archive* ar)
 	{
-		serialize(ar, m_translation);
-		serialize(ar, m_rotation);
-		serialize(ar, m_scale);
+		static_assert(std::is_trivially_copyable<LocalTransform>::value, "Saved with a single copy.");
+		ar->serialize(&m_local, sizeof(LocalTransform));
 	}
 
 	void CTransform::setTranslation(const Vec3& t)
 	{
-		m_translation = t;
+		m_local.m_translation = t;
 		m_bDirty = true;
 	}
 
 	void CTransform::setRotation(const Vec3& r)
 	{
-		m_rotation = r;
+		m_local.m_rotation = r;
 		m_bDirty = true;
 	}
 
 	void CTransform::setScale(const Vec3& s)
 	{
-		m_scale = s;
+		m_local.m_scale = s;
 		m_bDirty = true;
 	}
 
+	void CTransform::setParent(EntityHandle parent)
+	{
+		m_parent = parent;
+		m_bParentChanged = true;
+	}
+
+	EntityHandle CTransform::getParent() const
+	{
+		return m_parent;
+	}
+
 	const Vec3& CTransform::getTranslation() const
 	{
-		return m_translation;
+		return m_local.m_translation;
 	}
 
 	const Vec3& CTransform::getRotation() const
 	{
-		return m_rotation;
+		return m_local.m_rotation;
 	}
 
 	const Vec3& CTransform::getScale() const
 	{
-		return m_scale;
+		return m_local.m_scale;
 	}
 
 	void CTransform::save(Archive* ar) 
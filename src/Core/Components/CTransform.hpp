@@ -1,23 +1,48 @@
 #pragma once
 
 #include <Core/Component.hpp>
+#include <Math/Matrix4.hpp>
 #include <Math/Vec3.hpp>
 
 namespace Phoenix
 {
-	class CTransform : public Component
+	// The part of a transform save() writes, relative to the parent. Stored as one block. The parent
+	// is saved by saveWorld(), which knows the position of its entity in the file.
+	struct LocalTransform
 	{
+		LocalTransform()
+			: m_scale(1.f, 1.f, 1.f)
+		{}
+
 		Vec3 m_translation;
 		Vec3 m_rotation;
 		Vec3 m_scale;
+	};
+
+	class CTransform : public Component
+	{
+		LocalTransform m_local;
+		EntityHandle m_parent;
 
 		void serial(Archive* ar);
 
 	public:
+		CTransform()
+			: m_parent(0)
+			, m_transform(Matrix4::identity())
+			, m_bDirty(true)
+			, m_bParentChanged(false)
+			, m_node(-1)
+		{}
+
 		void setTranslation(const Vec3& t);
 		void setRotation(const Vec3& r);
 		void setScale(const Vec3& s);
 
+		// Translation, rotation and scale become relative to the transform of the parent entity.
+		// An invalid handle, or a parent without a CTransform, makes this a root again.
+		void setParent(EntityHandle parent);
+		EntityHandle getParent() const;
 
 		const Vec3& getTranslation() const;
 		const Vec3& getRotation() const;
@@ -26,8 +51,14 @@ namespace Phoenix
 		virtual void save(Archive* ar) override;
 		virtual void load(Archive* ar, LoadResources* resources) override;
 
-		Matrix4* m_transform;
+		// World transform, updated by the TransformSystem from translation, rotation and scale and
+		// those of the parents. m_bDirty is set when either changed this frame.
+		Matrix4 m_transform;
 		bool m_bDirty;
+		bool m_bParentChanged;
+
+		// Node in the TransformSystem hierarchy, -1 until the system has seen the component.
+		int32_t m_node;
 
 		IMPL_EC_TYPE_ID(ECType::CT_Transform, "Transform");
 	};
@@ -0,0 +1,517 @@
+#include "Compression.hpp"
+
+#include <assert.h>
+#include <string.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <vector>
+
+namespace Phoenix
+{
+	// A sequence is a token, the literals and a match: the high nibble of the token is the number of
+	// literals, the low nibble the match length minus MIN_MATCH. A nibble of 15 is followed by bytes
+	// adding to it, up to and including the first that is not 255. The literals follow their length,
+	// the 16 bit offset of the match back from the current position follows the literals. The last
+	// sequence of a block only has literals.
+	enum
+	{
+		MIN_MATCH = 4,
+		MAX_OFFSET = 65535,
+		NIBBLE_MAX = 15,
+
+		// Matches end at least LAST_LITERALS before the end of the block, and start at least
+		// MATCH_FIND_LIMIT before it, as in LZ4.
+		LAST_LITERALS = 5,
+		MATCH_FIND_LIMIT = 12,
+
+		FAST_HASH_BITS = 14,
+
+		// Misses in a row after which Fast starts skipping positions, faster the longer it misses.
+		FAST_SKIP_SHIFT = 6,
+
+		STRONG_HASH_BITS = 16,
+		STRONG_MAX_CHAIN = 256,
+		STRONG_WINDOW_MASK = 0xffff
+	};
+
+	static uint32_t read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static uint64_t read64(const uint8_t* p)
+	{
+		uint64_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static uint32_t hashSequence(uint32_t sequence, uint32_t bits)
+	{
+		return (sequence * 2654435761u) >> (32 - bits);
+	}
+
+	// Length of the common prefix of a and b, a may not go past limit.
+	static size_t countMatch(const uint8_t* a, const uint8_t* b, const uint8_t* limit)
+	{
+		const uint8_t* start = a;
+
+		while (a + sizeof(uint64_t) <= limit && read64(a) == read64(b))
+		{
+			a += sizeof(uint64_t);
+			b += sizeof(uint64_t);
+		}
+
+		while (a < limit && *a == *b)
+		{
+			++a;
+			++b;
+		}
+
+		return a - start;
+	}
+
+	struct SequenceWriter
+	{
+		uint8_t* m_dst;
+		size_t m_capacity;
+		size_t m_size;
+	};
+
+	static void writeLengthBytes(SequenceWriter* out, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+		{
+			out->m_dst[out->m_size++] = 255;
+		}
+
+		out->m_dst[out->m_size++] = static_cast<uint8_t>(length);
+	}
+
+	// A matchLength of 0 writes the last sequence. False if it does not fit.
+	static bool writeSequence(SequenceWriter* out, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength)
+	{
+		const size_t maxBytes = 1 + numLiterals / 255 + 1 + numLiterals + 2 + matchLength / 255 + 1;
+
+		if (out->m_capacity - out->m_size < maxBytes)
+		{
+			return false;
+		}
+
+		uint8_t* token = &out->m_dst[out->m_size++];
+		*token = static_cast<uint8_t>(std::min<size_t>(numLiterals, NIBBLE_MAX) << 4);
+
+		if (numLiterals >= NIBBLE_MAX)
+		{
+			writeLengthBytes(out, numLiterals - NIBBLE_MAX);
+		}
+
+		if (numLiterals > 0)
+		{
+			memcpy(out->m_dst + out->m_size, literals, numLiterals);
+			out->m_size += numLiterals;
+		}
+
+		if (matchLength == 0)
+		{
+			return true;
+		}
+
+		assert(matchLength >= MIN_MATCH && offset > 0 && offset <= MAX_OFFSET);
+		out->m_dst[out->m_size++] = static_cast<uint8_t>(offset);
+		out->m_dst[out->m_size++] = static_cast<uint8_t>(offset >> 8);
+
+		const size_t matchCode = matchLength - MIN_MATCH;
+		*token |= static_cast<uint8_t>(std::min<size_t>(matchCode, NIBBLE_MAX));
+
+		if (matchCode >= NIBBLE_MAX)
+		{
+			writeLengthBytes(out, matchCode - NIBBLE_MAX);
+		}
+
+		return true;
+	}
+
+	// Greedy, one candidate per hash.
+	static size_t compressFast(const uint8_t* src, size_t srcSize, SequenceWriter* out)
+	{
+		size_t anchor = 0;
+
+		if (srcSize >= MATCH_FIND_LIMIT + 1)
+		{
+			std::vector<uint32_t> table(size_t(1) << FAST_HASH_BITS, 0); // Position plus one.
+			const uint8_t* matchLimit = src + srcSize - LAST_LITERALS;
+			size_t ip = 0;
+
+			while (ip + MATCH_FIND_LIMIT <= srcSize)
+			{
+				const uint32_t sequence = read32(src + ip);
+				uint32_t& slot = table[hashSequence(sequence, FAST_HASH_BITS)];
+				const size_t candidate = slot;
+				slot = static_cast<uint32_t>(ip + 1);
+
+				if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != sequence)
+				{
+					ip += 1 + ((ip - anchor) >> FAST_SKIP_SHIFT);
+					continue;
+				}
+
+				size_t match = candidate - 1;
+				size_t length = MIN_MATCH + countMatch(src + ip + MIN_MATCH, src + match + MIN_MATCH, matchLimit);
+
+				while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1])
+				{
+					--ip;
+					--match;
+					++length;
+				}
+
+				if (!writeSequence(out, src + anchor, ip - anchor, ip - match, length))
+				{
+					return 0;
+				}
+
+				ip += length;
+				anchor = ip;
+
+				if (ip + MATCH_FIND_LIMIT <= srcSize)
+				{
+					table[hashSequence(read32(src + ip - 2), FAST_HASH_BITS)] = static_cast<uint32_t>(ip - 2 + 1);
+				}
+			}
+		}
+
+		return writeSequence(out, src + anchor, srcSize - anchor, 0, 0) ? out->m_size : 0;
+	}
+
+	// Hash chains over the last 64 KB, every position is inserted.
+	class MatchFinder
+	{
+	public:
+		MatchFinder(const uint8_t* src, size_t srcSize)
+			: m_src(src)
+			, m_matchLimit(src + srcSize - LAST_LITERALS)
+			, m_head(size_t(1) << STRONG_HASH_BITS, -1)
+			, m_chain(STRONG_WINDOW_MASK + 1, 0)
+			, m_nextInsert(0)
+		{}
+
+		// Longest match for ip among earlier positions, 0 if there is none of MIN_MATCH.
+		size_t find(size_t ip, size_t* outMatch)
+		{
+			for (; m_nextInsert < ip; ++m_nextInsert)
+			{
+				insert(m_nextInsert);
+			}
+
+			const uint32_t sequence = read32(m_src + ip);
+			int32_t candidate = m_head[hashSequence(sequence, STRONG_HASH_BITS)];
+			size_t bestLength = 0;
+
+			for (int steps = 0; candidate >= 0 && ip - candidate <= MAX_OFFSET && steps < STRONG_MAX_CHAIN; ++steps)
+			{
+				// A longer match has to differ from the best one at its end, which is checked first.
+				if (m_src[candidate + bestLength] == m_src[ip + bestLength] && read32(m_src + candidate) == sequence)
+				{
+					const size_t length = MIN_MATCH + countMatch(m_src + ip + MIN_MATCH, m_src + candidate + MIN_MATCH, m_matchLimit);
+
+					if (length > bestLength)
+					{
+						bestLength = length;
+						*outMatch = candidate;
+
+						if (m_src + ip + length >= m_matchLimit)
+						{
+							break;
+						}
+					}
+				}
+
+				const uint16_t delta = m_chain[candidate & STRONG_WINDOW_MASK];
+
+				if (delta == 0)
+				{
+					break;
+				}
+
+				candidate -= delta;
+			}
+
+			return bestLength;
+		}
+
+	private:
+		void insert(size_t position)
+		{
+			int32_t& head = m_head[hashSequence(read32(m_src + position), STRONG_HASH_BITS)];
+			const size_t delta = head < 0 ? 0 : position - head;
+			m_chain[position & STRONG_WINDOW_MASK] = static_cast<uint16_t>(delta > MAX_OFFSET ? 0 : delta);
+			head = static_cast<int32_t>(position);
+		}
+
+		const uint8_t* m_src;
+		const uint8_t* m_matchLimit;
+		std::vector<int32_t> m_head;
+		std::vector<uint16_t> m_chain; // Distance to the previous position with the same hash, 0 for none.
+		size_t m_nextInsert;
+	};
+
+	// Longest match of the chains, taken one position later if that one is longer.
+	static size_t compressStrong(const uint8_t* src, size_t srcSize, SequenceWriter* out)
+	{
+		size_t anchor = 0;
+
+		if (srcSize >= MATCH_FIND_LIMIT + 1)
+		{
+			MatchFinder finder(src, srcSize);
+			size_t ip = 0;
+
+			while (ip + MATCH_FIND_LIMIT <= srcSize)
+			{
+				size_t match = 0;
+				size_t length = finder.find(ip, &match);
+
+				if (length < MIN_MATCH)
+				{
+					++ip;
+					continue;
+				}
+
+				while (ip + 1 + MATCH_FIND_LIMIT <= srcSize)
+				{
+					size_t nextMatch = 0;
+					const size_t nextLength = finder.find(ip + 1, &nextMatch);
+
+					if (nextLength <= length)
+					{
+						break;
+					}
+
+					++ip;
+					length = nextLength;
+					match = nextMatch;
+				}
+
+				if (!writeSequence(out, src + anchor, ip - anchor, ip - match, length))
+				{
+					return 0;
+				}
+
+				ip += length;
+				anchor = ip;
+			}
+		}
+
+		return writeSequence(out, src + anchor, srcSize - anchor, 0, 0) ? out->m_size : 0;
+	}
+
+	size_t getCompressBound(size_t numBytes)
+	{
+		return numBytes + numBytes / 255 + 16;
+	}
+
+	size_t compressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity, ECompression level)
+	{
+		assert(level != ECompression::None);
+		SequenceWriter out = { dst, dstCapacity, 0 };
+		return level == ECompression::Strong ? compressStrong(src, srcSize, &out) : compressFast(src, srcSize, &out);
+	}
+
+	enum
+	{
+		SHORT_COPY = 16,
+
+		// Room wildCopy() needs past the end of both sides.
+		WILD_COPY_SLACK = SHORT_COPY
+	};
+
+	// Copies in pieces of SHORT_COPY, so up to SHORT_COPY - 1 bytes past numBytes.
+	static void wildCopy(uint8_t* dst, const uint8_t* src, size_t numBytes)
+	{
+		uint8_t* const end = dst + numBytes;
+
+		do
+		{
+			memcpy(dst, src, SHORT_COPY);
+			dst += SHORT_COPY;
+			src += SHORT_COPY;
+		} while (dst < end);
+	}
+
+	// Adds the bytes following a nibble of 15. False if the block ends first.
+	static bool readLengthBytes(const uint8_t** ip, const uint8_t* srcEnd, size_t* length)
+	{
+		uint8_t byte;
+
+		do
+		{
+			if (*ip == srcEnd)
+			{
+				return false;
+			}
+
+			byte = *(*ip)++;
+			*length += byte;
+		} while (byte == 255);
+
+		return true;
+	}
+
+	bool decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+	{
+		// Every block ends with a sequence, empty ones too.
+		if (srcSize == 0)
+		{
+			return false;
+		}
+
+		const uint8_t* ip = src;
+		const uint8_t* const srcEnd = src + srcSize;
+		uint8_t* op = dst;
+		uint8_t* const dstEnd = dst + dstSize;
+
+		while (ip < srcEnd)
+		{
+			const uint8_t token = *ip++;
+			size_t numLiterals = token >> 4;
+
+			if (numLiterals == NIBBLE_MAX && !readLengthBytes(&ip, srcEnd, &numLiterals))
+			{
+				return false;
+			}
+
+			if (static_cast<size_t>(srcEnd - ip) < numLiterals || static_cast<size_t>(dstEnd - op) < numLiterals)
+			{
+				return false;
+			}
+
+			if (static_cast<size_t>(srcEnd - ip) >= numLiterals + WILD_COPY_SLACK && static_cast<size_t>(dstEnd - op) >= numLiterals + WILD_COPY_SLACK)
+			{
+				wildCopy(op, ip, numLiterals);
+			}
+			else
+			{
+				memcpy(op, ip, numLiterals);
+			}
+
+			ip += numLiterals;
+			op += numLiterals;
+
+			if (ip == srcEnd)
+			{
+				break;
+			}
+
+			if (srcEnd - ip < 2)
+			{
+				return false;
+			}
+
+			const size_t offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+
+			size_t length = token & NIBBLE_MAX;
+
+			if (length == NIBBLE_MAX && !readLengthBytes(&ip, srcEnd, &length))
+			{
+				return false;
+			}
+
+			length += MIN_MATCH;
+
+			if (offset == 0 || offset > static_cast<size_t>(op - dst) || length > static_cast<size_t>(dstEnd - op))
+			{
+				return false;
+			}
+
+			const uint8_t* match = op - offset;
+
+			if (offset >= SHORT_COPY && static_cast<size_t>(dstEnd - op) >= length + WILD_COPY_SLACK)
+			{
+				// Every piece reads bytes written before it.
+				wildCopy(op, match, length);
+			}
+			else if (offset >= length)
+			{
+				memcpy(op, match, length);
+			}
+			else
+			{
+				// The match repeats the offset bytes before it. Once a whole number of repeats spans
+				// 8 bytes, the rest is copied 8 bytes at a time from that far back.
+				const size_t period = offset * ((sizeof(uint64_t) + offset - 1) / offset);
+				size_t i = 0;
+
+				for (; i < length && i < period; ++i)
+				{
+					op[i] = match[i];
+				}
+
+				for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+				{
+					memcpy(op + i, op + i - period, sizeof(uint64_t));
+				}
+
+				for (; i < length; ++i)
+				{
+					op[i] = op[i - offset];
+				}
+			}
+
+			op += length;
+		}
+
+		return ip == srcEnd && op == dstEnd;
+	}
+
+	void shuffleBytes(const uint8_t* src, uint8_t* dst, size_t numElements, size_t elementSize)
+	{
+		for (size_t i = 0; i < numElements; ++i)
+		{
+			for (size_t b = 0; b < elementSize; ++b)
+			{
+				dst[b * numElements + i] = src[i * elementSize + b];
+			}
+		}
+	}
+
+	void unshuffleBytes(const uint8_t* src, uint8_t* dst, size_t numElements, size_t elementSize)
+	{
+		size_t first = 0;
+
+		// Interleaves 16 floats at a time.
+		if (elementSize == 4)
+		{
+			const uint8_t* planes[4] = { src, src + numElements, src + 2 * numElements, src + 3 * numElements };
+
+			for (; first + 16 <= numElements; first += 16)
+			{
+				const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[0] + first));
+				const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[1] + first));
+				const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[2] + first));
+				const __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[3] + first));
+
+				const __m128i b01Low = _mm_unpacklo_epi8(b0, b1);
+				const __m128i b01High = _mm_unpackhi_epi8(b0, b1);
+				const __m128i b23Low = _mm_unpacklo_epi8(b2, b3);
+				const __m128i b23High = _mm_unpackhi_epi8(b2, b3);
+
+				__m128i* out = reinterpret_cast<__m128i*>(dst + first * 4);
+				_mm_storeu_si128(out, _mm_unpacklo_epi16(b01Low, b23Low));
+				_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(b01Low, b23Low));
+				_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(b01High, b23High));
+				_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(b01High, b23High));
+			}
+		}
+
+		for (size_t i = first; i < numElements; ++i)
+		{
+			for (size_t b = 0; b < elementSize; ++b)
+			{
+				dst[i * elementSize + b] = src[b * numElements + i];
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	// LZ77 block codec in the style of LZ4: sequences of literals and matches of at least 4 bytes
+	// up to 64 KB back, with no entropy coding, so decompressing is little more than copying.
+	// Both levels write the same format and decompress equally fast, Strong searches longer chains
+	// of earlier positions and defers matches when the next position has a longer one, which is
+	// several times slower to compress and meant for data cooked once.
+	// Blocks do not refer to each other.
+	enum class ECompression : uint8_t
+	{
+		None,
+		Fast,
+		Strong
+	};
+
+	// Largest size compressBlock() can produce for numBytes.
+	size_t getCompressBound(size_t numBytes);
+
+	// Returns the compressed size, 0 if it does not fit into dstCapacity. None is not a level.
+	size_t compressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity, ECompression level);
+
+	// dstSize has to be the exact size that was compressed. False for corrupt blocks, which never
+	// read or write out of bounds.
+	bool decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+	// Stores byte b of every element after byte b - 1 of all elements. Bytes of floats that change
+	// slowly, like the sign and exponent, end up next to each other and compress far better.
+	void shuffleBytes(const uint8_t* src, uint8_t* dst, size_t numElements, size_t elementSize);
+
+	// Undoes shuffleBytes().
+	void unshuffleBytes(const uint8_t* src, uint8_t* dst, size_t numElements, size_t elementSize);
+}
\ No newline at end of file
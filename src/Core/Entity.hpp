@@ -1,19 +1,24 @@
 #pragma once
 
-#include <Core/EntityHandle.hpp>
-#include <Core/ECType.hpp>
-#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
 
 namespace Phoenix
 {
-	class Component;
+	class Archetype;
 
+	// Slot of an entity in the World: where its components are stored and the generation handles
+	// to it have. Null archetype while the slot is free.
 	struct Entity
 	{
-		Component* getComponent(ECType type);
-		void addComponent(Component* component);
+		Entity() 
+			: m_archetype(nullptr)
+			, m_row(0) 
+			, m_generation(0)
+		{}
 
-		typedef std::unordered_map<ECType, Component*> ComponentTable;
-		ComponentTable m_components;
+		Archetype* m_archetype;
+		size_t m_row;
+		uint32_t m_generation;
 	};
 }
\ No newline at end of file
@@ -4,5 +4,31 @@
 
 namespace Phoenix
 {
-	typedef int32_t EntityHandle;
+	// Index of the entity slot in the low bits, generation of the slot in the high bits. The World
+	// bumps the generation when it destroys an entity, so handles to it stop matching the slot
+	// once it is reused.
+	typedef uint32_t EntityHandle;
+
+	enum
+	{
+		ENTITY_INDEX_BITS = 22,
+		ENTITY_GENERATION_BITS = 32 - ENTITY_INDEX_BITS,
+		ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1,
+		ENTITY_GENERATION_MASK = (1u << ENTITY_GENERATION_BITS) - 1
+	};
+
+	inline EntityHandle makeEntityHandle(uint32_t index, uint32_t generation)
+	{
+		return (generation << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+	}
+
+	inline uint32_t entityIndex(EntityHandle handle)
+	{
+		return handle & ENTITY_INDEX_MASK;
+	}
+
+	inline uint32_t entityGeneration(EntityHandle handle)
+	{
+		return handle >> ENTITY_INDEX_BITS;
+	}
 }
\ No newline at end of file
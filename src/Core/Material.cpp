@@ -4,7 +4,7 @@
 
 #include <Core/Texture.hpp>
 #include <Core/Serialize.hpp>
-#include <Core/SerialUtil.hpp>
+#include <Core/StaticSerialize.hpp>
 #include <Core/AssetRegistry.hpp>
 
 namespace Phoenix
@@ -91,16 +91,9 @@ namespace Phoenix
 		std::string m_roughnessTexPath;
 		std::string m_metallicTexPath;
 		std::string m_normalTexPath;
-	};
 
-	void serialize(Archive* ar, MaterialResources& exp)
-	{
-		serialize(ar, exp.m_name);
-		serialize(ar, exp.m_diffuseTexPath);
-		serialize(ar, exp.m_roughnessTexPath);
-		serialize(ar, exp.m_metallicTexPath);
-		serialize(ar, exp.m_normalTexPath);
-	}
+		PHI_SERIALIZE(m_name, m_diffuseTexPath, m_roughnessTexPath, m_metallicTexPath, m_normalTexPath)
+	};
 
 	static const char* g_assetFileExt = ".mat";
 
@@ -110,7 +103,10 @@ namespace Phoenix
 		createWriteArchive(sizeof(Material), &ar);
 
 		MaterialResources exp(material);
-		serialize(&ar, exp);
+		{
+			StaticWriteArchive writer(&ar);
+			serializeValue(writer, exp);
+		}
 
 		std::string writePath = assets->getAssetsPath() + material.m_name;
 		writePath += g_assetFileExt;
@@ -142,7 +138,11 @@ namespace Phoenix
 		}
 
 		MaterialResources exp;
-		serialize(&ar, exp);
+		{
+			StaticReadArchive reader(&ar);
+			serializeValue(reader, exp);
+		}
+		destroyArchive(ar);
 
 		mat = assets->allocMaterial(path);
 		mat->m_name = exp.m_name;
@@ -1,12 +1,21 @@
 #include "Mesh.hpp"
 
 #include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
 
 #include <Core/Serialize.hpp>
 #include <Core/SerialUtil.hpp>
 #include <Core/Material.hpp>
 #include <Core/AssetRegistry.hpp>
 #include <Core/LoadResources.hpp>
+#include <Core/FNVHash.hpp>
+#include <Core/Logger.hpp>
+#include <Core/MeshQuantize.hpp>
+#include <Math/Matrix4.hpp>
+#include <Math/Ray.hpp>
 
 #include <Render/RIDevice.hpp>
 
@@ -20,36 +29,343 @@ namespace Phoenix
 		m_tangents.reserve(numVertices);
 		m_texCoords.reserve(numVertices);
 	}
+
+	size_t MeshData::getIndexSizeBytes() const
+	{
+		return m_numVertices <= UINT16_MAX + 1 ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	size_t MeshData::getVertexSizeBytes() const
+	{
+		const size_t packedNormalTangentUv = 4 * sizeof(int16_t) + 2 * sizeof(uint16_t);
+
+		switch (m_vertexFormat)
+		{
+		case EVertexFormat::Packed:
+			return sizeof(Vec3) + packedNormalTangentUv;
+		case EVertexFormat::PackedPositions:
+			return 4 * sizeof(uint16_t) + packedNormalTangentUv;
+		case EVertexFormat::Float:
+		default:
+			return sizeof(Vec3) + sizeof(Vec3) + sizeof(Vec4) + sizeof(Vec2);
+		}
+	}
+
+	size_t MeshData::getSizeBytes() const
+	{
+		return m_numVertices * getVertexSizeBytes() + m_indices.size() * getIndexSizeBytes();
+	}
+
+	struct WeldKey
+	{
+		Vec3 m_position;
+		Vec3 m_normal;
+		Vec2 m_texCoord;
+		float m_handedness;
+
+		bool operator==(const WeldKey& other) const
+		{
+			return memcmp(this, &other, sizeof(WeldKey)) == 0;
+		}
+	};
+
+	// Compared and hashed as bytes, which only works without padding.
+	static_assert(sizeof(WeldKey) == 9 * sizeof(float), "WeldKey must not have padding");
+
+	struct WeldKeyHash
+	{
+		size_t operator()(const WeldKey& key) const
+		{
+			return static_cast<size_t>(hashBytes(&key, sizeof(WeldKey)));
+		}
+	};
+
+	void weldVertices(MeshData* data)
+	{
+		assert(data->m_indices.empty());
+
+		size_t numCorners = data->m_numVertices;
+
+		std::unordered_map<WeldKey, uint32_t, WeldKeyHash> uniqueVertices;
+		uniqueVertices.reserve(numCorners);
+
+		MeshData welded;
+		welded.setSize(numCorners);
+		welded.m_indices.reserve(numCorners);
+
+		for (size_t i = 0; i < numCorners; ++i)
+		{
+			WeldKey key{};
+			key.m_position = data->m_vertices[i];
+			key.m_normal = data->m_normals[i];
+			key.m_texCoord = data->m_texCoords[i];
+			key.m_handedness = data->m_tangents[i].w;
+
+			uint32_t nextIndex = static_cast<uint32_t>(welded.m_vertices.size());
+			auto inserted = uniqueVertices.emplace(key, nextIndex);
+
+			if (inserted.second)
+			{
+				welded.m_vertices.push_back(data->m_vertices[i]);
+				welded.m_normals.push_back(data->m_normals[i]);
+				welded.m_texCoords.push_back(data->m_texCoords[i]);
+				welded.m_tangents.push_back(data->m_tangents[i]);
+			}
+			else
+			{
+				Vec4& tangent = welded.m_tangents[inserted.first->second];
+				const Vec4& other = data->m_tangents[i];
+				tangent.x += other.x;
+				tangent.y += other.y;
+				tangent.z += other.z;
+			}
+
+			welded.m_indices.push_back(inserted.first->second);
+		}
+
+		welded.m_numVertices = welded.m_vertices.size();
+
+		// Re-orthogonalize the summed tangents against the shared normal.
+		for (size_t i = 0; i < welded.m_numVertices; ++i)
+		{
+			Vec4& tangent = welded.m_tangents[i];
+			const Vec3& n = welded.m_normals[i];
+
+			Vec3 t(tangent.x, tangent.y, tangent.z);
+			t = t - n * n.dot(t);
+			t.normalize();
+
+			tangent = Vec4(t, tangent.w);
+		}
+
+		welded.m_vertices.shrink_to_fit();
+		welded.m_normals.shrink_to_fit();
+		welded.m_texCoords.shrink_to_fit();
+		welded.m_tangents.shrink_to_fit();
+
+		*data = std::move(welded);
+	}
 	
+	void computeMeshBounds(StaticMesh* mesh)
+	{
+		const std::vector<Vec3>& vertices = mesh->m_data.m_vertices;
+
+		if (vertices.empty())
+		{
+			mesh->m_boundsCenter = Vec3(0.f);
+			mesh->m_boundsRadius = 0.f;
+			mesh->m_aabbMin = Vec3(0.f);
+			mesh->m_aabbMax = Vec3(0.f);
+			return;
+		}
+
+		Vec3 boundsMin = vertices[0];
+		Vec3 boundsMax = vertices[0];
+
+		for (const Vec3& vertex : vertices)
+		{
+			boundsMin = Vec3(std::min(boundsMin.x, vertex.x), std::min(boundsMin.y, vertex.y), std::min(boundsMin.z, vertex.z));
+			boundsMax = Vec3(std::max(boundsMax.x, vertex.x), std::max(boundsMax.y, vertex.y), std::max(boundsMax.z, vertex.z));
+		}
+
+		// Centered on the box, slightly larger than the tightest sphere but cheap and stable.
+		Vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radius2 = 0.f;
+
+		for (const Vec3& vertex : vertices)
+		{
+			radius2 = std::max(radius2, (vertex - center).length2());
+		}
+
+		mesh->m_boundsCenter = center;
+		mesh->m_boundsRadius = sqrtf(radius2);
+		mesh->m_aabbMin = boundsMin;
+		mesh->m_aabbMax = boundsMax;
+	}
+
+	float raycastStaticMesh(const StaticMesh& mesh, const Matrix4& transform, const Ray& ray, float maxDistance)
+	{
+		Matrix4 invTransform = transform.inverse();
+		Vec3 localDirection(invTransform * Vec4(ray.direction, 0.f));
+		Ray localRay(Vec3(invTransform * Vec4(ray.origin, 1.f)), localDirection);
+
+		// The local ray is normalized again, a world space distance d is a local one of d * scale.
+		float scale = localDirection.length();
+		float maxLocalDistance = maxDistance * scale;
+
+		std::pair<bool, float> boundsHit = localRay.intersect(mesh.m_aabbMin, mesh.m_aabbMax);
+
+		if (!boundsHit.first || boundsHit.second > maxLocalDistance)
+		{
+			return -1.f;
+		}
+
+		const std::vector<Vec3>& vertices = mesh.m_data.m_vertices;
+		const std::vector<uint32_t>& indices = mesh.m_data.m_indices;
+		float closest = -1.f;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			std::pair<bool, float> hit = localRay.intersect(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
+
+			if (hit.first && hit.second <= maxLocalDistance)
+			{
+				maxLocalDistance = hit.second;
+				closest = hit.second;
+			}
+		}
+
+		return closest < 0.f ? -1.f : closest / scale;
+	}
+
 	void createMeshBuffers(StaticMesh* outMesh, IRIDevice* renderDevice)
 	{
-		size_t numVertices = outMesh->m_data.m_numVertices;
+		const MeshData& data = outMesh->m_data;
+		size_t numVertices = data.m_numVertices;
 
 		VertexBufferFormat layout;
-		layout.add({ EAttributeProperty::Position, EAttributeType::Float, 3 },
-		{ sizeof(Vec3), numVertices, outMesh->m_data.m_vertices.data() });
 
-		layout.add({ EAttributeProperty::Normal, EAttributeType::Float, 3 },
-		{ sizeof(Vec3), numVertices, outMesh->m_data.m_normals.data() });
+		if (data.m_vertexFormat == EVertexFormat::Float)
+		{
+			layout.add({ EAttributeProperty::Position, EAttributeType::Float, 3 },
+			{ sizeof(Vec3), numVertices, data.m_vertices.data() });
+
+			layout.add({ EAttributeProperty::Normal, EAttributeType::Float, 3 },
+			{ sizeof(Vec3), numVertices, MeshData::getStream(data.m_normals, data.m_normalsView).data() });
+
+			layout.add({ EAttributeProperty::TexCoord, EAttributeType::Float, 2 },
+			{ sizeof(Vec2), numVertices, MeshData::getStream(data.m_texCoords, data.m_texCoordsView).data() });
 
-		layout.add({ EAttributeProperty::TexCoord, EAttributeType::Float, 2 },
-		{ sizeof(Vec2), numVertices, outMesh->m_data.m_texCoords.data() });
+			layout.add({ EAttributeProperty::Bitangent, EAttributeType::Float, 4 },
+			{ sizeof(Vec4), numVertices, MeshData::getStream(data.m_tangents, data.m_tangentsView).data() });
+		}
+		else
+		{
+			// Positions relative to the bounds are scaled back by the model view transform, see DeferredRenderer.
+			if (data.m_vertexFormat == EVertexFormat::PackedPositions)
+			{
+				layout.add({ EAttributeProperty::Position, EAttributeType::Ushort, 3 },
+				{ 4 * sizeof(uint16_t), numVertices, MeshData::getStream(data.m_packedPositions, data.m_packedPositionsView).data(), true });
+			}
+			else
+			{
+				layout.add({ EAttributeProperty::Position, EAttributeType::Float, 3 },
+				{ sizeof(Vec3), numVertices, data.m_vertices.data() });
+			}
 
-		layout.add({ EAttributeProperty::Bitangent, EAttributeType::Float, 4 },
-		{ sizeof(Vec4), numVertices, outMesh->m_data.m_tangents.data() });
+			layout.add({ EAttributeProperty::Normal, EAttributeType::Short, 4 },
+			{ 4 * sizeof(int16_t), numVertices, MeshData::getStream(data.m_packedNormalTangents, data.m_packedNormalTangentsView).data(), true });
+
+			layout.add({ EAttributeProperty::TexCoord, EAttributeType::HalfFloat, 2 },
+			{ 2 * sizeof(uint16_t), numVertices, MeshData::getStream(data.m_packedTexCoords, data.m_packedTexCoordsView).data() });
+		}
 
 		outMesh->m_vertexbuffer = renderDevice->createVertexBuffer(layout);
 
 		assert(outMesh->m_vertexbuffer.isValid());
+
+		// LODs reuse the vertices, their indices follow the ones of the full resolution mesh.
+		std::vector<uint32_t> indices = outMesh->m_data.m_indices;
+		assert(!indices.empty());
+		indices.insert(indices.end(), outMesh->m_lodIndices.begin(), outMesh->m_lodIndices.end());
+
+		if (outMesh->m_data.getIndexSizeBytes() == sizeof(uint16_t))
+		{
+			std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+			outMesh->m_indexbuffer = renderDevice->createIndexBuffer(sizeof(uint16_t), shortIndices.size(), shortIndices.data());
+		}
+		else
+		{
+			outMesh->m_indexbuffer = renderDevice->createIndexBuffer(sizeof(uint32_t), indices.size(), indices.data());
+		}
+
+		assert(outMesh->m_indexbuffer.isValid());
 	}
 
-	void serialize(Archive* ar, MeshData& data)
+	// Indices are stored with the smallest type that can address all vertices.
+	static void serializeIndices(Archive* ar, std::vector<uint32_t>& indices, size_t indexSizeBytes)
+	{
+		if (indexSizeBytes == sizeof(uint16_t))
+		{
+			std::vector<uint16_t> shortIndices;
+
+			if (ar->isWriting())
+			{
+				shortIndices.assign(indices.begin(), indices.end());
+			}
+
+			serialize(ar, shortIndices);
+
+			if (ar->isReading())
+			{
+				indices.assign(shortIndices.begin(), shortIndices.end());
+			}
+		}
+		else
+		{
+			serialize(ar, indices);
+		}
+	}
+
+	// Streams only the GPU needs are viewed in the archive when bViews is set, see deserializeWithViews().
+	template<typename T>
+	static void serializeStream(Archive* ar, std::vector<T>& stream, ArrayView<T>& view, bool bViews)
+	{
+		if (bViews)
+		{
+			assert(ar->isReading());
+			serializeView(static_cast<ReadArchive*>(ar), stream, view);
+		}
+		else
+		{
+			serializeAligned(ar, stream);
+		}
+	}
+
+	static void serializeMeshData(Archive* ar, MeshData& data, bool bViews)
 	{
 		serialize(ar, data.m_numVertices);
-		serialize(ar, data.m_vertices);
-		serialize(ar, data.m_normals);
-		serialize(ar, data.m_tangents);
-		serialize(ar, data.m_texCoords);
+
+		uint8_t vertexFormat = static_cast<uint8_t>(data.m_vertexFormat);
+		serialize(ar, vertexFormat);
+		data.m_vertexFormat = static_cast<EVertexFormat>(vertexFormat);
+
+		if (data.m_vertexFormat == EVertexFormat::Float)
+		{
+			serializeAligned(ar, data.m_vertices);
+			serializeStream(ar, data.m_normals, data.m_normalsView, bViews);
+			serializeStream(ar, data.m_tangents, data.m_tangentsView, bViews);
+			serializeStream(ar, data.m_texCoords, data.m_texCoordsView, bViews);
+		}
+		else
+		{
+			// Only the packed streams are stored, the float ones are decoded from them.
+			if (data.m_vertexFormat == EVertexFormat::PackedPositions)
+			{
+				serialize(ar, data.m_boundsMin);
+				serialize(ar, data.m_boundsExtent);
+				serializeStream(ar, data.m_packedPositions, data.m_packedPositionsView, bViews);
+			}
+			else
+			{
+				serializeAligned(ar, data.m_vertices);
+			}
+
+			serializeStream(ar, data.m_packedNormalTangents, data.m_packedNormalTangentsView, bViews);
+			serializeStream(ar, data.m_packedTexCoords, data.m_packedTexCoordsView, bViews);
+
+			if (ar->isReading())
+			{
+				unpackVertices(&data);
+			}
+		}
+
+		serializeIndices(ar, data.m_indices, data.getIndexSizeBytes());
+	}
+
+	void serialize(Archive* ar, MeshData& data)
+	{
+		serializeMeshData(ar, data, false);
 	}
 
 	struct MeshMaterialExport
@@ -61,14 +377,14 @@ namespace Phoenix
 			for (uint8_t i = 0; i < mesh.m_numMaterials; ++i)
 			{
 				m_materialRefs[i] = mesh.m_materials[i]->m_name;
-				m_matVertexFrom[i] = mesh.m_vertexFrom[i];
+				m_matIndexFrom[i] = mesh.m_indexFrom[i];
 			}
 
 			m_numMaterials = mesh.m_numMaterials;
 		}
 
 		std::string m_materialRefs[StaticMesh::MAX_MATERIALS];
-		size_t m_matVertexFrom[StaticMesh::MAX_MATERIALS];
+		size_t m_matIndexFrom[StaticMesh::MAX_MATERIALS];
 
 		uint8_t m_numMaterials;
 	};
@@ -80,15 +396,79 @@ namespace Phoenix
 		for (uint8_t i = 0; i < exp.m_numMaterials; ++i)
 		{
 			serialize(ar, exp.m_materialRefs[i]);
-			serialize(ar, exp.m_matVertexFrom[i]);
+			serialize(ar, exp.m_matIndexFrom[i]);
 		}
 	}
 
-	void serialize(Archive* ar, StaticMesh& mesh)
+	static void serializeStaticMesh(Archive* ar, StaticMesh& mesh, bool bViews)
 	{
-		serialize(ar, mesh.m_data);
+		serializeMeshData(ar, mesh.m_data, bViews);
 		serialize(ar, mesh.m_name);
 		serialize(ar, mesh.m_numMaterials);
+
+		serialize(ar, mesh.m_numLods);
+		assert(mesh.m_numLods >= 1 && mesh.m_numLods <= StaticMesh::MAX_LODS);
+
+		for (uint8_t lod = 1; lod < mesh.m_numLods; ++lod)
+		{
+			StaticMesh::Lod& lodData = mesh.m_lods[lod - 1];
+
+			for (uint8_t i = 0; i < mesh.m_numMaterials; ++i)
+			{
+				serialize(ar, lodData.m_indexFrom[i]);
+			}
+
+			serialize(ar, lodData.m_numIndices);
+			serialize(ar, lodData.m_error);
+		}
+
+		serializeIndices(ar, mesh.m_lodIndices, mesh.m_data.getIndexSizeBytes());
+	}
+
+	void serialize(Archive* ar, StaticMesh& mesh)
+	{
+		serializeStaticMesh(ar, mesh, false);
+	}
+
+	void deserializeWithViews(ReadArchive* ar, StaticMesh& mesh)
+	{
+		serializeStaticMesh(ar, mesh, true);
+	}
+
+	void clearStreamViews(MeshData* data)
+	{
+		data->m_normalsView = ArrayView<Vec3>();
+		data->m_tangentsView = ArrayView<Vec4>();
+		data->m_texCoordsView = ArrayView<Vec2>();
+		data->m_packedNormalTangentsView = ArrayView<int16_t>();
+		data->m_packedTexCoordsView = ArrayView<uint16_t>();
+		data->m_packedPositionsView = ArrayView<uint16_t>();
+	}
+
+	struct StaticMeshFileHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+	};
+
+	void writeStaticMeshHeader(WriteArchive* ar)
+	{
+		StaticMeshFileHeader header;
+		header.m_magic = STATIC_MESH_FILE_MAGIC;
+		header.m_version = STATIC_MESH_FILE_VERSION;
+		ar->serialize(&header, sizeof(StaticMeshFileHeader));
+	}
+
+	bool readStaticMeshHeader(ReadArchive* ar)
+	{
+		if (ar->m_size - ar->m_numBytesRead < sizeof(StaticMeshFileHeader))
+		{
+			return false;
+		}
+
+		StaticMeshFileHeader header;
+		ar->serialize(&header, sizeof(StaticMeshFileHeader));
+		return header.m_magic == STATIC_MESH_FILE_MAGIC && header.m_version == STATIC_MESH_FILE_VERSION;
 	}
 
 	static const char* g_assetFileExt = ".sm";
@@ -98,6 +478,7 @@ namespace Phoenix
 		WriteArchive ar;
 		createWriteArchive(sizeof(StaticMesh), &ar);
 
+		writeStaticMeshHeader(&ar);
 		serialize(&ar, mesh);
 
 		for (uint8_t i = 0; i < mesh.m_numMaterials; ++i)
@@ -139,10 +520,20 @@ namespace Phoenix
 			return mesh;
 		}
 
+		if (!readStaticMeshHeader(&ar))
+		{
+			Logger::errorf("Static mesh %s is not in the current format, it needs to be cooked again.", readPath.c_str());
+			destroyArchive(ar);
+			return mesh;
+		}
+
 		mesh = assets->allocStaticMesh(path);
 
-		serialize(&ar, *mesh);
+		// The vertex streams go to the GPU straight from the archive.
+		deserializeWithViews(&ar, *mesh);
+		computeMeshBounds(mesh);
 		createMeshBuffers(mesh, renderDevice);
+		clearStreamViews(&mesh->m_data);
 
 		for (uint8_t i = 0; i < mesh->m_numMaterials; ++i)
 		{
@@ -150,7 +541,7 @@ namespace Phoenix
 			serialize(&ar, exp);
 
 			mesh->m_materials[i] = loadMaterial(exp.m_materialRefs[i].c_str(), renderDevice, renderContext, assets);
-			mesh->m_vertexFrom[i] = exp.m_matVertexFrom[i];
+			mesh->m_indexFrom[i] = exp.m_matIndexFrom[i];
 		}
 
 		destroyArchive(ar);
@@ -6,6 +6,9 @@
 #include <Math/Vec3.hpp>
 #include <Math/Vec2.hpp>
 
+#include <Memory/ArrayView.hpp>
+
+#include <stdint.h>
 #include <vector>
 
 namespace Phoenix
@@ -15,17 +18,49 @@ namespace Phoenix
 	class AssetRegistry;
 	struct Material;
 	struct LoadResources;
+	struct Archive;
+	struct ReadArchive;
+	struct WriteArchive;
+	class Matrix4;
+	class Ray;
+
+	// Layout of the vertex attributes on disk and on the GPU.
+	enum class EVertexFormat : uint8_t
+	{
+		Float,			// 48 bytes, float position, normal, uv and tangent.
+		Packed,			// 24 bytes, float position, octahedral snorm16 normal and tangent, half float uv.
+		PackedPositions	// 20 bytes, like Packed but with unorm16 positions relative to the mesh bounds.
+	};
 
 	struct MeshData
 	{
 		MeshData()
 			: m_numVertices(0)
+			, m_vertexFormat(EVertexFormat::Float)
 		{}
 
 		void setSize(size_t numVertices);
 
+		// 2 if all vertices can be addressed with 16 bit indices, 4 otherwise.
+		size_t getIndexSizeBytes() const;
+
+		// Size of one vertex in the GPU vertex buffer, depends on m_vertexFormat.
+		size_t getVertexSizeBytes() const;
+
+		// Memory used by the vertex attributes and indices once uploaded to the GPU.
+		size_t getSizeBytes() const;
+
+		// The view while it is set, the vector otherwise.
+		template<typename T>
+		static ArrayView<T> getStream(const std::vector<T>& vector, const ArrayView<T>& view)
+		{
+			return view.empty() ? ArrayView<T>(vector) : view;
+		}
+
 		size_t m_numVertices;
 
+		EVertexFormat m_vertexFormat;
+
 		std::vector<Vec3> m_vertices;
 		
 		std::vector<Vec3> m_normals;
@@ -35,31 +70,115 @@ namespace Phoenix
 		std::vector<Vec4> m_tangents;
 
 		std::vector<Vec2> m_texCoords;
+
+		// Three indices per triangle. Stored with getIndexSizeBytes() per index on disk and GPU.
+		std::vector<uint32_t> m_indices;
+
+		// Packed formats upload these instead of the float streams, which then hold the 
+		// dequantized values for use on the CPU. See quantizeVertices().
+		std::vector<int16_t> m_packedNormalTangents; // Octahedral normal, then tangent with the handedness in the lowest bit.
+		std::vector<uint16_t> m_packedTexCoords; // Two half floats per vertex.
+		std::vector<uint16_t> m_packedPositions; // Four unorm16 per vertex (w unused), PackedPositions only.
+		
+		// Dequantizes m_packedPositions as m_boundsMin + position * m_boundsExtent.
+		Vec3 m_boundsMin;
+		Vec3 m_boundsExtent;
+
+		// Streams only the GPU needs, read in place from an archive by deserializeWithViews() and
+		// uploaded from there instead of the vectors, which stay empty. Set until clearStreamViews().
+		ArrayView<Vec3> m_normalsView;
+		ArrayView<Vec4> m_tangentsView;
+		ArrayView<Vec2> m_texCoordsView;
+		ArrayView<int16_t> m_packedNormalTangentsView;
+		ArrayView<uint16_t> m_packedTexCoordsView;
+		ArrayView<uint16_t> m_packedPositionsView;
 	};
 
 	struct StaticMesh
 	{
 		StaticMesh()
 			: m_vertexbuffer()
+			, m_indexbuffer()
+			, m_boundsRadius(0.f)
+			, m_numLods(1)
 		{}
 
 		enum
 		{
-			MAX_MATERIALS = 8
+			MAX_MATERIALS = 8,
+			MAX_LODS = 4
+		};
+
+		// A simplified version of the mesh that reuses its vertices, see generateLods().
+		struct Lod
+		{
+			size_t m_indexFrom[MAX_MATERIALS]; // Into the index buffer, which holds m_data.m_indices first.
+			size_t m_numIndices;
+			float m_error; // Largest object space distance to the full resolution surface.
 		};
 
 		std::string m_name;
 
 		MeshData m_data;
 		VertexBufferHandle m_vertexbuffer;	
+		IndexBufferHandle m_indexbuffer;
 		
 		Material* m_materials[MAX_MATERIALS]; 
-		size_t m_vertexFrom[MAX_MATERIALS]; 
+		size_t m_indexFrom[MAX_MATERIALS]; 
 		uint8_t m_numMaterials;
+
+		// Object space bounding sphere and box.
+		Vec3 m_boundsCenter;
+		float m_boundsRadius;
+		Vec3 m_aabbMin;
+		Vec3 m_aabbMax;
+
+		// LOD 0 is m_data itself, m_lods holds LOD 1 to m_numLods - 1.
+		Lod m_lods[MAX_LODS - 1];
+		std::vector<uint32_t> m_lodIndices;
+		uint8_t m_numLods;
 	};
 
+	// Merges vertices with identical position, normal, uv and tangent handedness and fills
+	// m_indices. Tangents of merged vertices are averaged. Expects a mesh without indices.
+	void weldVertices(MeshData* data);
+
+	// Fits the bounding sphere and box of the mesh around its vertices.
+	void computeMeshBounds(StaticMesh* mesh);
+
+	// Distance along the world space ray to the closest triangle of the full resolution mesh
+	// placed with the transform, negative if the ray misses it or the hit is beyond maxDistance.
+	float raycastStaticMesh(const StaticMesh& mesh, const Matrix4& transform, const Ray& ray, float maxDistance);
+
+	// Uploads the vertices, m_data.m_indices and the indices of all LODs.
 	void createMeshBuffers(StaticMesh* outMesh, IRIDevice* renderDevice);
 
+	void serialize(Archive* ar, MeshData& data);
+
+	// Mesh data, name and LODs. Materials are stored separately by saveStaticMesh().
+	void serialize(Archive* ar, StaticMesh& mesh);
+
+	// Reads a mesh like serialize(), but views the streams only the GPU needs in the archive instead
+	// of copying them, see MeshData. createMeshBuffers() uploads them straight from the archive, after
+	// which clearStreamViews() has to be called before the archive is destroyed. The mesh then only
+	// holds the streams used on the CPU and cannot be saved again.
+	void deserializeWithViews(ReadArchive* ar, StaticMesh& mesh);
+
+	void clearStreamViews(MeshData* data);
+
+	// .sm files start with a magic and a format version, which has to change with the layout of
+	// serialize(StaticMesh), so files cooked before are refused instead of misread.
+	enum
+	{
+		STATIC_MESH_FILE_MAGIC = 0x4D534850, // "PHSM"
+		STATIC_MESH_FILE_VERSION = 1
+	};
+
+	void writeStaticMeshHeader(WriteArchive* ar);
+
+	// False if the archive does not start with the header of the current version.
+	bool readStaticMeshHeader(ReadArchive* ar);
+
 	StaticMesh* loadStaticMesh(const char* path, LoadResources* resources);
 
 	void saveStaticMesh(StaticMesh& mesh, AssetRegistry* assets);
@@ -0,0 +1,168 @@
+#include "MeshLod.hpp"
+
+#include <assert.h>
+#include <float.h>
+#include <algorithm>
+#include <vector>
+
+#include <Core/Mesh.hpp>
+#include <Core/MeshOptimize.hpp>
+#include <Core/MeshSimplify.hpp>
+#include <Core/Logger.hpp>
+#include <Math/Vec3.hpp>
+
+namespace Phoenix
+{
+	void generateLods(StaticMesh* mesh)
+	{
+		const MeshData& data = mesh->m_data;
+		const std::vector<uint32_t>& baseIndices = data.m_indices;
+
+		// A level that keeps more than this fraction of the previous one is not worth its memory.
+		const float minReduction = 0.85f;
+
+		mesh->m_numLods = 1;
+		mesh->m_lodIndices.clear();
+
+		size_t numRanges = std::max<size_t>(mesh->m_numMaterials, 1);
+		size_t previousNumIndices = baseIndices.size();
+		std::vector<uint32_t> simplified(baseIndices.size());
+
+		for (uint8_t lod = 1; lod < StaticMesh::MAX_LODS; ++lod)
+		{
+			StaticMesh::Lod& lodData = mesh->m_lods[lod - 1];
+			lodData.m_numIndices = 0;
+			lodData.m_error = 0.f;
+
+			size_t lodStart = baseIndices.size() + mesh->m_lodIndices.size();
+
+			for (size_t range = 0; range < numRanges; ++range)
+			{
+				size_t from = mesh->m_numMaterials > 0 ? mesh->m_indexFrom[range] : 0;
+				size_t to = range + 1 < numRanges ? mesh->m_indexFrom[range + 1] : baseIndices.size();
+				size_t numIndices = to - from;
+
+				size_t targetNumIndices = (numIndices >> lod) / 3 * 3;
+
+				float error = 0.f;
+				size_t numSimplified = simplifyMesh(data.m_vertices.data(), data.m_numVertices, &baseIndices[from], numIndices,
+													targetNumIndices, FLT_MAX, simplified.data(), &error);
+
+				optimizeVertexCache(simplified.data(), numSimplified, data.m_numVertices);
+
+				lodData.m_indexFrom[range] = baseIndices.size() + mesh->m_lodIndices.size();
+				lodData.m_error = std::max(lodData.m_error, error);
+				mesh->m_lodIndices.insert(mesh->m_lodIndices.end(), simplified.begin(), simplified.begin() + numSimplified);
+			}
+
+			lodData.m_numIndices = baseIndices.size() + mesh->m_lodIndices.size() - lodStart;
+
+			// Coarser levels must never claim a smaller error, selectLod() relies on it.
+			if (lod > 1)
+			{
+				lodData.m_error = std::max(lodData.m_error, mesh->m_lods[lod - 2].m_error);
+			}
+
+			if (lodData.m_numIndices > previousNumIndices * minReduction)
+			{
+				mesh->m_lodIndices.resize(lodStart - baseIndices.size());
+				break;
+			}
+
+			Logger::logf("Mesh %s LOD %u: %zu -> %zu triangles (%.1f%%), error %f", mesh->m_name.c_str(), lod, baseIndices.size() / 3,
+				lodData.m_numIndices / 3, 100.0 * lodData.m_numIndices / baseIndices.size(), lodData.m_error);
+
+			previousNumIndices = lodData.m_numIndices;
+			mesh->m_numLods = lod + 1;
+		}
+	}
+
+	void getLodIndexRange(const StaticMesh& mesh, uint8_t lod, uint8_t material, size_t* outIndexFrom, size_t* outNumIndices)
+	{
+		assert(lod < mesh.m_numLods);
+		assert(material < mesh.m_numMaterials);
+
+		const size_t* indexFrom = mesh.m_indexFrom;
+		size_t indexEnd = mesh.m_data.m_indices.size();
+
+		if (lod > 0)
+		{
+			const StaticMesh::Lod& lodData = mesh.m_lods[lod - 1];
+			indexFrom = lodData.m_indexFrom;
+			indexEnd = lodData.m_indexFrom[0] + lodData.m_numIndices;
+		}
+
+		size_t next = material + 1 < mesh.m_numMaterials ? indexFrom[material + 1] : indexEnd;
+
+		*outIndexFrom = indexFrom[material];
+		*outNumIndices = next - indexFrom[material];
+	}
+
+	const uint32_t* getLodIndices(const StaticMesh& mesh, uint8_t lod, size_t* outNumIndices)
+	{
+		assert(lod < mesh.m_numLods);
+
+		if (lod == 0)
+		{
+			*outNumIndices = mesh.m_data.m_indices.size();
+			return mesh.m_data.m_indices.data();
+		}
+
+		// m_lodIndices follows m_data.m_indices in the index buffer.
+		const StaticMesh::Lod& lodData = mesh.m_lods[lod - 1];
+
+		*outNumIndices = lodData.m_numIndices;
+		return &mesh.m_lodIndices[lodData.m_indexFrom[0] - mesh.m_data.m_indices.size()];
+	}
+
+	float getProjectedSize(const Vec3& viewCenter, float radius, float projScaleY, float viewportHeight)
+	{
+		float distance = viewCenter.length();
+
+		// Inside the sphere it covers the whole screen.
+		if (distance <= radius)
+		{
+			return FLT_MAX;
+		}
+
+		return radius * projScaleY / distance * viewportHeight;
+	}
+
+	float getLodMaxScreenSize(const StaticMesh& mesh, uint8_t lod, float maxPixelError)
+	{
+		if (lod == 0)
+		{
+			return FLT_MAX;
+		}
+
+		float error = mesh.m_lods[lod - 1].m_error;
+
+		if (error <= 0.f)
+		{
+			return FLT_MAX;
+		}
+
+		// The error covers error / diameter of the sphere's projected size.
+		return maxPixelError * 2.f * mesh.m_boundsRadius / error;
+	}
+
+	uint8_t selectLod(const StaticMesh& mesh, float screenSize, uint8_t currentLod, float maxPixelError, float hysteresis)
+	{
+		uint8_t lod = std::min<uint8_t>(currentLod, mesh.m_numLods - 1);
+
+		while (lod > 0 && screenSize > getLodMaxScreenSize(mesh, lod, maxPixelError) * (1.f + hysteresis))
+		{
+			lod--;
+		}
+
+		if (lod == currentLod)
+		{
+			while (lod + 1 < mesh.m_numLods && screenSize <= getLodMaxScreenSize(mesh, lod + 1, maxPixelError) * (1.f - hysteresis))
+			{
+				lod++;
+			}
+		}
+
+		return lod;
+	}
+}
\ No newline at end of file
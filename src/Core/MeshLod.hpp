@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	struct StaticMesh;
+	class Vec3;
+
+	// Fills the LOD chain of mesh by simplifying each material range of m_data.m_indices on its own, 
+	// halving the triangles per level. Stops early when a level cannot remove enough triangles anymore.
+	// Logs the triangle count and error of each level.
+	void generateLods(StaticMesh* mesh);
+
+	// Range of the index buffer to draw for a material of a LOD.
+	void getLodIndexRange(const StaticMesh& mesh, uint8_t lod, uint8_t material, size_t* outIndexFrom, size_t* outNumIndices);
+
+	// CPU copy of the indices of all materials of a LOD.
+	const uint32_t* getLodIndices(const StaticMesh& mesh, uint8_t lod, size_t* outNumIndices);
+
+	// Projected diameter in pixels of a sphere at viewCenter in view space. projScaleY is element (1, 1) 
+	// of the projection matrix, the cotangent of half the vertical field of view.
+	float getProjectedSize(const Vec3& viewCenter, float radius, float projScaleY, float viewportHeight);
+
+	// Largest projected size of the mesh's bounding sphere (diameter in pixels) at which the error 
+	// of lod stays below maxPixelError. Unlimited for LOD 0.
+	float getLodMaxScreenSize(const StaticMesh& mesh, uint8_t lod, float maxPixelError);
+
+	// Picks the coarsest LOD whose error is invisible at screenSize, starting from currentLod.
+	// Switching to a coarser LOD needs the size to be a fraction hysteresis below its limit, switching
+	// back a fraction hysteresis above, so meshes near a limit do not flicker between LODs.
+	uint8_t selectLod(const StaticMesh& mesh, float screenSize, uint8_t currentLod, float maxPixelError, float hysteresis);
+}
\ No newline at end of file
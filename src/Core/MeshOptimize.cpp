@@ -0,0 +1,358 @@
+#include "MeshOptimize.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <Core/Mesh.hpp>
+
+namespace Phoenix
+{
+	float computeACMR(const uint32_t* indices, size_t numIndices, size_t numVertices, size_t cacheSize)
+	{
+		if (numIndices < 3)
+		{
+			return 0.f;
+		}
+
+		// Timestamp of the miss that put a vertex into the FIFO, it is still cached while 
+		// fewer than cacheSize misses happened since.
+		std::vector<size_t> insertedAt(numVertices, 0);
+		size_t numMisses = 0;
+
+		for (size_t i = 0; i < numIndices; ++i)
+		{
+			uint32_t vertex = indices[i];
+			assert(vertex < numVertices);
+
+			if (insertedAt[vertex] == 0 || numMisses - insertedAt[vertex] >= cacheSize)
+			{
+				numMisses++;
+				insertedAt[vertex] = numMisses;
+			}
+		}
+
+		return static_cast<float>(numMisses) / static_cast<float>(numIndices / 3);
+	}
+
+	namespace
+	{
+		enum
+		{
+			LRU_CACHE_SIZE = 32,
+			MAX_VALENCE_SCORES = 32
+		};
+
+		// Score tables from Forsyth's paper.
+		struct ForsythScores
+		{
+			float m_cache[LRU_CACHE_SIZE];
+			float m_valence[MAX_VALENCE_SCORES];
+
+			ForsythScores()
+			{
+				const float cacheDecayPower = 1.5f;
+				const float lastTriScore = 0.75f;
+				const float valenceBoostScale = 2.0f;
+				const float valenceBoostPower = 0.5f;
+
+				for (size_t i = 0; i < LRU_CACHE_SIZE; ++i)
+				{
+					// Vertices of the last triangle get a fixed score, so the next triangle does not 
+					// always continue a strip from the most recent edge.
+					if (i < 3)
+					{
+						m_cache[i] = lastTriScore;
+					}
+					else
+					{
+						const float scaler = 1.f / (LRU_CACHE_SIZE - 3);
+						m_cache[i] = powf(1.f - (i - 3) * scaler, cacheDecayPower);
+					}
+				}
+
+				m_valence[0] = 0.f;
+				for (size_t i = 1; i < MAX_VALENCE_SCORES; ++i)
+				{
+					// Boosts vertices with few triangles left, to get rid of lone triangles early.
+					m_valence[i] = valenceBoostScale * powf(static_cast<float>(i), -valenceBoostPower);
+				}
+			}
+
+			float score(int32_t cachePosition, uint32_t numLiveTriangles) const
+			{
+				if (numLiveTriangles == 0)
+				{
+					return -1.f;
+				}
+
+				float value = cachePosition >= 0 ? m_cache[cachePosition] : 0.f;
+				value += m_valence[numLiveTriangles < MAX_VALENCE_SCORES ? numLiveTriangles : MAX_VALENCE_SCORES - 1];
+				return value;
+			}
+		};
+	}
+
+	void optimizeVertexCache(uint32_t* indices, size_t numIndices, size_t numVertices)
+	{
+		assert(numIndices % 3 == 0);
+
+		size_t numTriangles = numIndices / 3;
+
+		if (numTriangles < 2)
+		{
+			return;
+		}
+
+		static const ForsythScores scores;
+
+		// Triangles adjacent to each vertex, packed into one array. The live part of a vertex's
+		// list shrinks as its triangles are emitted.
+		std::vector<uint32_t> numLive(numVertices, 0);
+		std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+
+		for (size_t i = 0; i < numIndices; ++i)
+		{
+			numLive[indices[i]]++;
+		}
+
+		for (size_t v = 0; v < numVertices; ++v)
+		{
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + numLive[v];
+		}
+
+		std::vector<uint32_t> adjacency(numIndices);
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < numIndices; ++i)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<int32_t> cachePosition(numVertices, -1);
+		std::vector<float> vertexScores(numVertices);
+
+		for (size_t v = 0; v < numVertices; ++v)
+		{
+			vertexScores[v] = scores.score(-1, numLive[v]);
+		}
+
+		std::vector<float> triangleScores(numTriangles);
+		std::vector<bool> bEmitted(numTriangles, false);
+
+		for (size_t t = 0; t < numTriangles; ++t)
+		{
+			triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+		}
+
+		std::vector<uint32_t> output;
+		output.reserve(numIndices);
+
+		// One extra slot for the three vertices pushed in front of a full cache.
+		uint32_t cache[LRU_CACHE_SIZE + 3];
+		size_t cacheSize = 0;
+
+		size_t scanCursor = 0;
+		int64_t bestTriangle = -1;
+
+		for (size_t emitted = 0; emitted < numTriangles; ++emitted)
+		{
+			// Nothing in the cache is adjacent to a live triangle, start over from the first one left.
+			if (bestTriangle < 0)
+			{
+				float bestScore = -1.f;
+
+				for (size_t t = scanCursor; t < numTriangles; ++t)
+				{
+					if (!bEmitted[t] && triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						bestTriangle = static_cast<int64_t>(t);
+					}
+				}
+			}
+
+			assert(bestTriangle >= 0);
+
+			size_t triangle = static_cast<size_t>(bestTriangle);
+			const uint32_t* triVertices = &indices[3 * triangle];
+
+			bEmitted[triangle] = true;
+			output.insert(output.end(), triVertices, triVertices + 3);
+
+			while (scanCursor < numTriangles && bEmitted[scanCursor])
+			{
+				scanCursor++;
+			}
+
+			// Remove the triangle from the adjacency of its vertices.
+			for (size_t i = 0; i < 3; ++i)
+			{
+				uint32_t vertex = triVertices[i];
+				uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+				uint32_t count = numLive[vertex];
+
+				for (uint32_t j = 0; j < count; ++j)
+				{
+					if (list[j] == triangle)
+					{
+						list[j] = list[count - 1];
+						break;
+					}
+				}
+
+				numLive[vertex]--;
+			}
+
+			// Move the triangle's vertices to the front of the LRU cache.
+			uint32_t newCache[LRU_CACHE_SIZE + 3];
+			size_t newCacheSize = 0;
+
+			for (size_t i = 0; i < 3; ++i)
+			{
+				newCache[newCacheSize++] = triVertices[i];
+			}
+
+			for (size_t i = 0; i < cacheSize; ++i)
+			{
+				uint32_t vertex = cache[i];
+
+				if (vertex != triVertices[0] && vertex != triVertices[1] && vertex != triVertices[2])
+				{
+					newCache[newCacheSize++] = vertex;
+				}
+			}
+
+			memcpy(cache, newCache, newCacheSize * sizeof(uint32_t));
+			cacheSize = newCacheSize;
+
+			// Rescore the cached vertices, the ones that fell out of the cache and their triangles.
+			for (size_t i = 0; i < cacheSize; ++i)
+			{
+				uint32_t vertex = cache[i];
+				int32_t position = i < LRU_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+
+				cachePosition[vertex] = position;
+				float newScore = scores.score(position, numLive[vertex]);
+				float delta = newScore - vertexScores[vertex];
+				vertexScores[vertex] = newScore;
+
+				const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+				for (uint32_t j = 0; j < numLive[vertex]; ++j)
+				{
+					triangleScores[list[j]] += delta;
+				}
+			}
+
+			if (cacheSize > LRU_CACHE_SIZE)
+			{
+				cacheSize = LRU_CACHE_SIZE;
+			}
+
+			// The next triangle is the best one that uses a cached vertex.
+			bestTriangle = -1;
+			float bestScore = -1.f;
+
+			for (size_t i = 0; i < cacheSize; ++i)
+			{
+				uint32_t vertex = cache[i];
+				const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+
+				for (uint32_t j = 0; j < numLive[vertex]; ++j)
+				{
+					uint32_t candidate = list[j];
+
+					if (triangleScores[candidate] > bestScore)
+					{
+						bestScore = triangleScores[candidate];
+						bestTriangle = candidate;
+					}
+				}
+			}
+		}
+
+		memcpy(indices, output.data(), numIndices * sizeof(uint32_t));
+	}
+
+	template <class T>
+	static void remapVertices(std::vector<T>& attribute, const std::vector<uint32_t>& newToOld)
+	{
+		if (attribute.empty())
+		{
+			return;
+		}
+
+		std::vector<T> remapped(newToOld.size());
+
+		for (size_t i = 0; i < newToOld.size(); ++i)
+		{
+			remapped[i] = attribute[newToOld[i]];
+		}
+
+		attribute.swap(remapped);
+	}
+
+	void optimizeVertexFetch(MeshData* data)
+	{
+		// Packed streams are encoded after optimizing, only the float ones are remapped.
+		assert(data->m_vertexFormat == EVertexFormat::Float);
+
+		const uint32_t unassigned = UINT32_MAX;
+
+		size_t numVertices = data->m_numVertices;
+		std::vector<uint32_t> oldToNew(numVertices, unassigned);
+		std::vector<uint32_t> newToOld;
+		newToOld.reserve(numVertices);
+
+		for (uint32_t& index : data->m_indices)
+		{
+			if (oldToNew[index] == unassigned)
+			{
+				oldToNew[index] = static_cast<uint32_t>(newToOld.size());
+				newToOld.push_back(index);
+			}
+
+			index = oldToNew[index];
+		}
+
+		for (uint32_t v = 0; v < numVertices; ++v)
+		{
+			if (oldToNew[v] == unassigned)
+			{
+				oldToNew[v] = static_cast<uint32_t>(newToOld.size());
+				newToOld.push_back(v);
+			}
+		}
+
+		remapVertices(data->m_vertices, newToOld);
+		remapVertices(data->m_normals, newToOld);
+		remapVertices(data->m_tangents, newToOld);
+		remapVertices(data->m_texCoords, newToOld);
+	}
+
+	MeshOptimizeStats optimizeMesh(MeshData* data, const size_t* rangeStarts, size_t numRanges)
+	{
+		std::vector<uint32_t>& indices = data->m_indices;
+		size_t numIndices = indices.size();
+
+		MeshOptimizeStats stats;
+		stats.m_acmrBefore = computeACMR(indices.data(), numIndices, data->m_numVertices);
+
+		for (size_t range = 0; range < numRanges; ++range)
+		{
+			size_t start = rangeStarts[range];
+			size_t end = (range + 1 < numRanges) ? rangeStarts[range + 1] : numIndices;
+
+			assert(start <= end && end <= numIndices);
+			assert(start % 3 == 0 && end % 3 == 0);
+
+			optimizeVertexCache(&indices[start], end - start, data->m_numVertices);
+		}
+
+		optimizeVertexFetch(data);
+
+		stats.m_acmrAfter = computeACMR(indices.data(), numIndices, data->m_numVertices);
+		return stats;
+	}
+}
\ No newline at end of file
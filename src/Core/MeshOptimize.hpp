@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	struct MeshData;
+
+	enum
+	{
+		// FIFO size used to measure ACMR, a conservative estimate of current GPUs.
+		ACMR_CACHE_SIZE = 16
+	};
+
+	// Average cache miss ratio: vertex shader invocations per triangle for a FIFO post-transform
+	// cache of cacheSize entries. Ranges from 3 (no reuse) down to ~0.5 for regular grids.
+	float computeACMR(const uint32_t* indices, size_t numIndices, size_t numVertices, size_t cacheSize = ACMR_CACHE_SIZE);
+
+	// Reorders the triangles of indices to improve post-transform cache hits, using Forsyth's 
+	// "Linear-Speed Vertex Cache Optimisation" with a 32 entry LRU cache. The triangles stay
+	// within the given index range.
+	void optimizeVertexCache(uint32_t* indices, size_t numIndices, size_t numVertices);
+
+	// Reorders the vertex attributes in the order the indices first use them and remaps the indices.
+	// Vertices that are not referenced are moved to the end.
+	void optimizeVertexFetch(MeshData* data);
+
+	struct MeshOptimizeStats
+	{
+		float m_acmrBefore;
+		float m_acmrAfter;
+	};
+
+	// Optimizes the vertex cache use of every index range separately, followed by the vertex 
+	// fetch order of the whole mesh. rangeStarts holds the first index of each range (e.g. 
+	// StaticMesh::m_indexFrom), so the index ranges of materials stay valid.
+	MeshOptimizeStats optimizeMesh(MeshData* data, const size_t* rangeStarts, size_t numRanges);
+}
\ No newline at end of file
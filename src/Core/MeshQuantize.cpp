@@ -0,0 +1,299 @@
+#include "MeshQuantize.hpp"
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include <Core/Mesh.hpp>
+#include <Math/PhiMath.hpp>
+#include <Math/Vec4.hpp>
+
+namespace Phoenix
+{
+	static float signNotZero(float value)
+	{
+		return value >= 0.f ? 1.f : -1.f;
+	}
+
+	Vec2 octEncode(const Vec3& unitVector)
+	{
+		float l1Norm = fabsf(unitVector.x) + fabsf(unitVector.y) + fabsf(unitVector.z);
+
+		if (l1Norm <= 0.f)
+		{
+			return Vec2(0.f, 0.f);
+		}
+
+		Vec2 result(unitVector.x / l1Norm, unitVector.y / l1Norm);
+
+		// Fold the lower hemisphere over the diagonals.
+		if (unitVector.z < 0.f)
+		{
+			Vec2 folded((1.f - fabsf(result.y)) * signNotZero(result.x), (1.f - fabsf(result.x)) * signNotZero(result.y));
+			result = folded;
+		}
+
+		return result;
+	}
+
+	Vec3 octDecode(const Vec2& encoded)
+	{
+		Vec3 result(encoded.x, encoded.y, 1.f - fabsf(encoded.x) - fabsf(encoded.y));
+
+		if (result.z < 0.f)
+		{
+			float x = (1.f - fabsf(encoded.y)) * signNotZero(encoded.x);
+			float y = (1.f - fabsf(encoded.x)) * signNotZero(encoded.y);
+			result.x = x;
+			result.y = y;
+		}
+
+		return result.normalized();
+	}
+
+	int16_t toSnorm16(float value)
+	{
+		value = std::min(std::max(value, -1.f), 1.f);
+		return static_cast<int16_t>(roundf(value * INT16_MAX));
+	}
+
+	float fromSnorm16(int16_t value)
+	{
+		return std::max(static_cast<float>(value) / INT16_MAX, -1.f);
+	}
+
+	uint16_t toUnorm16(float value)
+	{
+		value = std::min(std::max(value, 0.f), 1.f);
+		return static_cast<uint16_t>(roundf(value * UINT16_MAX));
+	}
+
+	float fromUnorm16(uint16_t value)
+	{
+		return static_cast<float>(value) / UINT16_MAX;
+	}
+
+	static uint32_t floatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(float));
+		return bits;
+	}
+
+	static float bitsToFloat(uint32_t bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(float));
+		return value;
+	}
+
+	uint16_t floatToHalf(float value)
+	{
+		uint32_t bits = floatBits(value);
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+		uint32_t half;
+
+		if (magnitude >= 0x47800000) 
+		{
+			// Too large for a half, infinity or NaN.
+			half = magnitude > 0x7F800000 ? 0x7E00 : 0x7C00;
+		}
+		else if (magnitude < 0x38800000)
+		{
+			// Denormal half, the addition shifts the mantissa into place and rounds it.
+			const uint32_t denormMagic = 126 << 23;
+			half = floatBits(bitsToFloat(magnitude) + bitsToFloat(denormMagic)) - denormMagic;
+		}
+		else
+		{
+			// Rebias the exponent and round the dropped 13 mantissa bits to nearest even.
+			uint32_t mantissaOdd = (magnitude >> 13) & 1;
+			magnitude += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + mantissaOdd;
+			half = magnitude >> 13;
+		}
+
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	float halfToFloat(uint16_t value)
+	{
+		uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+
+		if (exponent == 0)
+		{
+			float denormal = ldexpf(static_cast<float>(mantissa), -24);
+			return sign ? -denormal : denormal;
+		}
+
+		if (exponent == 0x1F)
+		{
+			return bitsToFloat(sign | 0x7F800000 | (mantissa << 13));
+		}
+
+		return bitsToFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+	}
+
+	// The handedness takes the lowest bit of the tangent's second component.
+	static int16_t packHandedness(int16_t encoded, float handedness)
+	{
+		int32_t packed = (encoded & ~1) | (handedness < 0.f ? 1 : 0);
+
+		// -32768 is read back as -1.0 like -32767, which would flip the bit on the GPU.
+		if (packed < -INT16_MAX)
+		{
+			packed += 2;
+		}
+
+		return static_cast<int16_t>(packed);
+	}
+
+	// atan2 stays precise for the tiny angles quantization introduces, acos of the dot product does not.
+	static float angleBetweenDeg(const Vec3& a, const Vec3& b)
+	{
+		return degrees(atan2f(a.cross(b).length(), a.dot(b)));
+	}
+
+	VertexQuantizeError quantizeVertices(MeshData* data, EVertexFormat format)
+	{
+		assert(data->m_vertexFormat == EVertexFormat::Float);
+		assert(format != EVertexFormat::Float);
+
+		size_t numVertices = data->m_numVertices;
+
+		data->m_packedNormalTangents.resize(numVertices * 4);
+		data->m_packedTexCoords.resize(numVertices * 2);
+
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			const Vec4& tangent = data->m_tangents[i];
+
+			Vec2 normal = octEncode(data->m_normals[i].normalized());
+			Vec2 tangentXyz = octEncode(Vec3(tangent).normalized());
+
+			int16_t* packed = &data->m_packedNormalTangents[i * 4];
+			packed[0] = toSnorm16(normal.x);
+			packed[1] = toSnorm16(normal.y);
+			packed[2] = toSnorm16(tangentXyz.x);
+			packed[3] = packHandedness(toSnorm16(tangentXyz.y), tangent.w);
+
+			data->m_packedTexCoords[i * 2 + 0] = floatToHalf(data->m_texCoords[i].x);
+			data->m_packedTexCoords[i * 2 + 1] = floatToHalf(data->m_texCoords[i].y);
+		}
+
+		if (format == EVertexFormat::PackedPositions)
+		{
+			Vec3 boundsMin(FLT_MAX);
+			Vec3 boundsMax(-FLT_MAX);
+
+			for (const Vec3& position : data->m_vertices)
+			{
+				boundsMin = Vec3(std::min(boundsMin.x, position.x), std::min(boundsMin.y, position.y), std::min(boundsMin.z, position.z));
+				boundsMax = Vec3(std::max(boundsMax.x, position.x), std::max(boundsMax.y, position.y), std::max(boundsMax.z, position.z));
+			}
+
+			data->m_boundsMin = numVertices > 0 ? boundsMin : Vec3(0.f);
+			data->m_boundsExtent = numVertices > 0 ? boundsMax - boundsMin : Vec3(0.f);
+			data->m_packedPositions.resize(numVertices * 4);
+
+			for (size_t i = 0; i < numVertices; ++i)
+			{
+				Vec3 relative = data->m_vertices[i] - data->m_boundsMin;
+
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					float extent = data->m_boundsExtent(axis);
+					data->m_packedPositions[i * 4 + axis] = toUnorm16(extent > 0.f ? relative(axis) / extent : 0.f);
+				}
+
+				data->m_packedPositions[i * 4 + 3] = 0;
+			}
+		}
+
+		MeshData reference;
+		reference.m_vertices.swap(data->m_vertices);
+		reference.m_normals.swap(data->m_normals);
+		reference.m_tangents.swap(data->m_tangents);
+		reference.m_texCoords.swap(data->m_texCoords);
+
+		data->m_vertexFormat = format;
+		unpackVertices(data);
+
+		// Positions are kept as floats by the Packed format and just copied back.
+		if (format == EVertexFormat::Packed)
+		{
+			data->m_vertices.swap(reference.m_vertices);
+		}
+
+		VertexQuantizeError error;
+
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			if (format == EVertexFormat::PackedPositions)
+			{
+				error.m_maxPositionError = std::max(error.m_maxPositionError, (data->m_vertices[i] - reference.m_vertices[i]).length());
+			}
+
+			error.m_maxNormalErrorDeg = std::max(error.m_maxNormalErrorDeg, angleBetweenDeg(data->m_normals[i], reference.m_normals[i].normalized()));
+			error.m_maxTangentErrorDeg = std::max(error.m_maxTangentErrorDeg, angleBetweenDeg(Vec3(data->m_tangents[i]), Vec3(reference.m_tangents[i]).normalized()));
+
+			if ((data->m_tangents[i].w < 0.f) != (reference.m_tangents[i].w < 0.f))
+			{
+				error.m_numHandednessErrors++;
+			}
+
+			error.m_maxTexCoordError = std::max(error.m_maxTexCoordError, fabsf(data->m_texCoords[i].x - reference.m_texCoords[i].x));
+			error.m_maxTexCoordError = std::max(error.m_maxTexCoordError, fabsf(data->m_texCoords[i].y - reference.m_texCoords[i].y));
+		}
+
+		return error;
+	}
+
+	void unpackVertices(MeshData* data)
+	{
+		assert(data->m_vertexFormat != EVertexFormat::Float);
+
+		size_t numVertices = data->m_numVertices;
+
+		const ArrayView<int16_t> packedNormalTangents = MeshData::getStream(data->m_packedNormalTangents, data->m_packedNormalTangentsView);
+		const ArrayView<uint16_t> packedTexCoords = MeshData::getStream(data->m_packedTexCoords, data->m_packedTexCoordsView);
+
+		assert(packedNormalTangents.size() == numVertices * 4);
+		assert(packedTexCoords.size() == numVertices * 2);
+
+		data->m_normals.resize(numVertices);
+		data->m_tangents.resize(numVertices);
+		data->m_texCoords.resize(numVertices);
+
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			const int16_t* packed = &packedNormalTangents[i * 4];
+
+			data->m_normals[i] = octDecode(Vec2(fromSnorm16(packed[0]), fromSnorm16(packed[1])));
+
+			Vec3 tangent = octDecode(Vec2(fromSnorm16(packed[2]), fromSnorm16(packed[3])));
+			data->m_tangents[i] = Vec4(tangent, (packed[3] & 1) ? -1.f : 1.f);
+
+			data->m_texCoords[i] = Vec2(halfToFloat(packedTexCoords[i * 2 + 0]), halfToFloat(packedTexCoords[i * 2 + 1]));
+		}
+
+		if (data->m_vertexFormat == EVertexFormat::PackedPositions)
+		{
+			const ArrayView<uint16_t> packedPositions = MeshData::getStream(data->m_packedPositions, data->m_packedPositionsView);
+			assert(packedPositions.size() == numVertices * 4);
+
+			data->m_vertices.resize(numVertices);
+
+			for (size_t i = 0; i < numVertices; ++i)
+			{
+				const uint16_t* packed = &packedPositions[i * 4];
+				Vec3 relative(fromUnorm16(packed[0]), fromUnorm16(packed[1]), fromUnorm16(packed[2]));
+				data->m_vertices[i] = data->m_boundsMin + relative * data->m_boundsExtent;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Math/Vec2.hpp>
+#include <Math/Vec3.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	struct MeshData;
+	enum class EVertexFormat : uint8_t;
+
+	// Maps a unit vector onto the [-1, 1] square of an octahedron folded out flat.
+	Vec2 octEncode(const Vec3& unitVector);
+
+	// Inverse of octEncode(), the result is normalized.
+	Vec3 octDecode(const Vec2& encoded);
+
+	// Clamps to [-1, 1] and rounds the same way the GPU reverses snorm16 / unorm16 attributes.
+	int16_t toSnorm16(float value);
+	float fromSnorm16(int16_t value);
+	uint16_t toUnorm16(float value);
+	float fromUnorm16(uint16_t value);
+
+	// IEEE 754 half precision, rounded to nearest even. Out of range values become infinity.
+	uint16_t floatToHalf(float value);
+	float halfToFloat(uint16_t value);
+
+	// Largest differences between the float attributes and their dequantized versions.
+	struct VertexQuantizeError
+	{
+		VertexQuantizeError()
+			: m_maxPositionError(0.f)
+			, m_maxNormalErrorDeg(0.f)
+			, m_maxTangentErrorDeg(0.f)
+			, m_maxTexCoordError(0.f)
+			, m_numHandednessErrors(0)
+		{}
+
+		float m_maxPositionError; // Object space distance.
+		float m_maxNormalErrorDeg;
+		float m_maxTangentErrorDeg;
+		float m_maxTexCoordError; // Largest error of u or v.
+		size_t m_numHandednessErrors;
+	};
+
+	// Encodes the float attributes of data into the packed streams of format, see EVertexFormat. 
+	// The float streams are replaced with their dequantized values so the CPU side matches 
+	// what the GPU reads. Returns the error introduced by the encoding.
+	VertexQuantizeError quantizeVertices(MeshData* data, EVertexFormat format);
+
+	// Fills the float streams of a packed mesh from its packed streams, e.g. after loading.
+	void unpackVertices(MeshData* data);
+}
\ No newline at end of file
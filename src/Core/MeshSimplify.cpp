@@ -0,0 +1,292 @@
+#include "MeshSimplify.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <Math/Vec3.hpp>
+
+namespace Phoenix
+{
+	namespace
+	{
+		// Symmetric 4x4 matrix of the summed squared distances to a set of planes, 
+		// weighted by the area of the triangles they came from.
+		struct Quadric
+		{
+			double a2, ab, ac, ad;
+			double b2, bc, bd;
+			double c2, cd;
+			double d2;
+			double weight;
+
+			void addPlane(const Vec3& normal, float d, double planeWeight)
+			{
+				double a = normal.x, b = normal.y, c = normal.z;
+
+				a2 += planeWeight * a * a; ab += planeWeight * a * b; ac += planeWeight * a * c; ad += planeWeight * a * d;
+				b2 += planeWeight * b * b; bc += planeWeight * b * c; bd += planeWeight * b * d;
+				c2 += planeWeight * c * c; cd += planeWeight * c * d;
+				d2 += planeWeight * d * d;
+				weight += planeWeight;
+			}
+
+			void add(const Quadric& other)
+			{
+				a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+				b2 += other.b2; bc += other.bc; bd += other.bd;
+				c2 += other.c2; cd += other.cd;
+				d2 += other.d2;
+				weight += other.weight;
+			}
+
+			// Weighted sum of the squared distances of p to the planes.
+			double evaluate(const Vec3& p) const
+			{
+				double x = p.x, y = p.y, z = p.z;
+
+				double result = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+							  + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+							  + c2 * z * z + 2.0 * cd * z
+							  + d2;
+
+				return result > 0.0 ? result : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			uint32_t m_from;
+			uint32_t m_to;
+			float m_cost; // Mean squared distance to the planes of both vertices.
+		};
+
+		uint64_t edgeKey(uint32_t a, uint32_t b)
+		{
+			return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+		}
+
+		Vec3 triangleNormal(const Vec3& p0, const Vec3& p1, const Vec3& p2)
+		{
+			return (p1 - p0).cross(p2 - p0);
+		}
+	}
+
+	size_t simplifyMesh(const Vec3* positions, size_t numVertices, const uint32_t* indices, size_t numIndices,
+						size_t targetNumIndices, float maxError, uint32_t* outIndices, float* outError)
+	{
+		assert(numIndices % 3 == 0);
+
+		memcpy(outIndices, indices, numIndices * sizeof(uint32_t));
+		*outError = 0.f;
+
+		std::vector<Quadric> quadrics(numVertices);
+		memset(quadrics.data(), 0, numVertices * sizeof(Quadric));
+
+		for (size_t i = 0; i < numIndices; i += 3)
+		{
+			const Vec3& p0 = positions[indices[i + 0]];
+			Vec3 normal = triangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+
+			float doubleArea = normal.length();
+			if (doubleArea <= 0.f)
+			{
+				continue;
+			}
+
+			normal /= doubleArea;
+			float d = -normal.dot(p0);
+
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				quadrics[indices[i + corner]].addPlane(normal, d, 0.5 * doubleArea);
+			}
+		}
+
+		// Vertices on edges without exactly two triangles stay where they are.
+		std::vector<bool> bLocked(numVertices, false);
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeUses;
+			edgeUses.reserve(numIndices);
+
+			for (size_t i = 0; i < numIndices; i += 3)
+			{
+				for (size_t corner = 0; corner < 3; ++corner)
+				{
+					edgeUses[edgeKey(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+				}
+			}
+
+			for (const auto& edge : edgeUses)
+			{
+				if (edge.second != 2)
+				{
+					bLocked[static_cast<uint32_t>(edge.first >> 32)] = true;
+					bLocked[static_cast<uint32_t>(edge.first)] = true;
+				}
+			}
+		}
+
+		const float maxCost = maxError * maxError;
+
+		size_t numResultIndices = numIndices;
+		std::vector<uint32_t> remap(numVertices);
+		std::vector<bool> bTouched(numVertices);
+		std::vector<uint32_t> adjacencyOffsets(numVertices + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+
+		while (numResultIndices > targetNumIndices)
+		{
+			size_t numTriangles = numResultIndices / 3;
+
+			// Triangles around each vertex.
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (size_t i = 0; i < numResultIndices; ++i)
+			{
+				adjacencyOffsets[outIndices[i] + 1]++;
+			}
+
+			for (size_t v = 0; v < numVertices; ++v)
+			{
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+
+			adjacency.resize(numResultIndices);
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < numResultIndices; ++i)
+			{
+				adjacency[fill[outIndices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+
+			// Every directed edge is a collapse candidate, onto the other end's position.
+			collapses.clear();
+			for (size_t i = 0; i < numResultIndices; i += 3)
+			{
+				for (size_t corner = 0; corner < 3; ++corner)
+				{
+					uint32_t from = outIndices[i + corner];
+					uint32_t to = outIndices[i + (corner + 1) % 3];
+
+					for (int direction = 0; direction < 2; ++direction)
+					{
+						if (!bLocked[from])
+						{
+							Quadric combined = quadrics[from];
+							combined.add(quadrics[to]);
+
+							float cost = combined.weight > 0.0 ? static_cast<float>(combined.evaluate(positions[to]) / combined.weight) : 0.f;
+							collapses.push_back({ from, to, cost });
+						}
+
+						std::swap(from, to);
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+			{
+				return a.m_cost < b.m_cost;
+			});
+
+			for (size_t v = 0; v < numVertices; ++v)
+			{
+				remap[v] = static_cast<uint32_t>(v);
+			}
+
+			std::fill(bTouched.begin(), bTouched.end(), false);
+
+			size_t targetTriangles = targetNumIndices / 3;
+			size_t numApplied = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (numTriangles <= targetTriangles || collapse.m_cost > maxCost)
+				{
+					break;
+				}
+
+				// Each vertex takes part in at most one collapse per pass, which keeps the adjacency valid.
+				if (bTouched[collapse.m_from] || bTouched[collapse.m_to])
+				{
+					continue;
+				}
+
+				const Vec3& target = positions[collapse.m_to];
+				bool bFlips = false;
+				size_t numRemoved = 0;
+
+				for (uint32_t a = adjacencyOffsets[collapse.m_from]; a < adjacencyOffsets[collapse.m_from + 1]; ++a)
+				{
+					const uint32_t* triangle = &outIndices[adjacency[a] * 3];
+
+					if (triangle[0] == collapse.m_to || triangle[1] == collapse.m_to || triangle[2] == collapse.m_to)
+					{
+						numRemoved++;
+						continue;
+					}
+
+					// Reject collapses that turn a surviving triangle over.
+					Vec3 before[3];
+					Vec3 after[3];
+					for (size_t corner = 0; corner < 3; ++corner)
+					{
+						before[corner] = positions[remap[triangle[corner]]];
+						after[corner] = triangle[corner] == collapse.m_from ? target : before[corner];
+					}
+
+					Vec3 normalBefore = triangleNormal(before[0], before[1], before[2]);
+					Vec3 normalAfter = triangleNormal(after[0], after[1], after[2]);
+
+					if (normalBefore.dot(normalAfter) <= 0.f)
+					{
+						bFlips = true;
+						break;
+					}
+				}
+
+				if (bFlips)
+				{
+					continue;
+				}
+
+				remap[collapse.m_from] = collapse.m_to;
+				quadrics[collapse.m_to].add(quadrics[collapse.m_from]);
+				bTouched[collapse.m_from] = true;
+				bTouched[collapse.m_to] = true;
+
+				numTriangles -= std::min(numRemoved, numTriangles);
+				*outError = std::max(*outError, sqrtf(collapse.m_cost));
+				numApplied++;
+			}
+
+			if (numApplied == 0)
+			{
+				break;
+			}
+
+			// Apply the collapses and drop the triangles that became degenerate.
+			size_t writeIndex = 0;
+			for (size_t i = 0; i < numResultIndices; i += 3)
+			{
+				uint32_t v0 = remap[outIndices[i + 0]];
+				uint32_t v1 = remap[outIndices[i + 1]];
+				uint32_t v2 = remap[outIndices[i + 2]];
+
+				if (v0 != v1 && v1 != v2 && v0 != v2)
+				{
+					outIndices[writeIndex++] = v0;
+					outIndices[writeIndex++] = v1;
+					outIndices[writeIndex++] = v2;
+				}
+			}
+
+			numResultIndices = writeIndex;
+		}
+
+		return numResultIndices;
+	}
+}
\ No newline at end of file
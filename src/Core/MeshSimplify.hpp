@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	class Vec3;
+
+	// Reduces the triangles of an index list towards targetNumIndices with quadric error metric edge 
+	// collapses (Garland and Heckbert). Vertices only collapse onto other vertices of the list, so
+	// the result keeps addressing the same vertex buffer. Vertices on open or non-manifold edges are 
+	// kept in place, which preserves holes, uv seams and the borders to other material ranges.
+	// Stops early once a collapse would move the surface more than maxError. Writes the remaining
+	// triangles to outIndices (numIndices large) and returns their index count. outError receives
+	// the largest error of the applied collapses, as an object space distance.
+	size_t simplifyMesh(const Vec3* positions, size_t numVertices, const uint32_t* indices, size_t numIndices,
+						size_t targetNumIndices, float maxError, uint32_t* outIndices, float* outError);
+}
\ No newline at end of file
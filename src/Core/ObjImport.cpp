@@ -7,6 +7,9 @@
 #include <Core/Texture.hpp>
 #include <Core/Material.hpp>
 #include <Core/Mesh.hpp>
+#include <Core/MeshOptimize.hpp>
+#include <Core/MeshLod.hpp>
+#include <Core/MeshQuantize.hpp>
 #include <Core/AssetRegistry.hpp>
 
 #include <algorithm>
@@ -32,7 +35,7 @@ namespace Phoenix
 		std::string m_normalTex;
 		std::string m_metallicTex;
 
-		size_t m_vertexFrom;
+		size_t m_indexFrom;
 	};
 
 	struct MeshImport
@@ -43,6 +46,7 @@ namespace Phoenix
 	};
 
 	// Converts the mesh into a format usable by rendering APIs i.e. creates linear buffers that have a complete set of values for each vertex.
+	// The buffers are not indexed yet, every face corner gets its own vertex.
 	MeshImport convertForRenderApiVNT(float* vertices, float* normals, float* uvs, const tinyobj::shape_t& shape, const std::vector<tinyobj::material_t>& materials)
 	{
 		MeshImport mesh;
@@ -77,7 +81,7 @@ namespace Phoenix
 				matImport.m_roughnessTex = mtl.specular_highlight_texname;
 				matImport.m_metallicTex = mtl.ambient_texname;
 				matImport.m_normalTex = mtl.bump_texname;
-				matImport.m_vertexFrom = indexOffset;
+				matImport.m_indexFrom = indexOffset;
 
 				matImport.m_name = mtl.name.c_str();
 			}
@@ -199,7 +203,7 @@ namespace Phoenix
 
 		for (const MaterialImport& matImport : import.m_matImports)
 		{
-			outMesh->m_vertexFrom[matIdx] = matImport.m_vertexFrom;
+			outMesh->m_indexFrom[matIdx] = matImport.m_indexFrom;
 
 			Material* material = resources.assets->getMaterial(matImport.m_name.c_str());
 
@@ -222,7 +226,7 @@ namespace Phoenix
 
 		if (matIdx == 0)
 		{
-			outMesh->m_vertexFrom[matIdx] = 0;
+			outMesh->m_indexFrom[matIdx] = 0;
 			outMesh->m_materials[matIdx] = resources.assets->getMaterial(g_defaultMaterialPath);
 			matIdx++;
 		}
@@ -231,7 +235,7 @@ namespace Phoenix
 	}
 
 	// Loads the.obj file and its mtl(s) and converts the mesh into a format drawable by our renderer.
-	std::vector<MeshImport> loadObj(const char* filename, const char* mtlDir)
+	std::vector<MeshImport> loadObj(const char* filename, const char* mtlDir, EVertexFormat vertexFormat)
 	{
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
@@ -255,6 +259,44 @@ namespace Phoenix
 		for (const tinyobj::shape_t& shape : shapes)
 		{
 			MeshImport submesh = convertForRenderApiVNT(attrib.vertices.data(), attrib.normals.data(), attrib.texcoords.data(), shape, materials);
+			
+			MeshData& data = submesh.m_meshData;
+			size_t numCorners = data.m_numVertices;
+			size_t expandedBytes = data.getSizeBytes();
+
+			// Face corners keep their order as indices, so material ranges now address the index buffer.
+			weldVertices(&data);
+
+			Logger::logf("Welded mesh %s: %zu -> %zu vertices, %zu -> %zu bytes (%zu bit indices)",
+				submesh.m_name.c_str(), numCorners, data.m_numVertices, expandedBytes, data.getSizeBytes(), data.getIndexSizeBytes() * 8);
+
+			// Triangles are only reordered within their material's range.
+			std::vector<size_t> rangeStarts;
+			for (const MaterialImport& matImport : submesh.m_matImports)
+			{
+				rangeStarts.push_back(matImport.m_indexFrom);
+			}
+
+			if (rangeStarts.empty())
+			{
+				rangeStarts.push_back(0);
+			}
+
+			MeshOptimizeStats stats = optimizeMesh(&data, rangeStarts.data(), rangeStarts.size());
+
+			Logger::logf("Optimized mesh %s: ACMR %.3f -> %.3f", submesh.m_name.c_str(), stats.m_acmrBefore, stats.m_acmrAfter);
+
+			if (vertexFormat != EVertexFormat::Float)
+			{
+				size_t floatVertexBytes = data.m_numVertices * data.getVertexSizeBytes();
+				VertexQuantizeError error = quantizeVertices(&data, vertexFormat);
+				size_t packedVertexBytes = data.m_numVertices * data.getVertexSizeBytes();
+
+				Logger::logf("Packed mesh %s: %zu -> %zu vertex bytes (%zu bytes per vertex), max error position %f, normal %.3f deg, tangent %.3f deg, uv %f, %zu flipped handedness",
+					submesh.m_name.c_str(), floatVertexBytes, packedVertexBytes, data.getVertexSizeBytes(), error.m_maxPositionError, 
+					error.m_maxNormalErrorDeg, error.m_maxTangentErrorDeg, error.m_maxTexCoordError, error.m_numHandednessErrors);
+			}
+
 			submeshes.push_back(submesh);
 		}
 
@@ -262,9 +304,9 @@ namespace Phoenix
 	}
 
 	// Loads the .obj file and its mtl(s), converts the mesh into a format drawable by our renderer and creates the GPU resources.
-	std::vector<StaticMesh*> importObjContents(const char* assetPath, const char* mtlPath, InitResources resources)
+	std::vector<StaticMesh*> importObjContents(const char* assetPath, const char* mtlPath, InitResources resources, EVertexFormat vertexFormat)
 	{
-		std::vector<MeshImport> imports = loadObj(assetPath, mtlPath);
+		std::vector<MeshImport> imports = loadObj(assetPath, mtlPath, vertexFormat);
 
 		std::vector<StaticMesh*> meshes;
 
@@ -276,14 +318,17 @@ namespace Phoenix
 			mesh->m_name = import.m_name;
 			mesh->m_data = std::move(import.m_meshData);
 
-			createMeshBuffers(mesh, resources.device);
+			// LODs are generated per material range, so they need the ranges set up by the materials.
 			createMaterials(import, mesh, mtlPath, resources);
+			computeMeshBounds(mesh);
+			generateLods(mesh);
+			createMeshBuffers(mesh, resources.device);
 		}
 
 		return meshes;
 	}
 
-	std::vector<StaticMesh*> importObj(const char* path, IRIDevice* renderDevice, IRIContext* renderContext, AssetRegistry* assets)
+	std::vector<StaticMesh*> importObj(const char* path, IRIDevice* renderDevice, IRIContext* renderContext, AssetRegistry* assets, EVertexFormat vertexFormat)
 	{
 		const char* fileDot = strrchr(path, '.');
 		size_t pathLen = strlen(path);
@@ -304,7 +349,7 @@ namespace Phoenix
 
 			InitResources resources{ renderContext, renderDevice, assets };
 
-			return importObjContents(path, pathToAsset.c_str(), resources);
+			return importObjContents(path, pathToAsset.c_str(), resources, vertexFormat);
 		}
 		else
 		{
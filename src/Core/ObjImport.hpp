@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <stdint.h>
 
 namespace Phoenix
 {
@@ -8,6 +9,8 @@ namespace Phoenix
 	class IRIDevice;
 	class IRIContext;
 	class AssetRegistry;
+	enum class EVertexFormat : uint8_t;
 
-	std::vector<StaticMesh*> importObj(const char* path, IRIDevice* renderDevice, IRIContext* renderContext, AssetRegistry* assets);
+	// Packed vertex formats are encoded once at import and stored like that in the mesh assets.
+	std::vector<StaticMesh*> importObj(const char* path, IRIDevice* renderDevice, IRIContext* renderContext, AssetRegistry* assets, EVertexFormat vertexFormat);
 }
\ No newline at end of file
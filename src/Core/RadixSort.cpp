@@ -0,0 +1,82 @@
+#include "RadixSort.hpp"
+
+#include <string.h>
+
+namespace Phoenix
+{
+	void radixSort(uint64_t* keys, uint32_t* values, uint64_t* tempKeys, uint32_t* tempValues, size_t count)
+	{
+		enum
+		{
+			DIGIT_BITS = 8,
+			NUM_BUCKETS = 1 << DIGIT_BITS,
+			NUM_PASSES = 64 / DIGIT_BITS
+		};
+
+		if (count < 2)
+		{
+			return;
+		}
+
+		// Build the histograms for all digits in a single read of the keys.
+		size_t histograms[NUM_PASSES][NUM_BUCKETS];
+		memset(histograms, 0, sizeof(histograms));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t key = keys[i];
+
+			for (size_t pass = 0; pass < NUM_PASSES; ++pass)
+			{
+				histograms[pass][(key >> (pass * DIGIT_BITS)) & (NUM_BUCKETS - 1)]++;
+			}
+		}
+
+		uint64_t* srcKeys = keys;
+		uint32_t* srcValues = values;
+		uint64_t* dstKeys = tempKeys;
+		uint32_t* dstValues = tempValues;
+
+		for (size_t pass = 0; pass < NUM_PASSES; ++pass)
+		{
+			size_t* histogram = histograms[pass];
+			size_t shift = pass * DIGIT_BITS;
+
+			// All keys share this digit, the pass would not change the order.
+			if (histogram[(srcKeys[0] >> shift) & (NUM_BUCKETS - 1)] == count)
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+			{
+				size_t bucketSize = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketSize;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint64_t key = srcKeys[i];
+				size_t dst = histogram[(key >> shift) & (NUM_BUCKETS - 1)]++;
+				dstKeys[dst] = key;
+				dstValues[dst] = srcValues[i];
+			}
+
+			uint64_t* swapKeys = srcKeys;
+			srcKeys = dstKeys;
+			dstKeys = swapKeys;
+
+			uint32_t* swapValues = srcValues;
+			srcValues = dstValues;
+			dstValues = swapValues;
+		}
+
+		if (srcKeys != keys)
+		{
+			memcpy(keys, srcKeys, sizeof(uint64_t) * count);
+			memcpy(values, srcValues, sizeof(uint32_t) * count);
+		}
+	}
+}
\ No newline at end of file
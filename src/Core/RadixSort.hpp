@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	// Sorts count keys in ascending order and applies the same permutation to values.
+	// The sort is a stable LSD radix sort over 8 bit digits. Digits that are identical
+	// for all keys are skipped, so keys that only use a few of their bits sort faster.
+	// tempKeys and tempValues must each be able to hold count elements.
+	void radixSort(uint64_t* keys, uint32_t* values, uint64_t* tempKeys, uint32_t* tempValues, size_t count);
+}
\ No newline at end of file
@@ -67,4 +67,12 @@ namespace Phoenix
 		}
 	}
 
+	void serializePadding(Archive* ar, size_t alignment)
+	{
+		uint8_t zeros[SERIAL_STREAM_ALIGNMENT] = {};
+		assert(alignment <= sizeof(zeros));
+
+		const size_t numBytes = (alignment - ar->getOffset() % alignment) % alignment;
+		ar->serialize(zeros, numBytes);
+	}
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <Core/Serialize.hpp>
+#include <Memory/ArrayView.hpp>
 
+#include <assert.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -44,4 +47,68 @@ namespace Phoenix
 			ar->serialize(vector.data(), sizeof(T) * size);
 		}
 	}
+
+	enum
+	{
+		// Elements written with serializeAligned() start at a multiple of this from the start of the archive.
+		SERIAL_STREAM_ALIGNMENT = 16
+	};
+
+	// Writes zeros up to the next multiple of alignment from the start of the archive, skips them when reading.
+	void serializePadding(Archive* ar, size_t alignment);
+
+	// Like serialize(ar, vector), but the elements are aligned in the archive so they can be
+	// read in place with serializeView().
+	template <class T>
+	static void serializeAligned(Archive* ar, std::vector<T>& vector)
+	{
+		static_assert(std::is_standard_layout<T>::value, "T should be standard layout.");
+
+		size_t size = vector.size();
+		serialize(ar, size);
+		serializePadding(ar, SERIAL_STREAM_ALIGNMENT);
+
+		if (ar->isReading())
+		{
+			vector.resize(size);
+		}
+
+		ar->serialize(vector.data(), sizeof(T) * size);
+	}
+
+	// Reads elements written by serializeAligned() without copying them, the view points into the
+	// archive and is valid until the archive is destroyed. Elements that are not aligned for T in
+	// memory are copied into storage and viewed there instead.
+	template <class T>
+	static void serializeView(ReadArchive* ar, std::vector<T>& storage, ArrayView<T>& view)
+	{
+		static_assert(std::is_standard_layout<T>::value, "T should be standard layout.");
+
+		size_t size = 0;
+		serialize(ar, size);
+		serializePadding(ar, SERIAL_STREAM_ALIGNMENT);
+
+		const size_t numBytes = sizeof(T) * size;
+		const uint8_t* elements = ar->m_data + ar->m_numBytesRead;
+
+		if (ar->m_numBytesRead + numBytes > ar->m_size)
+		{
+			assert(false);
+			view = ArrayView<T>();
+			return;
+		}
+
+		if (reinterpret_cast<uintptr_t>(elements) % alignof(T) == 0)
+		{
+			storage.clear();
+			view = ArrayView<T>(reinterpret_cast<const T*>(elements), size);
+			ar->m_numBytesRead += numBytes;
+		}
+		else
+		{
+			storage.resize(size);
+			ar->serialize(storage.data(), numBytes);
+			view = ArrayView<T>(storage);
+		}
+	}
 }
\ No newline at end of file
@@ -6,11 +6,19 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 #include <Core/Logger.hpp>
+#include <Core/WorkerPool.hpp>
 
 namespace Phoenix
 {
+	static EReadMode s_defaultReadMode = EReadMode::Mapped;
+	static ECompression s_defaultCompression = ECompression::None;
+	static WorkerPool* s_decompressionPool = nullptr;
+
 	void ReadArchive::serialize(void* data, size_t numBytes)
 	{
 		if (m_numBytesRead + numBytes > m_size)
@@ -57,7 +65,7 @@ namespace Phoenix
 		memset(outAr->m_data, 0, initialBytes);
 	}
 
-	EArchiveError writeArchiveToDisk(const char* path, const WriteArchive& ar)
+	static EArchiveError writeFile(const char* path, const uint8_t* data, size_t numBytes)
 	{
 		EArchiveError err = EArchiveError::NoError;
 
@@ -69,9 +77,9 @@ namespace Phoenix
 			return EArchiveError::Open;
 		}
 
-		size_t bytesWrittenToDisk = fwrite(ar.m_data, 1, ar.m_numBytesWritten, file);
+		size_t bytesWrittenToDisk = fwrite(data, 1, numBytes, file);
 
-		if (bytesWrittenToDisk != ar.m_numBytesWritten)
+		if (bytesWrittenToDisk != numBytes)
 		{
 			Logger::errorf("Failed writing archive %s to disk, file is likely invalid.", path);
 			err = EArchiveError::Write;
@@ -79,11 +87,118 @@ namespace Phoenix
 
 		fclose(file);
 
-		return EArchiveError::NoError;
+		return err;
+	}
+
+	static size_t getShuffledElements(size_t numBytes)
+	{
+		return numBytes / sizeof(float);
+	}
+
+	static void compressArchive(const uint8_t* data, size_t numBytes, ECompression compression, WriteArchive* outAr)
+	{
+		CompressedArchiveHeader header;
+		header.m_magic = COMPRESSED_ARCHIVE_MAGIC;
+		header.m_version = COMPRESSED_ARCHIVE_VERSION;
+		header.m_rawSize = numBytes;
+		header.m_blockSize = COMPRESSED_BLOCK_SIZE;
+		header.m_numBlocks = static_cast<uint32_t>((numBytes + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE);
+
+		std::vector<CompressedBlock> blocks(header.m_numBlocks);
+
+		createWriteArchive(0, outAr);
+		outAr->serialize(&header, sizeof(header));
+		outAr->serialize(blocks.data(), sizeof(CompressedBlock) * blocks.size());
+
+		std::vector<uint8_t> shuffled(COMPRESSED_BLOCK_SIZE);
+		std::vector<uint8_t> packed(COMPRESSED_BLOCK_SIZE);
+		std::vector<uint8_t> packedShuffled(COMPRESSED_BLOCK_SIZE);
+
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const uint8_t* raw = data + i * COMPRESSED_BLOCK_SIZE;
+			const size_t rawSize = std::min<size_t>(COMPRESSED_BLOCK_SIZE, numBytes - i * COMPRESSED_BLOCK_SIZE);
+
+			const size_t numElements = getShuffledElements(rawSize);
+			shuffleBytes(raw, shuffled.data(), numElements, sizeof(float));
+			memcpy(shuffled.data() + numElements * sizeof(float), raw + numElements * sizeof(float), rawSize - numElements * sizeof(float));
+
+			// Only smaller than the block is of use.
+			const size_t plainSize = compressBlock(raw, rawSize, packed.data(), rawSize - 1, compression);
+			const size_t shuffledSize = compressBlock(shuffled.data(), rawSize, packedShuffled.data(), rawSize - 1, compression);
+
+			CompressedBlock& block = blocks[i];
+			block.m_offset = outAr->m_numBytesWritten;
+
+			const uint8_t* bytes = raw;
+			block.m_size = static_cast<uint32_t>(rawSize);
+			block.m_flags = BLOCK_STORED;
+
+			if (plainSize != 0 && (shuffledSize == 0 || plainSize <= shuffledSize))
+			{
+				bytes = packed.data();
+				block.m_size = static_cast<uint32_t>(plainSize);
+				block.m_flags = 0;
+			}
+			else if (shuffledSize != 0)
+			{
+				bytes = packedShuffled.data();
+				block.m_size = static_cast<uint32_t>(shuffledSize);
+				block.m_flags = BLOCK_SHUFFLED;
+			}
+
+			outAr->serialize(const_cast<uint8_t*>(bytes), block.m_size);
+		}
+
+		memcpy(outAr->m_data + sizeof(header), blocks.data(), sizeof(CompressedBlock) * blocks.size());
+	}
+
+	EArchiveError writeArchiveToDisk(const char* path, const WriteArchive& ar)
+	{
+		return writeArchiveToDisk(path, ar, s_defaultCompression);
+	}
+
+	EArchiveError writeArchiveToDisk(const char* path, const WriteArchive& ar, ECompression compression)
+	{
+		if (compression == ECompression::None)
+		{
+			return writeFile(path, ar.m_data, ar.m_numBytesWritten);
+		}
+
+		WriteArchive compressed;
+		compressArchive(ar.m_data, ar.m_numBytesWritten, compression, &compressed);
+		const EArchiveError err = writeFile(path, compressed.m_data, compressed.m_numBytesWritten);
+		destroyArchive(compressed);
+		return err;
 	}
 
 	EArchiveError createReadArchive(const char* path, ReadArchive* outAr)
 	{
+		return createReadArchive(path, outAr, s_defaultReadMode);
+	}
+
+	// Empty and unreadable files fail to map, the copying path tells which it was.
+	static EArchiveError mapReadArchive(const char* path, ReadArchive* outAr)
+	{
+		if (!Platform::mapFile(path, &outAr->m_mappedFile))
+		{
+			return EArchiveError::Open;
+		}
+
+		outAr->m_data = const_cast<uint8_t*>(outAr->m_mappedFile.m_data);
+		outAr->m_size = outAr->m_mappedFile.m_size;
+		outAr->m_numBytesRead = 0;
+		return EArchiveError::NoError;
+	}
+
+	// The file as it is on disk.
+	static EArchiveError loadArchive(const char* path, ReadArchive* outAr, EReadMode mode)
+	{
+		if (mode == EReadMode::Mapped && mapReadArchive(path, outAr) == EArchiveError::NoError)
+		{
+			return EArchiveError::NoError;
+		}
+
 		EArchiveError err = EArchiveError::NoError;
 
 		FILE* file = fopen(path, "rb");
@@ -108,8 +223,6 @@ namespace Phoenix
 		outAr->m_numBytesRead = 0;
 		outAr->m_size = length;
 
-		memset(outAr->m_data, 0, length);
-
 		fseek(file, 0, SEEK_SET);
 		size_t numBytesRead = fread(outAr->m_data, 1, length, file);
 
@@ -129,11 +242,243 @@ namespace Phoenix
 		return err;
 	}
 
+	static EArchiveError parseCompressedArchive(const ReadArchive& file, CompressedArchiveHeader* outHeader, const CompressedBlock** outBlocks)
+	{
+		if (file.m_size < sizeof(CompressedArchiveHeader))
+		{
+			return EArchiveError::NotCompressed;
+		}
+
+		memcpy(outHeader, file.m_data, sizeof(CompressedArchiveHeader));
+
+		if (outHeader->m_magic != COMPRESSED_ARCHIVE_MAGIC)
+		{
+			return EArchiveError::NotCompressed;
+		}
+
+		// The raw size is allocated in one go when decompressing, it has to fill exactly the blocks
+		// in the table, which has to fit the file. Neither product overflows, both factors are 32 bit.
+		const uint64_t blocksSize = uint64_t(outHeader->m_numBlocks) * outHeader->m_blockSize;
+		const uint64_t tableSize = uint64_t(outHeader->m_numBlocks) * sizeof(CompressedBlock);
+
+		if (outHeader->m_version != COMPRESSED_ARCHIVE_VERSION || outHeader->m_blockSize == 0 || outHeader->m_blockSize > MAX_COMPRESSED_BLOCK_SIZE
+			|| outHeader->m_rawSize > blocksSize || (outHeader->m_numBlocks > 0 && outHeader->m_rawSize <= blocksSize - outHeader->m_blockSize)
+			|| tableSize > file.m_size - sizeof(CompressedArchiveHeader))
+		{
+			return EArchiveError::Corrupt;
+		}
+
+		*outBlocks = reinterpret_cast<const CompressedBlock*>(file.m_data + sizeof(CompressedArchiveHeader));
+
+		for (size_t i = 0; i < outHeader->m_numBlocks; ++i)
+		{
+			const CompressedBlock& block = (*outBlocks)[i];
+
+			if (block.m_offset > file.m_size || block.m_size > file.m_size - block.m_offset)
+			{
+				return EArchiveError::Corrupt;
+			}
+		}
+
+		return EArchiveError::NoError;
+	}
+
+	static bool decompressArchiveBlock(const uint8_t* file, const CompressedBlock& block, uint8_t* out, size_t rawSize)
+	{
+		const uint8_t* src = file + block.m_offset;
+
+		if (block.m_flags & BLOCK_STORED)
+		{
+			if (block.m_size != rawSize)
+			{
+				return false;
+			}
+
+			memcpy(out, src, rawSize);
+			return true;
+		}
+
+		if (!(block.m_flags & BLOCK_SHUFFLED))
+		{
+			return decompressBlock(src, block.m_size, out, rawSize);
+		}
+
+		static thread_local std::vector<uint8_t> t_shuffled;
+		t_shuffled.resize(rawSize);
+
+		if (!decompressBlock(src, block.m_size, t_shuffled.data(), rawSize))
+		{
+			return false;
+		}
+
+		const size_t numElements = getShuffledElements(rawSize);
+		unshuffleBytes(t_shuffled.data(), out, numElements, sizeof(float));
+		memcpy(out + numElements * sizeof(float), t_shuffled.data() + numElements * sizeof(float), rawSize - numElements * sizeof(float));
+		return true;
+	}
+
+	// Replaces the compressed bytes of the archive with the decompressed ones.
+	static EArchiveError decompressArchive(const char* path, const CompressedArchiveHeader& header, const CompressedBlock* blocks, ReadArchive* ar)
+	{
+		const size_t rawSize = static_cast<size_t>(header.m_rawSize);
+		uint8_t* raw = new uint8_t[rawSize];
+		std::atomic<bool> bCorrupt(false);
+
+		auto decompressBlocks = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const size_t offset = i * header.m_blockSize;
+				const size_t blockSize = std::min<size_t>(header.m_blockSize, rawSize - offset);
+
+				if (!decompressArchiveBlock(ar->m_data, blocks[i], raw + offset, blockSize))
+				{
+					bCorrupt = true;
+				}
+			}
+		};
+
+		if (s_decompressionPool && header.m_numBlocks > 1)
+		{
+			s_decompressionPool->parallelFor(header.m_numBlocks, 1, decompressBlocks);
+		}
+		else
+		{
+			decompressBlocks(0, header.m_numBlocks);
+		}
+
+		destroyArchive(*ar);
+
+		if (bCorrupt)
+		{
+			Logger::errorf("Compressed archive \"%s\" is corrupt.", path);
+			delete[] raw;
+			return EArchiveError::Corrupt;
+		}
+
+		if (rawSize == 0)
+		{
+			Logger::errorf("Archive \"%s\" is empty.", path);
+			delete[] raw;
+			return EArchiveError::ReadEmpty;
+		}
+
+		ar->m_data = raw;
+		ar->m_size = rawSize;
+		ar->m_numBytesRead = 0;
+		return EArchiveError::NoError;
+	}
+
+	EArchiveError createReadArchive(const char* path, ReadArchive* outAr, EReadMode mode)
+	{
+		EArchiveError err = loadArchive(path, outAr, mode);
+
+		if (err != EArchiveError::NoError)
+		{
+			return err;
+		}
+
+		CompressedArchiveHeader header;
+		const CompressedBlock* blocks = nullptr;
+		err = parseCompressedArchive(*outAr, &header, &blocks);
+
+		if (err == EArchiveError::NotCompressed)
+		{
+			return EArchiveError::NoError;
+		}
+
+		if (err != EArchiveError::NoError)
+		{
+			Logger::errorf("Compressed archive \"%s\" is corrupt.", path);
+			destroyArchive(*outAr);
+			return err;
+		}
+
+		return decompressArchive(path, header, blocks, outAr);
+	}
+
+	EArchiveError openCompressedArchive(const char* path, CompressedArchive* outAr)
+	{
+		EArchiveError err = loadArchive(path, &outAr->m_file, EReadMode::Mapped);
+
+		if (err != EArchiveError::NoError)
+		{
+			return err;
+		}
+
+		err = parseCompressedArchive(outAr->m_file, &outAr->m_header, &outAr->m_blocks);
+
+		if (err != EArchiveError::NoError)
+		{
+			closeCompressedArchive(*outAr);
+		}
+
+		return err;
+	}
+
+	size_t getCompressedBlockSize(const CompressedArchive& ar, size_t block)
+	{
+		assert(block < ar.m_header.m_numBlocks);
+		return std::min<size_t>(ar.m_header.m_blockSize, static_cast<size_t>(ar.m_header.m_rawSize) - block * ar.m_header.m_blockSize);
+	}
+
+	bool readCompressedBlock(const CompressedArchive& ar, size_t block, uint8_t* out)
+	{
+		return decompressArchiveBlock(ar.m_file.m_data, ar.m_blocks[block], out, getCompressedBlockSize(ar, block));
+	}
+
+	void closeCompressedArchive(CompressedArchive& ar)
+	{
+		destroyArchive(ar.m_file);
+		ar.m_file = ReadArchive();
+		ar.m_blocks = nullptr;
+	}
+
+	void setDefaultReadMode(EReadMode mode)
+	{
+		s_defaultReadMode = mode;
+	}
+
+	EReadMode getDefaultReadMode()
+	{
+		return s_defaultReadMode;
+	}
+
+	void setDefaultCompression(ECompression compression)
+	{
+		s_defaultCompression = compression;
+	}
+
+	ECompression getDefaultCompression()
+	{
+		return s_defaultCompression;
+	}
+
+	void setDecompressionPool(WorkerPool* pool)
+	{
+		s_decompressionPool = pool;
+	}
+
 	void destroyArchive(Archive& ar)
 	{
 		delete[] ar.m_data;
 	}
 
+	void destroyArchive(ReadArchive& ar)
+	{
+		if (ar.m_mappedFile.m_data)
+		{
+			Platform::unmapFile(&ar.m_mappedFile);
+		}
+		else
+		{
+			delete[] ar.m_data;
+		}
+
+		ar.m_data = nullptr;
+		ar.m_size = 0;
+	}
+
 	struct SerialTest
 	{
 		enum TestEnum
@@ -2,8 +2,13 @@
 
 #include <stdint.h>
 
+#include <Core/Compression.hpp>
+#include <Core/Windows/PlatformWindows.hpp>
+
 namespace Phoenix
 {
+	class WorkerPool;
+
 	// Represents a series of bytes which can be used to write or read data.
 	// Used to write and read binary data to/from disk.
 	struct Archive
@@ -19,18 +24,29 @@ namespace Phoenix
 		virtual void serialize(void* data, size_t numBytes) = 0;
 		virtual bool isReading() = 0;
 		virtual bool isWriting() = 0;
+
+		// Bytes read or written so far.
+		virtual size_t getOffset() = 0;
 	};
 
 	// Represents a series of bytes which may be read from sequentially.
 	struct ReadArchive : public Archive
 	{
+		ReadArchive()
+			: m_numBytesRead(0)
+		{}
+
 		size_t m_numBytesRead;
 
+		// Backs m_data when the archive was created with EReadMode::Mapped. m_data is read only then.
+		Platform::MappedFile m_mappedFile;
+
 		// Reads numBytes from the archive.
 		virtual void serialize(void* data, size_t numBytes) override;
 
 		virtual bool isReading() { return true; };
 		virtual bool isWriting() { return false; };
+		virtual size_t getOffset() { return m_numBytesRead; };
 	};
 
 	// Represents a series of bytes written into the archive.
@@ -48,6 +64,7 @@ namespace Phoenix
 
 		virtual bool isReading() { return false; };
 		virtual bool isWriting() { return true; };
+		virtual size_t getOffset() { return m_numBytesWritten; };
 	};
 
 	enum class EArchiveError
@@ -58,18 +75,108 @@ namespace Phoenix
 		Read,
 		ReadEmpty,
 		ReadEarlyEOF,
+		Corrupt, // A compressed archive that does not decompress.
+		NotCompressed,
 		NumErrorTypes
 	};
 
+	enum class EReadMode
+	{
+		Copy, // Reads the file into a buffer owned by the archive.
+		Mapped // Maps the file, reads come straight from the file cache without a copy.
+	};
+
 	//WriteArchive createWriteArchive(size_t initialBytes);
 	void createWriteArchive(size_t initialBytes, WriteArchive* outAr);
 
+	// Uses the default compression, see setDefaultCompression().
 	EArchiveError writeArchiveToDisk(const char* path, const WriteArchive& ar);
 
+	// Anything but ECompression::None writes a compressed archive, which createReadArchive()
+	// decompresses again.
+	EArchiveError writeArchiveToDisk(const char* path, const WriteArchive& ar, ECompression compression);
+
+	// Uses the default read mode, see setDefaultReadMode().
 	EArchiveError createReadArchive(const char* path, ReadArchive* outAr);
 
+	EArchiveError createReadArchive(const char* path, ReadArchive* outAr, EReadMode mode);
+
+	// Read mode of all archives created without one, EReadMode::Mapped unless changed.
+	void setDefaultReadMode(EReadMode mode);
+	EReadMode getDefaultReadMode();
+
+	// Compression of all archives written without one, ECompression::None unless changed.
+	void setDefaultCompression(ECompression compression);
+	ECompression getDefaultCompression();
+
+	// Compressed archives are decompressed on the pool when one is set, it has to outlive its use.
+	void setDecompressionPool(WorkerPool* pool);
+
+	// A compressed archive is a CompressedArchiveHeader, a CompressedBlock per block and the blocks.
+	// Every block holds COMPRESSED_BLOCK_SIZE bytes of the archive, the last one the rest, and is
+	// compressed on its own, so blocks can be decompressed in any order and on several threads.
+	// Blocks that do not get smaller are stored as they are. Blocks made of floats, such as the
+	// vertex streams of meshes, compress better with their bytes shuffled into planes first, see
+	// shuffleBytes(). The writer tries both and marks the blocks it shuffled.
+	enum
+	{
+		COMPRESSED_ARCHIVE_MAGIC = 0x41434850, // "PHCA"
+		COMPRESSED_ARCHIVE_VERSION = 1,
+		COMPRESSED_BLOCK_SIZE = 256 * 1024,
+		MAX_COMPRESSED_BLOCK_SIZE = 16 * COMPRESSED_BLOCK_SIZE // Headers with larger blocks are taken as corrupt.
+	};
+
+	enum ECompressedBlockFlags : uint32_t
+	{
+		BLOCK_STORED = 1 << 0,
+		BLOCK_SHUFFLED = 1 << 1 // Of 4 byte elements, trailing bytes that do not make one are not.
+	};
+
+	struct CompressedArchiveHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_rawSize;
+		uint32_t m_blockSize;
+		uint32_t m_numBlocks;
+	};
+
+	struct CompressedBlock
+	{
+		uint64_t m_offset; // From the start of the file.
+		uint32_t m_size;
+		uint32_t m_flags;
+	};
+
+	// Block by block access to a compressed archive, for consumers that start on the first blocks
+	// while later ones are still read or decompressed. The file stays mapped while open.
+	struct CompressedArchive
+	{
+		CompressedArchive()
+			: m_blocks(nullptr)
+		{}
+
+		ReadArchive m_file;
+		CompressedArchiveHeader m_header;
+		const CompressedBlock* m_blocks;
+	};
+
+	EArchiveError openCompressedArchive(const char* path, CompressedArchive* outAr);
+
+	// Size of the block once decompressed.
+	size_t getCompressedBlockSize(const CompressedArchive& ar, size_t block);
+
+	// Decompresses the block into out, which needs room for getCompressedBlockSize(). False if the
+	// block is corrupt. Blocks may be read from several threads at the same time.
+	bool readCompressedBlock(const CompressedArchive& ar, size_t block, uint8_t* out);
+
+	void closeCompressedArchive(CompressedArchive& ar);
+
 	void destroyArchive(Archive& ar);
 
+	// Unmaps mapped archives, frees the buffer of copied ones.
+	void destroyArchive(ReadArchive& ar);
+
 	namespace Tests
 	{
 		void runSerializeTests();
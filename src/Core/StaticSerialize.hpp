@@ -0,0 +1,258 @@
+#pragma once
+
+#include <Core/Serialize.hpp>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Declares the fields of a struct serializeValue() reads and writes, in order. Types without it
+// or a SerializeFields specialisation have to be trivially copyable and go through a single memcpy.
+#define PHI_SERIALIZE(...) \
+	typedef void PhiSerializeFields; \
+	\
+	template<class Ar> \
+	void serializeFields(Ar& ar) \
+	{ \
+		::Phoenix::serializeValues(ar, __VA_ARGS__); \
+	}
+
+namespace Phoenix
+{
+	// Static dispatch counterparts of ReadArchive and WriteArchive. They work on the buffer of one
+	// of those, so archives are still created, written to disk and destroyed as usual, but
+	// serialize() is inlined and whether the archive reads is known at compile time. The position
+	// is kept in the static archive while it exists and handed back when it is destroyed, the
+	// archive must not be used directly in between.
+	class StaticReadArchive
+	{
+	public:
+		explicit StaticReadArchive(ReadArchive* ar)
+			: m_ar(ar)
+			, m_data(ar->m_data)
+			, m_size(ar->m_size)
+			, m_offset(ar->m_numBytesRead)
+		{}
+
+		~StaticReadArchive()
+		{
+			m_ar->m_numBytesRead = m_offset;
+		}
+
+		StaticReadArchive(const StaticReadArchive&) = delete;
+		StaticReadArchive& operator=(const StaticReadArchive&) = delete;
+
+		static constexpr bool isReading() { return true; }
+
+		void serialize(void* data, size_t numBytes)
+		{
+			if (numBytes > m_size - m_offset)
+			{
+				assert(false);
+				return;
+			}
+
+			memcpy(data, m_data + m_offset, numBytes);
+			m_offset += numBytes;
+		}
+
+	private:
+		ReadArchive* m_ar;
+		const uint8_t* m_data;
+		size_t m_size;
+		size_t m_offset;
+	};
+
+	class StaticWriteArchive
+	{
+	public:
+		explicit StaticWriteArchive(WriteArchive* ar)
+			: m_ar(ar)
+			, m_data(ar->m_data)
+			, m_size(ar->m_size)
+			, m_offset(ar->m_numBytesWritten)
+		{}
+
+		~StaticWriteArchive()
+		{
+			m_ar->m_numBytesWritten = m_offset;
+		}
+
+		StaticWriteArchive(const StaticWriteArchive&) = delete;
+		StaticWriteArchive& operator=(const StaticWriteArchive&) = delete;
+
+		static constexpr bool isReading() { return false; }
+
+		void serialize(void* data, size_t numBytes)
+		{
+			if (numBytes > m_size - m_offset)
+			{
+				grow(numBytes);
+			}
+
+			memcpy(m_data + m_offset, data, numBytes);
+			m_offset += numBytes;
+		}
+
+	private:
+		void grow(size_t numBytes)
+		{
+			m_ar->m_numBytesWritten = m_offset;
+			m_ar->reserve(numBytes);
+			m_data = m_ar->m_data;
+			m_size = m_ar->m_size;
+		}
+
+		WriteArchive* m_ar;
+		uint8_t* m_data;
+		size_t m_size;
+		size_t m_offset;
+	};
+
+	// Runs serializeValue() through the virtual Archive, for code that only has one of those,
+	// such as Component::save() and load().
+	class DynamicArchive
+	{
+	public:
+		explicit DynamicArchive(Archive* ar)
+			: m_ar(ar)
+		{}
+
+		bool isReading() const { return m_ar->isReading(); }
+
+		void serialize(void* data, size_t numBytes)
+		{
+			m_ar->serialize(data, numBytes);
+		}
+
+	private:
+		Archive* m_ar;
+	};
+
+	template<class Ar, class T>
+	void serializeValue(Ar& ar, T& value);
+
+	// Same layout as serialize(Archive*, std::string&).
+	template<class Ar>
+	void serializeValue(Ar& ar, std::string& string);
+
+	// Same layout as serialize(Archive*, std::vector<T>&).
+	template<class Ar, class T>
+	void serializeValue(Ar& ar, std::vector<T>& vector);
+
+	template<class Ar>
+	void serializeValues(Ar& ar)
+	{}
+
+	template<class Ar, class T, class... Rest>
+	void serializeValues(Ar& ar, T& value, Rest&... rest)
+	{
+		serializeValue(ar, value);
+		serializeValues(ar, rest...);
+	}
+
+	// Declares the fields of a type from outside of it, for types whose header should not depend
+	// on serialization. A specialisation sets value and has a static serializeFields(ar, value),
+	// and has to be seen before the type is serialized.
+	template<class T>
+	struct SerializeFields
+	{
+		static const bool value = false;
+	};
+
+	template<class T>
+	struct HasSerializeMember
+	{
+		template<class U>
+		static char test(typename U::PhiSerializeFields*);
+
+		template<class U>
+		static int32_t test(...);
+
+		static const bool value = sizeof(test<T>(nullptr)) == sizeof(char);
+	};
+
+	template<class T>
+	struct HasSerializeFields
+	{
+		static const bool value = HasSerializeMember<T>::value || SerializeFields<T>::value;
+	};
+
+	template<class Ar, class T>
+	void serializeFieldsOf(Ar& ar, T& value, std::true_type /*bMember*/)
+	{
+		value.serializeFields(ar);
+	}
+
+	template<class Ar, class T>
+	void serializeFieldsOf(Ar& ar, T& value, std::false_type /*bMember*/)
+	{
+		SerializeFields<T>::serializeFields(ar, value);
+	}
+
+	template<class Ar, class T>
+	void serializeObject(Ar& ar, T& value, std::true_type /*bHasFields*/)
+	{
+		serializeFieldsOf(ar, value, std::integral_constant<bool, HasSerializeMember<T>::value>());
+	}
+
+	template<class Ar, class T>
+	void serializeObject(Ar& ar, T& value, std::false_type /*bHasFields*/)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "T needs PHI_SERIALIZE or has to be trivially copyable.");
+		ar.serialize(&value, sizeof(T));
+	}
+
+	template<class Ar, class T>
+	void serializeValue(Ar& ar, T& value)
+	{
+		serializeObject(ar, value, std::integral_constant<bool, HasSerializeFields<T>::value>());
+	}
+
+	template<class Ar>
+	void serializeValue(Ar& ar, std::string& string)
+	{
+		// The terminating zero is stored as well.
+		size_t length = string.size() + 1;
+		serializeValue(ar, length);
+
+		if (ar.isReading())
+		{
+			assert(length > 0);
+			string.resize(length);
+			ar.serialize(&string[0], length);
+			string.resize(strlen(string.c_str()));
+		}
+		else
+		{
+			ar.serialize(&string[0], length);
+		}
+	}
+
+	template<class Ar, class T>
+	void serializeValue(Ar& ar, std::vector<T>& vector)
+	{
+		size_t size = vector.size();
+		serializeValue(ar, size);
+
+		if (ar.isReading())
+		{
+			vector.resize(size);
+		}
+
+		if (!HasSerializeFields<T>::value && std::is_trivially_copyable<T>::value)
+		{
+			ar.serialize(vector.data(), sizeof(T) * size);
+			return;
+		}
+
+		for (T& element : vector)
+		{
+			serializeValue(ar, element);
+		}
+	}
+}
\ No newline at end of file
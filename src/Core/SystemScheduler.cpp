@@ -0,0 +1,159 @@
+#include "SystemScheduler.hpp"
+
+#include <assert.h>
+
+namespace Phoenix
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using Ms = std::chrono::duration<double, std::milli>;
+
+	SystemScheduler::SystemScheduler(World* world, WorkerPool* pool)
+		: m_world(world)
+		, m_pool(pool)
+		, m_numRunning(0)
+	{}
+
+	SystemScheduler::~SystemScheduler()
+	{
+		for (System* system : m_systems)
+		{
+			delete system;
+		}
+	}
+
+	int32_t SystemScheduler::addSystem(const char* name, ComponentMask reads, ComponentMask writes, SystemFunction fn)
+	{
+		System* system = new System();
+		system->m_name = name;
+		system->m_reads = reads;
+		system->m_writes = writes;
+		system->m_function = std::move(fn);
+		system->m_bEnabled = true;
+		system->m_numWaitingFor = 0;
+
+		m_systems.push_back(system);
+		m_timings.emplace_back();
+		m_timings.back().m_name = name;
+
+		return static_cast<int32_t>(m_systems.size() - 1);
+	}
+
+	void SystemScheduler::setEnabled(int32_t system, bool bEnabled)
+	{
+		m_systems[system]->m_bEnabled = bEnabled;
+	}
+
+	void SystemScheduler::buildGraph()
+	{
+		m_stats.m_numDependencies = 0;
+
+		for (System* system : m_systems)
+		{
+			system->m_dependencies.clear();
+			system->m_dependents.clear();
+		}
+
+		for (int32_t later = 0; later < static_cast<int32_t>(m_systems.size()); ++later)
+		{
+			System* b = m_systems[later];
+
+			if (!b->m_bEnabled)
+			{
+				continue;
+			}
+
+			for (int32_t earlier = 0; earlier < later; ++earlier)
+			{
+				System* a = m_systems[earlier];
+
+				const bool bConflict = (a->m_writes & (b->m_reads | b->m_writes)) || (a->m_reads & b->m_writes);
+
+				if (a->m_bEnabled && bConflict)
+				{
+					a->m_dependents.push_back(later);
+					b->m_dependencies.push_back(earlier);
+					++m_stats.m_numDependencies;
+				}
+			}
+
+			b->m_numWaitingFor = static_cast<int32_t>(b->m_dependencies.size());
+		}
+	}
+
+	void SystemScheduler::run()
+	{
+		buildGraph();
+
+		for (SystemTiming& timing : m_timings)
+		{
+			timing.m_bRan = false;
+		}
+
+		std::vector<double> busyMs;
+		m_pool->takeBusyTimes(&busyMs);
+		m_frameStart = Clock::now();
+
+		for (int32_t i = 0; i < static_cast<int32_t>(m_systems.size()); ++i)
+		{
+			if (m_systems[i]->m_bEnabled && m_systems[i]->m_dependencies.empty())
+			{
+				m_pool->submit([this, i]() { runSystem(i); }, &m_numRunning);
+			}
+		}
+
+		m_pool->wait(&m_numRunning);
+
+		m_stats.m_frameMs = Ms(Clock::now() - m_frameStart).count();
+		m_pool->takeBusyTimes(&m_stats.m_threadBusyMs);
+
+		m_stats.m_numThreads = m_stats.m_threadBusyMs.size();
+		m_stats.m_busyMs = 0.0;
+
+		for (double ms : m_stats.m_threadBusyMs)
+		{
+			m_stats.m_busyMs += ms;
+		}
+
+		const double available = m_stats.m_frameMs * m_stats.m_numThreads;
+		m_stats.m_utilisation = available > 0.0 ? m_stats.m_busyMs / available : 0.0;
+	}
+
+	void SystemScheduler::runSystem(int32_t id)
+	{
+		System* system = m_systems[id];
+		SystemTiming& timing = m_timings[id];
+
+		const Clock::time_point start = Clock::now();
+		system->m_function(m_world, m_pool);
+		const Clock::time_point end = Clock::now();
+
+		timing.m_startMs = Ms(start - m_frameStart).count();
+		timing.m_durationMs = Ms(end - start).count();
+		timing.m_thread = WorkerPool::getThreadIndex();
+		timing.m_bRan = true;
+
+		// Submitted before this task counts as done, so the wait in run() cannot end in between.
+		for (int32_t dependent : system->m_dependents)
+		{
+			if (m_systems[dependent]->m_numWaitingFor.fetch_sub(1) == 1)
+			{
+				m_pool->submit([this, dependent]() { runSystem(dependent); }, &m_numRunning);
+			}
+		}
+	}
+
+	const std::vector<int32_t>& SystemScheduler::getDependencies(int32_t system) const
+	{
+		return m_systems[system]->m_dependencies;
+	}
+
+	const std::vector<SystemTiming>& SystemScheduler::getTimings() const
+	{
+		return m_timings;
+	}
+
+	const SchedulerStats& SystemScheduler::getStats() const
+	{
+		return m_stats;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Core/Archetype.hpp>
+#include <Core/View.hpp>
+#include <Core/WorkerPool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+namespace Phoenix
+{
+	class World;
+
+	struct SystemTiming
+	{
+		SystemTiming()
+			: m_name(nullptr)
+			, m_startMs(0.0)
+			, m_durationMs(0.0)
+			, m_thread(0)
+			, m_bRan(false)
+		{}
+
+		const char* m_name;
+		double m_startMs; // From the start of the frame.
+		double m_durationMs; // Includes tasks of other systems the thread ran while this one waited.
+		size_t m_thread;
+		bool m_bRan;
+	};
+
+	struct SchedulerStats
+	{
+		SchedulerStats()
+			: m_frameMs(0.0)
+			, m_busyMs(0.0)
+			, m_utilisation(0.0)
+			, m_numThreads(0)
+			, m_numDependencies(0)
+		{}
+
+		double m_frameMs;
+		double m_busyMs; // Summed over the threads.
+		double m_utilisation; // m_busyMs over m_frameMs times the number of threads.
+		size_t m_numThreads;
+		size_t m_numDependencies; // Edges of the graph of the frame.
+		std::vector<double> m_threadBusyMs;
+	};
+
+	// Runs the systems of a frame on a worker pool. Every system declares the component types it
+	// reads and the ones it writes. A system runs after the systems added before it that write
+	// what it reads or writes, or read what it writes, and at the same time as the others.
+	// Systems running at the same time may read and write their columns and mark changes of the
+	// types they write. Creating or destroying entities, adding components and advancing the
+	// change version change the world for everyone, so such systems write ALL_COMPONENTS.
+	class SystemScheduler
+	{
+	public:
+		static const ComponentMask ALL_COMPONENTS = ~0u;
+
+		// Systems split their own work into tasks on the pool, see parallelForEachChunk().
+		typedef std::function<void(World*, WorkerPool*)> SystemFunction;
+
+		SystemScheduler(World* world, WorkerPool* pool);
+		~SystemScheduler();
+
+		SystemScheduler(const SystemScheduler&) = delete;
+		SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+		// The name has to outlive the scheduler. Returns the id of the system.
+		int32_t addSystem(const char* name, ComponentMask reads, ComponentMask writes, SystemFunction fn);
+
+		// Disabled systems are left out of the graph, nothing waits for them.
+		void setEnabled(int32_t system, bool bEnabled);
+
+		// Builds the dependency graph of the enabled systems and runs them. Returns once all ran.
+		void run();
+
+		// Systems the system waited for in the last run.
+		const std::vector<int32_t>& getDependencies(int32_t system) const;
+
+		// Of the last run, indexed by system id.
+		const std::vector<SystemTiming>& getTimings() const;
+		const SchedulerStats& getStats() const;
+
+	private:
+		struct System
+		{
+			const char* m_name;
+			ComponentMask m_reads;
+			ComponentMask m_writes;
+			SystemFunction m_function;
+			bool m_bEnabled;
+
+			std::vector<int32_t> m_dependencies;
+			std::vector<int32_t> m_dependents;
+			std::atomic<int32_t> m_numWaitingFor;
+		};
+
+		void buildGraph();
+		void runSystem(int32_t system);
+
+		World* m_world;
+		WorkerPool* m_pool;
+		std::vector<System*> m_systems;
+		std::vector<SystemTiming> m_timings;
+		SchedulerStats m_stats;
+
+		std::atomic<int32_t> m_numRunning;
+		std::chrono::high_resolution_clock::time_point m_frameStart;
+	};
+
+	// Calls fn(size_t count, const EntityHandle* entities, C*... columns) for every chunk of the view
+	// like View::forEachChunk(), with chunksPerTask chunks per task on the pool.
+	template<typename... C, typename F>
+	void parallelForEachChunk(WorkerPool* pool, const View<C...>& view, F fn, size_t chunksPerTask = 1)
+	{
+		std::vector<std::pair<Archetype*, size_t>> chunks;
+
+		for (Archetype* archetype : view.getArchetypes())
+		{
+			for (size_t chunk = 0; chunk < archetype->getNumChunks(); ++chunk)
+			{
+				chunks.push_back(std::make_pair(archetype, chunk));
+			}
+		}
+
+		pool->parallelFor(chunks.size(), chunksPerTask, [&chunks, &fn](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				Archetype* archetype = chunks[i].first;
+				const size_t chunk = chunks[i].second;
+				fn(archetype->getChunkSize(chunk), archetype->getEntities(chunk), archetype->template getColumn<C>(chunk)...);
+			}
+		});
+	}
+}
\ No newline at end of file
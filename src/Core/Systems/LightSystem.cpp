@@ -0,0 +1,36 @@
+#include "LightSystem.hpp"
+
+#include <Core/World.hpp>
+#include <Core/Components/CTransform.hpp>
+#include <Core/Components/CDirectionalLight.hpp>
+#include <Core/Components/CPointLight.hpp>
+#include <Math/Matrix4.hpp>
+#include <Math/Vec4.hpp>
+#include <Render/DeferredRenderer.hpp>
+
+namespace Phoenix
+{
+	void LightSystem::gatherLights(World* world, const Matrix4& viewTf)
+	{
+		m_lightBuffer.clear();
+
+		world->forEach<CDirectionalLight>([this, &viewTf](EntityHandle, CDirectionalLight& dl)
+		{
+			m_lightBuffer.addDirectional(viewTf * dl.m_direction, dl.m_color);
+		});
+
+		world->forEach<CTransform, CPointLight>([this, &viewTf](EntityHandle, CTransform& tf, CPointLight& pl)
+		{
+			Vec4 eyePos(tf.getTranslation(), 1.0);
+			eyePos *= viewTf;
+
+			m_lightBuffer.addPointLight(eyePos, pl.m_radius, pl.m_color, pl.m_intensity);
+		});
+	}
+
+	void LightSystem::renderLights(DeferredRenderer* renderer)
+	{
+		renderer->setupDirectLightingPass();
+		renderer->runLightsPass(m_lightBuffer);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Render/LightBuffer.hpp>
+
+namespace Phoenix
+{
+	class World;
+	class DeferredRenderer;
+	class Matrix4;
+
+	// Lights the gbuffer with the CDirectionalLight and CPointLight of the world.
+	class LightSystem
+	{
+	public:
+		// Collects the lights in eye space. Only reads the world, so it runs next to other readers.
+		void gatherLights(World* world, const Matrix4& viewTf);
+
+		// Lights the gbuffer with the lights gathered last.
+		void renderLights(DeferredRenderer* renderer);
+
+	private:
+		LightBuffer m_lightBuffer;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "StaticMeshSystem.hpp"
+
+#include <Core/World.hpp>
+#include <Core/Mesh.hpp>
+#include <Core/MeshLod.hpp>
+#include <Core/Components/CTransform.hpp>
+#include <Core/Components/CStaticMesh.hpp>
+#include <Math/Plane.hpp>
+#include <Math/Ray.hpp>
+#include <Math/Vec4.hpp>
+#include <Render/DeferredRenderer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace Phoenix
+{
+	static Aabb getWorldBounds(const StaticMesh& mesh, const Matrix4& transform)
+	{
+		Vec3 center;
+		Vec3 extent;
+		transformAabb(transform, mesh.m_aabbMin, mesh.m_aabbMax, &center, &extent);
+
+		return Aabb(center - extent, center + extent);
+	}
+
+	void StaticMeshSystem::updateBounds(World* world)
+	{
+		// The mesh component of a destroyed entity is gone with its proxy id, the owners still know it.
+		for (size_t proxy = 0; proxy < m_proxyOwners.size(); ++proxy)
+		{
+			if (m_proxyOwners[proxy] != World::INVALID_ENTITY && !world->handleIsValid(m_proxyOwners[proxy]))
+			{
+				m_tree.destroyProxy(static_cast<int32_t>(proxy));
+				m_proxyOwners[proxy] = World::INVALID_ENTITY;
+			}
+		}
+
+		View<CTransform, CStaticMesh> meshes = world->view<CTransform, CStaticMesh>();
+
+		meshes.forEachChangedSince<CStaticMesh>(m_lastChangeVersion, [this](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+		{
+			if (sm.m_proxy == AabbTree::NULL_NODE)
+			{
+				sm.m_proxy = m_tree.createProxy(getWorldBounds(*sm.m_mesh, tf.m_transform), static_cast<uint32_t>(entity));
+
+				if (static_cast<size_t>(sm.m_proxy) >= m_proxyOwners.size())
+				{
+					m_proxyOwners.resize(sm.m_proxy + 1, World::INVALID_ENTITY);
+				}
+
+				m_proxyOwners[sm.m_proxy] = entity;
+			}
+		});
+
+		meshes.forEachChangedSince<CTransform>(m_lastChangeVersion, [this](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+		{
+			m_tree.moveProxy(sm.m_proxy, getWorldBounds(*sm.m_mesh, tf.m_transform));
+		});
+
+		m_lastChangeVersion = world->getChangeVersion();
+	}
+
+	void StaticMeshSystem::renderMeshes(World* world, DeferredRenderer* renderer)
+	{
+		// LODs may move the surface by up to a pixel and switch 15% past their limit.
+		const float maxLodPixelError = 1.f;
+		const float lodHysteresis = 0.15f;
+
+		// Occluders are the largest meshes covering at least a tenth of the screen height.
+		const size_t maxOccluders = 16;
+		const float minOccluderScreenFraction = 0.1f;
+
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<float, std::milli>;
+
+		Matrix4 viewProjection = renderer->getProjectionMatrix() * renderer->getViewMatrix();
+
+		Plane frustum[NUM_FRUSTUM_PLANES];
+		extractFrustumPlanes(viewProjection, frustum);
+
+		m_tree.queryFrustum(frustum, &m_visibleEntities);
+
+		m_cullStats.m_numVisible = m_visibleEntities.size();
+		m_cullStats.m_numCulled = m_tree.getNumProxies() - m_visibleEntities.size();
+
+		// Components do not move while rendering, so they are looked up once per frame.
+		m_visible.resize(m_visibleEntities.size());
+
+		for (size_t k = 0; k < m_visibleEntities.size(); ++k)
+		{
+			EntityHandle entity = static_cast<EntityHandle>(m_visibleEntities[k]);
+			m_visible[k].m_mesh = world->getComponent<CStaticMesh>(entity);
+			m_visible[k].m_transform = world->getComponent<CTransform>(entity);
+		}
+
+		m_screenSizes.resize(m_visible.size());
+		m_occluders.clear();
+
+		for (size_t k = 0; k < m_visible.size(); ++k)
+		{
+			CStaticMesh& sm = *m_visible[k].m_mesh;
+			const StaticMesh& mesh = *sm.m_mesh;
+			const Matrix4& transform = m_visible[k].m_transform->m_transform;
+
+			Vec3 center(transform * Vec4(mesh.m_boundsCenter, 1.f));
+			m_screenSizes[k] = renderer->getScreenSize(center, mesh.m_boundsRadius * getMaxScale(transform));
+
+			sm.m_lod = selectLod(mesh, m_screenSizes[k], sm.m_lod, maxLodPixelError, lodHysteresis);
+
+			if (m_screenSizes[k] >= minOccluderScreenFraction * renderer->getViewportHeight())
+			{
+				m_occluders.push_back(static_cast<uint32_t>(k));
+			}
+		}
+
+		if (m_occluders.size() > maxOccluders)
+		{
+			std::partial_sort(m_occluders.begin(), m_occluders.begin() + maxOccluders, m_occluders.end(),
+				[this](uint32_t a, uint32_t b) { return m_screenSizes[a] > m_screenSizes[b]; });
+
+			m_occluders.resize(maxOccluders);
+		}
+
+		// Occluders use the LOD that would be picked at the resolution of the occlusion buffer.
+		Clock::time_point rasterStart = Clock::now();
+		m_occlusionCuller.begin(viewProjection);
+
+		const float occlusionScale = OcclusionCuller::HEIGHT / renderer->getViewportHeight();
+
+		for (uint32_t k : m_occluders)
+		{
+			CStaticMesh& sm = *m_visible[k].m_mesh;
+			const StaticMesh& mesh = *sm.m_mesh;
+
+			uint8_t occluderLod = selectLod(mesh, m_screenSizes[k] * occlusionScale, sm.m_lod, maxLodPixelError, 0.f);
+
+			size_t numIndices = 0;
+			const uint32_t* indices = getLodIndices(mesh, occluderLod, &numIndices);
+
+			m_occlusionCuller.addOccluder(mesh.m_data.m_vertices.data(), mesh.m_data.m_vertices.size(), indices, numIndices, m_visible[k].m_transform->m_transform);
+		}
+
+		m_occlusionCuller.rasterize();
+		Clock::time_point testStart = Clock::now();
+
+		m_occlusionStats.m_numOccluders = m_occluders.size();
+		m_occlusionStats.m_numOccluderTriangles = m_occlusionCuller.getNumTriangles();
+		m_occlusionStats.m_numTested = m_visible.size();
+		m_occlusionStats.m_numOccluded = 0;
+		m_occlusionStats.m_rasterMs = Ms(testStart - rasterStart).count();
+
+		for (const VisibleMesh& visible : m_visible)
+		{
+			const StaticMesh& mesh = *visible.m_mesh->m_mesh;
+			const Matrix4& transform = visible.m_transform->m_transform;
+
+			Aabb bounds = getWorldBounds(mesh, transform);
+
+			if (!m_occlusionCuller.isVisible(bounds.m_min, bounds.m_max))
+			{
+				++m_occlusionStats.m_numOccluded;
+				continue;
+			}
+
+			renderer->drawStaticMesh(mesh, transform, visible.m_mesh->m_lod);
+		}
+
+		m_occlusionStats.m_testMs = Ms(Clock::now() - testStart).count();
+	}
+
+	EntityHandle StaticMeshSystem::pickEntity(World* world, const Ray& ray)
+	{
+		auto hitMesh = [world](uint32_t entity, const Ray& ray, float maxDistance) -> float
+		{
+			CStaticMesh* sm = world->getComponent<CStaticMesh>(static_cast<EntityHandle>(entity));
+			CTransform* tf = world->getComponent<CTransform>(static_cast<EntityHandle>(entity));
+
+			return raycastStaticMesh(*sm->m_mesh, tf->m_transform, ray, maxDistance);
+		};
+
+		uint32_t hitEntity = 0;
+		float distance = 0.f;
+
+		if (!m_tree.raycast(ray, std::numeric_limits<float>::max(), hitMesh, &hitEntity, &distance))
+		{
+			return World::INVALID_ENTITY;
+		}
+
+		return static_cast<EntityHandle>(hitEntity);
+	}
+
+	const FrustumCullStats& StaticMeshSystem::getCullStats() const
+	{
+		return m_cullStats;
+	}
+
+	const OcclusionCullStats& StaticMeshSystem::getOcclusionStats() const
+	{
+		return m_occlusionStats;
+	}
+}
\ No newline at end of file
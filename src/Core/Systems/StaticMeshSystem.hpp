@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Core/AabbTree.hpp>
+#include <Core/EntityHandle.hpp>
+#include <Render/FrustumCulling.hpp>
+#include <Render/OcclusionCulling.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class World;
+	class WorkerPool;
+	class DeferredRenderer;
+	class Ray;
+	class CStaticMesh;
+	class CTransform;
+
+	// Culls and draws the CStaticMesh of the world, keeping their bounds in an AabbTree.
+	class StaticMeshSystem
+	{
+	public:
+		// Occluders are rasterized on the pool.
+		explicit StaticMeshSystem(WorkerPool* pool)
+			: m_occlusionCuller(pool)
+			, m_lastChangeVersion(0)
+		{}
+
+		// Adds meshes added since the last call to the bounding volume tree, moves the ones whose
+		// transform changed since then and removes the ones of destroyed entities. Runs after the
+		// transforms are updated. Sees the changes up to the current change version, the caller
+		// advances it once per frame after the systems ran.
+		void updateBounds(World* world);
+
+		// Draws the meshes inside the view frustum of the renderer that are not hidden behind the
+		// largest meshes on screen.
+		void renderMeshes(World* world, DeferredRenderer* renderer);
+
+		// Entity of the mesh the ray hits first, World::INVALID_ENTITY if there is none.
+		EntityHandle pickEntity(World* world, const Ray& ray);
+
+		const FrustumCullStats& getCullStats() const;
+
+		const OcclusionCullStats& getOcclusionStats() const;
+
+	private:
+		struct VisibleMesh
+		{
+			CStaticMesh* m_mesh;
+			CTransform* m_transform;
+		};
+
+		// Leaves hold the entity of their mesh.
+		AabbTree m_tree;
+		std::vector<EntityHandle> m_proxyOwners; // Indexed by proxy, INVALID_ENTITY for unused ones.
+
+		std::vector<uint32_t> m_visibleEntities;
+		std::vector<VisibleMesh> m_visible;
+		FrustumCullStats m_cullStats;
+
+		OcclusionCuller m_occlusionCuller;
+		std::vector<float> m_screenSizes; // Of the meshes in m_visible.
+		std::vector<uint32_t> m_occluders; // Into m_visible.
+		OcclusionCullStats m_occlusionStats;
+
+		uint32_t m_lastChangeVersion;
+	};
+}
\ No newline at end of file
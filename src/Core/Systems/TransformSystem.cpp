@@ -0,0 +1,92 @@
+#include "TransformSystem.hpp"
+
+#include <Core/World.hpp>
+#include <Core/SystemScheduler.hpp>
+#include <Core/Components/CTransform.hpp>
+
+namespace Phoenix
+{
+	void TransformSystem::updateTransforms(World* world)
+	{
+		for (size_t node = 0; node < m_nodeOwners.size(); ++node)
+		{
+			if (m_nodeOwners[node] != World::INVALID_ENTITY && !world->handleIsValid(m_nodeOwners[node]))
+			{
+				m_hierarchy.destroyNode(static_cast<int32_t>(node));
+				m_nodeOwners[node] = World::INVALID_ENTITY;
+			}
+		}
+
+		View<CTransform> transforms = world->view<CTransform>();
+
+		// All nodes exist before parents are linked, a parent may have been added after its child.
+		transforms.forEach([this](EntityHandle entity, CTransform& c)
+		{
+			if (c.m_node == TransformHierarchy::NULL_NODE)
+			{
+				c.m_node = m_hierarchy.createNode(entity);
+
+				if (static_cast<size_t>(c.m_node) >= m_nodeOwners.size())
+				{
+					m_nodeOwners.resize(c.m_node + 1, World::INVALID_ENTITY);
+				}
+
+				m_nodeOwners[c.m_node] = entity;
+				c.m_bParentChanged = c.getParent() != World::INVALID_ENTITY;
+			}
+		});
+
+		m_dirtyTrs.clear();
+		m_dirtyNodes.clear();
+
+		transforms.forEach([this, world](EntityHandle entity, CTransform& c)
+		{
+			if (c.m_bParentChanged)
+			{
+				CTransform* parent = world->handleIsValid(c.getParent()) ? world->getComponent<CTransform>(c.getParent()) : nullptr;
+				m_hierarchy.setParent(c.m_node, parent ? parent->m_node : TransformHierarchy::NULL_NODE);
+				c.m_bParentChanged = false;
+			}
+
+			if (c.m_bDirty)
+			{
+				m_dirtyTrs.add(c.getTranslation(), c.getRotation(), c.getScale());
+				m_dirtyNodes.push_back(c.m_node);
+			}
+		});
+
+		m_dirtyLocals.resize(m_dirtyNodes.size());
+		m_dirtyTrs.compose(m_dirtyLocals.data());
+
+		for (size_t i = 0; i < m_dirtyNodes.size(); ++i)
+		{
+			m_hierarchy.setLocal(m_dirtyNodes[i], m_dirtyLocals[i]);
+		}
+
+		m_stats = m_hierarchy.update();
+
+		for (int32_t node : m_hierarchy.getUpdatedNodes())
+		{
+			CTransform* c = world->getComponent<CTransform>(m_nodeOwners[node]);
+			c->m_transform = m_hierarchy.getWorld(node);
+			c->m_bDirty = true;
+			world->markChanged<CTransform>(m_nodeOwners[node]);
+		}
+	}
+
+	void TransformSystem::clearDirtyFlags(World* world, WorkerPool* pool)
+	{
+		parallelForEachChunk(pool, world->view<CTransform>(), [](size_t count, const EntityHandle*, CTransform* transforms)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				transforms[i].m_bDirty = false;
+			}
+		});
+	}
+
+	const TransformHierarchyStats& TransformSystem::getStats() const
+	{
+		return m_stats;
+	}
+}
\ No newline at end of file
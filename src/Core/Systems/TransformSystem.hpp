@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Core/EntityHandle.hpp>
+#include <Core/TransformHierarchy.hpp>
+#include <Math/Matrix4.hpp>
+#include <Math/TransformBatch.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class World;
+	class WorkerPool;
+
+	// Keeps the world transforms of CTransform up to date through a TransformHierarchy.
+	class TransformSystem
+	{
+	public:
+		// Computes the world transforms of the changed transforms and their children, and marks
+		// the children dirty as well.
+		void updateTransforms(World* world);
+
+		// Called once the other systems have seen which transforms changed this frame.
+		void clearDirtyFlags(World* world, WorkerPool* pool);
+
+		const TransformHierarchyStats& getStats() const;
+
+	private:
+		TransformHierarchy m_hierarchy;
+		std::vector<EntityHandle> m_nodeOwners; // Indexed by node, INVALID_ENTITY for unused ones.
+
+		// Dirty local transforms are gathered and composed together.
+		TrsBatch m_dirtyTrs;
+		std::vector<int32_t> m_dirtyNodes;
+		std::vector<Matrix4> m_dirtyLocals;
+		TransformHierarchyStats m_stats;
+	};
+}
\ No newline at end of file
@@ -4,9 +4,11 @@
 #include <Core/Logger.hpp>
 #include <Core/Serialize.hpp>
 #include <Core/SerialUtil.hpp>
+#include <Core/StaticSerialize.hpp>
 #include <Core/FileSystem.hpp>
 #include <Core/AssetRegistry.hpp>
 
+#include <Render/RIDefsSerialize.hpp>
 #include <Render/RIDevice.hpp>
 #include <Render/RIContext.hpp>
 
@@ -188,31 +190,38 @@ namespace Phoenix
 		}
 	}
 
+	// Field by field, the same layout as serializeValue().
 	void serialize(Archive* ar, TextureDesc& desc)
 	{
-		ar->serialize(&desc.width, sizeof(uint32_t));
-		ar->serialize(&desc.height, sizeof(uint32_t));
-		ar->serialize(&desc.pixelFormat, sizeof(EPixelFormat));
-		ar->serialize(&desc.minFilter, sizeof(ETextureFilter));
-		ar->serialize(&desc.magFilter, sizeof(ETextureFilter));
-		ar->serialize(&desc.wrapU, sizeof(ETextureWrap));
-		ar->serialize(&desc.wrapV, sizeof(ETextureWrap));
-		ar->serialize(&desc.wrapW, sizeof(ETextureWrap));
-		ar->serialize(&desc.numMips, sizeof(uint8_t));
+		DynamicArchive dynamicAr(ar);
+		serializeValue(dynamicAr, desc);
 	}
 
 	void serialize(Archive* ar, TextureCreationHints& hints)
 	{
-		ar->serialize(&hints.colorSpace, sizeof(ETextrueColorSpace));
-		ar->serialize(&hints.magFilter, sizeof(ETextureFilter));
-		ar->serialize(&hints.minFilter, sizeof(ETextureFilter));
-		ar->serialize(&hints.mipFilter, sizeof(ETextureFilter));
-		ar->serialize(&hints.wrapU, sizeof(ETextureWrap));
-		ar->serialize(&hints.wrapV, sizeof(ETextureWrap));
-		ar->serialize(&hints.wrapW, sizeof(ETextureWrap));
-		ar->serialize(&hints.bGenMipMaps, sizeof(bool));
+		DynamicArchive dynamicAr(ar);
+		serializeValue(dynamicAr, hints);
 	}
 
+	// Files from before the header existed start with the length of the source path instead and
+	// are refused.
+	enum
+	{
+		TEXTURE_FILE_MAGIC = 0x58544850, // "PHTX"
+		TEXTURE_FILE_VERSION = 1
+	};
+
+	struct TextureFileHeader
+	{
+		TextureFileHeader()
+			: m_magic(TEXTURE_FILE_MAGIC)
+			, m_version(TEXTURE_FILE_VERSION)
+		{}
+
+		uint32_t m_magic;
+		uint32_t m_version;
+	};
+
 	struct TextureAsset
 	{
 		TextureAsset() = default;
@@ -226,14 +235,9 @@ namespace Phoenix
 		std::string m_sourcePath;
 		TextureDesc m_desc;
 		TextureCreationHints m_hints;
-	};
 
-	void serialize(Archive* ar, TextureAsset& asset)
-	{
-		serialize(ar, asset.m_sourcePath);
-		serialize(ar, asset.m_desc);
-		serialize(ar, asset.m_hints);
-	}
+		PHI_SERIALIZE(m_sourcePath, m_desc, m_hints)
+	};
 
 	std::string textureNameFromPath(const char* path)
 	{
@@ -297,8 +301,13 @@ namespace Phoenix
 		WriteArchive ar;
 		createWriteArchive(sizeof(TextureAsset), &ar);
 
+		TextureFileHeader header;
 		TextureAsset asset(texture);
-		serialize(&ar, asset);
+		{
+			StaticWriteArchive writer(&ar);
+			serializeValue(writer, header);
+			serializeValue(writer, asset);
+		}
 
 		std::string writePath = assets->getAssetsPath() + texture.m_name;
 		writePath += g_assetFileExt;
@@ -329,8 +338,28 @@ namespace Phoenix
 			return tex;
 		}
 
+		TextureFileHeader header;
+		header.m_magic = 0;
+
+		if (ar.m_size >= sizeof(TextureFileHeader))
+		{
+			StaticReadArchive reader(&ar);
+			serializeValue(reader, header);
+		}
+
+		if (header.m_magic != TEXTURE_FILE_MAGIC || header.m_version != TEXTURE_FILE_VERSION)
+		{
+			Logger::errorf("Texture file %s is not in the current format, it needs to be saved again.", readPath.c_str());
+			destroyArchive(ar);
+			return tex;
+		}
+
 		TextureAsset asset;
-		serialize(&ar, asset);
+		{
+			StaticReadArchive reader(&ar);
+			serializeValue(reader, asset);
+		}
+		destroyArchive(ar);
 
 		return importTexture(asset.m_sourcePath.c_str(), &asset.m_hints, renderDevice, renderContext, assets);
 	}
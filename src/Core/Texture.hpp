@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <string>
 
+#include <Core/StaticSerialize.hpp>
 #include <Render/RIDefs.hpp>
 #include <Render/RIResourceHandles.hpp>
 
@@ -62,6 +63,8 @@ namespace Phoenix
 		
 		// Whether to generate a mip-map for this texture.
 		bool bGenMipMaps;
+
+		PHI_SERIALIZE(colorSpace, magFilter, minFilter, mipFilter, wrapU, wrapV, wrapW, bGenMipMaps)
 	};
 
 	struct Texture2D
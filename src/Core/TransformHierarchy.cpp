@@ -0,0 +1,386 @@
+#include "TransformHierarchy.hpp"
+
+#include <assert.h>
+
+namespace Phoenix
+{
+	TransformHierarchy::TransformHierarchy()
+		: m_bNeedsReorder(false)
+	{}
+
+	int32_t TransformHierarchy::createNode(uint32_t userData, int32_t parent)
+	{
+		int32_t node;
+
+		if (!m_freeIds.empty())
+		{
+			node = m_freeIds.back();
+			m_freeIds.pop_back();
+		}
+		else
+		{
+			node = static_cast<int32_t>(m_position.size());
+			m_position.push_back(NULL_NODE);
+			m_parent.push_back(NULL_NODE);
+			m_firstChild.push_back(NULL_NODE);
+			m_nextSibling.push_back(NULL_NODE);
+			m_prevSibling.push_back(NULL_NODE);
+		}
+
+		const int32_t position = static_cast<int32_t>(m_nodeAt.size());
+
+		m_position[node] = position;
+		m_parent[node] = NULL_NODE;
+		m_firstChild[node] = NULL_NODE;
+		m_nextSibling[node] = NULL_NODE;
+		m_prevSibling[node] = NULL_NODE;
+
+		// A new root at the end is already in depth first order, a new child is not.
+		m_nodeAt.push_back(node);
+		m_parentPosition.push_back(NULL_NODE);
+		m_subtreeEnd.push_back(position + 1);
+		m_userData.push_back(userData);
+		m_flags.push_back(0);
+		m_local.push_back(Matrix4::identity());
+		m_world.push_back(Matrix4::identity());
+
+		if (parent != NULL_NODE)
+		{
+			linkChild(node, parent);
+			m_bNeedsReorder = true;
+		}
+
+		markChanged(node);
+		return node;
+	}
+
+	void TransformHierarchy::destroyNode(int32_t node)
+	{
+		assert(m_position[node] != NULL_NODE);
+		const int32_t parent = m_parent[node];
+
+		while (m_firstChild[node] != NULL_NODE)
+		{
+			int32_t child = m_firstChild[node];
+			unlinkChild(child);
+
+			if (parent != NULL_NODE)
+			{
+				linkChild(child, parent);
+			}
+
+			markChanged(child);
+		}
+
+		unlinkChild(node);
+
+		// The position stays taken until the next reorder drops it.
+		m_nodeAt[m_position[node]] = NULL_NODE;
+		m_position[node] = NULL_NODE;
+		m_freeIds.push_back(node);
+		m_bNeedsReorder = true;
+	}
+
+	void TransformHierarchy::setParent(int32_t node, int32_t parent)
+	{
+		if (m_parent[node] == parent)
+		{
+			return;
+		}
+
+		for (int32_t ancestor = parent; ancestor != NULL_NODE; ancestor = m_parent[ancestor])
+		{
+			assert(ancestor != node && "A node cannot become its own descendant.");
+		}
+
+		unlinkChild(node);
+
+		if (parent != NULL_NODE)
+		{
+			linkChild(node, parent);
+		}
+
+		m_bNeedsReorder = true;
+		markChanged(node);
+	}
+
+	void TransformHierarchy::setLocal(int32_t node, const Matrix4& local)
+	{
+		m_local[m_position[node]] = local;
+		markChanged(node);
+	}
+
+	int32_t TransformHierarchy::getParent(int32_t node) const
+	{
+		return m_parent[node];
+	}
+
+	uint32_t TransformHierarchy::getUserData(int32_t node) const
+	{
+		return m_userData[m_position[node]];
+	}
+
+	const Matrix4& TransformHierarchy::getLocal(int32_t node) const
+	{
+		return m_local[m_position[node]];
+	}
+
+	const Matrix4& TransformHierarchy::getWorld(int32_t node) const
+	{
+		return m_world[m_position[node]];
+	}
+
+	size_t TransformHierarchy::getNumNodes() const
+	{
+		return m_position.size() - m_freeIds.size();
+	}
+
+	void TransformHierarchy::markChanged(int32_t node)
+	{
+		m_flags[m_position[node]] |= LOCAL_CHANGED | SUBTREE_CHANGED;
+
+		// Ancestors of a marked node are marked, so the walk stops at the first one that is.
+		for (int32_t ancestor = m_parent[node]; ancestor != NULL_NODE; ancestor = m_parent[ancestor])
+		{
+			uint8_t& flags = m_flags[m_position[ancestor]];
+
+			if (flags & SUBTREE_CHANGED)
+			{
+				break;
+			}
+
+			flags |= SUBTREE_CHANGED;
+		}
+	}
+
+	void TransformHierarchy::linkChild(int32_t node, int32_t parent)
+	{
+		assert(m_parent[node] == NULL_NODE);
+		const int32_t next = m_firstChild[parent];
+
+		m_parent[node] = parent;
+		m_prevSibling[node] = NULL_NODE;
+		m_nextSibling[node] = next;
+
+		if (next != NULL_NODE)
+		{
+			m_prevSibling[next] = node;
+		}
+
+		m_firstChild[parent] = node;
+	}
+
+	void TransformHierarchy::unlinkChild(int32_t node)
+	{
+		const int32_t parent = m_parent[node];
+
+		if (parent == NULL_NODE)
+		{
+			return;
+		}
+
+		const int32_t prev = m_prevSibling[node];
+		const int32_t next = m_nextSibling[node];
+
+		if (prev != NULL_NODE)
+		{
+			m_nextSibling[prev] = next;
+		}
+		else
+		{
+			m_firstChild[parent] = next;
+		}
+
+		if (next != NULL_NODE)
+		{
+			m_prevSibling[next] = prev;
+		}
+
+		m_parent[node] = NULL_NODE;
+		m_prevSibling[node] = NULL_NODE;
+		m_nextSibling[node] = NULL_NODE;
+	}
+
+	void TransformHierarchy::reorder()
+	{
+		// Depth first walk from the roots in their current order, through the child links.
+		std::vector<int32_t> order;
+		std::vector<uint32_t> subtreeEnd(m_position.size());
+		order.reserve(getNumNodes());
+
+		for (int32_t root : m_nodeAt)
+		{
+			if (root == NULL_NODE || m_parent[root] != NULL_NODE)
+			{
+				continue;
+			}
+
+			int32_t node = root;
+
+			while (node != NULL_NODE)
+			{
+				order.push_back(node);
+
+				if (m_firstChild[node] != NULL_NODE)
+				{
+					node = m_firstChild[node];
+					continue;
+				}
+
+				// Leaving a leaf closes its subtree and those of the ancestors it is the last node of.
+				while (true)
+				{
+					subtreeEnd[node] = static_cast<uint32_t>(order.size());
+
+					if (node == root)
+					{
+						node = NULL_NODE;
+						break;
+					}
+
+					if (m_nextSibling[node] != NULL_NODE)
+					{
+						node = m_nextSibling[node];
+						break;
+					}
+
+					node = m_parent[node];
+				}
+			}
+		}
+
+		assert(order.size() == getNumNodes());
+
+		std::vector<int32_t> parentPosition(order.size());
+		std::vector<uint32_t> userData(order.size());
+		std::vector<uint8_t> flags(order.size());
+		std::vector<Matrix4> local(order.size());
+		std::vector<Matrix4> world(order.size());
+
+		for (size_t position = 0; position < order.size(); ++position)
+		{
+			const int32_t node = order[position];
+			const int32_t oldPosition = m_position[node];
+
+			userData[position] = m_userData[oldPosition];
+			flags[position] = m_flags[oldPosition];
+			local[position] = m_local[oldPosition];
+			world[position] = m_world[oldPosition];
+		}
+
+		for (size_t position = 0; position < order.size(); ++position)
+		{
+			m_position[order[position]] = static_cast<int32_t>(position);
+		}
+
+		m_subtreeEnd.resize(order.size());
+
+		for (size_t position = 0; position < order.size(); ++position)
+		{
+			const int32_t node = order[position];
+			parentPosition[position] = m_parent[node] == NULL_NODE ? NULL_NODE : m_position[m_parent[node]];
+			m_subtreeEnd[position] = subtreeEnd[node];
+		}
+
+		m_nodeAt.swap(order);
+		m_parentPosition.swap(parentPosition);
+		m_userData.swap(userData);
+		m_flags.swap(flags);
+		m_local.swap(local);
+		m_world.swap(world);
+
+		m_bNeedsReorder = false;
+	}
+
+	const TransformHierarchyStats& TransformHierarchy::update()
+	{
+		m_stats.m_bReordered = m_bNeedsReorder;
+
+		if (m_bNeedsReorder)
+		{
+			reorder();
+		}
+
+		m_updated.clear();
+
+		const uint32_t numPositions = static_cast<uint32_t>(m_nodeAt.size());
+		uint32_t position = 0;
+
+		while (position < numPositions)
+		{
+			const uint8_t flags = m_flags[position];
+
+			if (0 == (flags & SUBTREE_CHANGED))
+			{
+				position = m_subtreeEnd[position];
+				continue;
+			}
+
+			if (0 == (flags & LOCAL_CHANGED))
+			{
+				// Something below changed, the node itself did not.
+				m_flags[position] = 0;
+				++position;
+				continue;
+			}
+
+			// Parents are ahead in the range or already up to date outside of it.
+			const uint32_t end = m_subtreeEnd[position];
+
+			for (uint32_t i = position; i < end; ++i)
+			{
+				const int32_t parentPosition = m_parentPosition[i];
+				m_world[i] = parentPosition == NULL_NODE ? m_local[i] : m_world[parentPosition] * m_local[i];
+				m_flags[i] = 0;
+				m_updated.push_back(m_nodeAt[i]);
+			}
+
+			position = end;
+		}
+
+		m_stats.m_numNodes = numPositions;
+		m_stats.m_numUpdated = m_updated.size();
+		return m_stats;
+	}
+
+	const std::vector<int32_t>& TransformHierarchy::getUpdatedNodes() const
+	{
+		return m_updated;
+	}
+
+	void TransformHierarchy::validate() const
+	{
+		assert(!m_bNeedsReorder && "The order is only consistent after update().");
+		assert(m_nodeAt.size() == getNumNodes());
+
+		for (uint32_t position = 0; position < m_nodeAt.size(); ++position)
+		{
+			const int32_t node = m_nodeAt[position];
+			assert(m_position[node] == static_cast<int32_t>(position));
+			assert(m_subtreeEnd[position] > position && m_subtreeEnd[position] <= m_nodeAt.size());
+
+			const int32_t parent = m_parent[node];
+
+			if (parent == NULL_NODE)
+			{
+				assert(m_parentPosition[position] == NULL_NODE);
+				continue;
+			}
+
+			// Nested inside the range of the parent.
+			const int32_t parentPosition = m_parentPosition[position];
+			assert(parentPosition == m_position[parent]);
+			assert(parentPosition < static_cast<int32_t>(position));
+			assert(m_subtreeEnd[position] <= m_subtreeEnd[parentPosition]);
+
+			bool bFoundInParent = false;
+
+			for (int32_t child = m_firstChild[parent]; child != NULL_NODE; child = m_nextSibling[child])
+			{
+				bFoundInParent |= child == node;
+			}
+
+			assert(bFoundInParent);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Math/Matrix4.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	struct TransformHierarchyStats
+	{
+		TransformHierarchyStats()
+			: m_numNodes(0)
+			, m_numUpdated(0)
+			, m_bReordered(false)
+		{}
+
+		size_t m_numNodes;
+		size_t m_numUpdated;
+		bool m_bReordered;
+	};
+
+	// Parent/child links between local transforms and the world transforms they result in. Nodes are
+	// kept in depth first order, so parents come before their children and every subtree is one
+	// contiguous range. update() computes the world matrices in one pass over that order, only for
+	// the subtrees below changed nodes, and jumps over the ranges of subtrees without changes.
+	// Node ids stay the same while the order changes. Changing the structure reorders the nodes
+	// in the next update().
+	class TransformHierarchy
+	{
+	public:
+		enum
+		{
+			NULL_NODE = -1
+		};
+
+		TransformHierarchy();
+
+		// The node starts with an identity local transform, below the parent if there is one.
+		int32_t createNode(uint32_t userData, int32_t parent = NULL_NODE);
+
+		// The children of the node move to its parent, keeping their local transforms.
+		void destroyNode(int32_t node);
+
+		// NULL_NODE makes the node a root. The parent must not be in the subtree of the node.
+		void setParent(int32_t node, int32_t parent);
+
+		void setLocal(int32_t node, const Matrix4& local);
+
+		int32_t getParent(int32_t node) const;
+		uint32_t getUserData(int32_t node) const;
+		const Matrix4& getLocal(int32_t node) const;
+
+		// As of the last update().
+		const Matrix4& getWorld(int32_t node) const;
+
+		size_t getNumNodes() const;
+
+		// Computes the world transforms of the changed nodes and their subtrees.
+		const TransformHierarchyStats& update();
+
+		// Nodes whose world transform changed in the last update(), parents before children.
+		const std::vector<int32_t>& getUpdatedNodes() const;
+
+		// Asserts the order, ranges and links are consistent. For tests.
+		void validate() const;
+
+	private:
+		enum
+		{
+			LOCAL_CHANGED = 1 << 0, // The node needs a new world transform, and so does its subtree.
+			SUBTREE_CHANGED = 1 << 1 // Some node in the subtree, this one included, changed.
+		};
+
+		void markChanged(int32_t node);
+		void linkChild(int32_t node, int32_t parent);
+		void unlinkChild(int32_t node);
+
+		// Puts the nodes back in depth first order after the structure changed.
+		void reorder();
+
+		// Indexed by node id. Siblings are a doubly linked list for unlinking in constant time.
+		std::vector<int32_t> m_position;
+		std::vector<int32_t> m_parent;
+		std::vector<int32_t> m_firstChild;
+		std::vector<int32_t> m_nextSibling;
+		std::vector<int32_t> m_prevSibling;
+		std::vector<int32_t> m_freeIds;
+
+		// Indexed by position. New nodes are appended at the end until the next reorder.
+		std::vector<int32_t> m_nodeAt;
+		std::vector<int32_t> m_parentPosition;
+		std::vector<uint32_t> m_subtreeEnd; // One past the last position of the subtree.
+		std::vector<uint32_t> m_userData;
+		std::vector<uint8_t> m_flags;
+		std::vector<Matrix4> m_local;
+		std::vector<Matrix4> m_world;
+
+		std::vector<int32_t> m_updated;
+		std::vector<int32_t> m_stack;
+		bool m_bNeedsReorder;
+		TransformHierarchyStats m_stats;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Core/Archetype.hpp>
+#include <Core/EntityHandle.hpp>
+
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	// Archetypes matching a component mask. The World keeps one per mask that was asked for and
+	// appends new archetypes to the matching ones as they are created, so views never search.
+	struct ArchetypeQuery
+	{
+		ArchetypeQuery(ComponentMask mask)
+			: m_mask(mask)
+		{}
+
+		ComponentMask m_mask;
+		std::vector<Archetype*> m_archetypes;
+	};
+
+	template<typename F, typename... C>
+	void forEachInChunk(F& fn, size_t count, const EntityHandle* entities, C*... columns)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			fn(entities[i], columns[i]...);
+		}
+	}
+
+	template<typename F, typename... C>
+	void forEachChangedInChunk(F& fn, uint32_t sinceVersion, size_t count, const uint32_t* versions, const EntityHandle* entities, C*... columns)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (versions[i] > sinceVersion)
+			{
+				fn(entities[i], columns[i]...);
+			}
+		}
+	}
+
+	// The entities having all of the component types C, as returned by World::view(). Cheap to copy,
+	// and it sees entities and archetypes added after it was made. Iterating while components are
+	// added or entities destroyed is not supported.
+	template<typename... C>
+	class View
+	{
+	public:
+		View(const ArchetypeQuery* query)
+			: m_query(query)
+		{}
+
+		// Calls fn(EntityHandle, C&...) for every entity.
+		template<typename F>
+		void forEach(F fn) const
+		{
+			for (Archetype* archetype : m_query->m_archetypes)
+			{
+				const size_t numChunks = archetype->getNumChunks();
+
+				for (size_t chunk = 0; chunk < numChunks; ++chunk)
+				{
+					forEachInChunk(fn, archetype->getChunkSize(chunk), archetype->getEntities(chunk), archetype->template getColumn<C>(chunk)...);
+				}
+			}
+		}
+
+		// Calls fn(size_t count, const EntityHandle* entities, C*... columns) for every chunk of rows,
+		// for loops the compiler can vectorise over the packed columns.
+		template<typename F>
+		void forEachChunk(F fn) const
+		{
+			for (Archetype* archetype : m_query->m_archetypes)
+			{
+				const size_t numChunks = archetype->getNumChunks();
+
+				for (size_t chunk = 0; chunk < numChunks; ++chunk)
+				{
+					fn(archetype->getChunkSize(chunk), archetype->getEntities(chunk), archetype->template getColumn<C>(chunk)...);
+				}
+			}
+		}
+
+		// Calls fn(EntityHandle, C&...) for every entity whose component of type Changed changed after
+		// sinceVersion, see World::advanceChangeVersion(). Chunks without such changes are skipped.
+		template<typename Changed, typename F>
+		void forEachChangedSince(uint32_t sinceVersion, F fn) const
+		{
+			const ECType changedType = Changed::staticType();
+			assert((m_query->m_mask & componentBit(changedType)) && "Changes are only tracked for the types of the view.");
+
+			for (Archetype* archetype : m_query->m_archetypes)
+			{
+				const size_t numChunks = archetype->getNumChunks();
+
+				for (size_t chunk = 0; chunk < numChunks; ++chunk)
+				{
+					if (archetype->getChunkChangeVersion(changedType, chunk) <= sinceVersion)
+					{
+						continue;
+					}
+
+					const size_t count = archetype->getChunkSize(chunk);
+					const uint32_t* versions = archetype->getChangeVersions(changedType, chunk);
+					const EntityHandle* entities = archetype->getEntities(chunk);
+
+					forEachChangedInChunk(fn, sinceVersion, count, versions, entities, archetype->template getColumn<C>(chunk)...);
+				}
+			}
+		}
+
+		size_t size() const
+		{
+			size_t count = 0;
+
+			for (const Archetype* archetype : m_query->m_archetypes)
+			{
+				count += archetype->size();
+			}
+
+			return count;
+		}
+
+		const std::vector<Archetype*>& getArchetypes() const
+		{
+			return m_query->m_archetypes;
+		}
+
+	private:
+		const ArchetypeQuery* m_query;
+	};
+}
\ No newline at end of file
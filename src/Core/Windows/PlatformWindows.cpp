@@ -1,6 +1,8 @@
 #include "PlatformWindows.hpp"
 #include "PhiWindowsInclude.hpp"
+#include <Psapi.h>
 #include <algorithm>
+#include <string.h>
 
 #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
 #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
@@ -102,5 +104,121 @@ namespace Phoenix
 
 			return nullptr;
 		}
+
+		bool hasCMDFlag(char** start, char** end, const char* flag)
+		{
+			char** iter = std::find_if(start, end, [flag](const char* arg)
+			{
+				return strcmp(arg, flag) == 0;
+			});
+
+			return iter != end;
+		}
+
+		bool pinCurrentThread(size_t core)
+		{
+			if (core >= sizeof(DWORD_PTR) * 8)
+			{
+				return false;
+			}
+
+			return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+		}
+
+		// PrefetchVirtualMemory only exists from Windows 8 on.
+		typedef BOOL(WINAPI*PrefetchVirtualMemoryPtr)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+
+		bool mapFile(const char* path, MappedFile* outFile)
+		{
+			HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			LARGE_INTEGER size;
+
+			if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			{
+				CloseHandle(file);
+				return false;
+			}
+
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+			if (!view)
+			{
+				if (mapping)
+				{
+					CloseHandle(mapping);
+				}
+
+				CloseHandle(file);
+				return false;
+			}
+
+			static PrefetchVirtualMemoryPtr prefetchVirtualMemory = (PrefetchVirtualMemoryPtr)GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")), "PrefetchVirtualMemory");
+
+			if (prefetchVirtualMemory)
+			{
+				WIN32_MEMORY_RANGE_ENTRY range;
+				range.VirtualAddress = view;
+				range.NumberOfBytes = static_cast<SIZE_T>(size.QuadPart);
+				prefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+			}
+
+			outFile->m_data = static_cast<const uint8_t*>(view);
+			outFile->m_size = static_cast<size_t>(size.QuadPart);
+			outFile->m_file = file;
+			outFile->m_mapping = mapping;
+			return true;
+		}
+
+		void unmapFile(MappedFile* file)
+		{
+			if (!file->m_data)
+			{
+				return;
+			}
+
+			UnmapViewOfFile(file->m_data);
+			CloseHandle(file->m_mapping);
+			CloseHandle(file->m_file);
+			*file = MappedFile();
+		}
+
+		bool evictFileFromCache(const char* path)
+		{
+			// Opening a file without buffering makes the cache manager drop its pages.
+			HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			CloseHandle(file);
+			return true;
+		}
+
+		static PROCESS_MEMORY_COUNTERS getMemoryCounters()
+		{
+			PROCESS_MEMORY_COUNTERS counters = {};
+			counters.cb = sizeof(counters);
+			GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+			return counters;
+		}
+
+		size_t getResidentBytes()
+		{
+			return getMemoryCounters().WorkingSetSize;
+		}
+
+		size_t getPeakResidentBytes()
+		{
+			return getMemoryCounters().PeakWorkingSetSize;
+		}
 	}
 }
\ No newline at end of file
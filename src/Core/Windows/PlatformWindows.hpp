@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 namespace Phoenix
 {
 	namespace Platform
@@ -9,5 +12,45 @@ namespace Phoenix
 		bool enableConsoleColor(bool enabled);
 
 		char* getCMDOption(char** start, char** end, const char* option);
+
+		// Returns whether flag is one of the arguments in [start, end).
+		bool hasCMDFlag(char** start, char** end, const char* flag);
+
+		// Keeps the calling thread on one logical processor. False if that failed.
+		bool pinCurrentThread(size_t core);
+
+		// A file mapped read only into the address space, see mapFile().
+		struct MappedFile
+		{
+			MappedFile()
+				: m_data(nullptr)
+				, m_size(0)
+				, m_file(nullptr)
+				, m_mapping(nullptr)
+			{}
+
+			const uint8_t* m_data;
+			size_t m_size;
+			void* m_file;
+			void* m_mapping;
+		};
+
+		// Maps the whole file for reading front to back: it is opened with FILE_FLAG_SEQUENTIAL_SCAN,
+		// so the cache manager reads ahead, and the whole view is handed to PrefetchVirtualMemory,
+		// which pages it in with large reads up front where Windows 8 or later provides it.
+		// Reading the memory then comes straight from the file cache.
+		// False if the file cannot be opened or is empty.
+		bool mapFile(const char* path, MappedFile* outFile);
+
+		void unmapFile(MappedFile* file);
+
+		// Drops the cached pages of the file, so the next read comes from the disk. For benchmarks.
+		bool evictFileFromCache(const char* path);
+
+		// Physical memory used by the process, pages of mapped files included. For benchmarks.
+		size_t getResidentBytes();
+
+		// Most physical memory the process used at any point so far.
+		size_t getPeakResidentBytes();
 	}
 }
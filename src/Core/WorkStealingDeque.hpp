@@ -0,0 +1,184 @@
+#pragma once
+
+#include <assert.h>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	// Chase-Lev deque, with the memory orderings of Le, Pop, Cohen and Zappa Nardelli, "Correct and
+	// Efficient Work-Stealing for Weak Memory Models". The thread owning the deque pushes and pops at
+	// the bottom, the most recent item first. Other threads steal the oldest item from the top, and
+	// only fight over the last item with the owner. The ring grows when full. Old rings are kept
+	// until the deque is destroyed, a thief may still be reading one.
+	// T has to be trivially copyable, such as a pointer to the actual work.
+	template<typename T>
+	class WorkStealingDeque
+	{
+	public:
+		// Rounded up to a power of two.
+		explicit WorkStealingDeque(size_t capacity = 1024)
+			: m_top(0)
+			, m_bottom(0)
+		{
+			size_t size = 1;
+
+			while (size < capacity)
+			{
+				size *= 2;
+			}
+
+			m_ring.store(new Ring(size), std::memory_order_relaxed);
+		}
+
+		~WorkStealingDeque()
+		{
+			delete m_ring.load(std::memory_order_relaxed);
+
+			for (Ring* ring : m_oldRings)
+			{
+				delete ring;
+			}
+		}
+
+		WorkStealingDeque(const WorkStealingDeque&) = delete;
+		WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+		// Owner only.
+		void push(T item)
+		{
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+			const int64_t top = m_top.load(std::memory_order_acquire);
+			Ring* ring = m_ring.load(std::memory_order_relaxed);
+
+			if (bottom - top > static_cast<int64_t>(ring->m_mask))
+			{
+				ring = grow(ring, top, bottom);
+			}
+
+			ring->put(bottom, item);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		// Owner only. False if empty, or a thief took the last item.
+		bool pop(T* outItem)
+		{
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+			Ring* ring = m_ring.load(std::memory_order_relaxed);
+			m_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			*outItem = ring->get(bottom);
+
+			if (top < bottom)
+			{
+				return true;
+			}
+
+			// The last item, whoever moves the top first gets it.
+			const bool bWon = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return bWon;
+		}
+
+		// Any thread. False if empty, or another thread took the item first.
+		bool steal(T* outItem)
+		{
+			int64_t top = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+			{
+				return false;
+			}
+
+			Ring* ring = m_ring.load(std::memory_order_acquire);
+			const T item = ring->get(top);
+
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return false;
+			}
+
+			*outItem = item;
+			return true;
+		}
+
+		// Only a hint while other threads use the deque.
+		size_t size() const
+		{
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+			const int64_t top = m_top.load(std::memory_order_relaxed);
+			return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+		}
+
+		size_t capacity() const
+		{
+			return m_ring.load(std::memory_order_relaxed)->m_mask + 1;
+		}
+
+	private:
+		struct Ring
+		{
+			Ring(size_t size)
+				: m_mask(size - 1)
+				, m_items(new std::atomic<T>[size])
+			{}
+
+			~Ring()
+			{
+				delete[] m_items;
+			}
+
+			void put(int64_t index, T item)
+			{
+				m_items[index & m_mask].store(item, std::memory_order_relaxed);
+			}
+
+			T get(int64_t index) const
+			{
+				return m_items[index & m_mask].load(std::memory_order_relaxed);
+			}
+
+			size_t m_mask;
+			std::atomic<T>* m_items;
+		};
+
+		Ring* grow(Ring* ring, int64_t top, int64_t bottom)
+		{
+			Ring* bigger = new Ring(2 * (ring->m_mask + 1));
+
+			for (int64_t i = top; i < bottom; ++i)
+			{
+				bigger->put(i, ring->get(i));
+			}
+
+			m_oldRings.push_back(ring);
+			m_ring.store(bigger, std::memory_order_release);
+			return bigger;
+		}
+
+		enum
+		{
+			CACHE_LINE_BYTES = 64
+		};
+
+		// Thieves write the top, the owner the bottom, so they are kept on separate cache lines.
+		std::atomic<int64_t> m_top;
+		char m_topPadding[CACHE_LINE_BYTES - sizeof(std::atomic<int64_t>)];
+		std::atomic<int64_t> m_bottom;
+		std::atomic<Ring*> m_ring;
+		std::vector<Ring*> m_oldRings; // Owner only.
+	};
+}
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include "WorkerPool.hpp"
+
+#include <Core/Windows/PlatformWindows.hpp>
+
+#include <chrono>
+
+namespace Phoenix
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	enum
+	{
+		DEQUE_CAPACITY = 1024,
+
+		// Rounds of looking for a job before a worker goes to sleep.
+		IDLE_SPINS = 64,
+
+		// Finished jobs kept per thread for the next submit instead of freeing them.
+		MAX_CACHED_JOBS = 256
+	};
+
+	// The pool the thread works for and its index in it.
+	static thread_local const WorkerPool* t_pool = nullptr;
+	static thread_local size_t t_threadIndex = 0;
+
+	// Nesting of jobs on this thread, and when the thread last started or resumed running one.
+	static thread_local int32_t t_jobDepth = 0;
+	static thread_local Clock::time_point t_busySince;
+
+	static thread_local uint32_t t_stealSeed = 0;
+
+	// Frees the cached jobs when the thread exits.
+	template<typename Job>
+	struct JobCache
+	{
+		~JobCache()
+		{
+			for (Job* job : m_jobs)
+			{
+				delete job;
+			}
+		}
+
+		std::vector<Job*> m_jobs;
+	};
+
+	WorkerPool::WorkerPool(size_t numThreads)
+		: m_numInjected(0)
+		, m_numQueued(0)
+		, m_numSleeping(0)
+		, m_bQuit(false)
+		, m_numSteals(0)
+	{
+		if (numThreads == 0)
+		{
+			numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		m_busyNs.reset(new std::atomic<int64_t>[numThreads]);
+
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			m_busyNs[i] = 0;
+			m_deques.emplace_back(new WorkStealingDeque<Job*>(DEQUE_CAPACITY));
+		}
+
+		t_pool = this;
+		t_threadIndex = 0;
+
+		for (size_t i = 1; i < numThreads; ++i)
+		{
+			m_threads.emplace_back(&WorkerPool::workerMain, this, i);
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		assert(m_numQueued == 0 && "Jobs are still waiting to run.");
+
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_bQuit = true;
+		}
+
+		m_jobQueued.notify_all();
+
+		for (std::thread& thread : m_threads)
+		{
+			thread.join();
+		}
+
+		if (t_pool == this)
+		{
+			t_pool = nullptr;
+			t_threadIndex = 0;
+		}
+	}
+
+	size_t WorkerPool::getNumThreads() const
+	{
+		return m_threads.size() + 1;
+	}
+
+	void WorkerPool::submit(Task task, std::atomic<int32_t>* counter)
+	{
+		counter->fetch_add(1);
+
+		std::vector<Job*>& cachedJobs = getJobCache();
+		Job* job;
+
+		if (!cachedJobs.empty())
+		{
+			job = cachedJobs.back();
+			cachedJobs.pop_back();
+		}
+		else
+		{
+			job = new Job();
+		}
+
+		job->m_task = std::move(task);
+		job->m_counter = counter;
+
+		// Counted before looking for sleepers. A worker about to sleep counts itself before
+		// looking at the queued jobs, so one of the two sees the other.
+		++m_numQueued;
+
+		const size_t localIndex = getLocalIndex();
+
+		if (localIndex != NOT_IN_POOL)
+		{
+			m_deques[localIndex]->push(job);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_injectedMutex);
+			m_injected.push_back(job);
+			++m_numInjected;
+		}
+
+		if (m_numSleeping > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_jobQueued.notify_one();
+		}
+	}
+
+	void WorkerPool::wait(std::atomic<int32_t>* counter)
+	{
+		const size_t localIndex = getLocalIndex();
+		const size_t busyIndex = localIndex == NOT_IN_POOL ? 0 : localIndex;
+
+		// Time spent waiting inside a job is not busy time of the job.
+		const bool bInJob = t_jobDepth > 0;
+
+		if (bInJob)
+		{
+			m_busyNs[busyIndex] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t_busySince).count();
+		}
+
+		while (counter->load(std::memory_order_acquire) > 0)
+		{
+			if (Job* job = findJob(localIndex))
+			{
+				runJob(job, busyIndex);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		if (bInJob)
+		{
+			t_busySince = Clock::now();
+		}
+	}
+
+	void WorkerPool::takeBusyTimes(std::vector<double>* outBusyMs)
+	{
+		outBusyMs->resize(getNumThreads());
+
+		for (size_t i = 0; i < outBusyMs->size(); ++i)
+		{
+			(*outBusyMs)[i] = m_busyNs[i].exchange(0) / 1e6;
+		}
+	}
+
+	uint64_t WorkerPool::getNumSteals() const
+	{
+		return m_numSteals;
+	}
+
+	size_t WorkerPool::getThreadIndex()
+	{
+		return t_threadIndex;
+	}
+
+	std::vector<WorkerPool::Job*>& WorkerPool::getJobCache()
+	{
+		static thread_local JobCache<Job> t_jobCache;
+		return t_jobCache.m_jobs;
+	}
+
+	size_t WorkerPool::getLocalIndex() const
+	{
+		return t_pool == this ? t_threadIndex : NOT_IN_POOL;
+	}
+
+	void WorkerPool::workerMain(size_t threadIndex)
+	{
+		t_pool = this;
+		t_threadIndex = threadIndex;
+		t_stealSeed = static_cast<uint32_t>(threadIndex) * 2654435761u + 1;
+
+		// Thread 0 is left to the OS, it is usually the main thread.
+		Platform::pinCurrentThread(threadIndex % std::max(std::thread::hardware_concurrency(), 1u));
+
+		int idleSpins = 0;
+
+		while (true)
+		{
+			if (Job* job = findJob(threadIndex))
+			{
+				runJob(job, threadIndex);
+				idleSpins = 0;
+				continue;
+			}
+
+			if (++idleSpins < IDLE_SPINS)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			++m_numSleeping;
+			m_jobQueued.wait(lock, [this]() { return m_bQuit || m_numQueued > 0; });
+			--m_numSleeping;
+
+			if (m_bQuit && m_numQueued == 0)
+			{
+				return;
+			}
+
+			idleSpins = 0;
+		}
+	}
+
+	WorkerPool::Job* WorkerPool::findJob(size_t localIndex)
+	{
+		Job* job = nullptr;
+
+		if (localIndex != NOT_IN_POOL && m_deques[localIndex]->pop(&job))
+		{
+			--m_numQueued;
+			return job;
+		}
+
+		// From a random victim on, so thieves spread over the deques.
+		const size_t numDeques = m_deques.size();
+		t_stealSeed = t_stealSeed * 1664525u + 1013904223u;
+		const size_t first = (t_stealSeed >> 8) % numDeques;
+
+		for (size_t i = 0; i < numDeques; ++i)
+		{
+			const size_t victim = (first + i) % numDeques;
+
+			if (victim != localIndex && m_deques[victim]->steal(&job))
+			{
+				++m_numSteals;
+				--m_numQueued;
+				return job;
+			}
+		}
+
+		if (m_numInjected > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_injectedMutex);
+
+			if (!m_injected.empty())
+			{
+				job = m_injected.front();
+				m_injected.pop_front();
+				--m_numInjected;
+				--m_numQueued;
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void WorkerPool::runJob(Job* job, size_t busyIndex)
+	{
+		++t_jobDepth;
+		t_busySince = Clock::now();
+
+		job->m_task();
+
+		m_busyNs[busyIndex] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t_busySince).count();
+		--t_jobDepth;
+
+		// What the task captured goes before the waiting thread may return and release it.
+		std::atomic<int32_t>* counter = job->m_counter;
+		job->m_task = nullptr;
+
+		std::vector<Job*>& cachedJobs = getJobCache();
+
+		if (cachedJobs.size() < MAX_CACHED_JOBS)
+		{
+			cachedJobs.push_back(job);
+		}
+		else
+		{
+			delete job;
+		}
+
+		counter->fetch_sub(1, std::memory_order_release);
+	}
+}
\ No newline at end of file
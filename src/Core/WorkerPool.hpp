@@ -0,0 +1,139 @@
+#pragma once
+
+#include <Core/WorkStealingDeque.hpp>
+
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace Phoenix
+{
+	// Work stealing job system. Every thread of the pool has its own deque, jobs submitted from a
+	// thread of the pool go on its deque and it runs the newest of them first, while idle threads
+	// steal the oldest ones from the others. Jobs submitted by threads outside of the pool are
+	// queued for all. The thread that creates the pool counts as thread 0 and runs jobs while it
+	// waits, so a pool of one thread runs everything on the caller. The other threads are pinned
+	// to a core each and sleep when there is nothing to run.
+	// Fork and join goes through counters: submit() increments one, the job decrements it once it
+	// ran, and wait() runs other jobs until it is zero. Jobs may submit and wait for more jobs.
+	class WorkerPool
+	{
+	public:
+		typedef std::function<void()> Task;
+
+		// numThreads includes the calling thread, 0 starts one per hardware thread.
+		explicit WorkerPool(size_t numThreads = 0);
+
+		// All jobs have to be done.
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		size_t getNumThreads() const;
+
+		// Increments the counter and decrements it again once the task ran.
+		void submit(Task task, std::atomic<int32_t>* counter);
+
+		// Runs jobs until the counter is zero.
+		void wait(std::atomic<int32_t>* counter);
+
+		// Calls fn(begin, end) for consecutive ranges of at most grainSize of [0, count), spread
+		// over the threads. The range is halved recursively, so thieves take large pieces and
+		// the submitting thread works through the rest in order. Returns after all of them.
+		template<typename F>
+		void parallelFor(size_t count, size_t grainSize, F fn);
+
+		// Milliseconds each thread spent running jobs since the last call, not counting the time
+		// jobs spent waiting.
+		void takeBusyTimes(std::vector<double>* outBusyMs);
+
+		// Jobs taken from the deque of another thread since the pool started.
+		uint64_t getNumSteals() const;
+
+		// Index of the calling thread in the pool it works for, 0 for all other threads.
+		static size_t getThreadIndex();
+
+	private:
+		struct Job
+		{
+			Task m_task;
+			std::atomic<int32_t>* m_counter;
+		};
+
+		// Splits off the upper half as a job until the range is small enough to run.
+		template<typename F>
+		void runRange(size_t begin, size_t end, size_t grainSize, F* fn, std::atomic<int32_t>* counter);
+
+		void workerMain(size_t threadIndex);
+
+		// The pool's index of the calling thread, NOT_IN_POOL for threads outside of it.
+		size_t getLocalIndex() const;
+
+		// Finished jobs of the calling thread, reused by its next submits.
+		static std::vector<Job*>& getJobCache();
+
+		// Null if no deque or queue had a job.
+		Job* findJob(size_t localIndex);
+		void runJob(Job* job, size_t localIndex);
+
+		enum : size_t
+		{
+			NOT_IN_POOL = ~size_t(0)
+		};
+
+		std::vector<std::thread> m_threads;
+		std::vector<std::unique_ptr<WorkStealingDeque<Job*>>> m_deques; // Per thread.
+
+		// Jobs from threads outside of the pool.
+		std::mutex m_injectedMutex;
+		std::deque<Job*> m_injected;
+		std::atomic<size_t> m_numInjected;
+
+		// Submitted jobs not taken yet. Workers sleep while there are none.
+		std::atomic<size_t> m_numQueued;
+		std::atomic<size_t> m_numSleeping;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_jobQueued;
+		bool m_bQuit;
+
+		std::unique_ptr<std::atomic<int64_t>[]> m_busyNs; // Per thread.
+		std::atomic<uint64_t> m_numSteals;
+	};
+
+	template<typename F>
+	void WorkerPool::parallelFor(size_t count, size_t grainSize, F fn)
+	{
+		assert(grainSize > 0);
+		std::atomic<int32_t> counter(0);
+
+		if (count > 0)
+		{
+			submit([this, count, grainSize, &fn, &counter]() { runRange(0, count, grainSize, &fn, &counter); }, &counter);
+		}
+
+		wait(&counter);
+	}
+
+	template<typename F>
+	void WorkerPool::runRange(size_t begin, size_t end, size_t grainSize, F* fn, std::atomic<int32_t>* counter)
+	{
+		while (end - begin > grainSize)
+		{
+			const size_t middle = begin + (end - begin) / 2;
+			submit([this, middle, end, grainSize, fn, counter]() { runRange(middle, end, grainSize, fn, counter); }, counter);
+			end = middle;
+		}
+
+		(*fn)(begin, end);
+	}
+}
\ No newline at end of file
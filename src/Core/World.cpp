@@ -2,154 +2,230 @@
 
 #include "World.hpp"
 #include <Core/Component.hpp>
-#include <Core/Serialize.hpp>
-#include <Core/SerialUtil.hpp>
 #include <assert.h>
 
 namespace Phoenix
 {
-	void World::addComponentFactory(ECType type, const ComponentFactory& factory)
+	World::World()
+		: m_entities(ENTITIES_PER_PAGE)
+		, m_numEntities(0)
+		, m_changeVersion(1)
 	{
-		auto& entry = m_factories.find(type);
+		m_entities.add();
 
-		if (entry != m_factories.end())
+		for (ComponentTypeInfo& info : m_typeInfos)
 		{
-			assert(false);
-			return;
+			info = ComponentTypeInfo();
 		}
 
-		m_factories.emplace(type, factory);
+		m_archetypes.push_back(new Archetype(0, m_typeInfos));
+	}
+
+	World::~World()
+	{
+		for (Archetype* archetype : m_archetypes)
+		{
+			delete archetype;
+		}
+
+		for (ArchetypeQuery* query : m_queries)
+		{
+			delete query;
+		}
 	}
 
 	EntityHandle World::createEntity()
 	{
-		assert(m_lastEntityIdx < MAX_ENTITIES);
-		return m_lastEntityIdx++;
+		return createEntity(0);
 	}
 
-	bool World::handleIsValid(EntityHandle handle) const
+	EntityHandle World::createEntity(ComponentMask mask)
 	{
-		return (handle != INVALID_ENTITY && m_lastEntityIdx < MAX_ENTITIES && handle <= m_lastEntityIdx);
+		uint32_t index;
+
+		if (m_freeIndices.size() > MIN_FREE_INDICES)
+		{
+			index = m_freeIndices.front();
+			m_freeIndices.pop_front();
+		}
+		else
+		{
+			assert(m_entities.size() < MAX_ENTITIES);
+			index = static_cast<uint32_t>(m_entities.size());
+			m_entities.add();
+		}
+
+		Entity& entity = m_entities[index];
+		EntityHandle handle = makeEntityHandle(index, entity.m_generation);
+
+		entity.m_archetype = mask ? getArchetype(mask) : m_archetypes[0];
+		entity.m_row = entity.m_archetype->addRow(handle, m_changeVersion);
+		++m_numEntities;
+
+		for (size_t type = 0; mask >> type; ++type)
+		{
+			if (mask & componentBit(static_cast<ECType>(type)))
+			{
+				static_cast<Component*>(entity.m_archetype->getComponent(static_cast<ECType>(type), entity.m_row))->m_owner = handle;
+			}
+		}
+
+		return handle;
 	}
 
-	Entity* World::getEntity(EntityHandle handle)
+	void World::destroyEntity(EntityHandle handle)
 	{
 		assert(handleIsValid(handle));
-		return &m_entites[handle];
+		const uint32_t index = entityIndex(handle);
+		Entity& entity = m_entities[index];
+
+		EntityHandle moved = entity.m_archetype->removeRow(entity.m_row);
+		m_entities[entityIndex(moved)].m_row = entity.m_row;
+
+		entity.m_archetype = nullptr;
+		entity.m_row = 0;
+		entity.m_generation = (entity.m_generation + 1) & ENTITY_GENERATION_MASK;
+
+		m_freeIndices.push_back(index);
+		--m_numEntities;
 	}
 
-	Component* World::addComponent(EntityHandle handle, ECType type)
+	bool World::handleIsValid(EntityHandle handle) const
 	{
-		assert(handleIsValid(handle));
-		Entity& entity = m_entites[handle];
+		const uint32_t index = entityIndex(handle);
 
-		ComponentFactory* factory = getCFactory(type);
-		assert(factory != nullptr);
+		if (0 == index || index >= m_entities.size())
+		{
+			return false;
+		}
 
-		Component* component = (*factory)();
-		component->m_owner = handle;
-		entity.addComponent(component);
-		return component;
+		const Entity& entity = m_entities[index];
+		return entity.m_archetype != nullptr && entity.m_generation == entityGeneration(handle);
 	}
 
-	Component* World::getComponent(EntityHandle handle, ECType type)
+	Entity* World::getEntity(EntityHandle handle)
 	{
 		assert(handleIsValid(handle));
-		return m_entites[handle].getComponent(type);
+		return &m_entities[entityIndex(handle)];
 	}
-	
-	void serialize(Archive* ar, ECType& ectype)
+
+	size_t World::getNumEntities() const
 	{
-		ar->serialize(&ectype, sizeof(ECType));
+		return m_numEntities;
 	}
 
-	void saveEntityHeader(Entity* entity, WriteArchive* ar)
+	Archetype* World::getArchetype(ComponentMask mask)
 	{
-		size_t numComponents = entity->m_components.size();
-		serialize(ar, numComponents);
-
-		for (auto& kvp : entity->m_components)
+		for (Archetype* archetype : m_archetypes)
 		{
-			Component* component = kvp.second;
-			ECType type = component->type();
-			serialize(ar, type);
+			if (archetype->getMask() == mask)
+			{
+				return archetype;
+			}
 		}
-	}
 
-	void saveComponentData(Entity* entity, WriteArchive* ar)
-	{
-		for (auto& kvp : entity->m_components)
+		Archetype* archetype = new Archetype(mask, m_typeInfos);
+		m_archetypes.push_back(archetype);
+
+		for (ArchetypeQuery* query : m_queries)
 		{
-			Component* component = kvp.second;
-			component->save(ar);
+			if ((mask & query->m_mask) == query->m_mask)
+			{
+				query->m_archetypes.push_back(archetype);
+			}
 		}
+
+		return archetype;
 	}
 
-	void saveWorld(World* world, const char* path)
+	const ArchetypeQuery* World::getQuery(ComponentMask mask)
 	{
-		WriteArchive ar;
-		createWriteArchive(0, &ar);
+		std::lock_guard<std::mutex> lock(m_queryMutex);
 
-		size_t numEntities = world->m_lastEntityIdx - 1;
-		serialize(&ar, numEntities);
-
-		for (size_t i = World::FIRST_VALID_ENTITY; i <= world->m_lastEntityIdx; ++i)
+		for (const ArchetypeQuery* query : m_queries)
 		{
-			saveEntityHeader(world->getEntity(i), &ar);
-			saveComponentData(world->getEntity(i), &ar);
+			if (query->m_mask == mask)
+			{
+				return query;
+			}
 		}
 
-		EArchiveError err = writeArchiveToDisk(path, ar);
-		assert(err == EArchiveError::NoError);
-		destroyArchive(ar);
+		ArchetypeQuery* query = new ArchetypeQuery(mask);
+		getArchetypes(mask, &query->m_archetypes);
+		m_queries.push_back(query);
+		return query;
 	}
 
-	void addComponentsFromEntityHeader(ReadArchive* ar, EntityHandle eHandle, World* world)
+	Component* World::addComponent(EntityHandle handle, ECType type)
 	{
-		size_t numComponents = 0;
-		serialize(ar, numComponents);
+		assert(handleIsValid(handle));
+		Entity& entity = m_entities[entityIndex(handle)];
+		Archetype* source = entity.m_archetype;
 
-		for (size_t i = 0; i < numComponents; ++i)
+		if (Component* existing = static_cast<Component*>(source->getComponent(type, entity.m_row)))
 		{
-			ECType type;
-			serialize(ar, type);
-			world->addComponent(eHandle, type);
+			return existing;
 		}
-	}
 
-	void loadComponentData(ReadArchive* ar, Entity* entity, LoadResources* resources)
-	{
-		for (auto& kvp : entity->m_components)
+		// The search for the target archetype only happens the first time an entity moves along this edge.
+		Archetype*& target = source->m_addEdges[type];
+
+		if (!target)
 		{
-			Component* component = kvp.second;
-			component->load(ar, resources);
+			target = getArchetype(source->getMask() | componentBit(type));
 		}
+
+		size_t row = target->addRowMovedFrom(source, entity.m_row, m_changeVersion);
+		EntityHandle moved = source->removeRow(entity.m_row);
+		m_entities[entityIndex(moved)].m_row = entity.m_row;
+
+		entity.m_archetype = target;
+		entity.m_row = row;
+
+		Component* component = static_cast<Component*>(target->getComponent(type, row));
+		component->m_owner = handle;
+		return component;
 	}
 
-	void loadWorld(const char* path, World* outWorld, LoadResources* resources)
+	Component* World::getComponent(EntityHandle handle, ECType type)
 	{
-		ReadArchive ar;
-		EArchiveError err = createReadArchive(path, &ar);
+		assert(handleIsValid(handle));
+		const Entity& entity = m_entities[entityIndex(handle)];
+		return static_cast<Component*>(entity.m_archetype->getComponent(type, entity.m_row));
+	}
 
-		assert(err == EArchiveError::NoError);
-		if (err != EArchiveError::NoError)
-		{
-			return;
-		}
+	void World::markChanged(EntityHandle handle, ECType type)
+	{
+		assert(handleIsValid(handle));
+		const Entity& entity = m_entities[entityIndex(handle)];
+		entity.m_archetype->setChanged(type, entity.m_row, m_changeVersion);
+	}
+
+	uint32_t World::getChangeVersion() const
+	{
+		return m_changeVersion;
+	}
 
-		size_t numEntitiesToLoad = 0;
+	uint32_t World::advanceChangeVersion()
+	{
+		return m_changeVersion++;
+	}
 
-		serialize(&ar, numEntitiesToLoad);
+	void World::getArchetypes(ComponentMask mask, std::vector<Archetype*>* outArchetypes)
+	{
+		outArchetypes->clear();
 
-		for (size_t i = 0; i < numEntitiesToLoad; ++i)
+		for (Archetype* archetype : m_archetypes)
 		{
-			EntityHandle eHandle = outWorld->createEntity();
-			Entity* entity = outWorld->getEntity(eHandle);
-
-			addComponentsFromEntityHeader(&ar, eHandle, outWorld);
-			loadComponentData(&ar, entity, resources);
+			if ((archetype->getMask() & mask) == mask)
+			{
+				outArchetypes->push_back(archetype);
+			}
 		}
+	}
 
-		destroyArchive(ar);
+	size_t World::getNumArchetypes() const
+	{
+		return m_archetypes.size();
 	}
 }
\ No newline at end of file
@@ -3,40 +3,76 @@
 #include <Core/EntityHandle.hpp>
 #include <Core/ECType.hpp>
 #include <Core/Entity.hpp>
+#include <Core/Archetype.hpp>
+#include <Core/View.hpp>
 
-#include <unordered_map>
-#include <functional>
+#include <Memory/ChunkArray.hpp>
+
+#include <deque>
+#include <mutex>
+#include <vector>
 
 namespace Phoenix
 {
 	class Component;
-	struct Entity;
-	struct LoadResources;
-
-	typedef std::function<Component*(void)> ComponentFactory;
-
-	typedef std::unordered_map<ECType, ComponentFactory> CFactoryTable;
 
+	// Owns the entities and their components. Entities with the same set of component types share
+	// an archetype, which keeps each type in a chunked column. Systems iterate the columns with
+	// forEach() instead of looking components up one entity at a time.
 	class World
 	{
 	public:
 		enum
 		{
-			MAX_ENTITIES = 1024,
+			MAX_ENTITIES = 1 << ENTITY_INDEX_BITS,
 			INVALID_ENTITY = 0,
-			FIRST_VALID_ENTITY = 1
+			ENTITIES_PER_PAGE = 4096,
+
+			// Destroyed slots are reused oldest first once more than this many are free, so a
+			// slot goes through its generations slowly and stale handles are caught for longer.
+			MIN_FREE_INDICES = 1024
 		};
 
-		World()
-			: m_lastEntityIdx(1) {}
+		World();
+		~World();
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		// A component type has to be registered before it is added to an entity.
+		template<typename C>
+		void registerComponentType()
+		{
+			m_typeInfos[C::staticType()] = makeComponentTypeInfo<C>();
+		}
 
 		EntityHandle createEntity();
+
+		// Creates the entity with default constructed components of the types in the mask right
+		// away, instead of moving it through an archetype per type like addComponent() does.
+		EntityHandle createEntity(ComponentMask mask);
+
+		// Destroys the components and frees the slot. Handles to the entity become invalid and
+		// pointers to the components of the last entity in its archetype move into its row.
+		void destroyEntity(EntityHandle handle);
+
+		// False for handles to destroyed entities, also after their slot has been reused.
 		bool handleIsValid(EntityHandle handle) const;
 		Entity* getEntity(EntityHandle handle);
 
-		void addComponentFactory(ECType type, const ComponentFactory& factory);
+		size_t getNumEntities() const;
 
+		// Calls fn(EntityHandle) for every live entity in slot order. Entities may be destroyed
+		// from fn, created ones may or may not be visited.
+		template<typename F>
+		void forEachEntity(F fn);
+
+		// Moves the entity to the archetype with one more type, returns the existing component if
+		// it already has one. Moving invalidates pointers to the components of this entity and of
+		// the entity that takes over its row in the old archetype.
 		Component* addComponent(EntityHandle handle, ECType type);
+
+		// Null if the entity has no component of the type.
 		Component* getComponent(EntityHandle handle, ECType type);
 
 		template<typename C>
@@ -51,27 +87,73 @@ namespace Phoenix
 			return static_cast<C*>(getComponent(handle, C::staticType()));
 		}
 
-		Entity m_entites[MAX_ENTITIES];
-		size_t m_lastEntityIdx;
+		// Records that the component of the entity changed in the current change version. Adding a
+		// component counts as a change too.
+		void markChanged(EntityHandle handle, ECType type);
 
-	private:
-		ComponentFactory* getCFactory(ECType type)
+		template<typename C>
+		void markChanged(EntityHandle handle)
 		{
-			auto& entry = m_factories.find(type);
+			markChanged(handle, C::staticType());
+		}
 
-			if (entry != m_factories.end())
-			{
-				return &(entry->second);
-			}
-			else
-			{
-				return nullptr;
-			}
+		// Version changes are recorded in. Starts at 1, so a system that has seen nothing yet
+		// remembers version 0 and gets every component as changed.
+		uint32_t getChangeVersion() const;
+
+		// Returns the current change version and starts the next one. A system calls this after
+		// going over the changes and passes the result as sinceVersion the next time, so it sees
+		// everything changed after it looked, including changes it made itself later on.
+		uint32_t advanceChangeVersion();
+
+		// Entities having all of the component types. The archetypes matching a set of types are
+		// found once and kept up to date as new ones are created, a view only walks their columns.
+		template<typename... C>
+		View<C...> view()
+		{
+			return View<C...>(getQuery(makeComponentMask<C...>()));
+		}
+
+		// Calls fn(EntityHandle, C&...) for every entity having all of the component types,
+		// walking the contiguous columns of each matching archetype chunk by chunk.
+		template<typename... C, typename F>
+		void forEach(F fn)
+		{
+			view<C...>().forEach(fn);
 		}
 
-		CFactoryTable m_factories;
+		// Archetypes that have all the types of the mask.
+		void getArchetypes(ComponentMask mask, std::vector<Archetype*>* outArchetypes);
+
+		size_t getNumArchetypes() const;
+
+	private:
+		Archetype* getArchetype(ComponentMask mask);
+		const ArchetypeQuery* getQuery(ComponentMask mask);
+
+		// Slots live in pages, growing never moves them. Slot 0 stays free for INVALID_ENTITY.
+		ChunkArray<Entity> m_entities;
+		std::deque<uint32_t> m_freeIndices;
+		size_t m_numEntities;
+
+		ComponentTypeInfo m_typeInfos[ECType::CT_Max];
+		std::vector<Archetype*> m_archetypes; // The first one has no components.
+		std::vector<ArchetypeQuery*> m_queries;
+		std::mutex m_queryMutex; // Systems running at the same time ask for views.
+		uint32_t m_changeVersion;
 	};
 
-	void saveWorld(World* world, const char* path);
-	void loadWorld(const char* path, World* outWorld, LoadResources* resources);
-}
+	template<typename F>
+	void World::forEachEntity(F fn)
+	{
+		for (size_t index = 1; index < m_entities.size(); ++index)
+		{
+			const Entity& entity = m_entities[index];
+
+			if (entity.m_archetype)
+			{
+				fn(makeEntityHandle(static_cast<uint32_t>(index), entity.m_generation));
+			}
+		}
+	}
+}
\ No newline at end of file
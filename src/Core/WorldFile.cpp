@@ -0,0 +1,694 @@
+#include "WorldFile.hpp"
+
+#include <Core/Component.hpp>
+#include <Core/Logger.hpp>
+#include <Core/RadixSort.hpp>
+#include <Core/SerialUtil.hpp>
+#include <Core/WorkerPool.hpp>
+#include <Core/World.hpp>
+#include <Core/Components/CTransform.hpp>
+#include <Math/Matrix4.hpp>
+#include <Math/Vec4.hpp>
+
+#include <assert.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+namespace Phoenix
+{
+	enum
+	{
+		// Bits per axis of the Morton code entities are sorted by.
+		MORTON_AXIS_BITS = 21,
+
+		TOC_ALIGNMENT = 16,
+
+		FIRST_VERSION_WITH_PARENTS = 2
+	};
+
+	// Spreads the low 21 bits of v so there are two zero bits between each of them.
+	static uint64_t spreadBits(uint64_t v)
+	{
+		v &= 0x1fffff;
+		v = (v | v << 32) & 0x1f00000000ffffull;
+		v = (v | v << 16) & 0x1f0000ff0000ffull;
+		v = (v | v << 8) & 0x100f00f00f00f00full;
+		v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+		v = (v | v << 2) & 0x1249249249249249ull;
+		return v;
+	}
+
+	static uint64_t quantize(float value, float min, float scale)
+	{
+		const float q = (value - min) * scale;
+		return q > 0.f ? static_cast<uint64_t>(q) : 0;
+	}
+
+	static void growBounds(const Vec3& point, Vec3* min, Vec3* max)
+	{
+		min->x = std::min(min->x, point.x);
+		min->y = std::min(min->y, point.y);
+		min->z = std::min(min->z, point.z);
+		max->x = std::max(max->x, point.x);
+		max->y = std::max(max->y, point.y);
+		max->z = std::max(max->z, point.z);
+	}
+
+	static bool overlaps(const Vec3& minA, const Vec3& maxA, const Vec3& minB, const Vec3& maxB)
+	{
+		return minA.x <= maxB.x && maxA.x >= minB.x
+			&& minA.y <= maxB.y && maxA.y >= minB.y
+			&& minA.z <= maxB.z && maxA.z >= minB.z;
+	}
+
+	// The local translation moved through the transforms of the parents. Saving does not rely on
+	// m_transform, which is only up to date once the TransformSystem ran.
+	static Vec3 getWorldTranslation(World* world, const CTransform* transform)
+	{
+		Vec4 translation(transform->getTranslation(), 1.f);
+		EntityHandle parent = transform->getParent();
+
+		// No chain is longer than there are entities, unless it has a cycle.
+		for (size_t depth = 0; depth < world->getNumEntities() && world->handleIsValid(parent); ++depth)
+		{
+			const CTransform* parentTransform = world->getComponent<CTransform>(parent);
+
+			if (!parentTransform)
+			{
+				break;
+			}
+
+			const Matrix4 local = Matrix4::translation(parentTransform->getTranslation())
+				* Matrix4::rotation(parentTransform->getRotation()) * Matrix4::scale(parentTransform->getScale());
+
+			translation = local * translation;
+			parent = parentTransform->getParent();
+		}
+
+		return Vec3(translation);
+	}
+
+	// Of every row, empty for archetypes without CTransform.
+	static void getWorldTranslations(World* world, Archetype* archetype, std::vector<Vec3>* outTranslations)
+	{
+		outTranslations->clear();
+
+		if (!archetype->hasType(ECType::CT_Transform))
+		{
+			return;
+		}
+
+		outTranslations->resize(archetype->size());
+
+		for (size_t row = 0; row < archetype->size(); ++row)
+		{
+			(*outTranslations)[row] = getWorldTranslation(world, static_cast<CTransform*>(archetype->getComponent(ECType::CT_Transform, row)));
+		}
+	}
+
+	// Rows of the archetype along a Morton curve through their translations, in row order without those.
+	static void sortRows(Archetype* archetype, const std::vector<Vec3>& translations, std::vector<uint32_t>* outRows)
+	{
+		const size_t numRows = archetype->size();
+		outRows->resize(numRows);
+
+		for (size_t row = 0; row < numRows; ++row)
+		{
+			(*outRows)[row] = static_cast<uint32_t>(row);
+		}
+
+		if (translations.empty())
+		{
+			return;
+		}
+
+		Vec3 min(FLT_MAX), max(-FLT_MAX);
+
+		for (size_t row = 0; row < numRows; ++row)
+		{
+			growBounds(translations[row], &min, &max);
+		}
+
+		const float cells = static_cast<float>((1 << MORTON_AXIS_BITS) - 1);
+		const Vec3 scale(
+			max.x > min.x ? cells / (max.x - min.x) : 0.f,
+			max.y > min.y ? cells / (max.y - min.y) : 0.f,
+			max.z > min.z ? cells / (max.z - min.z) : 0.f);
+
+		std::vector<uint64_t> keys(numRows), tempKeys(numRows);
+		std::vector<uint32_t> tempRows(numRows);
+
+		for (size_t row = 0; row < numRows; ++row)
+		{
+			const Vec3& t = translations[row];
+			keys[row] = spreadBits(quantize(t.x, min.x, scale.x))
+				| spreadBits(quantize(t.y, min.y, scale.y)) << 1
+				| spreadBits(quantize(t.z, min.z, scale.z)) << 2;
+		}
+
+		radixSort(keys.data(), outRows->data(), tempKeys.data(), tempRows.data(), numRows);
+	}
+
+	void saveWorld(World* world, const char* path)
+	{
+		WriteArchive ar;
+		createWriteArchive(0, &ar);
+
+		WorldFileHeader header = {};
+		header.m_magic = WORLD_FILE_MAGIC;
+		header.m_version = WORLD_FILE_VERSION;
+		header.m_numEntities = world->getNumEntities();
+		ar.serialize(&header, sizeof(header));
+
+		std::vector<Archetype*> archetypes;
+		world->getArchetypes(0, &archetypes);
+
+		// All entities are numbered in file order first, parents are saved as those numbers.
+		std::vector<std::vector<Vec3>> translations(archetypes.size());
+		std::vector<std::vector<uint32_t>> sortedRows(archetypes.size());
+		std::vector<uint32_t> fileNumbers; // Plus one, by entity index.
+		uint32_t numNumbered = 0;
+
+		for (size_t a = 0; a < archetypes.size(); ++a)
+		{
+			getWorldTranslations(world, archetypes[a], &translations[a]);
+			sortRows(archetypes[a], translations[a], &sortedRows[a]);
+
+			for (uint32_t row : sortedRows[a])
+			{
+				const uint32_t index = entityIndex(archetypes[a]->getEntity(row));
+
+				if (index >= fileNumbers.size())
+				{
+					fileNumbers.resize(index + 1, 0);
+				}
+
+				fileNumbers[index] = ++numNumbered;
+			}
+		}
+
+		std::vector<WorldEntityChunk> entityChunks;
+		std::vector<WorldColumnChunk> columnChunks;
+		std::vector<uint32_t> parents;
+
+		for (size_t a = 0; a < archetypes.size(); ++a)
+		{
+			Archetype* archetype = archetypes[a];
+			const std::vector<uint32_t>& rows = sortedRows[a];
+
+			for (size_t first = 0; first < rows.size(); first += ENTITIES_PER_WORLD_CHUNK)
+			{
+				const size_t last = std::min(first + ENTITIES_PER_WORLD_CHUNK, rows.size());
+
+				WorldEntityChunk chunk;
+				chunk.m_mask = archetype->getMask();
+				chunk.m_numEntities = static_cast<uint32_t>(last - first);
+				chunk.m_firstColumn = static_cast<uint32_t>(columnChunks.size());
+				chunk.m_boundsMin = Vec3(FLT_MAX);
+				chunk.m_boundsMax = Vec3(-FLT_MAX);
+
+				for (size_t i = first; i < last && !translations[a].empty(); ++i)
+				{
+					growBounds(translations[a][rows[i]], &chunk.m_boundsMin, &chunk.m_boundsMax);
+				}
+
+				for (size_t type = 0; type < ECType::CT_Max; ++type)
+				{
+					if (!archetype->hasType(static_cast<ECType>(type)))
+					{
+						continue;
+					}
+
+					WorldColumnChunk column;
+					column.m_offset = ar.m_numBytesWritten;
+					column.m_type = static_cast<uint32_t>(type);
+					column.m_entityChunk = static_cast<uint32_t>(entityChunks.size());
+
+					for (size_t i = first; i < last; ++i)
+					{
+						static_cast<Component*>(archetype->getComponent(static_cast<ECType>(type), rows[i]))->save(&ar);
+					}
+
+					if (type == ECType::CT_Transform)
+					{
+						parents.clear();
+
+						for (size_t i = first; i < last; ++i)
+						{
+							const EntityHandle parent = static_cast<CTransform*>(archetype->getComponent(ECType::CT_Transform, rows[i]))->getParent();
+							const bool bSaved = world->handleIsValid(parent) && entityIndex(parent) < fileNumbers.size();
+							parents.push_back(bSaved ? fileNumbers[entityIndex(parent)] : 0);
+						}
+
+						ar.serialize(parents.data(), sizeof(uint32_t) * parents.size());
+					}
+
+					column.m_size = ar.m_numBytesWritten - column.m_offset;
+					columnChunks.push_back(column);
+				}
+
+				chunk.m_numColumns = static_cast<uint32_t>(columnChunks.size()) - chunk.m_firstColumn;
+				entityChunks.push_back(chunk);
+			}
+		}
+
+		// Aligned so the table is used in place when the file is mapped.
+		serializePadding(&ar, TOC_ALIGNMENT);
+		header.m_tocOffset = ar.m_numBytesWritten;
+		header.m_numEntityChunks = static_cast<uint32_t>(entityChunks.size());
+		header.m_numColumnChunks = static_cast<uint32_t>(columnChunks.size());
+		ar.serialize(entityChunks.data(), sizeof(WorldEntityChunk) * entityChunks.size());
+		ar.serialize(columnChunks.data(), sizeof(WorldColumnChunk) * columnChunks.size());
+		memcpy(ar.m_data, &header, sizeof(header));
+
+		EArchiveError err = writeArchiveToDisk(path, ar);
+		assert(err == EArchiveError::NoError);
+		destroyArchive(ar);
+	}
+
+	WorldLoadOptions::WorldLoadOptions()
+		: m_types(~0u)
+		, m_bRegion(false)
+		, m_pool(nullptr)
+		, m_parallelTypes(componentBit(ECType::CT_Transform))
+	{}
+
+	WorldFile::WorldFile()
+		: m_bOpen(false)
+		, m_header()
+		, m_entityChunks(nullptr)
+		, m_columnChunks(nullptr)
+	{}
+
+	WorldFile::~WorldFile()
+	{
+		close();
+	}
+
+	EWorldFileError WorldFile::open(const char* path)
+	{
+		close();
+
+		if (createReadArchive(path, &m_ar) != EArchiveError::NoError)
+		{
+			return EWorldFileError::Open;
+		}
+
+		m_bOpen = true;
+
+		if (m_ar.m_size < sizeof(WorldFileHeader))
+		{
+			close();
+			return EWorldFileError::Legacy;
+		}
+
+		memcpy(&m_header, m_ar.m_data, sizeof(WorldFileHeader));
+
+		// The legacy count of entities can not be the magic, that is more than a World holds.
+		if (m_header.m_magic != WORLD_FILE_MAGIC)
+		{
+			close();
+			return EWorldFileError::Legacy;
+		}
+
+		if (m_header.m_version < WORLD_FILE_OLDEST_VERSION || m_header.m_version > WORLD_FILE_VERSION)
+		{
+			Logger::errorf("World file %s has version %u, versions %u to %u are supported.", path, m_header.m_version, WORLD_FILE_OLDEST_VERSION, WORLD_FILE_VERSION);
+			close();
+			return EWorldFileError::Version;
+		}
+
+		const uint64_t tocSize = uint64_t(m_header.m_numEntityChunks) * sizeof(WorldEntityChunk)
+			+ uint64_t(m_header.m_numColumnChunks) * sizeof(WorldColumnChunk);
+
+		if (m_header.m_tocOffset % TOC_ALIGNMENT != 0 || m_header.m_tocOffset > m_ar.m_size || tocSize > m_ar.m_size - m_header.m_tocOffset)
+		{
+			Logger::errorf("World file %s is cut off or corrupt.", path);
+			close();
+			return EWorldFileError::Corrupt;
+		}
+
+		m_entityChunks = reinterpret_cast<const WorldEntityChunk*>(m_ar.m_data + m_header.m_tocOffset);
+		m_columnChunks = reinterpret_cast<const WorldColumnChunk*>(m_entityChunks + m_header.m_numEntityChunks);
+
+		m_firstEntities.resize(m_header.m_numEntityChunks);
+		uint64_t numEntities = 0;
+
+		for (size_t i = 0; i < m_header.m_numEntityChunks; ++i)
+		{
+			const WorldEntityChunk& chunk = m_entityChunks[i];
+			m_firstEntities[i] = static_cast<size_t>(numEntities);
+			numEntities += chunk.m_numEntities;
+
+			bool bValid = uint64_t(chunk.m_firstColumn) + chunk.m_numColumns <= m_header.m_numColumnChunks;
+
+			for (uint32_t c = 0; bValid && c < chunk.m_numColumns; ++c)
+			{
+				bValid = m_columnChunks[chunk.m_firstColumn + c].m_entityChunk == i;
+			}
+
+			if (!bValid)
+			{
+				Logger::errorf("World file %s is cut off or corrupt.", path);
+				close();
+				return EWorldFileError::Corrupt;
+			}
+		}
+
+		if (numEntities != m_header.m_numEntities)
+		{
+			Logger::errorf("World file %s is cut off or corrupt.", path);
+			close();
+			return EWorldFileError::Corrupt;
+		}
+
+		for (size_t i = 0; i < m_header.m_numColumnChunks; ++i)
+		{
+			const WorldColumnChunk& column = m_columnChunks[i];
+
+			// Parents follow the transforms.
+			const bool bParents = m_header.m_version >= FIRST_VERSION_WITH_PARENTS && column.m_type == ECType::CT_Transform;
+
+			if (column.m_offset > m_header.m_tocOffset || column.m_size > m_header.m_tocOffset - column.m_offset
+				|| column.m_entityChunk >= m_header.m_numEntityChunks || column.m_type >= ECType::CT_Max
+				|| (bParents && column.m_size < sizeof(uint32_t) * uint64_t(m_entityChunks[column.m_entityChunk].m_numEntities)))
+			{
+				Logger::errorf("World file %s is cut off or corrupt.", path);
+				close();
+				return EWorldFileError::Corrupt;
+			}
+		}
+
+		return EWorldFileError::NoError;
+	}
+
+	void WorldFile::close()
+	{
+		if (m_bOpen)
+		{
+			destroyArchive(m_ar);
+			m_ar = ReadArchive();
+			m_bOpen = false;
+		}
+
+		m_header = WorldFileHeader();
+		m_entityChunks = nullptr;
+		m_columnChunks = nullptr;
+		m_firstEntities.clear();
+	}
+
+	const WorldFileHeader& WorldFile::getHeader() const
+	{
+		return m_header;
+	}
+
+	size_t WorldFile::getNumEntityChunks() const
+	{
+		return m_header.m_numEntityChunks;
+	}
+
+	const WorldEntityChunk& WorldFile::getEntityChunk(size_t chunk) const
+	{
+		assert(chunk < m_header.m_numEntityChunks);
+		return m_entityChunks[chunk];
+	}
+
+	const WorldColumnChunk& WorldFile::getColumnChunk(size_t column) const
+	{
+		assert(column < m_header.m_numColumnChunks);
+		return m_columnChunks[column];
+	}
+
+	const WorldColumnChunk* WorldFile::findColumnChunk(size_t chunk, ECType type) const
+	{
+		const WorldEntityChunk& entityChunk = getEntityChunk(chunk);
+
+		for (size_t i = 0; i < entityChunk.m_numColumns; ++i)
+		{
+			const WorldColumnChunk& column = m_columnChunks[entityChunk.m_firstColumn + i];
+
+			if (column.m_type == static_cast<uint32_t>(type))
+			{
+				return &column;
+			}
+		}
+
+		return nullptr;
+	}
+
+	size_t WorldFile::getFirstEntity(size_t chunk) const
+	{
+		assert(chunk < m_header.m_numEntityChunks);
+		return m_firstEntities[chunk];
+	}
+
+	void WorldFile::loadEntityChunk(size_t chunk, ComponentMask types, World* world, LoadResources* resources, std::vector<EntityHandle>* outEntities)
+	{
+		const WorldEntityChunk& entityChunk = getEntityChunk(chunk);
+		const ComponentMask mask = entityChunk.m_mask & types;
+		const size_t first = outEntities->size();
+
+		for (size_t i = 0; i < entityChunk.m_numEntities; ++i)
+		{
+			outEntities->push_back(world->createEntity(mask));
+		}
+
+		for (size_t i = 0; i < entityChunk.m_numColumns; ++i)
+		{
+			const WorldColumnChunk& column = m_columnChunks[entityChunk.m_firstColumn + i];
+
+			if (mask & componentBit(static_cast<ECType>(column.m_type)))
+			{
+				loadColumn(column, outEntities->data() + first, world, resources);
+			}
+		}
+	}
+
+	void WorldFile::loadComponents(size_t chunk, ComponentMask types, const EntityHandle* entities, World* world, LoadResources* resources)
+	{
+		const WorldEntityChunk& entityChunk = getEntityChunk(chunk);
+
+		for (size_t i = 0; i < entityChunk.m_numColumns; ++i)
+		{
+			const WorldColumnChunk& column = m_columnChunks[entityChunk.m_firstColumn + i];
+			const ECType type = static_cast<ECType>(column.m_type);
+
+			if (!(types & componentBit(type)))
+			{
+				continue;
+			}
+
+			for (size_t e = 0; e < entityChunk.m_numEntities; ++e)
+			{
+				world->addComponent(entities[e], type);
+			}
+
+			loadColumn(column, entities, world, resources);
+		}
+	}
+
+	void WorldFile::loadColumn(const WorldColumnChunk& column, const EntityHandle* entities, World* world, LoadResources* resources)
+	{
+		const WorldEntityChunk& entityChunk = getEntityChunk(column.m_entityChunk);
+		const ECType type = static_cast<ECType>(column.m_type);
+
+		// A view of the column, it is not destroyed.
+		ReadArchive ar;
+		ar.m_data = m_ar.m_data + column.m_offset;
+		ar.m_size = getComponentBytes(column);
+
+		for (size_t i = 0; i < entityChunk.m_numEntities; ++i)
+		{
+			Component* component = world->getComponent(entities[i], type);
+			assert(component);
+			component->load(&ar, resources);
+		}
+
+		assert(ar.m_numBytesRead == ar.m_size);
+	}
+
+	void WorldFile::linkParents(size_t chunk, const EntityHandle* entities, const EntityHandle* fileEntities, World* world)
+	{
+		const WorldColumnChunk* column = findColumnChunk(chunk, ECType::CT_Transform);
+
+		if (!column || m_header.m_version < FIRST_VERSION_WITH_PARENTS)
+		{
+			return;
+		}
+
+		const WorldEntityChunk& entityChunk = getEntityChunk(chunk);
+		const uint8_t* parents = m_ar.m_data + column->m_offset + getComponentBytes(*column);
+
+		for (size_t i = 0; i < entityChunk.m_numEntities; ++i)
+		{
+			uint32_t parentNumber = 0;
+			memcpy(&parentNumber, parents + i * sizeof(uint32_t), sizeof(uint32_t));
+
+			if (parentNumber == 0 || parentNumber > m_header.m_numEntities || fileEntities[parentNumber - 1] == World::INVALID_ENTITY)
+			{
+				continue;
+			}
+
+			if (CTransform* transform = world->getComponent<CTransform>(entities[i]))
+			{
+				transform->setParent(fileEntities[parentNumber - 1]);
+			}
+		}
+	}
+
+	size_t WorldFile::getComponentBytes(const WorldColumnChunk& column) const
+	{
+		size_t numBytes = static_cast<size_t>(column.m_size);
+
+		if (m_header.m_version >= FIRST_VERSION_WITH_PARENTS && column.m_type == ECType::CT_Transform)
+		{
+			numBytes -= sizeof(uint32_t) * m_entityChunks[column.m_entityChunk].m_numEntities;
+		}
+
+		return numBytes;
+	}
+
+	static void serialize(Archive* ar, ECType& ectype)
+	{
+		ar->serialize(&ectype, sizeof(ECType));
+	}
+
+	// Component data follows the header in the order of the types listed in it.
+	static void loadLegacyEntity(ReadArchive* ar, EntityHandle handle, World* world, LoadResources* resources)
+	{
+		size_t numComponents = 0;
+		serialize(ar, numComponents);
+		assert(numComponents <= ECType::CT_Max);
+
+		ECType types[ECType::CT_Max];
+
+		for (size_t i = 0; i < numComponents; ++i)
+		{
+			serialize(ar, types[i]);
+			world->addComponent(handle, types[i]);
+		}
+
+		// Components only move while types are added, so they are looked up after the last one.
+		for (size_t i = 0; i < numComponents; ++i)
+		{
+			world->getComponent(handle, types[i])->load(ar, resources);
+		}
+	}
+
+	// The entity count, then per entity the number and types of its components and their data.
+	static void loadLegacyWorld(const char* path, World* outWorld, LoadResources* resources)
+	{
+		ReadArchive ar;
+		EArchiveError err = createReadArchive(path, &ar);
+
+		assert(err == EArchiveError::NoError);
+		if (err != EArchiveError::NoError)
+		{
+			return;
+		}
+
+		size_t numEntitiesToLoad = 0;
+
+		serialize(&ar, numEntitiesToLoad);
+
+		for (size_t i = 0; i < numEntitiesToLoad; ++i)
+		{
+			loadLegacyEntity(&ar, outWorld->createEntity(), outWorld, resources);
+		}
+
+		destroyArchive(ar);
+	}
+
+	void loadWorld(const char* path, World* outWorld, LoadResources* resources)
+	{
+		loadWorld(path, outWorld, resources, WorldLoadOptions());
+	}
+
+	void loadWorld(const char* path, World* outWorld, LoadResources* resources, const WorldLoadOptions& options)
+	{
+		WorldFile file;
+		const EWorldFileError err = file.open(path);
+
+		if (err == EWorldFileError::Legacy)
+		{
+			loadLegacyWorld(path, outWorld, resources);
+			return;
+		}
+
+		assert(err == EWorldFileError::NoError);
+		if (err != EWorldFileError::NoError)
+		{
+			return;
+		}
+
+		// Entities are created up front, after that loading a column only touches its own components.
+		std::vector<EntityHandle> entities;
+		std::vector<EntityHandle> fileEntities(static_cast<size_t>(file.getHeader().m_numEntities), World::INVALID_ENTITY);
+		std::vector<size_t> firstEntity(file.getNumEntityChunks());
+		std::vector<size_t> transformChunks;
+		std::vector<const WorldColumnChunk*> serialColumns;
+		std::vector<const WorldColumnChunk*> parallelColumns;
+		const ComponentMask parallelTypes = options.m_pool ? options.m_parallelTypes : 0;
+
+		entities.reserve(static_cast<size_t>(file.getHeader().m_numEntities));
+
+		for (size_t chunk = 0; chunk < file.getNumEntityChunks(); ++chunk)
+		{
+			const WorldEntityChunk& entityChunk = file.getEntityChunk(chunk);
+
+			if (options.m_bRegion && !overlaps(entityChunk.m_boundsMin, entityChunk.m_boundsMax, options.m_regionMin, options.m_regionMax))
+			{
+				continue;
+			}
+
+			const ComponentMask mask = entityChunk.m_mask & options.m_types;
+			firstEntity[chunk] = entities.size();
+
+			for (size_t i = 0; i < entityChunk.m_numEntities; ++i)
+			{
+				entities.push_back(outWorld->createEntity(mask));
+				fileEntities[file.getFirstEntity(chunk) + i] = entities.back();
+			}
+
+			if (mask & componentBit(ECType::CT_Transform))
+			{
+				transformChunks.push_back(chunk);
+			}
+
+			for (size_t i = 0; i < entityChunk.m_numColumns; ++i)
+			{
+				const WorldColumnChunk& column = file.getColumnChunk(entityChunk.m_firstColumn + i);
+				const ComponentMask bit = componentBit(static_cast<ECType>(column.m_type));
+
+				if (mask & bit)
+				{
+					(parallelTypes & bit ? parallelColumns : serialColumns).push_back(&column);
+				}
+			}
+		}
+
+		if (!parallelColumns.empty())
+		{
+			options.m_pool->parallelFor(parallelColumns.size(), 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const WorldColumnChunk& column = *parallelColumns[i];
+					file.loadColumn(column, &entities[firstEntity[column.m_entityChunk]], outWorld, resources);
+				}
+			});
+		}
+
+		for (const WorldColumnChunk* column : serialColumns)
+		{
+			file.loadColumn(*column, &entities[firstEntity[column->m_entityChunk]], outWorld, resources);
+		}
+
+		// Parents may be in any chunk, so they are linked once all entities exist.
+		for (size_t chunk : transformChunks)
+		{
+			file.linkParents(chunk, &entities[firstEntity[chunk]], fileEntities.data(), outWorld);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <Core/ECType.hpp>
+#include <Core/EntityHandle.hpp>
+#include <Core/Archetype.hpp>
+#include <Core/Serialize.hpp>
+#include <Math/Vec3.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class World;
+	class WorkerPool;
+	struct LoadResources;
+
+	// Layout of a world file:
+	//   WorldFileHeader
+	//   Column chunks, the components of one type of one entity chunk saved one after the other.
+	//   Table of contents: m_numEntityChunks WorldEntityChunk, then m_numColumnChunks WorldColumnChunk.
+	// An entity chunk holds up to ENTITIES_PER_WORLD_CHUNK entities of one archetype, sorted along a
+	// Morton curve through their world space translations, so the bounds of a chunk cover a compact
+	// region. Column chunks are found by their offset, which lets a loader skip types and regions,
+	// load chunks in any order and read the columns of different chunks at the same time.
+	// Entities are numbered in file order. From version 2 on, a CTransform column ends with the parent
+	// of each of its entities as that number plus one, 0 for roots, version 1 files load without parents.
+	// Files from before the header existed start with the entity count instead, and still load.
+	enum
+	{
+		WORLD_FILE_MAGIC = 0x46574850, // "PHWF"
+		WORLD_FILE_VERSION = 2,
+		WORLD_FILE_OLDEST_VERSION = 1,
+		ENTITIES_PER_WORLD_CHUNK = 4096
+	};
+
+	struct WorldFileHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_numEntities;
+		uint64_t m_tocOffset;
+		uint32_t m_numEntityChunks;
+		uint32_t m_numColumnChunks;
+	};
+
+	struct WorldEntityChunk
+	{
+		ComponentMask m_mask;
+		uint32_t m_numEntities;
+
+		// Columns of the chunk in the table of contents, one per type of the mask in ECType order.
+		uint32_t m_firstColumn;
+		uint32_t m_numColumns;
+
+		// Of the world space translations, min is above max for chunks without CTransform.
+		Vec3 m_boundsMin;
+		Vec3 m_boundsMax;
+	};
+
+	struct WorldColumnChunk
+	{
+		uint64_t m_offset;
+		uint64_t m_size;
+		uint32_t m_type;
+		uint32_t m_entityChunk;
+	};
+
+	enum class EWorldFileError
+	{
+		NoError,
+		Open,
+		Legacy, // Flat file without a table of contents, only loadWorld() reads those.
+		Version,
+		Corrupt
+	};
+
+	// What loadWorld() loads and how.
+	struct WorldLoadOptions
+	{
+		WorldLoadOptions();
+
+		// Components of other types are not created.
+		ComponentMask m_types;
+
+		// Only entity chunks with bounds overlapping the region, chunks without CTransform are left out.
+		// The test is per chunk, entities close to the region come along.
+		bool m_bRegion;
+		Vec3 m_regionMin;
+		Vec3 m_regionMax;
+
+		// Columns of these types are loaded on the pool, their load() must not touch anything shared.
+		// The others are loaded on the calling thread, in file order.
+		WorkerPool* m_pool;
+		ComponentMask m_parallelTypes;
+	};
+
+	// Read access to a world file for loading parts of it. The file stays mapped while open.
+	class WorldFile
+	{
+	public:
+		WorldFile();
+		~WorldFile();
+
+		WorldFile(const WorldFile&) = delete;
+		WorldFile& operator=(const WorldFile&) = delete;
+
+		EWorldFileError open(const char* path);
+		void close();
+
+		const WorldFileHeader& getHeader() const;
+
+		size_t getNumEntityChunks() const;
+		const WorldEntityChunk& getEntityChunk(size_t chunk) const;
+		const WorldColumnChunk& getColumnChunk(size_t column) const;
+
+		// Column of the type in the entity chunk, null if the chunk has no such type.
+		const WorldColumnChunk* findColumnChunk(size_t chunk, ECType type) const;
+
+		// Number of the first entity of the chunk in file order.
+		size_t getFirstEntity(size_t chunk) const;
+
+		// Creates the entities of the chunk with components of the types in the mask the chunk has
+		// and loads those. Appends the entities in file order. Transforms are loaded as roots,
+		// linkParents() sets their parents once those are loaded as well.
+		void loadEntityChunk(size_t chunk, ComponentMask types, World* world, LoadResources* resources, std::vector<EntityHandle>* outEntities);
+
+		// Adds and loads components of the types to entities loaded from the chunk earlier, entities
+		// are in the order loadEntityChunk() returned them.
+		void loadComponents(size_t chunk, ComponentMask types, const EntityHandle* entities, World* world, LoadResources* resources);
+
+		// Loads one column into the components of the entities, which have to exist already. Only
+		// touches those components, so different columns may be loaded at the same time.
+		void loadColumn(const WorldColumnChunk& column, const EntityHandle* entities, World* world, LoadResources* resources);
+
+		// Sets the parents of the loaded transforms of the chunk. fileEntities maps the number of
+		// every entity in the file to the entity it was loaded as, World::INVALID_ENTITY for those
+		// that were not loaded, whose children stay roots.
+		void linkParents(size_t chunk, const EntityHandle* entities, const EntityHandle* fileEntities, World* world);
+
+	private:
+		// Bytes of the column written by the components, without the parents after them.
+		size_t getComponentBytes(const WorldColumnChunk& column) const;
+
+		ReadArchive m_ar;
+		bool m_bOpen;
+		WorldFileHeader m_header;
+		const WorldEntityChunk* m_entityChunks;
+		const WorldColumnChunk* m_columnChunks;
+		std::vector<size_t> m_firstEntities; // Per entity chunk.
+	};
+
+	// Writes the chunked format.
+	void saveWorld(World* world, const char* path);
+
+	// Everything, on the calling thread.
+	void loadWorld(const char* path, World* outWorld, LoadResources* resources);
+
+	// Legacy files are loaded whole whatever the options are.
+	void loadWorld(const char* path, World* outWorld, LoadResources* resources, const WorldLoadOptions& options);
+}
\ No newline at end of file
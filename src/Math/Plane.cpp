@@ -4,6 +4,11 @@
 
 namespace Phoenix
 {
+	Plane::Plane()
+		: n()
+		, d(0.f)
+	{}
+
 	Plane::Plane(const Vec3& _n, float _d)
 		: n(_n)
 		, d(_d)
@@ -16,6 +21,13 @@ namespace Phoenix
 		, d(other.d)
 	{}
 
+	Plane& Plane::operator=(const Plane& other)
+	{
+		n = other.n;
+		d = other.d;
+		return *this;
+	}
+
 	Plane::Plane(const Vec3& p0, const Vec3& p1, const Vec3& p2)
 	{
 		auto edge1 = p1 - p0;
@@ -25,8 +25,10 @@ namespace Phoenix
 		Vec3 n;
 		float d;
 
+		Plane();
 		Plane(const Vec3& _n, float _d);
 		Plane(const Plane& other);
+		Plane& operator=(const Plane& other);
 		Plane(const Vec3& p0, const Vec3& p1, const Vec3& p2);
 
 		void normalize();
@@ -15,4 +15,77 @@ namespace Phoenix
 	{
 		return origin + (direction * t);
 	}
+
+	std::pair<bool, float> Ray::intersect(const Vec3& boxMin, const Vec3& boxMax) const
+	{
+		float tNear = 0.f;
+		float tFar = std::numeric_limits<float>::max();
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (std::abs(direction(axis)) < VERY_SMALL_FLT) // Parallel to the slab.
+			{
+				if (origin(axis) < boxMin(axis) || origin(axis) > boxMax(axis))
+				{
+					return{ false, 0.f };
+				}
+
+				continue;
+			}
+
+			float invDir = 1.f / direction(axis);
+			float t0 = (boxMin(axis) - origin(axis)) * invDir;
+			float t1 = (boxMax(axis) - origin(axis)) * invDir;
+
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+
+			tNear = std::max(tNear, t0);
+			tFar = std::min(tFar, t1);
+
+			if (tNear > tFar)
+			{
+				return{ false, 0.f };
+			}
+		}
+
+		return{ true, tNear };
+	}
+
+	std::pair<bool, float> Ray::intersect(const Vec3& v0, const Vec3& v1, const Vec3& v2) const
+	{
+		Vec3 edge1 = v1 - v0;
+		Vec3 edge2 = v2 - v0;
+
+		Vec3 p = direction.cross(edge2);
+		float det = edge1.dot(p);
+
+		if (std::abs(det) < VERY_SMALL_FLT) // Parallel to the triangle.
+		{
+			return{ false, 0.f };
+		}
+
+		float invDet = 1.f / det;
+		Vec3 s = origin - v0;
+		float u = s.dot(p) * invDet;
+
+		if (u < 0.f || u > 1.f)
+		{
+			return{ false, 0.f };
+		}
+
+		Vec3 q = s.cross(edge1);
+		float v = direction.dot(q) * invDet;
+
+		if (v < 0.f || u + v > 1.f)
+		{
+			return{ false, 0.f };
+		}
+
+		float t = edge2.dot(q) * invDet;
+
+		return{ t >= 0.f, t };
+	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <utility>
 #include "Vec3.hpp"
 
 namespace Phoenix
@@ -14,5 +15,11 @@ namespace Phoenix
 		Ray(const Vec3& _origin, const Vec3& _direction);
 
 		Vec3 pointAt(float t) const;
+
+		// Distance to where the ray enters the box, 0 if it starts inside.
+		std::pair<bool, float> intersect(const Vec3& boxMin, const Vec3& boxMax) const;
+
+		// Distance to the triangle, hits both sides (Moeller and Trumbore).
+		std::pair<bool, float> intersect(const Vec3& v0, const Vec3& v1, const Vec3& v2) const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "TransformBatch.hpp"
+
+#include <assert.h>
+#include <emmintrin.h>
+#include <xmmintrin.h>
+
+#include <Math/Matrix4.hpp>
+#include <Math/PhiMath.hpp>
+
+namespace Phoenix
+{
+	enum
+	{
+		LANES = 4
+	};
+
+	// Cephes sinf/cosf: the angle is reduced to [-pi/4, pi/4] around the nearest multiple j of pi/2,
+	// in three steps so the reduction stays exact, then both polynomials are evaluated. Odd j swap
+	// sin and cos, and bit 1 of j (of j + 1 for cos) flips the sign.
+	static void sinCos4(__m128 x, __m128* outSin, __m128* outCos)
+	{
+		const __m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(2.f / PI)));
+		const __m128 jf = _mm_cvtepi32_ps(j);
+
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(jf, _mm_set1_ps(1.5703125f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(jf, _mm_set1_ps(4.837512969970703125e-4f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(jf, _mm_set1_ps(7.54978995489188216e-8f)));
+
+		const __m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+		s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(-1.6666654611e-1f));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+
+		__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+		c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(4.166664568298827e-2f));
+		c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, r2), r2), _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))));
+
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), 30));
+		const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+		*outSin = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+		*outCos = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+	}
+
+	void sinCosBatch(const float* angles, size_t count, float* outSin, float* outCos)
+	{
+		size_t i = 0;
+		__m128 s;
+		__m128 c;
+
+		for (; i + LANES <= count; i += LANES)
+		{
+			sinCos4(_mm_loadu_ps(angles + i), &s, &c);
+			_mm_storeu_ps(outSin + i, s);
+			_mm_storeu_ps(outCos + i, c);
+		}
+
+		if (i < count)
+		{
+			float x[LANES] = {};
+			float sinTail[LANES];
+			float cosTail[LANES];
+
+			for (size_t k = i; k < count; ++k)
+			{
+				x[k - i] = angles[k];
+			}
+
+			sinCos4(_mm_loadu_ps(x), &s, &c);
+			_mm_storeu_ps(sinTail, s);
+			_mm_storeu_ps(cosTail, c);
+
+			for (size_t k = i; k < count; ++k)
+			{
+				outSin[k] = sinTail[k - i];
+				outCos[k] = cosTail[k - i];
+			}
+		}
+	}
+
+	// Matrix4 stores columns, so each column of the four matrices is a transpose of four row registers.
+	static void storeColumn(__m128 row0, __m128 row1, __m128 row2, __m128 row3, int column, Matrix4* out)
+	{
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		_mm_storeu_ps(out[0].m_data[column].data(), row0);
+		_mm_storeu_ps(out[1].m_data[column].data(), row1);
+		_mm_storeu_ps(out[2].m_data[column].data(), row2);
+		_mm_storeu_ps(out[3].m_data[column].data(), row3);
+	}
+
+	// The arrays point at the first of four transforms.
+	static void composeFour(const float* tx, const float* ty, const float* tz,
+							const float* rx, const float* ry, const float* rz,
+							const float* sx, const float* sy, const float* sz, Matrix4* out)
+	{
+		const __m128 toRadians = _mm_set1_ps(PI / 180.f);
+
+		__m128 A, B, C, D, E, F;
+		sinCos4(_mm_mul_ps(_mm_loadu_ps(rx), toRadians), &B, &A);
+		sinCos4(_mm_mul_ps(_mm_loadu_ps(ry), toRadians), &D, &C);
+		sinCos4(_mm_mul_ps(_mm_loadu_ps(rz), toRadians), &F, &E);
+
+		const __m128 scaleX = _mm_loadu_ps(sx);
+		const __m128 scaleY = _mm_loadu_ps(sy);
+		const __m128 scaleZ = _mm_loadu_ps(sz);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 negB = _mm_sub_ps(zero, B);
+
+		// Rotation as in Matrix4::rotation(), times the scale of its column.
+		__m128 m00 = _mm_mul_ps(_mm_mul_ps(C, E), scaleX);
+		__m128 m01 = _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(C, F)), scaleY);
+		__m128 m02 = _mm_mul_ps(_mm_sub_ps(zero, D), scaleZ);
+
+		__m128 m10 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(negB, D), E), _mm_mul_ps(A, F)), scaleX);
+		__m128 m11 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(B, D), F), _mm_mul_ps(A, E)), scaleY);
+		__m128 m12 = _mm_mul_ps(_mm_mul_ps(negB, C), scaleZ);
+
+		__m128 m20 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(A, D), E), _mm_mul_ps(B, F)), scaleX);
+		__m128 m21 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(zero, A), D), F), _mm_mul_ps(B, E)), scaleY);
+		__m128 m22 = _mm_mul_ps(_mm_mul_ps(A, C), scaleZ);
+
+		storeColumn(m00, m10, m20, zero, 0, out);
+		storeColumn(m01, m11, m21, zero, 1, out);
+		storeColumn(m02, m12, m22, zero, 2, out);
+		storeColumn(_mm_loadu_ps(tx), _mm_loadu_ps(ty), _mm_loadu_ps(tz), _mm_set1_ps(1.f), 3, out);
+	}
+
+	void TrsBatch::clear()
+	{
+		m_tx.clear();
+		m_ty.clear();
+		m_tz.clear();
+		m_rx.clear();
+		m_ry.clear();
+		m_rz.clear();
+		m_sx.clear();
+		m_sy.clear();
+		m_sz.clear();
+	}
+
+	void TrsBatch::reserve(size_t numTransforms)
+	{
+		m_tx.reserve(numTransforms);
+		m_ty.reserve(numTransforms);
+		m_tz.reserve(numTransforms);
+		m_rx.reserve(numTransforms);
+		m_ry.reserve(numTransforms);
+		m_rz.reserve(numTransforms);
+		m_sx.reserve(numTransforms);
+		m_sy.reserve(numTransforms);
+		m_sz.reserve(numTransforms);
+	}
+
+	size_t TrsBatch::add(const Vec3& translation, const Vec3& rotation, const Vec3& scale)
+	{
+		m_tx.push_back(translation.x);
+		m_ty.push_back(translation.y);
+		m_tz.push_back(translation.z);
+		m_rx.push_back(rotation.x);
+		m_ry.push_back(rotation.y);
+		m_rz.push_back(rotation.z);
+		m_sx.push_back(scale.x);
+		m_sy.push_back(scale.y);
+		m_sz.push_back(scale.z);
+
+		return m_tx.size() - 1;
+	}
+
+	size_t TrsBatch::size() const
+	{
+		return m_tx.size();
+	}
+
+	void TrsBatch::compose(Matrix4* outMatrices) const
+	{
+		const size_t count = size();
+		size_t i = 0;
+
+		for (; i + LANES <= count; i += LANES)
+		{
+			composeFour(&m_tx[i], &m_ty[i], &m_tz[i], &m_rx[i], &m_ry[i], &m_rz[i], &m_sx[i], &m_sy[i], &m_sz[i], outMatrices + i);
+		}
+
+		if (i == count)
+		{
+			return;
+		}
+
+		// The last few go through the same code padded to four, so they match the others exactly.
+		float tail[9][LANES] = {};
+		const std::vector<float>* arrays[9] = { &m_tx, &m_ty, &m_tz, &m_rx, &m_ry, &m_rz, &m_sx, &m_sy, &m_sz };
+
+		for (int a = 0; a < 9; ++a)
+		{
+			for (size_t k = i; k < count; ++k)
+			{
+				tail[a][k - i] = (*arrays[a])[k];
+			}
+		}
+
+		Matrix4 matrices[LANES];
+		composeFour(tail[0], tail[1], tail[2], tail[3], tail[4], tail[5], tail[6], tail[7], tail[8], matrices);
+
+		for (size_t k = i; k < count; ++k)
+		{
+			outMatrices[k] = matrices[k - i];
+		}
+	}
+
+	void TrsBatch::composeScalar(Matrix4* outMatrices) const
+	{
+		for (size_t i = 0; i < size(); ++i)
+		{
+			outMatrices[i] = Matrix4::translation(Vec3(m_tx[i], m_ty[i], m_tz[i]))
+						   * Matrix4::rotation(Vec3(m_rx[i], m_ry[i], m_rz[i]))
+						   * Matrix4::scale(Vec3(m_sx[i], m_sy[i], m_sz[i]));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Math/Vec3.hpp>
+
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class Matrix4;
+
+	// sin and cos of count angles in radians, four at a time with SSE. Within a few ulp of
+	// sinf and cosf for angles up to a few thousand radians.
+	void sinCosBatch(const float* angles, size_t count, float* outSin, float* outCos);
+
+	// Translations, Euler rotations in degrees and scales of many transforms as structure of arrays,
+	// so each lane of a register holds another transform.
+	class TrsBatch
+	{
+	public:
+		void clear();
+
+		void reserve(size_t numTransforms);
+
+		// Returns the index compose() writes the matrix of the transform to.
+		size_t add(const Vec3& translation, const Vec3& rotation, const Vec3& scale);
+
+		size_t size() const;
+
+		// Writes Matrix4::translation(t) * Matrix4::rotation(r) * Matrix4::scale(s) of every transform,
+		// building four affine matrices at a time with SSE instead of multiplying them out.
+		void compose(Matrix4* outMatrices) const;
+
+		// Same result one transform at a time with the Matrix4 functions. Reference for tests and benchmarks.
+		void composeScalar(Matrix4* outMatrices) const;
+
+	private:
+		std::vector<float> m_tx;
+		std::vector<float> m_ty;
+		std::vector<float> m_tz;
+		std::vector<float> m_rx;
+		std::vector<float> m_ry;
+		std::vector<float> m_rz;
+		std::vector<float> m_sx;
+		std::vector<float> m_sy;
+		std::vector<float> m_sz;
+	};
+}
\ No newline at end of file
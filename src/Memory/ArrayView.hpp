@@ -0,0 +1,47 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	// Read only view of elements owned by something else, such as a vector or a read archive.
+	// Only valid as long as the owner keeps the elements where they are.
+	template<typename T>
+	class ArrayView
+	{
+	public:
+		ArrayView()
+			: m_data(nullptr)
+			, m_size(0)
+		{}
+
+		ArrayView(const T* data, size_t size)
+			: m_data(data)
+			, m_size(size)
+		{}
+
+		ArrayView(const std::vector<T>& vector)
+			: m_data(vector.data())
+			, m_size(vector.size())
+		{}
+
+		const T* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+
+		const T* begin() const { return m_data; }
+		const T* end() const { return m_data + m_size; }
+
+		const T& operator[](size_t index) const
+		{
+			assert(index < m_size);
+			return m_data[index];
+		}
+
+	private:
+		const T* m_data;
+		size_t m_size;
+	};
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <assert.h>
+#include <string.h>
 #include <vector>
 
 namespace Phoenix
@@ -48,7 +50,13 @@ namespace Phoenix
 		void* at(size_t idx)
 		{
 			assert(idx <= m_nextAllocIdx);
-			return m_chunks[floor(idx / m_elemsPerChunk)] + (idx % m_elemsPerChunk) * m_sizePerAllocBytes;
+			return m_chunks[idx / m_elemsPerChunk] + (idx % m_elemsPerChunk) * m_sizePerAllocBytes;
+		}
+
+		const void* at(size_t idx) const
+		{
+			assert(idx <= m_nextAllocIdx);
+			return m_chunks[idx / m_elemsPerChunk] + (idx % m_elemsPerChunk) * m_sizePerAllocBytes;
 		}
 
 		void* alloc()
@@ -58,11 +66,18 @@ namespace Phoenix
 			return at(next);
 		}
 
+		// Forgets the last element without destroying it, for callers that manage construction themselves.
+		void popBack()
+		{
+			assert(m_nextAllocIdx > 0);
+			--m_nextAllocIdx;
+		}
+
 	protected:
 		virtual void swapAndPop(size_t idx)
 		{
 			void* toRemove = at(idx);
-			void* last = at(m_nextAllocIdx--);
+			void* last = at(--m_nextAllocIdx);
 
 			memcpy(toRemove, last, m_sizePerAllocBytes);
 			memset(last, 0, m_sizePerAllocBytes);
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	// Bounded lock-free queue for any number of producer and consumer threads, after Dmitry Vyukov's
+	// bounded MPMC queue. Every cell has a sequence number saying whose turn it is: a producer may
+	// fill the cell at position p once it is p, a consumer may empty it once it is p + 1. Threads
+	// claim positions by moving the shared enqueue or dequeue index forward, and only contend on
+	// that index. Pushing to a full queue and popping from an empty one fail.
+	// The cells are stored inline, large queues belong on the heap.
+	template <typename T, size_t bufferSize>
+	class MpmcQueue
+	{
+		static_assert(bufferSize >= 2 && (bufferSize & (bufferSize - 1)) == 0, "The size of the queue has to be a power of two.");
+
+	public:
+		MpmcQueue()
+			: m_enqueuePos(0)
+			, m_dequeuePos(0)
+		{
+			for (size_t i = 0; i < bufferSize; ++i)
+			{
+				m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MpmcQueue(const MpmcQueue&) = delete;
+		MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+		// False if the queue is full.
+		bool push(const T& item)
+		{
+			return pushBatch(&item, 1) == 1;
+		}
+
+		// Claims as many consecutive free cells as it can, up to count, and fills them in order.
+		// Returns how many items were pushed, 0 only if the queue was full.
+		size_t pushBatch(const T* items, size_t count)
+		{
+			size_t numPushed = 0;
+
+			while (numPushed < count)
+			{
+				size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+				const size_t numClaimed = countReady(pos, 0, count - numPushed);
+
+				if (numClaimed == 0)
+				{
+					// A lap behind: full. Ahead: another producer claimed it, look again.
+					if (static_cast<intptr_t>(m_cells[pos & MASK].m_sequence.load(std::memory_order_acquire) - pos) < 0)
+					{
+						break;
+					}
+
+					continue;
+				}
+
+				if (!m_enqueuePos.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed))
+				{
+					continue;
+				}
+
+				for (size_t i = 0; i < numClaimed; ++i)
+				{
+					Cell& cell = m_cells[(pos + i) & MASK];
+					cell.m_item = items[numPushed + i];
+					cell.m_sequence.store(pos + i + 1, std::memory_order_release);
+				}
+
+				numPushed += numClaimed;
+			}
+
+			return numPushed;
+		}
+
+		// False if the queue is empty.
+		bool pop(T* outItem)
+		{
+			return popBatch(outItem, 1) == 1;
+		}
+
+		// Takes up to maxCount items, oldest first as far as the claimed cells go. Returns how
+		// many, 0 only if the queue was empty.
+		size_t popBatch(T* outItems, size_t maxCount)
+		{
+			size_t numPopped = 0;
+
+			while (numPopped < maxCount)
+			{
+				size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+				const size_t numClaimed = countReady(pos, 1, maxCount - numPopped);
+
+				if (numClaimed == 0)
+				{
+					// Not filled yet: empty. Ahead: another consumer took it, look again.
+					if (static_cast<intptr_t>(m_cells[pos & MASK].m_sequence.load(std::memory_order_acquire) - (pos + 1)) < 0)
+					{
+						break;
+					}
+
+					continue;
+				}
+
+				if (!m_dequeuePos.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed))
+				{
+					continue;
+				}
+
+				for (size_t i = 0; i < numClaimed; ++i)
+				{
+					Cell& cell = m_cells[(pos + i) & MASK];
+					outItems[numPopped + i] = cell.m_item;
+
+					// Free for the producer one lap later.
+					cell.m_sequence.store(pos + i + bufferSize, std::memory_order_release);
+				}
+
+				numPopped += numClaimed;
+			}
+
+			return numPopped;
+		}
+
+		// Only a hint while other threads use the queue.
+		size_t size() const
+		{
+			const size_t enqueuePos = m_enqueuePos.load(std::memory_order_relaxed);
+			const size_t dequeuePos = m_dequeuePos.load(std::memory_order_relaxed);
+			return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+		}
+
+		bool isEmpty() const
+		{
+			return size() == 0;
+		}
+
+		size_t capacity() const
+		{
+			return bufferSize;
+		}
+
+	private:
+		enum : size_t
+		{
+			MASK = bufferSize - 1,
+			CACHE_LINE_BYTES = 64
+		};
+
+		struct Cell
+		{
+			std::atomic<size_t> m_sequence;
+			T m_item;
+		};
+
+		// Number of cells from pos on, up to maxCount, whose sequence is pos + offset, so they are
+		// ready to be filled (offset 0) or emptied (offset 1).
+		size_t countReady(size_t pos, size_t offset, size_t maxCount) const
+		{
+			size_t count = 0;
+
+			while (count < maxCount && m_cells[(pos + count) & MASK].m_sequence.load(std::memory_order_acquire) == pos + count + offset)
+			{
+				++count;
+			}
+
+			return count;
+		}
+
+		char m_padding0[CACHE_LINE_BYTES];
+		Cell m_cells[bufferSize];
+		char m_padding1[CACHE_LINE_BYTES];
+		std::atomic<size_t> m_enqueuePos;
+		char m_padding2[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> m_dequeuePos;
+		char m_padding3[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>)];
+	};
+}
\ No newline at end of file
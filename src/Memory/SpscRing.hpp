@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Phoenix
+{
+	// Bounded lock-free queue between exactly one producer thread and one consumer thread. Unlike
+	// CircularBuffer nothing is overwritten: pushing to a full ring and popping from an empty one
+	// fail. Each side owns one index and keeps a copy of the other one, so it only reads the other
+	// side's cache line when its copy says the ring is full or empty.
+	template <typename T, size_t bufferSize>
+	class SpscRing
+	{
+		static_assert(bufferSize >= 2 && (bufferSize & (bufferSize - 1)) == 0, "The size of the ring has to be a power of two.");
+
+	public:
+		SpscRing()
+			: m_tail(0)
+			, m_cachedHead(0)
+			, m_head(0)
+			, m_cachedTail(0)
+		{}
+
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		// Producer only. False if the ring is full.
+		bool push(const T& item)
+		{
+			return pushBatch(&item, 1) == 1;
+		}
+
+		// Producer only. Pushes as many of the items as fit, in order, and returns how many.
+		size_t pushBatch(const T* items, size_t count)
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+			if (tail - m_cachedHead + count > bufferSize)
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+			}
+
+			const size_t free = bufferSize - (tail - m_cachedHead);
+			const size_t numPushed = count < free ? count : free;
+
+			for (size_t i = 0; i < numPushed; ++i)
+			{
+				m_data[(tail + i) & MASK] = items[i];
+			}
+
+			m_tail.store(tail + numPushed, std::memory_order_release);
+			return numPushed;
+		}
+
+		// Consumer only. False if the ring is empty.
+		bool pop(T* outItem)
+		{
+			return popBatch(outItem, 1) == 1;
+		}
+
+		// Consumer only. Pops up to maxCount items, oldest first, and returns how many.
+		size_t popBatch(T* outItems, size_t maxCount)
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+
+			if (m_cachedTail - head < maxCount)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+			}
+
+			const size_t available = m_cachedTail - head;
+			const size_t numPopped = maxCount < available ? maxCount : available;
+
+			for (size_t i = 0; i < numPopped; ++i)
+			{
+				outItems[i] = m_data[(head + i) & MASK];
+			}
+
+			m_head.store(head + numPopped, std::memory_order_release);
+			return numPopped;
+		}
+
+		// Exact only on a side that is not running at the same time.
+		size_t size() const
+		{
+			return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+		}
+
+		bool isEmpty() const
+		{
+			return size() == 0;
+		}
+
+		size_t capacity() const
+		{
+			return bufferSize;
+		}
+
+	private:
+		enum : size_t
+		{
+			MASK = bufferSize - 1,
+			CACHE_LINE_BYTES = 64
+		};
+
+		// The indices count up forever and wrap around with size_t, the masked ones are slots.
+		// Producer side.
+		std::atomic<size_t> m_tail;
+		size_t m_cachedHead;
+		char m_producerPadding[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+		// Consumer side.
+		std::atomic<size_t> m_head;
+		size_t m_cachedTail;
+		char m_consumerPadding[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+		T m_data[bufferSize];
+	};
+}
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "ClusteredLighting.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <xmmintrin.h>
+
+#include <Math/Matrix4.hpp>
+
+namespace Phoenix
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using Ms = std::chrono::duration<float, std::milli>;
+
+	ClusteredLightCuller::ClusteredLightCuller()
+		: m_nearPlane(0.1f)
+		, m_farPlane(1000.f)
+		, m_sliceScale(0.f)
+		, m_sliceBias(0.f)
+		, m_minX(NUM_CLUSTERS)
+		, m_minY(NUM_CLUSTERS)
+		, m_minZ(NUM_CLUSTERS)
+		, m_maxX(NUM_CLUSTERS)
+		, m_maxY(NUM_CLUSTERS)
+		, m_maxZ(NUM_CLUSTERS)
+		, m_ranges(NUM_CLUSTERS)
+	{
+		static_assert(NUM_X % LANES == 0, "The clusters of a row are tested LANES at a time.");
+	}
+
+	void ClusteredLightCuller::setProjection(const Matrix4& projection, float nearPlane, float farPlane)
+	{
+		assert(nearPlane > 0.f && farPlane > nearPlane);
+
+		m_nearPlane = nearPlane;
+		m_farPlane = farPlane;
+
+		// Slice z starts at near * (far / near)^(z / NUM_Z), which inverts to log(distance) * scale + bias.
+		const float logRatio = logf(farPlane / nearPlane);
+		m_sliceScale = NUM_Z / logRatio;
+		m_sliceBias = -NUM_Z * logf(nearPlane) / logRatio;
+
+		// A view space point at distance d in front of the camera with NDC x has x = ndc * d / projection(0, 0).
+		const float invScaleX = 1.f / projection(0, 0);
+		const float invScaleY = 1.f / projection(1, 1);
+
+		for (uint32_t z = 0; z < NUM_Z; ++z)
+		{
+			float d0 = nearPlane * powf(farPlane / nearPlane, static_cast<float>(z) / NUM_Z);
+			float d1 = z + 1 == NUM_Z ? farPlane : nearPlane * powf(farPlane / nearPlane, static_cast<float>(z + 1) / NUM_Z);
+
+			for (uint32_t y = 0; y < NUM_Y; ++y)
+			{
+				float ndcY0 = -1.f + 2.f * y / NUM_Y;
+				float ndcY1 = -1.f + 2.f * (y + 1) / NUM_Y;
+
+				for (uint32_t x = 0; x < NUM_X; ++x)
+				{
+					float ndcX0 = -1.f + 2.f * x / NUM_X;
+					float ndcX1 = -1.f + 2.f * (x + 1) / NUM_X;
+
+					uint32_t c = (z * NUM_Y + y) * NUM_X + x;
+
+					m_minX[c] = std::min(std::min(ndcX0 * d0, ndcX0 * d1), std::min(ndcX1 * d0, ndcX1 * d1)) * invScaleX;
+					m_maxX[c] = std::max(std::max(ndcX0 * d0, ndcX0 * d1), std::max(ndcX1 * d0, ndcX1 * d1)) * invScaleX;
+					m_minY[c] = std::min(std::min(ndcY0 * d0, ndcY0 * d1), std::min(ndcY1 * d0, ndcY1 * d1)) * invScaleY;
+					m_maxY[c] = std::max(std::max(ndcY0 * d0, ndcY0 * d1), std::max(ndcY1 * d0, ndcY1 * d1)) * invScaleY;
+					m_minZ[c] = -d1;
+					m_maxZ[c] = -d0;
+				}
+			}
+		}
+	}
+
+	uint32_t ClusteredLightCuller::getSlice(float distance) const
+	{
+		if (distance <= m_nearPlane)
+		{
+			return 0;
+		}
+
+		float slice = floorf(logf(distance) * m_sliceScale + m_sliceBias);
+		return static_cast<uint32_t>(std::min(std::max(slice, 0.f), static_cast<float>(NUM_Z - 1)));
+	}
+
+	void ClusteredLightCuller::addLightToSlices(const GpuPointLight& light, uint32_t lightIndex)
+	{
+		const GpuVec4& sphere = light.m_positionEyeRadius;
+		float distance = -sphere.z;
+
+		if (distance + sphere.w < m_nearPlane || distance - sphere.w > m_farPlane)
+		{
+			return;
+		}
+
+		// One more slice on both sides covers rounding between the logarithm and the slice bounds, the box tests are exact.
+		uint32_t firstSlice = getSlice(distance - sphere.w);
+		uint32_t lastSlice = getSlice(distance + sphere.w);
+		firstSlice = firstSlice > 0 ? firstSlice - 1 : 0;
+		lastSlice = lastSlice + 1 < NUM_Z ? lastSlice + 1 : lastSlice;
+
+		const float radius2 = sphere.w * sphere.w;
+
+		const __m128 x = _mm_set1_ps(sphere.x);
+		const __m128 y = _mm_set1_ps(sphere.y);
+		const __m128 z = _mm_set1_ps(sphere.z);
+		const __m128 radius2x4 = _mm_set1_ps(radius2);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (uint32_t slice = firstSlice; slice <= lastSlice; ++slice)
+		{
+			// z bounds are the same for the whole slice and y bounds for a row of it. A sphere too far away 
+			// along one axis is too far in total, so skipping these gives the same result as testing all clusters.
+			uint32_t sliceStart = slice * NUM_TILES;
+			float dz = std::max(std::max(m_minZ[sliceStart] - sphere.z, 0.f), sphere.z - m_maxZ[sliceStart]);
+
+			if (dz * dz > radius2)
+			{
+				continue;
+			}
+
+			for (uint32_t row = 0; row < NUM_Y; ++row)
+			{
+				uint32_t rowStart = sliceStart + row * NUM_X;
+				float dy = std::max(std::max(m_minY[rowStart] - sphere.y, 0.f), sphere.y - m_maxY[rowStart]);
+
+				if (dy * dy > radius2)
+				{
+					continue;
+				}
+
+				for (uint32_t c = rowStart; c < rowStart + NUM_X; c += LANES)
+				{
+					// Distance from the center to the box along each axis, zero where the center is between the sides.
+					__m128 dx4 = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minX[c]), x), zero), _mm_sub_ps(x, _mm_loadu_ps(&m_maxX[c])));
+					__m128 dy4 = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minY[c]), y), zero), _mm_sub_ps(y, _mm_loadu_ps(&m_maxY[c])));
+					__m128 dz4 = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minZ[c]), z), zero), _mm_sub_ps(z, _mm_loadu_ps(&m_maxZ[c])));
+
+					__m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx4, dx4), _mm_mul_ps(dy4, dy4)), _mm_mul_ps(dz4, dz4));
+					int mask = _mm_movemask_ps(_mm_cmple_ps(dist2, radius2x4));
+
+					if (0 == mask)
+					{
+						continue;
+					}
+
+					for (uint32_t lane = 0; lane < LANES; ++lane)
+					{
+						if (mask & (1 << lane))
+						{
+							m_pairClusters.push_back(c + lane);
+							m_pairLights.push_back(lightIndex);
+							++m_ranges[c + lane].m_count;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const ClusteredLightStats& ClusteredLightCuller::build(const GpuPointLight* lights, size_t numLights)
+	{
+		Clock::time_point start = Clock::now();
+
+		m_pairClusters.clear();
+		m_pairLights.clear();
+
+		for (ClusterLightRange& range : m_ranges)
+		{
+			range.m_count = 0;
+		}
+
+		for (size_t i = 0; i < numLights; ++i)
+		{
+			addLightToSlices(lights[i], static_cast<uint32_t>(i));
+		}
+
+		finishBuild(numLights);
+
+		m_stats.m_buildMs = Ms(Clock::now() - start).count();
+		return m_stats;
+	}
+
+	const ClusteredLightStats& ClusteredLightCuller::buildScalar(const GpuPointLight* lights, size_t numLights)
+	{
+		Clock::time_point start = Clock::now();
+
+		m_pairClusters.clear();
+		m_pairLights.clear();
+
+		for (uint32_t c = 0; c < NUM_CLUSTERS; ++c)
+		{
+			m_ranges[c].m_count = 0;
+
+			for (size_t i = 0; i < numLights; ++i)
+			{
+				const GpuVec4& sphere = lights[i].m_positionEyeRadius;
+
+				float dx = std::max(std::max(m_minX[c] - sphere.x, 0.f), sphere.x - m_maxX[c]);
+				float dy = std::max(std::max(m_minY[c] - sphere.y, 0.f), sphere.y - m_maxY[c]);
+				float dz = std::max(std::max(m_minZ[c] - sphere.z, 0.f), sphere.z - m_maxZ[c]);
+
+				if (dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w)
+				{
+					m_pairClusters.push_back(c);
+					m_pairLights.push_back(static_cast<uint32_t>(i));
+					++m_ranges[c].m_count;
+				}
+			}
+		}
+
+		finishBuild(numLights);
+
+		m_stats.m_buildMs = Ms(Clock::now() - start).count();
+		return m_stats;
+	}
+
+	void ClusteredLightCuller::finishBuild(size_t numLights)
+	{
+		m_stats.m_numLights = numLights;
+		m_stats.m_numIndices = m_pairLights.size();
+		m_stats.m_numOccupiedClusters = 0;
+		m_stats.m_maxLightsPerCluster = 0;
+
+		uint32_t offset = 0;
+
+		for (ClusterLightRange& range : m_ranges)
+		{
+			range.m_offset = offset;
+			offset += range.m_count;
+
+			if (range.m_count > 0)
+			{
+				++m_stats.m_numOccupiedClusters;
+				m_stats.m_maxLightsPerCluster = std::max(m_stats.m_maxLightsPerCluster, range.m_count);
+			}
+
+			// Counts again while scattering, the pairs of a cluster are in ascending light order.
+			range.m_count = 0;
+		}
+
+		m_lightIndices.resize(m_pairLights.size());
+
+		for (size_t i = 0; i < m_pairLights.size(); ++i)
+		{
+			ClusterLightRange& range = m_ranges[m_pairClusters[i]];
+			m_lightIndices[range.m_offset + range.m_count++] = m_pairLights[i];
+		}
+
+		m_stats.m_avgLightsPerOccupiedCluster = m_stats.m_numOccupiedClusters > 0
+			? static_cast<float>(m_stats.m_numIndices) / m_stats.m_numOccupiedClusters : 0.f;
+	}
+
+	const ClusterLightRange* ClusteredLightCuller::getRanges() const
+	{
+		return m_ranges.data();
+	}
+
+	const std::vector<uint32_t>& ClusteredLightCuller::getLightIndices() const
+	{
+		return m_lightIndices;
+	}
+
+	const ClusteredLightStats& ClusteredLightCuller::getStats() const
+	{
+		return m_stats;
+	}
+
+	void ClusteredLightCuller::getClusterBounds(uint32_t cluster, Vec3* outMin, Vec3* outMax) const
+	{
+		assert(cluster < NUM_CLUSTERS);
+		*outMin = Vec3(m_minX[cluster], m_minY[cluster], m_minZ[cluster]);
+		*outMax = Vec3(m_maxX[cluster], m_maxY[cluster], m_maxZ[cluster]);
+	}
+
+	float ClusteredLightCuller::getSliceScale() const
+	{
+		return m_sliceScale;
+	}
+
+	float ClusteredLightCuller::getSliceBias() const
+	{
+		return m_sliceBias;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Render/LightBuffer.hpp>
+
+#include <Math/Vec3.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class Matrix4;
+
+	struct ClusteredLightStats
+	{
+		ClusteredLightStats()
+			: m_numLights(0)
+			, m_numOccupiedClusters(0)
+			, m_numIndices(0)
+			, m_maxLightsPerCluster(0)
+			, m_avgLightsPerOccupiedCluster(0.f)
+			, m_buildMs(0.f)
+		{}
+
+		size_t m_numLights;
+		size_t m_numOccupiedClusters;
+		size_t m_numIndices;
+		uint32_t m_maxLightsPerCluster;
+		float m_avgLightsPerOccupiedCluster;
+		float m_buildMs;
+	};
+
+	// Where the lights of a cluster start in the light index list and how many there are.
+	struct ClusterLightRange
+	{
+		uint32_t m_offset;
+		uint32_t m_count;
+	};
+
+	// Divides the view frustum into a grid of screen tiles and exponential depth slices and lists
+	// the point lights touching each cell (cluster). Lights are view space spheres, clusters are
+	// the view space boxes around their frustum piece. Spheres are tested against four clusters
+	// of a row at a time with SSE, only in the slices and rows their bounds reach.
+	// Cluster x and y go from the left and bottom of the screen, cluster (x, y, z) has the index
+	// (z * NUM_Y + y) * NUM_X + x.
+	class ClusteredLightCuller
+	{
+	public:
+		enum
+		{
+			NUM_X = 16,
+			NUM_Y = 8,
+			NUM_Z = 32,
+			NUM_TILES = NUM_X * NUM_Y,
+			NUM_CLUSTERS = NUM_TILES * NUM_Z
+		};
+
+		ClusteredLightCuller();
+
+		// Computes the cluster boxes of a projection built by perspectiveRH(). Only needed when it changes.
+		void setProjection(const Matrix4& projection, float nearPlane, float farPlane);
+
+		// Assigns the lights to the clusters they touch, in ascending order within each cluster.
+		const ClusteredLightStats& build(const GpuPointLight* lights, size_t numLights);
+
+		// Same result as build(), testing every light against every cluster one at a time. Reference for tests and benchmarks.
+		const ClusteredLightStats& buildScalar(const GpuPointLight* lights, size_t numLights);
+
+		const ClusterLightRange* getRanges() const;
+
+		const std::vector<uint32_t>& getLightIndices() const;
+
+		const ClusteredLightStats& getStats() const;
+
+		void getClusterBounds(uint32_t cluster, Vec3* outMin, Vec3* outMax) const;
+
+		// Slice containing a view space distance, clamped to the grid. The shader uses
+		// log(distance) * getSliceScale() + getSliceBias().
+		uint32_t getSlice(float distance) const;
+
+		float getSliceScale() const;
+
+		float getSliceBias() const;
+
+	private:
+		enum
+		{
+			LANES = 4
+		};
+
+		void addLightToSlices(const GpuPointLight& light, uint32_t lightIndex);
+
+		// Turns the per cluster counts and the (cluster, light) pairs into ranges and the index list.
+		void finishBuild(size_t numLights);
+
+		float m_nearPlane;
+		float m_farPlane;
+		float m_sliceScale;
+		float m_sliceBias;
+
+		// Cluster boxes as structure of arrays, indexed like the clusters.
+		std::vector<float> m_minX;
+		std::vector<float> m_minY;
+		std::vector<float> m_minZ;
+		std::vector<float> m_maxX;
+		std::vector<float> m_maxY;
+		std::vector<float> m_maxZ;
+
+		std::vector<uint32_t> m_pairClusters;
+		std::vector<uint32_t> m_pairLights;
+
+		std::vector<ClusterLightRange> m_ranges;
+		std::vector<uint32_t> m_lightIndices;
+
+		ClusteredLightStats m_stats;
+	};
+}
\ No newline at end of file
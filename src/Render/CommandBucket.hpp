@@ -3,37 +3,65 @@
 #include <vector>
 #include <typeindex>
 #include <typeinfo>
+#include <assert.h>
 
 #include "RIDefs.hpp"
 #include "CommandPacket.hpp"
+#include "CommandKey.hpp"
 #include <Memory/StackAllocator.hpp>
+#include <Core/Logger.hpp>
+#include <Core/RadixSort.hpp>
 
 namespace Phoenix
 {
 	class IRIContext;
 
+	// Collects command packets together with a CommandKey each. On submit the 
+	// packets are radix sorted by their keys, so the order in which they were 
+	// added does not dictate the order in which they reach the context.
+	// The memory has to hold the packets of maxCommands commands with everything appended to them.
 	class CommandBucket
 	{
 	public:
 		CommandBucket(uint32_t maxCommands, size_t memorySizeBytes)
 			: m_memory(memorySizeBytes)
 			, m_currentIndex(0)
+			, m_bSorted(true)
+			, m_bFullLogged(false)
 			, m_commands(maxCommands)
+			, m_keys(maxCommands)
+			, m_sortedKeys(maxCommands)
+			, m_order(maxCommands)
+			, m_tempKeys(maxCommands)
+			, m_tempOrder(maxCommands)
 		{
 		}
 
+		// Null once maxCommands commands were added since the last submit, the command is dropped.
 		template <class Command>
-		Command* addCommand(/*Key key, */size_t auxMemorySize = 0)
+		Command* addCommand(CommandKey key, size_t auxMemorySize = 0)
 		{
 			static_assert(is_submittable<Command>::value, "Commands require a SubmitFunc.");
+
+			if (m_currentIndex >= m_commands.size())
+			{
+				if (!m_bFullLogged)
+				{
+					Logger::errorf("CommandBucket is full, commands past %zu per submit are dropped.", m_commands.size());
+					m_bFullLogged = true;
+				}
+
+				return nullptr;
+			}
 			
 			CommandPacket packet = commandPacket::create<Command>(auxMemorySize, m_memory);
 
 			// store key and pointer to the data
 			{
-				//m_keys[current] = key;
+				m_keys[m_currentIndex] = key;
 				m_commands[m_currentIndex] = packet;
 				m_currentIndex++;
+				m_bSorted = false;
 			}
 
 			commandPacket::setNextCommandPacket(packet, nullptr);
@@ -57,30 +85,58 @@ namespace Phoenix
 			return commandPacket::getCommand<NewCommand>(packet);
 		}
 
+		// Orders the packets added since the last submit by their keys. Packets 
+		// with equal keys keep the order in which they were added.
+		void sort()
+		{
+			if (m_bSorted)
+			{
+				return;
+			}
+
+			for (size_t i = 0; i < m_currentIndex; ++i)
+			{
+				m_sortedKeys[i] = m_keys[i];
+				m_order[i] = static_cast<uint32_t>(i);
+			}
+
+			radixSort(m_sortedKeys.data(), m_order.data(), m_tempKeys.data(), m_tempOrder.data(), m_currentIndex);
+			m_bSorted = true;
+		}
+
 		void submit(IRIContext* rc) 
 		{
+			sort();
+
 			for (size_t i = 0; i < m_currentIndex; ++i)
 			{
-				CommandPacket packet = m_commands[i];
+				CommandPacket packet = m_commands[m_order[i]];
 				do
 				{
 					const SubmitFptr function = commandPacket::loadSubmitFptr(packet);
 					const void* command = commandPacket::loadCommand(packet);
 					function(rc, command);
 
-					void* previous = packet;
 					packet = commandPacket::loadNextCommandPacket(packet);
 					
 				} while (packet != nullptr);
 			}
 
 			m_currentIndex = 0;
+			m_bSorted = true;
 			m_memory.clear();
 		}
 
 	private:
 		StackAllocator m_memory;
 		size_t m_currentIndex;
+		bool m_bSorted;
+		bool m_bFullLogged; // Only the first time, not every frame.
 		std::vector<void*> m_commands;
+		std::vector<CommandKey> m_keys;
+		std::vector<CommandKey> m_sortedKeys;
+		std::vector<uint32_t> m_order;
+		std::vector<CommandKey> m_tempKeys;
+		std::vector<uint32_t> m_tempOrder;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "CommandKey.hpp"
+
+#include <assert.h>
+#include <math.h>
+
+namespace Phoenix
+{
+	namespace commandKey
+	{
+		static uint64_t mask(size_t bits)
+		{
+			return (uint64_t(1) << bits) - 1;
+		}
+
+		CommandKey create(uint8_t pass, ETranslucency translucency, uint32_t depth, uint32_t program, uint32_t material)
+		{
+			assert(pass <= mask(PASS_BITS));
+			assert(depth <= mask(DEPTH_BITS));
+
+			// Translucent draws need to be blended back-to-front.
+			if (ETranslucency::Translucent == translucency)
+			{
+				depth = static_cast<uint32_t>(mask(DEPTH_BITS)) - depth;
+			}
+
+			CommandKey key = 0;
+			key |= (uint64_t(pass) & mask(PASS_BITS)) << PASS_SHIFT;
+			key |= (uint64_t(translucency) & mask(TRANSLUCENCY_BITS)) << TRANSLUCENCY_SHIFT;
+			key |= (uint64_t(depth) & mask(DEPTH_BITS)) << DEPTH_SHIFT;
+			key |= (uint64_t(program) & mask(PROGRAM_BITS)) << PROGRAM_SHIFT;
+			key |= (uint64_t(material) & mask(MATERIAL_BITS)) << MATERIAL_SHIFT;
+			return key;
+		}
+
+		uint32_t quantizeDepth(float viewDepth, float nearPlane, float farPlane)
+		{
+			assert(nearPlane > 0.0f && farPlane > nearPlane);
+
+			if (viewDepth <= nearPlane)
+			{
+				return 0;
+			}
+
+			if (viewDepth >= farPlane)
+			{
+				return static_cast<uint32_t>(mask(DEPTH_BITS));
+			}
+
+			float normalized = logf(viewDepth / nearPlane) / logf(farPlane / nearPlane);
+			return static_cast<uint32_t>(normalized * mask(DEPTH_BITS));
+		}
+
+		uint8_t getPass(CommandKey key)
+		{
+			return static_cast<uint8_t>((key >> PASS_SHIFT) & mask(PASS_BITS));
+		}
+
+		uint32_t getDepth(CommandKey key)
+		{
+			return static_cast<uint32_t>((key >> DEPTH_SHIFT) & mask(DEPTH_BITS));
+		}
+
+		uint32_t getProgram(CommandKey key)
+		{
+			return static_cast<uint32_t>((key >> PROGRAM_SHIFT) & mask(PROGRAM_BITS));
+		}
+
+		uint32_t getMaterial(CommandKey key)
+		{
+			return static_cast<uint32_t>((key >> MATERIAL_SHIFT) & mask(MATERIAL_BITS));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Phoenix
+{
+	// 64 bit key used to order the command packets of a CommandBucket before they
+	// are submitted. Packets are submitted in ascending key order.
+	//
+	// CommandKey Layout (most to least significant):
+	// - pass         4 bits, the pass the command belongs to
+	// - translucency 2 bits, opaque draws are submitted before translucent ones
+	// - depth       10 bits, quantized view depth, front-to-back for opaque and 
+	//                        back-to-front for translucent draws
+	// - program     16 bits, groups draws that use the same shader program
+	// - material    32 bits, groups draws that use the same textures
+	//
+	// Depth is quantized coarsely on purpose, draws that land in the same depth 
+	// slice are grouped by program and material to reduce binds.
+	typedef uint64_t CommandKey;
+
+	enum class ETranslucency
+	{
+		Opaque,
+		Translucent
+	};
+
+	namespace commandKey
+	{
+		enum
+		{
+			MATERIAL_BITS = 32,
+			PROGRAM_BITS = 16,
+			DEPTH_BITS = 10,
+			TRANSLUCENCY_BITS = 2,
+			PASS_BITS = 4,
+
+			MATERIAL_SHIFT = 0,
+			PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS,
+			DEPTH_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS,
+			TRANSLUCENCY_SHIFT = DEPTH_SHIFT + DEPTH_BITS,
+			PASS_SHIFT = TRANSLUCENCY_SHIFT + TRANSLUCENCY_BITS,
+		};
+
+		static_assert(PASS_SHIFT + PASS_BITS == 64, "CommandKey fields must fill exactly 64 bits.");
+
+		CommandKey create(uint8_t pass, ETranslucency translucency, uint32_t depth, uint32_t program, uint32_t material);
+
+		// Maps a positive view space depth between near and far logarithmically to [0, 2^DEPTH_BITS), 
+		// so that close objects get finer slices than distant ones.
+		uint32_t quantizeDepth(float viewDepth, float nearPlane, float farPlane);
+
+		uint8_t getPass(CommandKey key);
+		uint32_t getDepth(CommandKey key);
+		uint32_t getProgram(CommandKey key);
+		uint32_t getMaterial(CommandKey key);
+	}
+}
\ No newline at end of file
@@ -1,84 +1,51 @@
-#pragma once
-
 #include "Commands.hpp"
 #include "RIContext.hpp"
 
 namespace Phoenix
 {
-	//namespace SubmitFunctions
-	//{
-	//	void indexedDraw(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::DrawIndexed*>(command);
-
-	//		rc->setState(dc->state);
-	//		rc->drawIndexed(dc->vertexBuffer, dc->indexBuffer, dc->primitives, dc->count, dc->start);
-	//	}
-
-	//	void linearDraw(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::DrawLinear*>(command);
-
-	//		rc->setState(dc->state);
-	//		rc->drawLinear(dc->vertexBuffer, dc->primitives, dc->count, dc->start);
-	//	}
-	//
-	//	void clearTarget(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::ClearTarget*>(command);
-	//		rc->clearRenderTarget(dc->handle, dc->toClear, dc->color);
-	//	}
-
-	//	void vertexBufferCreate(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::CreateVertexBuffer*>(command);
-	//		rc->createVertexBuffer(dc->handle, dc->format);
-	//	}
-
-	//	void indexBufferCreate(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::CreateIndexBuffer*>(command);
-	//		rc->createIndexBuffer(dc->handle, dc->size, dc->count, dc->data);
-	//	}
-
-	//	void shaderCreate(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::CreateShader*>(command);
-	//		rc->createShader(dc->handle, dc->source, dc->shaderType);
-	//	}
-
-	//	void programCreate(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::CreateProgram*>(command);
-	//		rc->createProgram(dc->handle, dc->shaders);
-	//	}
-
-	//	void textureCreate(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::createTexture*>(command);
-	//		rc->createTexture(dc->handle, dc->format, dc->desc, dc->name);
-	//	}
-
-	//	void textureUpload(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::UploadTexture*>(command);
-	//		rc->uploadTextureData(dc->handle, dc->data, dc->width, dc->height);
-	//	}
-
-	//	void cubemapUpload(RIContext* rc, const void* command)
-	//	{
-	//		auto dc = static_cast<const Commands::UploadCubemap*>(command);
-
-	//		for (size_t i = 0; i < 6; ++i)
-	//		{
-	//			rc->uploadTextureData(dc->handle, dc->data.data[i], dc->width, dc->height);
-	//		}
-	//	}
-	//}
-
-	//const SubmitFptr Commands::DrawIndexed::SubmitFunc = SubmitFunctions::indexedDraw;
-	//const SubmitFptr Commands::DrawLinear::SubmitFunc = SubmitFunctions::linearDraw;
-	//const SubmitFptr Commands::ClearTarget::SubmitFunc = SubmitFunctions::clearTarget;
-	//const SubmitFptr Commands::UploadTexture::SubmitFunc = SubmitFunctions::textureUpload;
-	//const SubmitFptr Commands::UploadCubemap::SubmitFunc = SubmitFunctions::cubemapUpload;
-}
+	namespace SubmitFunctions
+	{
+		void drawIndexed(IRIContext* rc, const void* command)
+		{
+			auto dc = static_cast<const RIDrawIndexedCommand*>(command);
+			rc->drawIndexed(dc->vertexBuffer, dc->indexBuffer, dc->primitives, dc->count, dc->start);
+		}
+
+		void drawLinear(IRIContext* rc, const void* command)
+		{
+			auto dc = static_cast<const RIDrawLinearCommand*>(command);
+			rc->drawLinear(dc->vertexBuffer, dc->primitives, dc->count, dc->start);
+		}
+
+		template <class UniformCommand>
+		void setUniform(IRIContext* rc, const void* command)
+		{
+			auto uc = static_cast<const UniformCommand*>(command);
+			rc->bindShaderProgram(uc->usingProgram);
+			rc->bindUniform(uc->uniform, &uc->data);
+		}
+
+		void bindTexture2D(IRIContext* rc, const void* command)
+		{
+			auto tc = static_cast<const RIBindTexture2DCommand*>(command);
+			rc->bindShaderProgram(tc->usingProgram);
+			rc->bindTexture(tc->sampler, tc->texture);
+		}
+
+		void unbindTextures(IRIContext* rc, const void* command)
+		{
+			rc->unbindTextures();
+		}
+	}
+
+	const SubmitFptr RIDrawIndexedCommand::SubmitFunc = SubmitFunctions::drawIndexed;
+	const SubmitFptr RIDrawLinearCommand::SubmitFunc = SubmitFunctions::drawLinear;
+	const SubmitFptr RISetUniformInt32Command::SubmitFunc = SubmitFunctions::setUniform<RISetUniformInt32Command>;
+	const SubmitFptr RISetUniformFloatCommand::SubmitFunc = SubmitFunctions::setUniform<RISetUniformFloatCommand>;
+	const SubmitFptr RISetUniformVec3Command::SubmitFunc = SubmitFunctions::setUniform<RISetUniformVec3Command>;
+	const SubmitFptr RISetUniformVec4Command::SubmitFunc = SubmitFunctions::setUniform<RISetUniformVec4Command>;
+	const SubmitFptr RISetUniformMatrix3Command::SubmitFunc = SubmitFunctions::setUniform<RISetUniformMatrix3Command>;
+	const SubmitFptr RISetUniformMatrix4Command::SubmitFunc = SubmitFunctions::setUniform<RISetUniformMatrix4Command>;
+	const SubmitFptr RIBindTexture2DCommand::SubmitFunc = SubmitFunctions::bindTexture2D;
+	const SubmitFptr RIUnbindTexturesCommand::SubmitFunc = SubmitFunctions::unbindTextures;
+}
\ No newline at end of file
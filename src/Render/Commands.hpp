@@ -18,6 +18,8 @@ namespace Phoenix
 	
 	struct RIDrawIndexedCommand
 	{
+		SUBMITTABLE();
+
 		uint32_t start;
 		uint32_t count;
 
@@ -29,6 +31,8 @@ namespace Phoenix
 
 	struct RIDrawLinearCommand
 	{
+		SUBMITTABLE();
+
 		uint32_t start;
 		uint32_t count;
 
@@ -48,6 +52,8 @@ namespace Phoenix
 
 	struct RISetUniformInt32Command
 	{
+		SUBMITTABLE();
+
 		int32_t data;
 		ProgramHandle usingProgram;
 		UniformHandle uniform;
@@ -55,6 +61,8 @@ namespace Phoenix
 
 	struct RISetUniformFloatCommand
 	{
+		SUBMITTABLE();
+
 		float data;
 		ProgramHandle usingProgram;
 		UniformHandle uniform;
@@ -62,6 +70,8 @@ namespace Phoenix
 
 	struct RISetUniformVec3Command
 	{
+		SUBMITTABLE();
+
 		Vec3 data;
 		ProgramHandle usingProgram;
 		UniformHandle uniform;
@@ -69,6 +79,8 @@ namespace Phoenix
 
 	struct RISetUniformVec4Command
 	{
+		SUBMITTABLE();
+
 		Vec4 data;
 		ProgramHandle usingProgram;
 		UniformHandle uniform;
@@ -76,6 +88,8 @@ namespace Phoenix
 
 	struct RISetUniformMatrix3Command
 	{
+		SUBMITTABLE();
+
 		Matrix3 data;
 		ProgramHandle usingProgram;
 		UniformHandle uniform;
@@ -83,11 +97,27 @@ namespace Phoenix
 
 	struct RISetUniformMatrix4Command
 	{
+		SUBMITTABLE();
+
 		Matrix4 data;
 		ProgramHandle usingProgram;
 		UniformHandle uniform;
 	};
 
+	struct RIBindTexture2DCommand
+	{
+		SUBMITTABLE();
+
+		ProgramHandle usingProgram;
+		UniformHandle sampler;
+		Texture2DHandle texture;
+	};
+
+	struct RIUnbindTexturesCommand
+	{
+		SUBMITTABLE();
+	};
+
 	/*struct RIUploadTexture2DCommand
 	{
 		const void* data;
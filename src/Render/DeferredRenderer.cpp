@@ -2,6 +2,7 @@
 
 #include <Core/Shader.hpp>
 #include <Core/Mesh.hpp>
+#include <Core/MeshLod.hpp>
 #include <Core/Texture.hpp>
 #include <Core/Material.hpp>
 #include <Core/Logger.hpp>
@@ -11,12 +12,18 @@
 #include <Render/RIDevice.hpp>
 #include <Render/RIContext.hpp>
 #include <Render/LightBuffer.hpp>
+#include <Render/Commands.hpp>
 
 namespace Phoenix
 {
 	DeferredRenderer::DeferredRenderer(IRIDevice* renderDevice, IRIContext* renderContext, uint32_t gBufferWidth, uint32_t gBufferHeight)
-		: m_device(renderDevice)
+		: m_nearPlane(0.1f)
+		, m_farPlane(10000.0f)
+		, m_viewportWidth(static_cast<float>(gBufferWidth))
+		, m_viewportHeight(static_cast<float>(gBufferHeight))
+		, m_device(renderDevice)
 		, m_context(renderContext)
+		, m_gBufferCommands(MAX_GBUFFER_COMMANDS, GBUFFER_COMMAND_MEMORY_BYTES)
 	{
 		TextureDesc desc;
 		desc.width = gBufferWidth;
@@ -64,6 +71,7 @@ namespace Phoenix
 		m_uniforms.normalTf = renderDevice->createUniform("normalTf", EUniformType::Mat3);
 
 		m_gBufferProgram = loadShaderProgram(renderDevice, "Shaders/deferred/buildGBuffer.vert", "Shaders/deferred/buildGBuffer.frag");
+		m_gBufferPackedProgram = loadShaderProgram(renderDevice, "Shaders/deferred/buildGBufferPacked.vert", "Shaders/deferred/buildGBuffer.frag");
 		m_lightsPassProgram = loadShaderProgram(renderDevice, "Shaders/deferred/lightsPass.vert", "Shaders/deferred/lightsPass.frag");
 		m_copyToBackBufferProgram = loadShaderProgram(renderDevice, "Shaders/deferred/copyToBackBuffer.vert", "Shaders/deferred/copyToBackBuffer.frag");
 
@@ -74,7 +82,13 @@ namespace Phoenix
 		m_uniforms.matMetallicSampler = renderDevice->createUniform("matMetallicTex", EUniformType::Sampler2D);
 		m_uniforms.matNormalSampler = renderDevice->createUniform("matNormalTex", EUniformType::Sampler2D);
 
-		m_cbLights =  renderDevice->createConstantBuffer("LightDataBuffer", sizeof(LightBuffer));
+		m_cbLights =  renderDevice->createConstantBuffer("LightDataBuffer", sizeof(GpuLightPassParams));
+
+		// Start sized for a few hundred lights, updates resize them to the lights of the frame.
+		m_sbDirectionalLights = renderDevice->createStorageBuffer("DirectionalLights", 32 * sizeof(GpuDirectionalLight));
+		m_sbPointLights = renderDevice->createStorageBuffer("PointLights", 256 * sizeof(GpuPointLight));
+		m_sbClusterRanges = renderDevice->createStorageBuffer("ClusterRanges", ClusteredLightCuller::NUM_CLUSTERS * sizeof(ClusterLightRange));
+		m_sbClusterLightIndices = renderDevice->createStorageBuffer("ClusterLightIndices", 4096 * sizeof(uint32_t));
 	}
 
 	void DeferredRenderer::setViewMatrix(const Matrix4& view)
@@ -85,6 +99,22 @@ namespace Phoenix
 	void DeferredRenderer::setProjectionMatrix(const Matrix4& projection)
 	{
 		m_projMat = projection;
+
+		// Recover the clip planes from a projection built by perspectiveRH(), they bound the depth used to sort draws.
+		m_nearPlane = projection(2, 3) / (projection(2, 2) - 1.0f);
+		m_farPlane = projection(2, 3) / (projection(2, 2) + 1.0f);
+
+		m_lightCuller.setProjection(projection, m_nearPlane, m_farPlane);
+	}
+
+	const Matrix4& DeferredRenderer::getViewMatrix() const
+	{
+		return m_viewMat;
+	}
+
+	const Matrix4& DeferredRenderer::getProjectionMatrix() const
+	{
+		return m_projMat;
 	}
 
 	void DeferredRenderer::setupGBufferPass()
@@ -98,43 +128,113 @@ namespace Phoenix
 		m_context->setDepthTest(EDepth::Enable);
 		m_context->setDepthWrite(EDepth::Enable);
 		m_context->setBlendState(BlendState(EBlend::Disable));
+		m_context->bindShaderProgram(m_gBufferPackedProgram);
+		m_context->bindUniform(m_uniforms.projTf, &m_projMat);
 		m_context->bindShaderProgram(m_gBufferProgram);
 		m_context->bindUniform(m_uniforms.projTf, &m_projMat);
 	}
 
-	void DeferredRenderer::drawStaticMeshWithMaterial(VertexBufferHandle vb, const Material& material, uint32_t numVertices, uint32_t vertexFrom)
+	template <class PrevCommand>
+	RIBindTexture2DCommand* appendBindTexture(CommandBucket& bucket, PrevCommand* prev, ProgramHandle program, UniformHandle sampler, Texture2DHandle texture)
 	{
-		m_context->bindTexture(m_uniforms.matDiffuseSampler, material.m_diffuseTex->m_resourceHandle);
-		m_context->bindTexture(m_uniforms.matMetallicSampler, material.m_metallicTex->m_resourceHandle);
-		m_context->bindTexture(m_uniforms.matNormalSampler, material.m_normalTex->m_resourceHandle);
-		m_context->bindTexture(m_uniforms.matRoughnessSampler, material.m_roughnessTex->m_resourceHandle);
+		RIBindTexture2DCommand* cmd = bucket.appendCommand<RIBindTexture2DCommand>(prev);
+		cmd->usingProgram = program;
+		cmd->sampler = sampler;
+		cmd->texture = texture;
+		return cmd;
+	}
+
+	void DeferredRenderer::drawStaticMeshWithMaterial(ProgramHandle program, VertexBufferHandle vb, IndexBufferHandle ib, const Material& material, uint32_t numIndices, uint32_t indexFrom,
+													  const Matrix4& modelViewTf, const Matrix3& normalTf, uint32_t depth)
+	{
+		// Diffuse and normal textures are the ones that differ the most between materials, 
+		// keying on them puts draws that share their textures next to each other.
+		uint32_t materialKey = (static_cast<uint32_t>(material.m_diffuseTex->m_resourceHandle.m_idx) << 16)
+							 | (static_cast<uint32_t>(material.m_normalTex->m_resourceHandle.m_idx) & 0xFFFF);
+
+		CommandKey key = commandKey::create(GBufferPass, ETranslucency::Opaque, depth, static_cast<uint32_t>(program.m_idx), materialKey);
+
+		RISetUniformMatrix4Command* modelView = m_gBufferCommands.addCommand<RISetUniformMatrix4Command>(key);
+
+		if (!modelView)
+		{
+			return;
+		}
+
+		modelView->data = modelViewTf;
+		modelView->usingProgram = program;
+		modelView->uniform = m_uniforms.modelViewTf;
+
+		RISetUniformMatrix3Command* normal = m_gBufferCommands.appendCommand<RISetUniformMatrix3Command>(modelView);
+		normal->data = normalTf;
+		normal->usingProgram = program;
+		normal->uniform = m_uniforms.normalTf;
+
+		RIBindTexture2DCommand* tex = appendBindTexture(m_gBufferCommands, normal, program, m_uniforms.matDiffuseSampler, material.m_diffuseTex->m_resourceHandle);
+		tex = appendBindTexture(m_gBufferCommands, tex, program, m_uniforms.matMetallicSampler, material.m_metallicTex->m_resourceHandle);
+		tex = appendBindTexture(m_gBufferCommands, tex, program, m_uniforms.matNormalSampler, material.m_normalTex->m_resourceHandle);
+		tex = appendBindTexture(m_gBufferCommands, tex, program, m_uniforms.matRoughnessSampler, material.m_roughnessTex->m_resourceHandle);
 
-		m_context->drawLinear(vb, EPrimitive::Triangles, numVertices, vertexFrom);
+		RIDrawIndexedCommand* draw = m_gBufferCommands.appendCommand<RIDrawIndexedCommand>(tex);
+		draw->start = indexFrom;
+		draw->count = numIndices;
+		draw->primitives = EPrimitive::Triangles;
+		draw->vertexBuffer = vb;
+		draw->indexBuffer = ib;
+
+		m_gBufferCommands.appendCommand<RIUnbindTexturesCommand>(draw);
 	}
 
-	void DeferredRenderer::drawStaticMesh(const StaticMesh& mesh, const Matrix4& transform)
+	void DeferredRenderer::drawStaticMesh(const StaticMesh& mesh, const Matrix4& transform, uint8_t lod)
 	{
 		Matrix4 modelViewTf = m_viewMat * transform;
-		m_context->bindUniform(m_uniforms.modelViewTf, &modelViewTf);
 
 		Matrix3 normalTf(modelViewTf.asMatrix3());
 		normalTf.transposeSelf().inverseSelf();
-		m_context->bindUniform(m_uniforms.normalTf, &normalTf);
 
-		size_t materialIdx = 0;
+		// The view looks down -z, so the translation of the model view transform gives the depth of the mesh origin.
+		uint32_t depth = commandKey::quantizeDepth(-modelViewTf(2, 3), m_nearPlane, m_farPlane);
+
+		ProgramHandle program = m_gBufferProgram;
+		const MeshData& data = mesh.m_data;
+
+		if (data.m_vertexFormat != EVertexFormat::Float)
+		{
+			program = m_gBufferPackedProgram;
+
+			// Packed positions are relative to the mesh bounds, the normal transform stays the one of the mesh.
+			if (data.m_vertexFormat == EVertexFormat::PackedPositions)
+			{
+				modelViewTf = modelViewTf * Matrix4::translation(data.m_boundsMin) * Matrix4::scale(data.m_boundsExtent);
+			}
+		}
 
-		for (; materialIdx < mesh.m_numMaterials - 1; ++materialIdx)
+		for (uint8_t materialIdx = 0; materialIdx < mesh.m_numMaterials; ++materialIdx)
 		{
 			const Material& material = *mesh.m_materials[materialIdx];
-			size_t currVertexIdx = mesh.m_vertexFrom[materialIdx];
-			drawStaticMeshWithMaterial(mesh.m_vertexbuffer, material, mesh.m_vertexFrom[materialIdx + 1] - currVertexIdx, currVertexIdx);
+
+			size_t indexFrom = 0;
+			size_t numIndices = 0;
+			getLodIndexRange(mesh, lod, materialIdx, &indexFrom, &numIndices);
+
+			drawStaticMeshWithMaterial(program, mesh.m_vertexbuffer, mesh.m_indexbuffer, material, static_cast<uint32_t>(numIndices), static_cast<uint32_t>(indexFrom), modelViewTf, normalTf, depth);
 		}
+	}
+
+	float DeferredRenderer::getScreenSize(const Vec3& center, float radius) const
+	{
+		Vec3 viewCenter(m_viewMat * Vec4(center, 1.f));
+		return getProjectedSize(viewCenter, radius, m_projMat(1, 1), m_viewportHeight);
+	}
 
-		const Material& material = *mesh.m_materials[materialIdx];
-		size_t currVertexIdx = mesh.m_vertexFrom[materialIdx];
-		drawStaticMeshWithMaterial(mesh.m_vertexbuffer, material, mesh.m_data.m_numVertices - currVertexIdx, currVertexIdx);
+	float DeferredRenderer::getViewportHeight() const
+	{
+		return m_viewportHeight;
+	}
 
-		m_context->unbindTextures();
+	void DeferredRenderer::runGBufferPass()
+	{
+		m_gBufferCommands.submit(m_context);
 	}
 
 	void DeferredRenderer::setupDirectLightingPass()
@@ -155,11 +255,40 @@ namespace Phoenix
 
 	void DeferredRenderer::runLightsPass(const LightBuffer& lightBuffer)
 	{
-		m_context->updateConstantBuffer(m_cbLights, &lightBuffer, sizeof(LightBuffer));
+		const std::vector<GpuPointLight>& pointLights = lightBuffer.m_pointLights;
+		m_lightCuller.build(pointLights.data(), pointLights.size());
+
+		GpuLightPassParams params;
+		params.m_numDirLights = static_cast<uint32_t>(lightBuffer.m_directional.size());
+		params.m_numPointLights = static_cast<uint32_t>(pointLights.size());
+		params.m_sliceScale = m_lightCuller.getSliceScale();
+		params.m_sliceBias = m_lightCuller.getSliceBias();
+		params.m_tileScaleX = ClusteredLightCuller::NUM_X / m_viewportWidth;
+		params.m_tileScaleY = ClusteredLightCuller::NUM_Y / m_viewportHeight;
+		params.m_pad0 = 0.f;
+		params.m_pad1 = 0.f;
+
+		const std::vector<uint32_t>& lightIndices = m_lightCuller.getLightIndices();
+
+		m_context->updateConstantBuffer(m_cbLights, &params, sizeof(params));
+		m_context->updateStorageBuffer(m_sbDirectionalLights, lightBuffer.m_directional.data(), lightBuffer.m_directional.size() * sizeof(GpuDirectionalLight));
+		m_context->updateStorageBuffer(m_sbPointLights, pointLights.data(), pointLights.size() * sizeof(GpuPointLight));
+		m_context->updateStorageBuffer(m_sbClusterRanges, m_lightCuller.getRanges(), ClusteredLightCuller::NUM_CLUSTERS * sizeof(ClusterLightRange));
+		m_context->updateStorageBuffer(m_sbClusterLightIndices, lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+
 		m_context->bindConstantBufferToLocation(m_cbLights, 1);
+		m_context->bindStorageBufferToLocation(m_sbDirectionalLights, 1);
+		m_context->bindStorageBufferToLocation(m_sbPointLights, 2);
+		m_context->bindStorageBufferToLocation(m_sbClusterRanges, 3);
+		m_context->bindStorageBufferToLocation(m_sbClusterLightIndices, 4);
 		m_context->drawLinear(EPrimitive::TriangleStrips, 4, 0);
 	}
 
+	const ClusteredLightStats& DeferredRenderer::getLightClusterStats() const
+	{
+		return m_lightCuller.getStats();
+	}
+
 	void DeferredRenderer::copyFinalColorToBackBuffer()
 	{
 		m_context->unbindTextures();
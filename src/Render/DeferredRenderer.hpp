@@ -2,6 +2,8 @@
 
 #include <Render/RIDefs.hpp>
 #include <Render/RIResourceHandles.hpp>
+#include <Render/CommandBucket.hpp>
+#include <Render/ClusteredLighting.hpp>
 
 #include <Math/Matrix4.hpp>
 #include <Math/Vec3.hpp>
@@ -14,6 +16,7 @@ namespace Phoenix
 
 	struct StaticMesh;
 	struct Material;
+	class Matrix3;
 	
 	class DeferredRenderer
 	{
@@ -24,22 +27,55 @@ namespace Phoenix
 
 		void setProjectionMatrix(const Matrix4& projection);
 
+		const Matrix4& getViewMatrix() const;
+
+		const Matrix4& getProjectionMatrix() const;
+
 		// Sets up the state needed to draw values into the GBuffer. Needs to be called before e.g. first drawStaticMesh() call.
 		void setupGBufferPass();
 
-		// Draws the material values needed for shading from this StaticMesh into the GBuffer.
-		void drawStaticMesh(const StaticMesh& mesh, const Matrix4& transform);
+		// Queues the draws that write the material values needed for shading from this StaticMesh into the GBuffer.
+		void drawStaticMesh(const StaticMesh& mesh, const Matrix4& transform, uint8_t lod);
+
+		// Projected diameter in pixels of a world space sphere with the current view and projection.
+		float getScreenSize(const Vec3& center, float radius) const;
+
+		float getViewportHeight() const;
+
+		// Sorts the draws queued since setupGBufferPass() front-to-back, grouped by program and material, and submits them.
+		void runGBufferPass();
 
 		void setupDirectLightingPass();
 
+		// Assigns the point lights to the clusters of the view frustum, uploads the lights and their
+		// cluster lists and shades every pixel with the lights of its cluster.
 		void runLightsPass(const LightBuffer& lightBuffer);
 
+		const ClusteredLightStats& getLightClusterStats() const;
+
 		// Applies gamma correction and simple tonemapping to the final color values and copies them into the default framebuffer. 
 		void copyFinalColorToBackBuffer();
 
 	private:
+		enum ERenderPass
+		{
+			GBufferPass
+		};
+
+		// Draws past MAX_GBUFFER_COMMANDS are dropped. The packets of a draw take a bit over 512 bytes
+		// on 64 bit, the memory holds every draw the bucket can take.
+		enum
+		{
+			MAX_GBUFFER_COMMANDS = 4096,
+			GBUFFER_COMMAND_MEMORY_BYTES = MAX_GBUFFER_COMMANDS * 1024
+		};
+
 		Matrix4 m_viewMat;
 		Matrix4 m_projMat;
+		float m_nearPlane;
+		float m_farPlane;
+		float m_viewportWidth;
+		float m_viewportHeight;
 
 		RenderTargetHandle m_gBuffer;
 		Texture2DHandle m_kDiffuseDepthTex;
@@ -72,16 +108,26 @@ namespace Phoenix
 		} m_uniforms;
 
 		ProgramHandle m_gBufferProgram;
+		ProgramHandle m_gBufferPackedProgram; // For meshes with a packed EVertexFormat.
 		ProgramHandle m_lightsPassProgram;
 		ProgramHandle m_copyToBackBufferProgram;
 
 		ConstantBufferHandle m_cbLights;
+		StorageBufferHandle m_sbDirectionalLights;
+		StorageBufferHandle m_sbPointLights;
+		StorageBufferHandle m_sbClusterRanges;
+		StorageBufferHandle m_sbClusterLightIndices;
+
+		ClusteredLightCuller m_lightCuller;
 
 		BlendState m_lightBlendState;
 
 		IRIDevice* m_device;
 		IRIContext* m_context;
 
-		void drawStaticMeshWithMaterial(VertexBufferHandle vb, const Material& material, uint32_t numVertices, uint32_t vertexFrom);
+		CommandBucket m_gBufferCommands;
+
+		void drawStaticMeshWithMaterial(ProgramHandle program, VertexBufferHandle vb, IndexBufferHandle ib, const Material& material, uint32_t numIndices, uint32_t indexFrom, 
+										const Matrix4& modelViewTf, const Matrix3& normalTf, uint32_t depth);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "FrustumCulling.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <xmmintrin.h>
+
+#include <Math/Matrix4.hpp>
+
+namespace Phoenix
+{
+	void extractFrustumPlanes(const Matrix4& viewProjection, Plane* outPlanes)
+	{
+		const Matrix4& m = viewProjection;
+
+		// A point is inside when -w <= x, y, z <= w in clip space, each bound gives row 3 +- row i.
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int side = 0; side < 2; ++side)
+			{
+				float sign = side == 0 ? 1.f : -1.f;
+
+				Vec3 n(m(3, 0) + sign * m(i, 0), m(3, 1) + sign * m(i, 1), m(3, 2) + sign * m(i, 2));
+				float d = m(3, 3) + sign * m(i, 3);
+
+				// Plane normalizes n on construction, d needs the same scale.
+				outPlanes[i * 2 + side] = Plane(n, d / n.length());
+			}
+		}
+	}
+
+	void transformAabb(const Matrix4& transform, const Vec3& boundsMin, const Vec3& boundsMax, Vec3* outCenter, Vec3* outExtent)
+	{
+		Vec3 center = (boundsMin + boundsMax) * 0.5f;
+		Vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+		// The new extent along an axis is the sum of the absolute projections of the old extents (Arvo).
+		for (int row = 0; row < 3; ++row)
+		{
+			(*outCenter)(row) = transform(row, 0) * center.x + transform(row, 1) * center.y + transform(row, 2) * center.z + transform(row, 3);
+			(*outExtent)(row) = fabsf(transform(row, 0)) * extent.x + fabsf(transform(row, 1)) * extent.y + fabsf(transform(row, 2)) * extent.z;
+		}
+	}
+
+	float getMaxScale(const Matrix4& transform)
+	{
+		float maxLength2 = 0.f;
+
+		for (int col = 0; col < 3; ++col)
+		{
+			Vec3 axis(transform(0, col), transform(1, col), transform(2, col));
+			maxLength2 = std::max(maxLength2, axis.length2());
+		}
+
+		return sqrtf(maxLength2);
+	}
+
+	FrustumCuller::FrustumCuller()
+		: m_numBounds(0)
+	{}
+
+	void FrustumCuller::clear()
+	{
+		m_numBounds = 0;
+	}
+
+	void FrustumCuller::reserve(size_t numBounds)
+	{
+		size_t padded = (numBounds + LANES - 1) / LANES * LANES;
+
+		for (std::vector<float>* stream : { &m_sphereX, &m_sphereY, &m_sphereZ, &m_sphereRadius, &m_boxX, &m_boxY, &m_boxZ, &m_boxExtentX, &m_boxExtentY, &m_boxExtentZ })
+		{
+			stream->reserve(padded);
+		}
+	}
+
+	uint32_t FrustumCuller::addBounds(const Vec3& sphereCenter, float sphereRadius, const Vec3& boxCenter, const Vec3& boxExtent)
+	{
+		size_t index = m_numBounds++;
+
+		// Grow a whole batch at a time, lanes past m_numBounds are masked out by cull().
+		if (index % LANES == 0)
+		{
+			size_t padded = index + LANES;
+
+			for (std::vector<float>* stream : { &m_sphereX, &m_sphereY, &m_sphereZ, &m_sphereRadius, &m_boxX, &m_boxY, &m_boxZ, &m_boxExtentX, &m_boxExtentY, &m_boxExtentZ })
+			{
+				stream->resize(padded, 0.f);
+			}
+		}
+
+		m_sphereX[index] = sphereCenter.x;
+		m_sphereY[index] = sphereCenter.y;
+		m_sphereZ[index] = sphereCenter.z;
+		m_sphereRadius[index] = sphereRadius;
+		m_boxX[index] = boxCenter.x;
+		m_boxY[index] = boxCenter.y;
+		m_boxZ[index] = boxCenter.z;
+		m_boxExtentX[index] = boxExtent.x;
+		m_boxExtentY[index] = boxExtent.y;
+		m_boxExtentZ[index] = boxExtent.z;
+
+		return static_cast<uint32_t>(index);
+	}
+
+	size_t FrustumCuller::getNumBounds() const
+	{
+		return m_numBounds;
+	}
+
+	FrustumCullStats FrustumCuller::cull(const Plane* planes, std::vector<uint32_t>* outVisible) const
+	{
+		outVisible->clear();
+
+		// Broadcast every plane component once, they are shared by all batches.
+		__m128 planeX[NUM_FRUSTUM_PLANES];
+		__m128 planeY[NUM_FRUSTUM_PLANES];
+		__m128 planeZ[NUM_FRUSTUM_PLANES];
+		__m128 planeD[NUM_FRUSTUM_PLANES];
+		__m128 planeAbsX[NUM_FRUSTUM_PLANES];
+		__m128 planeAbsY[NUM_FRUSTUM_PLANES];
+		__m128 planeAbsZ[NUM_FRUSTUM_PLANES];
+
+		for (size_t p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+		{
+			planeX[p] = _mm_set1_ps(planes[p].n.x);
+			planeY[p] = _mm_set1_ps(planes[p].n.y);
+			planeZ[p] = _mm_set1_ps(planes[p].n.z);
+			planeD[p] = _mm_set1_ps(planes[p].d);
+			planeAbsX[p] = _mm_set1_ps(fabsf(planes[p].n.x));
+			planeAbsY[p] = _mm_set1_ps(fabsf(planes[p].n.y));
+			planeAbsZ[p] = _mm_set1_ps(fabsf(planes[p].n.z));
+		}
+
+		for (size_t batch = 0; batch < m_numBounds; batch += LANES)
+		{
+			__m128 sphereX = _mm_loadu_ps(&m_sphereX[batch]);
+			__m128 sphereY = _mm_loadu_ps(&m_sphereY[batch]);
+			__m128 sphereZ = _mm_loadu_ps(&m_sphereZ[batch]);
+			__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&m_sphereRadius[batch]));
+
+			__m128 boxX = _mm_loadu_ps(&m_boxX[batch]);
+			__m128 boxY = _mm_loadu_ps(&m_boxY[batch]);
+			__m128 boxZ = _mm_loadu_ps(&m_boxZ[batch]);
+			__m128 extentX = _mm_loadu_ps(&m_boxExtentX[batch]);
+			__m128 extentY = _mm_loadu_ps(&m_boxExtentY[batch]);
+			__m128 extentZ = _mm_loadu_ps(&m_boxExtentZ[batch]);
+
+			// Lanes that end up set lie completely behind a plane.
+			__m128 outside = _mm_setzero_ps();
+
+			for (size_t p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+			{
+				__m128 sphereDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], sphereX), _mm_mul_ps(planeY[p], sphereY)),
+											   _mm_add_ps(_mm_mul_ps(planeZ[p], sphereZ), planeD[p]));
+
+				__m128 boxDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], boxX), _mm_mul_ps(planeY[p], boxY)),
+											_mm_add_ps(_mm_mul_ps(planeZ[p], boxZ), planeD[p]));
+
+				// Extent of the box along the plane normal.
+				__m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeAbsX[p], extentX), _mm_mul_ps(planeAbsY[p], extentY)),
+											  _mm_mul_ps(planeAbsZ[p], extentZ));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(sphereDist, negRadius));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(boxDist, _mm_sub_ps(_mm_setzero_ps(), boxRadius)));
+			}
+
+			int visibleMask = ~_mm_movemask_ps(outside) & 0xF;
+
+			size_t numLanes = std::min<size_t>(LANES, m_numBounds - batch);
+			visibleMask &= (1 << numLanes) - 1;
+
+			while (visibleMask)
+			{
+				int lane = 0;
+				while (!(visibleMask & (1 << lane)))
+				{
+					lane++;
+				}
+
+				outVisible->push_back(static_cast<uint32_t>(batch + lane));
+				visibleMask &= visibleMask - 1;
+			}
+		}
+
+		FrustumCullStats stats;
+		stats.m_numVisible = outVisible->size();
+		stats.m_numCulled = m_numBounds - stats.m_numVisible;
+		return stats;
+	}
+
+	FrustumCullStats FrustumCuller::cullScalar(const Plane* planes, std::vector<uint32_t>* outVisible) const
+	{
+		outVisible->clear();
+
+		for (size_t i = 0; i < m_numBounds; ++i)
+		{
+			bool bOutside = false;
+
+			for (size_t p = 0; p < NUM_FRUSTUM_PLANES && !bOutside; ++p)
+			{
+				const Plane& plane = planes[p];
+
+				// Summed in the same order as the SSE path, so both agree on bounds that touch a plane.
+				float sphereDist = (plane.n.x * m_sphereX[i] + plane.n.y * m_sphereY[i]) + (plane.n.z * m_sphereZ[i] + plane.d);
+				float boxDist = (plane.n.x * m_boxX[i] + plane.n.y * m_boxY[i]) + (plane.n.z * m_boxZ[i] + plane.d);
+				float boxRadius = fabsf(plane.n.x) * m_boxExtentX[i] + fabsf(plane.n.y) * m_boxExtentY[i] + fabsf(plane.n.z) * m_boxExtentZ[i];
+
+				bOutside = sphereDist < -m_sphereRadius[i] || boxDist < -boxRadius;
+			}
+
+			if (!bOutside)
+			{
+				outVisible->push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		FrustumCullStats stats;
+		stats.m_numVisible = outVisible->size();
+		stats.m_numCulled = m_numBounds - stats.m_numVisible;
+		return stats;
+	}
+}
\ No newline at end of file
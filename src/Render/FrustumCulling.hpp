@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Math/Plane.hpp>
+#include <Math/Vec3.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class Matrix4;
+
+	enum
+	{
+		NUM_FRUSTUM_PLANES = 6
+	};
+
+	// Left, right, bottom, top, near and far plane of a view projection matrix with OpenGL clip space,
+	// normalized and with their normals pointing into the frustum (Gribb and Hartmann). In world space
+	// for projection * view, in view space for just the projection.
+	void extractFrustumPlanes(const Matrix4& viewProjection, Plane* outPlanes);
+
+	// Box around the object space box [boundsMin, boundsMax] after transforming it.
+	void transformAabb(const Matrix4& transform, const Vec3& boundsMin, const Vec3& boundsMax, Vec3* outCenter, Vec3* outExtent);
+
+	// Largest factor the transform scales a length by, for transforming bounding spheres.
+	float getMaxScale(const Matrix4& transform);
+
+	struct FrustumCullStats
+	{
+		FrustumCullStats()
+			: m_numVisible(0)
+			, m_numCulled(0)
+		{}
+
+		size_t m_numVisible;
+		size_t m_numCulled;
+	};
+
+	// Tests world space bounding spheres and boxes against a frustum, four at a time with SSE. 
+	// Bounds are kept as structure of arrays so each lane of a register holds another object.
+	// An object is visible unless its sphere or its box lies completely behind one of the planes.
+	// Rendering culls through AabbTree::queryFrustum(), this flat pass is kept as the baseline the
+	// tree is tested and benchmarked against.
+	class FrustumCuller
+	{
+	public:
+		FrustumCuller();
+
+		void clear();
+
+		void reserve(size_t numBounds);
+
+		// Returns the index cull() reports the bounds as.
+		uint32_t addBounds(const Vec3& sphereCenter, float sphereRadius, const Vec3& boxCenter, const Vec3& boxExtent);
+
+		size_t getNumBounds() const;
+
+		// Writes the indices of the visible bounds to outVisible in ascending order.
+		FrustumCullStats cull(const Plane* planes, std::vector<uint32_t>* outVisible) const;
+
+		// Same result as cull(), one object and plane at a time. Reference for tests and benchmarks.
+		FrustumCullStats cullScalar(const Plane* planes, std::vector<uint32_t>* outVisible) const;
+
+	private:
+		enum
+		{
+			LANES = 4
+		};
+
+		size_t m_numBounds;
+
+		// Padded to a multiple of LANES.
+		std::vector<float> m_sphereX;
+		std::vector<float> m_sphereY;
+		std::vector<float> m_sphereZ;
+		std::vector<float> m_sphereRadius;
+		std::vector<float> m_boxX;
+		std::vector<float> m_boxY;
+		std::vector<float> m_boxZ;
+		std::vector<float> m_boxExtentX;
+		std::vector<float> m_boxExtentY;
+		std::vector<float> m_boxExtentZ;
+	};
+}
\ No newline at end of file
@@ -3,28 +3,36 @@
 #include <Math/Vec3.hpp>
 #include <Math/Vec4.hpp>
 
+#include <stdint.h>
+#include <vector>
+
 namespace Phoenix
 {
+	// Padded to 16 bytes by hand, the padding is uploaded and has to be initialised as well.
 	struct alignas(16) GpuVec3
 	{
 		GpuVec3()
-			: x(0.0f), y(0.0f), z(0.0f) {}
+			: x(0.0f), y(0.0f), z(0.0f), pad(0.0f) {}
 
 		GpuVec3(const Vec3& v)
-			: x(v.x), y(v.y), z(v.z) {}
+			: x(v.x), y(v.y), z(v.z), pad(0.0f) {}
 
 		float x;
 		float y;
 		float z;
+		float pad;
 	};
 
 	struct alignas(16) GpuVec4
 	{
 		GpuVec4()
-			: x(0.0f), y(0.0f), z(0.0f) {}
+			: x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
 
 		GpuVec4(const Vec3& v)
-			: x(v.x), y(v.y), z(v.z) {}
+			: x(v.x), y(v.y), z(v.z), w(0.0f) {}
+
+		GpuVec4(const Vec3& v, float w)
+			: x(v.x), y(v.y), z(v.z), w(w) {}
 
 		float x;
 		float y;
@@ -32,59 +40,60 @@ namespace Phoenix
 		float w;
 	};
 
+	// Layouts match the std430 arrays of the lights pass shader.
+	struct GpuDirectionalLight
+	{
+		GpuVec3 m_directionEye;
+		GpuVec3 m_color;
+	};
+
+	struct GpuPointLight
+	{
+		GpuVec4 m_positionEyeRadius;
+		GpuVec4 m_colorIntensity;
+	};
+
+	// Constant buffer LightDataBuffer of the lights pass (std140), padded to a multiple of 16 bytes.
+	struct GpuLightPassParams
+	{
+		uint32_t m_numDirLights;
+		uint32_t m_numPointLights;
+		float m_sliceScale;
+		float m_sliceBias;
+		float m_tileScaleX; // Clusters per pixel.
+		float m_tileScaleY;
+		float m_pad0;
+		float m_pad1;
+	};
+
+	// Lights of a frame in eye space. There is no limit on their number, point lights are 
+	// assigned to clusters by the renderer so each pixel only shades the ones near it.
 	class LightBuffer
 	{
 	public:
-		enum 
-		{
-			MAX_DIR = 32,
-			MAX_POINT = 64
-		};
-
 		void addDirectional(const Vec3& direction, const Vec3& color)
 		{
-			if (m_dir_numLights >= MAX_DIR)
-			{
-				return;
-			}
-
-			m_dir_directions[m_dir_numLights] = direction;
-			m_dir_colors[m_dir_numLights] = color;			
-			m_dir_numLights++;
+			GpuDirectionalLight light;
+			light.m_directionEye = direction;
+			light.m_color = color;
+			m_directional.push_back(light);
 		}
 
 		void addPointLight(const Vec3& position, float radius, const Vec3& color, float intensity)
 		{
-			if (m_pl_numLights >= MAX_POINT)
-			{
-				return;
-			}
-
-			m_pl_positionRadius[m_pl_numLights] = position;
-			m_pl_positionRadius[m_pl_numLights].w = radius;
-			m_pl_colorsIntensity[m_pl_numLights] = color;
-			m_pl_colorsIntensity[m_pl_numLights].w = intensity;
-			m_pl_numLights++;
+			GpuPointLight light;
+			light.m_positionEyeRadius = GpuVec4(position, radius);
+			light.m_colorIntensity = GpuVec4(color, intensity);
+			m_pointLights.push_back(light);
 		}
 
 		void clear()
 		{
-			memset(m_dir_directions, 0, sizeof(GpuVec3) * MAX_DIR);
-			memset(m_dir_colors, 0, sizeof(GpuVec3) * MAX_DIR);
-
-			memset(m_pl_positionRadius, 0, sizeof(GpuVec4) * MAX_POINT);
-			memset(m_pl_colorsIntensity, 0, sizeof(GpuVec3) * MAX_POINT);
-
-			m_dir_numLights = 0;
-			m_pl_numLights = 0;
+			m_directional.clear();
+			m_pointLights.clear();
 		}
 
-		GpuVec3 m_dir_directions[MAX_DIR];
-		GpuVec3 m_dir_colors[MAX_DIR];
-		uint32_t m_dir_numLights;
-
-		GpuVec4 m_pl_positionRadius[MAX_POINT];
-		GpuVec4 m_pl_colorsIntensity[MAX_POINT];
-		uint32_t m_pl_numLights;
+		std::vector<GpuDirectionalLight> m_directional;
+		std::vector<GpuPointLight> m_pointLights;
 	};
 }
\ No newline at end of file
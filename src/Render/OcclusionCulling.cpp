@@ -0,0 +1,321 @@
+#include "OcclusionCulling.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <emmintrin.h>
+
+#include <Core/WorkerPool.hpp>
+
+namespace Phoenix
+{
+	OcclusionCuller::OcclusionCuller(WorkerPool* pool)
+		: m_depth(WIDTH * HEIGHT, 1.f)
+		, m_pool(pool)
+	{}
+
+	void OcclusionCuller::begin(const Matrix4& viewProjection)
+	{
+		m_viewProjection = viewProjection;
+		m_triangles.clear();
+	}
+
+	void OcclusionCuller::addOccluder(const Vec3* vertices, size_t numVertices, const uint32_t* indices, size_t numIndices, const Matrix4& transform)
+	{
+		Matrix4 toClip = m_viewProjection * transform;
+
+		m_clipVertices.resize(numVertices);
+
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			m_clipVertices[i] = toClip * Vec4(vertices[i], 1.f);
+		}
+
+		for (size_t i = 0; i + 2 < numIndices; i += 3)
+		{
+			const Vec4* v[3] = { &m_clipVertices[indices[i]], &m_clipVertices[indices[i + 1]], &m_clipVertices[indices[i + 2]] };
+
+			// Completely outside one of the side planes.
+			if ((v[0]->x > v[0]->w && v[1]->x > v[1]->w && v[2]->x > v[2]->w)
+				|| (v[0]->x < -v[0]->w && v[1]->x < -v[1]->w && v[2]->x < -v[2]->w)
+				|| (v[0]->y > v[0]->w && v[1]->y > v[1]->w && v[2]->y > v[2]->w)
+				|| (v[0]->y < -v[0]->w && v[1]->y < -v[1]->w && v[2]->y < -v[2]->w))
+			{
+				continue;
+			}
+
+			// Signed distance to the near plane, z >= -w in clip space.
+			float distance[3];
+			int numInside = 0;
+
+			for (int j = 0; j < 3; ++j)
+			{
+				distance[j] = v[j]->z + v[j]->w;
+				numInside += distance[j] >= 0.f ? 1 : 0;
+			}
+
+			if (numInside == 3)
+			{
+				addClippedTriangle(*v[0], *v[1], *v[2]);
+			}
+			else if (numInside > 0)
+			{
+				// Cuts the triangle at the near plane, leaving three or four vertices.
+				Vec4 polygon[4];
+				int numPolygon = 0;
+
+				for (int j = 0; j < 3; ++j)
+				{
+					int next = (j + 1) % 3;
+
+					if (distance[j] >= 0.f)
+					{
+						polygon[numPolygon++] = *v[j];
+					}
+
+					if ((distance[j] >= 0.f) != (distance[next] >= 0.f))
+					{
+						float t = distance[j] / (distance[j] - distance[next]);
+						polygon[numPolygon++] = *v[j] + (*v[next] - *v[j]) * t;
+					}
+				}
+
+				for (int j = 1; j + 1 < numPolygon; ++j)
+				{
+					addClippedTriangle(polygon[0], polygon[j], polygon[j + 1]);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::addClippedTriangle(const Vec4& v0, const Vec4& v1, const Vec4& v2)
+	{
+		const Vec4* clip[3] = { &v0, &v1, &v2 };
+		float x[3];
+		float y[3];
+		float z[3];
+
+		for (int i = 0; i < 3; ++i)
+		{
+			float invW = 1.f / clip[i]->w;
+			x[i] = (clip[i]->x * invW * 0.5f + 0.5f) * WIDTH;
+			y[i] = (0.5f - clip[i]->y * invW * 0.5f) * HEIGHT;
+			z[i] = clip[i]->z * invW;
+		}
+
+		ScreenTriangle tri;
+		tri.m_minX = std::max(0, static_cast<int32_t>(floorf(std::min(x[0], std::min(x[1], x[2])))));
+		tri.m_minY = std::max(0, static_cast<int32_t>(floorf(std::min(y[0], std::min(y[1], y[2])))));
+		tri.m_maxX = std::min(static_cast<int32_t>(WIDTH), static_cast<int32_t>(ceilf(std::max(x[0], std::max(x[1], x[2])))));
+		tri.m_maxY = std::min(static_cast<int32_t>(HEIGHT), static_cast<int32_t>(ceilf(std::max(y[0], std::max(y[1], y[2])))));
+
+		if (tri.m_minX >= tri.m_maxX || tri.m_minY >= tri.m_maxY)
+		{
+			return;
+		}
+
+		// Edge i lies opposite of vertex i.
+		for (int i = 0; i < 3; ++i)
+		{
+			int from = (i + 1) % 3;
+			int to = (i + 2) % 3;
+
+			tri.m_edgeA[i] = y[from] - y[to];
+			tri.m_edgeB[i] = x[to] - x[from];
+			tri.m_edgeC[i] = -(tri.m_edgeA[i] * x[from] + tri.m_edgeB[i] * y[from]);
+		}
+
+		float area = tri.m_edgeA[0] * x[0] + tri.m_edgeB[0] * y[0] + tri.m_edgeC[0];
+
+		if (fabsf(area) < 1e-6f)
+		{
+			return;
+		}
+
+		// Occluders are drawn from both sides, flip the edges of clockwise triangles.
+		float invArea = 1.f / area;
+		float sign = area > 0.f ? 1.f : -1.f;
+
+		tri.m_depthA = (tri.m_edgeA[0] * z[0] + tri.m_edgeA[1] * z[1] + tri.m_edgeA[2] * z[2]) * invArea;
+		tri.m_depthB = (tri.m_edgeB[0] * z[0] + tri.m_edgeB[1] * z[1] + tri.m_edgeB[2] * z[2]) * invArea;
+		tri.m_depthC = (tri.m_edgeC[0] * z[0] + tri.m_edgeC[1] * z[1] + tri.m_edgeC[2] * z[2]) * invArea;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			tri.m_edgeA[i] *= sign;
+			tri.m_edgeB[i] *= sign;
+			tri.m_edgeC[i] *= sign;
+		}
+
+		m_triangles.push_back(tri);
+	}
+
+	void OcclusionCuller::rasterize()
+	{
+		auto rasterizeTiles = [this](size_t begin, size_t end)
+		{
+			for (size_t tile = begin; tile < end; ++tile)
+			{
+				rasterizeTile(static_cast<uint32_t>(tile));
+			}
+		};
+
+		// Tiles write to separate parts of the buffer, one job each.
+		if (m_pool)
+		{
+			m_pool->parallelFor(NUM_TILES_X * NUM_TILES_Y, 1, rasterizeTiles);
+		}
+		else
+		{
+			rasterizeTiles(0, NUM_TILES_X * NUM_TILES_Y);
+		}
+	}
+
+	void OcclusionCuller::rasterizeTile(uint32_t tile)
+	{
+		const int32_t tileMinX = (tile % NUM_TILES_X) * TILE_WIDTH;
+		const int32_t tileMinY = (tile / NUM_TILES_X) * TILE_HEIGHT;
+		const int32_t tileMaxX = tileMinX + TILE_WIDTH;
+		const int32_t tileMaxY = tileMinY + TILE_HEIGHT;
+
+		for (int32_t y = tileMinY; y < tileMaxY; ++y)
+		{
+			std::fill(&m_depth[y * WIDTH + tileMinX], &m_depth[y * WIDTH + tileMaxX], 1.f);
+		}
+
+		const __m128 pixelCenterOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (const ScreenTriangle& tri : m_triangles)
+		{
+			int32_t minX = std::max(tri.m_minX, tileMinX);
+			int32_t maxX = std::min(tri.m_maxX, tileMaxX);
+			int32_t minY = std::max(tri.m_minY, tileMinY);
+			int32_t maxY = std::min(tri.m_maxY, tileMaxY);
+
+			if (minX >= maxX || minY >= maxY)
+			{
+				continue;
+			}
+
+			// Tiles start at multiples of four, so aligning down stays inside the tile.
+			minX &= ~3;
+
+			__m128 edgeA0 = _mm_set1_ps(tri.m_edgeA[0]);
+			__m128 edgeA1 = _mm_set1_ps(tri.m_edgeA[1]);
+			__m128 edgeA2 = _mm_set1_ps(tri.m_edgeA[2]);
+			__m128 depthA = _mm_set1_ps(tri.m_depthA);
+
+			for (int32_t y = minY; y < maxY; ++y)
+			{
+				float centerY = y + 0.5f;
+
+				__m128 row0 = _mm_set1_ps(tri.m_edgeB[0] * centerY + tri.m_edgeC[0]);
+				__m128 row1 = _mm_set1_ps(tri.m_edgeB[1] * centerY + tri.m_edgeC[1]);
+				__m128 row2 = _mm_set1_ps(tri.m_edgeB[2] * centerY + tri.m_edgeC[2]);
+				__m128 rowDepth = _mm_set1_ps(tri.m_depthB * centerY + tri.m_depthC);
+
+				float* depthRow = &m_depth[y * WIDTH];
+
+				for (int32_t x = minX; x < maxX; x += 4)
+				{
+					__m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelCenterOffsets);
+
+					__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, centerX), row0), zero);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, centerX), row1), zero));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, centerX), row2), zero));
+
+					if (_mm_movemask_ps(inside) == 0)
+					{
+						continue;
+					}
+
+					__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, centerX), rowDepth);
+					__m128 current = _mm_loadu_ps(depthRow + x);
+					__m128 closest = _mm_min_ps(current, depth);
+
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, current)));
+				}
+			}
+		}
+	}
+
+	bool OcclusionCuller::isVisible(const Vec3& boxMin, const Vec3& boxMax) const
+	{
+		float minX = static_cast<float>(WIDTH);
+		float minY = static_cast<float>(HEIGHT);
+		float maxX = 0.f;
+		float maxY = 0.f;
+		float minZ = 1.f;
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			Vec4 position((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z, 1.f);
+			Vec4 clip = m_viewProjection * position;
+
+			if (clip.w <= 0.f || clip.z < -clip.w)
+			{
+				return true;
+			}
+
+			float invW = 1.f / clip.w;
+			float x = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+			float y = (0.5f - clip.y * invW * 0.5f) * HEIGHT;
+
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minZ = std::min(minZ, clip.z * invW);
+		}
+
+		// Every pixel the box touches.
+		int32_t x0 = std::max(0, static_cast<int32_t>(floorf(minX)));
+		int32_t y0 = std::max(0, static_cast<int32_t>(floorf(minY)));
+		int32_t x1 = std::min(static_cast<int32_t>(WIDTH), static_cast<int32_t>(ceilf(maxX)));
+		int32_t y1 = std::min(static_cast<int32_t>(HEIGHT), static_cast<int32_t>(ceilf(maxY)));
+
+		// Off screen, left to the frustum culling.
+		if (x0 >= x1 || y0 >= y1)
+		{
+			return true;
+		}
+
+		const __m128 laneOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+		__m128 rectMinX = _mm_set1_ps(static_cast<float>(x0));
+		__m128 rectMaxX = _mm_set1_ps(static_cast<float>(x1));
+		__m128 boxDepth = _mm_set1_ps(minZ);
+
+		for (int32_t y = y0; y < y1; ++y)
+		{
+			const float* depthRow = &m_depth[y * WIDTH];
+
+			for (int32_t x = x0 & ~3; x < x1; x += 4)
+			{
+				__m128 laneX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+				__m128 inRect = _mm_and_ps(_mm_cmpge_ps(laneX, rectMinX), _mm_cmplt_ps(laneX, rectMaxX));
+
+				// Visible where no occluder is in front of the nearest point of the box.
+				__m128 notOccluded = _mm_and_ps(inRect, _mm_cmpge_ps(_mm_loadu_ps(depthRow + x), boxDepth));
+
+				if (_mm_movemask_ps(notOccluded) != 0)
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	size_t OcclusionCuller::getNumTriangles() const
+	{
+		return m_triangles.size();
+	}
+
+	float OcclusionCuller::getDepth(uint32_t x, uint32_t y) const
+	{
+		assert(x < WIDTH && y < HEIGHT);
+		return m_depth[y * WIDTH + x];
+	}
+}
\ No newline at end of file
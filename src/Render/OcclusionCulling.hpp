@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Math/Matrix4.hpp>
+#include <Math/Vec3.hpp>
+#include <Math/Vec4.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Phoenix
+{
+	class WorkerPool;
+
+	struct OcclusionCullStats
+	{
+		OcclusionCullStats()
+			: m_numOccluders(0)
+			, m_numOccluderTriangles(0)
+			, m_numTested(0)
+			, m_numOccluded(0)
+			, m_rasterMs(0.f)
+			, m_testMs(0.f)
+		{}
+
+		size_t m_numOccluders;
+		size_t m_numOccluderTriangles;
+		size_t m_numTested;
+		size_t m_numOccluded;
+		float m_rasterMs;
+		float m_testMs;
+	};
+
+	// Rasterizes occluder triangles into a small depth buffer on the CPU and tests boxes against it.
+	// The buffer is split into tiles that are rasterized as jobs of a worker pool, four pixels at a
+	// time with SSE.
+	// Depth is the OpenGL NDC depth, rows go from the top of the screen to the bottom.
+	class OcclusionCuller
+	{
+	public:
+		enum
+		{
+			WIDTH = 256,
+			HEIGHT = 128,
+			TILE_WIDTH = 64,
+			TILE_HEIGHT = 32,
+			NUM_TILES_X = WIDTH / TILE_WIDTH,
+			NUM_TILES_Y = HEIGHT / TILE_HEIGHT
+		};
+
+		// Rasterizes the tiles on the pool, on the calling thread without one.
+		explicit OcclusionCuller(WorkerPool* pool = nullptr);
+
+		// Removes the occluders of the last frame.
+		void begin(const Matrix4& viewProjection);
+
+		// Transforms the triangles into screen space and clips them at the near plane.
+		void addOccluder(const Vec3* vertices, size_t numVertices, const uint32_t* indices, size_t numIndices, const Matrix4& transform);
+
+		// Clears the depth buffer and rasterizes the occluders added since begin().
+		void rasterize();
+
+		// False if the world space box is completely behind the rasterized occluders. Boxes
+		// crossing the near plane are always visible.
+		bool isVisible(const Vec3& boxMin, const Vec3& boxMax) const;
+
+		size_t getNumTriangles() const;
+
+		// Depth of a pixel after rasterize(), 1 where no occluder was drawn.
+		float getDepth(uint32_t x, uint32_t y) const;
+
+	private:
+		// Edge functions a * x + b * y + c are positive inside, depth is interpolated as a plane.
+		struct ScreenTriangle
+		{
+			float m_edgeA[3];
+			float m_edgeB[3];
+			float m_edgeC[3];
+			float m_depthA;
+			float m_depthB;
+			float m_depthC;
+			int32_t m_minX;
+			int32_t m_minY;
+			int32_t m_maxX; // Exclusive.
+			int32_t m_maxY;
+		};
+
+		// Takes clip space vertices in front of the near plane.
+		void addClippedTriangle(const Vec4& v0, const Vec4& v1, const Vec4& v2);
+		void rasterizeTile(uint32_t tile);
+
+		Matrix4 m_viewProjection;
+		std::vector<Vec4> m_clipVertices;
+		std::vector<ScreenTriangle> m_triangles;
+		std::vector<float> m_depth;
+		WorkerPool* m_pool;
+	};
+}
\ No newline at end of file
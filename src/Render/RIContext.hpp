@@ -56,6 +56,11 @@ namespace Phoenix
 		virtual void bindConstantBufferToLocation(ConstantBufferHandle cbHandle, uint32_t location) = 0;
 
 		virtual void updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes = 0) = 0;
+
+		virtual void bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location) = 0;
+
+		// Replaces the whole contents, the buffer takes the size of the new data.
+		virtual void updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes) = 0;
 	};
 }
 
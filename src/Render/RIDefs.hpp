@@ -47,6 +47,9 @@ namespace Phoenix
 		Float,
 		Uint,
 		Int,
+		Short,
+		Ushort,
+		HalfFloat,
 		Count
 	};
 
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Core/StaticSerialize.hpp>
+#include <Render/RIDefs.hpp>
+
+// Fields of the RI types that are stored in asset files, kept out of RIDefs.hpp so only code
+// that serializes them depends on the serialization headers.
+namespace Phoenix
+{
+	template<>
+	struct SerializeFields<TextureDesc>
+	{
+		static const bool value = true;
+
+		template<class Ar>
+		static void serializeFields(Ar& ar, TextureDesc& desc)
+		{
+			serializeValues(ar, desc.width, desc.height, desc.pixelFormat, desc.minFilter, desc.magFilter, desc.mipFilter,
+				desc.wrapU, desc.wrapV, desc.wrapW, desc.numMips);
+		}
+	};
+}
\ No newline at end of file
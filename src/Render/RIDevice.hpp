@@ -33,5 +33,7 @@ namespace Phoenix
 		virtual UniformHandle		 createUniform(const char* name, EUniformType type, EUniformIsArray isArray = EUniformIsArray::False) = 0;
 
 		virtual ConstantBufferHandle createConstantBuffer(const char* name, size_t bufferSizeBytes) = 0;
+
+		virtual StorageBufferHandle	 createStorageBuffer(const char* name, size_t bufferSizeBytes) = 0;
 	};
 }
@@ -0,0 +1,337 @@
+#include "GlStateFilter.hpp"
+
+#include <assert.h>
+#include <string.h>
+
+namespace Phoenix
+{
+	uint32_t GlStateFilterStats::getTotalIssued() const
+	{
+		uint32_t total = 0;
+
+		for (uint32_t issued : m_issued)
+		{
+			total += issued;
+		}
+
+		return total;
+	}
+
+	uint32_t GlStateFilterStats::getTotalSkipped() const
+	{
+		uint32_t total = 0;
+
+		for (uint32_t skipped : m_skipped)
+		{
+			total += skipped;
+		}
+
+		return total;
+	}
+
+	uint32_t GlStateFilterStats::getNumBindCalls() const
+	{
+		uint32_t total = 0;
+
+		for (size_t i = 0; i < static_cast<size_t>(EGlStateCall::NumBindCalls); ++i)
+		{
+			total += m_issued[i] + m_skipped[i];
+		}
+
+		return total;
+	}
+
+	GlStateFilter::GlStateFilter()
+		: m_program(UNKNOWN)
+		, m_activeTextures(0)
+		, m_depthTest(UINT8_MAX)
+		, m_depthWrite(UINT8_MAX)
+		, m_bBlendKnown(false)
+	{
+		for (size_t i = 0; i < MAX_ACTIVE_CONSTANT_BUFFERS; ++i)
+		{
+			m_cbBindings[i] = UNKNOWN;
+		}
+
+		for (size_t i = 0; i < MAX_ACTIVE_STORAGE_BUFFERS; ++i)
+		{
+			m_sbBindings[i] = UNKNOWN;
+		}
+
+		for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
+		{
+			m_samplerLocations[i] = -1;
+		}
+
+		invalidate();
+		resetStats();
+	}
+
+	bool GlStateFilter::bindProgram(uint32_t program)
+	{
+		bool bChanged = m_program != program;
+		countCall(EGlStateCall::Program, bChanged);
+
+		if (!bChanged)
+		{
+			return false;
+		}
+
+		m_program = program;
+
+		// Sampler values are program state, the new program may have any units assigned.
+		for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
+		{
+			m_samplerLocations[i] = -1;
+		}
+
+		return true;
+	}
+
+	void GlStateFilter::bindUniform()
+	{
+		countCall(EGlStateCall::Uniform, true);
+	}
+
+	bool GlStateFilter::bindVertexBuffer(uint32_t vertexArray)
+	{
+		bool bChanged = changeVertexArray(vertexArray);
+		countCall(EGlStateCall::VertexBuffer, bChanged);
+		return bChanged;
+	}
+
+	bool GlStateFilter::bindIndexBuffer(uint32_t indexBuffer)
+	{
+		bool bChanged = changeIndexBuffer(indexBuffer);
+		countCall(EGlStateCall::IndexBuffer, bChanged);
+		return bChanged;
+	}
+
+	GlStateFilter::TextureChange GlStateFilter::bindTexture(uint32_t textureType, uint32_t texture, int32_t samplerLocation)
+	{
+		assert(m_activeTextures < MAX_TEXTURE_UNITS);
+
+		TextureChange change;
+		change.unit = m_activeTextures;
+		change.bTexture = changeTexture(change.unit, textureType, texture);
+		change.bSampler = m_samplerLocations[change.unit] != samplerLocation;
+
+		if (change.bSampler)
+		{
+			// The location no longer points to any unit it was set to before.
+			for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
+			{
+				if (m_samplerLocations[i] == samplerLocation)
+				{
+					m_samplerLocations[i] = -1;
+				}
+			}
+
+			m_samplerLocations[change.unit] = samplerLocation;
+		}
+
+		countCall(EGlStateCall::Texture, change.bTexture || change.bSampler);
+		m_activeTextures++;
+
+		return change;
+	}
+
+	void GlStateFilter::skipTexture()
+	{
+		countCall(EGlStateCall::Texture, false);
+	}
+
+	bool GlStateFilter::bindRenderTarget(uint32_t framebuffer)
+	{
+		bool bChanged = changeFramebuffer(framebuffer);
+		countCall(EGlStateCall::RenderTarget, bChanged);
+		return bChanged;
+	}
+
+	bool GlStateFilter::bindConstantBuffer(uint32_t location, uint32_t buffer)
+	{
+		assert(location < MAX_ACTIVE_CONSTANT_BUFFERS);
+
+		bool bChanged = m_cbBindings[location] != buffer;
+		countCall(EGlStateCall::ConstantBuffer, bChanged);
+		m_cbBindings[location] = buffer;
+
+		return bChanged;
+	}
+
+	bool GlStateFilter::bindStorageBuffer(uint32_t location, uint32_t buffer)
+	{
+		assert(location < MAX_ACTIVE_STORAGE_BUFFERS);
+
+		bool bChanged = m_sbBindings[location] != buffer;
+		countCall(EGlStateCall::StorageBuffer, bChanged);
+		m_sbBindings[location] = buffer;
+
+		return bChanged;
+	}
+
+	bool GlStateFilter::setDepthTest(EDepth state)
+	{
+		uint8_t value = static_cast<uint8_t>(state);
+
+		bool bChanged = m_depthTest != value;
+		countCall(EGlStateCall::DepthTest, bChanged);
+		m_depthTest = value;
+
+		return bChanged;
+	}
+
+	bool GlStateFilter::setDepthWrite(EDepth state)
+	{
+		uint8_t value = static_cast<uint8_t>(state);
+
+		bool bChanged = m_depthWrite != value;
+		countCall(EGlStateCall::DepthWrite, bChanged);
+		m_depthWrite = value;
+
+		return bChanged;
+	}
+
+	bool isSameBlendState(const BlendState& a, const BlendState& b)
+	{
+		if (a.m_enabeld != b.m_enabeld)
+		{
+			return false;
+		}
+
+		if (EBlend::Disable == a.m_enabeld)
+		{
+			return true;
+		}
+
+		return a.m_blendOpRGB == b.m_blendOpRGB
+			&& a.m_blendOpA == b.m_blendOpA
+			&& a.m_factorSrcRGB == b.m_factorSrcRGB
+			&& a.m_factorSrcA == b.m_factorSrcA
+			&& a.m_factorDstRGB == b.m_factorDstRGB
+			&& a.m_factorDstA == b.m_factorDstA;
+	}
+
+	bool GlStateFilter::setBlendState(const BlendState& state)
+	{
+		bool bChanged = !m_bBlendKnown || !isSameBlendState(m_blend, state);
+		countCall(EGlStateCall::Blend, bChanged);
+
+		m_blend = state;
+		m_bBlendKnown = true;
+
+		return bChanged;
+	}
+
+	bool GlStateFilter::changeVertexArray(uint32_t vertexArray)
+	{
+		if (m_vertexArray == vertexArray)
+		{
+			return false;
+		}
+
+		m_vertexArray = vertexArray;
+
+		// The element array binding is part of the vertex array object.
+		m_indexBuffer = UNKNOWN;
+		return true;
+	}
+
+	bool GlStateFilter::changeIndexBuffer(uint32_t indexBuffer)
+	{
+		if (m_indexBuffer == indexBuffer)
+		{
+			return false;
+		}
+
+		m_indexBuffer = indexBuffer;
+		return true;
+	}
+
+	bool GlStateFilter::changeFramebuffer(uint32_t framebuffer)
+	{
+		if (m_framebuffer == framebuffer)
+		{
+			return false;
+		}
+
+		m_framebuffer = framebuffer;
+		return true;
+	}
+
+	bool GlStateFilter::changeTexture(uint32_t unit, uint32_t textureType, uint32_t texture)
+	{
+		assert(unit < MAX_TEXTURE_UNITS);
+
+		if (isTextureBound(unit, textureType, texture))
+		{
+			return false;
+		}
+
+		m_textures[unit] = texture;
+		m_textureTypes[unit] = textureType;
+		return true;
+	}
+
+	bool GlStateFilter::changeActiveUnit(uint32_t unit)
+	{
+		if (m_activeUnit == unit)
+		{
+			return false;
+		}
+
+		m_activeUnit = unit;
+		return true;
+	}
+
+	bool GlStateFilter::isTextureBound(uint32_t unit, uint32_t textureType, uint32_t texture) const
+	{
+		return m_textures[unit] == texture && m_textureTypes[unit] == textureType;
+	}
+
+	void GlStateFilter::releaseTextureUnits()
+	{
+		m_activeTextures = 0;
+	}
+
+	uint8_t GlStateFilter::getNumActiveTextures() const
+	{
+		return m_activeTextures;
+	}
+
+	void GlStateFilter::invalidate()
+	{
+		m_vertexArray = UNKNOWN;
+		m_indexBuffer = UNKNOWN;
+		m_framebuffer = UNKNOWN;
+		m_activeUnit = UNKNOWN;
+
+		for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
+		{
+			m_textures[i] = UNKNOWN;
+			m_textureTypes[i] = UNKNOWN;
+		}
+	}
+
+	const GlStateFilterStats& GlStateFilter::getStats() const
+	{
+		return m_stats;
+	}
+
+	void GlStateFilter::resetStats()
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	void GlStateFilter::countCall(EGlStateCall call, bool bIssued)
+	{
+		if (bIssued)
+		{
+			m_stats.m_issued[static_cast<size_t>(call)]++;
+		}
+		else
+		{
+			m_stats.m_skipped[static_cast<size_t>(call)]++;
+		}
+	}
+}
\ No newline at end of file
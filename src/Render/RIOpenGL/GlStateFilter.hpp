@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <Render/RIDefs.hpp>
+
+namespace Phoenix
+{
+	// Calls of the RI filtered by the context's shadow state.
+	enum class EGlStateCall
+	{
+		// Bind calls, counted once per call like RIContextRecording counts them.
+		Program,
+		Uniform,
+		VertexBuffer,
+		IndexBuffer,
+		Texture,
+		RenderTarget,
+		ConstantBuffer,
+		StorageBuffer,
+		NumBindCalls,
+
+		// Render state, not a bind to the recording.
+		DepthTest = NumBindCalls,
+		DepthWrite,
+		Blend,
+		NumCalls
+	};
+
+	// Issued counts calls that reached GL, skipped counts calls that would not have changed
+	// the GL state. Binds the context does on its own for draws, clears and uploads are not 
+	// counted, so replaying a recorded frame getNumBindCalls() matches its RIFrameStats::m_numBinds.
+	struct GlStateFilterStats
+	{
+		uint32_t m_issued[static_cast<size_t>(EGlStateCall::NumCalls)];
+		uint32_t m_skipped[static_cast<size_t>(EGlStateCall::NumCalls)];
+
+		uint32_t getTotalIssued() const;
+		uint32_t getTotalSkipped() const;
+		uint32_t getNumBindCalls() const;
+	};
+
+	// Shadow copy of the GL state a context has set, keyed by GL ids. Knows nothing about GL 
+	// itself, the context asks it whether a call would change the state and only then calls GL.
+	// The bind* and set* functions are RI calls and counted, the change* functions are used
+	// by the context for its own binds and are not.
+	class GlStateFilter
+	{
+	public:
+		enum
+		{
+			MAX_ACTIVE_CONSTANT_BUFFERS = 64,
+			MAX_ACTIVE_STORAGE_BUFFERS = 16,
+			MAX_TEXTURE_UNITS = 32,
+			UNKNOWN = 0xFFFFFFFF
+		};
+
+		// What a texture bind has to send to GL.
+		struct TextureChange
+		{
+			uint32_t unit;
+			bool bTexture;
+			bool bSampler;
+		};
+
+		GlStateFilter();
+
+		bool bindProgram(uint32_t program);
+
+		// Uniform values are not shadowed, every bind is issued.
+		void bindUniform();
+
+		bool bindVertexBuffer(uint32_t vertexArray);
+
+		bool bindIndexBuffer(uint32_t indexBuffer);
+
+		// Takes the next texture unit. Issued if either the texture or the sampler value has to change.
+		TextureChange bindTexture(uint32_t textureType, uint32_t texture, int32_t samplerLocation);
+
+		// The sampler is not active in the bound program, nothing reaches GL.
+		void skipTexture();
+
+		bool bindRenderTarget(uint32_t framebuffer);
+
+		bool bindConstantBuffer(uint32_t location, uint32_t buffer);
+
+		bool bindStorageBuffer(uint32_t location, uint32_t buffer);
+
+		bool setDepthTest(EDepth state);
+
+		bool setDepthWrite(EDepth state);
+
+		bool setBlendState(const BlendState& state);
+
+		bool changeVertexArray(uint32_t vertexArray);
+
+		bool changeIndexBuffer(uint32_t indexBuffer);
+
+		bool changeFramebuffer(uint32_t framebuffer);
+
+		bool changeTexture(uint32_t unit, uint32_t textureType, uint32_t texture);
+
+		bool changeActiveUnit(uint32_t unit);
+
+		bool isTextureBound(uint32_t unit, uint32_t textureType, uint32_t texture) const;
+
+		// Textures stay bound until their unit is reused, the units are only handed out again.
+		void releaseTextureUnits();
+
+		uint8_t getNumActiveTextures() const;
+
+		// Forgets the vertex array, index buffer, texture unit and framebuffer bindings.
+		void invalidate();
+
+		const GlStateFilterStats& getStats() const;
+
+		void resetStats();
+
+	private:
+		void countCall(EGlStateCall call, bool bIssued);
+
+		uint32_t m_program;
+		uint32_t m_vertexArray;
+		uint32_t m_indexBuffer;
+		uint32_t m_framebuffer;
+		uint8_t m_activeTextures;
+
+		uint32_t m_cbBindings[MAX_ACTIVE_CONSTANT_BUFFERS];
+		uint32_t m_sbBindings[MAX_ACTIVE_STORAGE_BUFFERS];
+
+		uint32_t m_activeUnit;
+		uint32_t m_textures[MAX_TEXTURE_UNITS];
+		uint32_t m_textureTypes[MAX_TEXTURE_UNITS];
+
+		// Sampler location set to each unit in the bound program.
+		int32_t m_samplerLocations[MAX_TEXTURE_UNITS];
+
+		uint8_t m_depthTest;
+		uint8_t m_depthWrite;
+		bool m_bBlendKnown;
+		BlendState m_blend;
+
+		GlStateFilterStats m_stats;
+	};
+}
\ No newline at end of file
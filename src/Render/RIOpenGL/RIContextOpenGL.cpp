@@ -6,18 +6,29 @@
 #include <Core/Logger.hpp>
 
 #include <assert.h>
+#include <string.h>
 
 namespace Phoenix
 {
 	RIContextOpenGL::RIContextOpenGL(const RIOpenGLResourceStore* resources)
 		: m_resources(resources)
+		, m_program(nullptr)
 		, m_maxTextureUnits(0)
 	{
 		m_maxTextureUnits = getMaxTextureUnits();
 
+		if (m_maxTextureUnits > GlStateFilter::MAX_TEXTURE_UNITS)
+		{
+			m_maxTextureUnits = GlStateFilter::MAX_TEXTURE_UNITS;
+		}
+
 		GLint maxUboBindings = 0;
 		glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxUboBindings);
-		assert(m_boundState.MAX_ACTIVE_CONSTANT_BUFFERS < maxUboBindings);
+		assert(GlStateFilter::MAX_ACTIVE_CONSTANT_BUFFERS < maxUboBindings);
+
+		GLint maxSsboBindings = 0;
+		glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSsboBindings);
+		assert(GlStateFilter::MAX_ACTIVE_STORAGE_BUFFERS <= maxSsboBindings);
 	}
 
 	GLenum toGlPrimitive(EPrimitive primitive)
@@ -52,44 +63,87 @@ namespace Phoenix
 
 	void RIContextOpenGL::drawLinear(VertexBufferHandle vbHandle, EPrimitive primitives, uint32_t count, uint32_t start)
 	{
-		bindVertexBuffer(vbHandle);
+		const GlVertexBuffer* vb = m_resources->m_vertexbuffers.getResource(vbHandle);
+
+		if (m_stateFilter.changeVertexArray(vb->m_id))
+		{
+			glBindVertexArray(vb->m_id);
+		}
+
 		glDrawArrays(toGlPrimitive(primitives), start, count);
 	}
 
 	void RIContextOpenGL::drawIndexed(VertexBufferHandle vbHandle, IndexBufferHandle ibHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex)
 	{
-		bindVertexBuffer(vbHandle);
+		const GlVertexBuffer* vb = m_resources->m_vertexbuffers.getResource(vbHandle);
+
+		if (m_stateFilter.changeVertexArray(vb->m_id))
+		{
+			glBindVertexArray(vb->m_id);
+		}
 
 		const GlIndexBuffer* ib = m_resources->m_indexbuffers.getResource(ibHandle);
-		bindIndexBuffer(ibHandle);
+
+		if (m_stateFilter.changeIndexBuffer(ib->m_id))
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->m_id);
+		}
 
 		if (0 == count)
 		{
 			count = static_cast<uint32_t>(ib->m_numElements);
 		}
 
-		glDrawElements(toGlPrimitive(primitives), count, GL_UNSIGNED_INT, (GLvoid*)(sizeof(GLubyte) * startIndex));
+		GLenum indexType = ib->m_elementSizeBytes == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		size_t offsetBytes = ib->m_elementSizeBytes * startIndex;
+
+		glDrawElements(toGlPrimitive(primitives), count, indexType, reinterpret_cast<const GLvoid*>(offsetBytes));
+	}
+
+	void RIContextOpenGL::invalidateBoundState()
+	{
+		m_stateFilter.invalidate();
+	}
+
+	const GlStateFilterStats& RIContextOpenGL::getStateFilterStats() const
+	{
+		return m_stateFilter.getStats();
+	}
+
+	void RIContextOpenGL::resetStateFilterStats()
+	{
+		m_stateFilter.resetStats();
 	}
 
 	void RIContextOpenGL::bindShaderProgram(ProgramHandle programHandle)
 	{
 		const GlProgram* program = m_resources->m_programs.getResource(programHandle);
-		m_boundState.program = program;
-		glUseProgram(program->m_id);
+		m_program = program;
+
+		if (m_stateFilter.bindProgram(program->m_id))
+		{
+			glUseProgram(program->m_id);
+		}
 	}
 
 	void RIContextOpenGL::bindVertexBuffer(VertexBufferHandle vbHandle)
 	{
 		const GlVertexBuffer* vb = m_resources->m_vertexbuffers.getResource(vbHandle);
-		m_boundState.vertexbuffer = vb;
-		glBindVertexArray(vb->m_id);
+
+		if (m_stateFilter.bindVertexBuffer(vb->m_id))
+		{
+			glBindVertexArray(vb->m_id);
+		}
 	}
 
 	void RIContextOpenGL::bindIndexBuffer(IndexBufferHandle ibHandle)
 	{
 		const GlIndexBuffer* ib = m_resources->m_indexbuffers.getResource(ibHandle);
-		m_boundState.indexbuffer = ib;
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->m_id);
+
+		if (m_stateFilter.bindIndexBuffer(ib->m_id))
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->m_id);
+		}
 	}
 
 	void setUniform(const GlUniform& uniform, const void* data, EUniformType type)
@@ -152,9 +206,11 @@ namespace Phoenix
 	void RIContextOpenGL::bindUniform(UniformHandle uniformHandle, const void* data)
 	{
 		const RIUniform* uniform = m_resources->m_uniforms.getResource(uniformHandle);
-		const GlProgram* program = m_boundState.program;
+		const GlProgram* program = m_program;
 		assert(nullptr != program);
 
+		m_stateFilter.bindUniform();
+
 		GlUniform glUniform;
 		bool bIsActive = program->m_activeUniforms.getUniformIfExisting(uniform->m_nameHash, program->m_id, glUniform);
 
@@ -196,7 +252,7 @@ namespace Phoenix
 
 	void RIContextOpenGL::bindTextureBase(UniformHandle samplerHandle, const TextureBind& binding)
 	{
-		const GlProgram* program = m_boundState.program;
+		const GlProgram* program = m_program;
 		assert(nullptr != program);
 
 		const RIUniform* uniform = m_resources->m_uniforms.getResource(samplerHandle);
@@ -206,23 +262,51 @@ namespace Phoenix
 
 		if (!bIsActive)
 		{
+			m_stateFilter.skipTexture();
 			Logger::errorf("Texture %s does not have an equivalent sampler in currently bound program", uniform->m_debugName);
 			return;
 		}
 
 		assert(glUniform.m_glType == getSamplerType(binding.texturetype));
-		assert(m_boundState.activeTextures < m_maxTextureUnits);
+		assert(m_stateFilter.getNumActiveTextures() < m_maxTextureUnits);
 
-		glActiveTexture(GL_TEXTURE0 + m_boundState.activeTextures);
-		glBindTexture(binding.texturetype, binding.texID);
-		
-		glUniform1iv(glUniform.m_location, glUniform.m_numElements, reinterpret_cast<const GLint*>(&m_boundState.activeTextures));
-	
-		m_boundState.activeTextures++;
+		GLint location = static_cast<GLint>(glUniform.m_location);
+		GlStateFilter::TextureChange change = m_stateFilter.bindTexture(binding.texturetype, binding.texID, location);
+
+		if (change.bTexture)
+		{
+			applyTexture(change.unit, binding.texturetype, binding.texID);
+		}
+
+		if (change.bSampler)
+		{
+			GLint unitValue = static_cast<GLint>(change.unit);
+			glUniform1iv(glUniform.m_location, glUniform.m_numElements, &unitValue);
+		}
 
 		assert(!checkGlErrorOccured());
 	}
 
+	void RIContextOpenGL::bindTextureToUnit(uint32_t unit, uint32_t textureType, uint32_t texID)
+	{
+		if (m_stateFilter.changeTexture(unit, textureType, texID))
+		{
+			applyTexture(unit, textureType, texID);
+		}
+	}
+
+	void RIContextOpenGL::applyTexture(uint32_t unit, uint32_t textureType, uint32_t texID)
+	{
+		if (m_stateFilter.changeActiveUnit(unit))
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+		}
+
+		// NOTE(Phil): A unit can hold one texture per target, binding a texture of a different
+		// type leaves the old one bound to its target. It is not sampled by the new binding though.
+		glBindTexture(textureType, texID);
+	}
+
 	void RIContextOpenGL::bindTexture(UniformHandle samplerHandle, Texture2DHandle texHandle)
 	{
 		const GlTexture2D* texture = m_resources->m_texture2Ds.getResource(texHandle);
@@ -237,19 +321,48 @@ namespace Phoenix
 
 	void RIContextOpenGL::unbindTextures()
 	{
-		for (uint8_t activeTexture = 0; activeTexture < m_boundState.activeTextures; ++activeTexture)
+		// Textures stay bound until their unit is reused, so a following draw that binds the
+		// same textures again does not touch GL. applyFramebuffer unbinds textures that 
+		// would otherwise be sampled while being rendered to.
+		m_stateFilter.releaseTextureUnits();
+	}
+
+	void RIContextOpenGL::applyFramebuffer(const GlFramebuffer* framebuffer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer ? framebuffer->m_id : 0);
+
+		if (!framebuffer)
 		{
-			glActiveTexture(GL_TEXTURE0 + activeTexture);
-			glBindTexture(GL_TEXTURE_2D, 0); 
+			return;
 		}
 
-		m_boundState.activeTextures = 0;
+		for (size_t attachment = 0; attachment < RenderTargetDesc::NumAttachments; ++attachment)
+		{
+			const GlTexture2D* texture = framebuffer->m_attachedTextures[attachment];
+
+			if (!texture)
+			{
+				continue;
+			}
+
+			for (uint32_t unit = 0; unit < GlStateFilter::MAX_TEXTURE_UNITS; ++unit)
+			{
+				if (m_stateFilter.isTextureBound(unit, GL_TEXTURE_2D, texture->m_glTex.m_id))
+				{
+					bindTextureToUnit(unit, GL_TEXTURE_2D, 0);
+				}
+			}
+		}
 	}
 
 	void RIContextOpenGL::clearRenderTargetColor(RenderTargetHandle rtHandle, const RGBA& clearColor)
 	{
 		const GlFramebuffer* fb = m_resources->m_framebuffers.getResource(rtHandle);
-		glBindFramebuffer(GL_FRAMEBUFFER, fb->m_id);
+
+		if (m_stateFilter.changeFramebuffer(fb->m_id))
+		{
+			applyFramebuffer(fb);
+		}
 
 		uint8_t attachments = fb->m_colorAttachCount;
 		for (uint8_t i = 0; i < attachments; ++i)
@@ -262,7 +375,12 @@ namespace Phoenix
 	{
 		const GlFramebuffer* fb = m_resources->m_framebuffers.getResource(rtHandle);
 		GLfloat clearValue = 1;
-		glBindFramebuffer(GL_FRAMEBUFFER, fb->m_id);
+
+		if (m_stateFilter.changeFramebuffer(fb->m_id))
+		{
+			applyFramebuffer(fb);
+		}
+
 		glClearBufferfv(GL_DEPTH, 0, &clearValue);
 	}
 
@@ -270,8 +388,7 @@ namespace Phoenix
 	{
 		const GlTexture2D* texture = m_resources->m_texture2Ds.getResource(handle);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture->m_glTex.m_id);
+		bindTextureToUnit(0, GL_TEXTURE_2D, texture->m_glTex.m_id);
 
 		glTexSubImage2D(GL_TEXTURE_2D,
 			0,
@@ -293,8 +410,7 @@ namespace Phoenix
 	{
 		const GlTextureCube* texture = m_resources->m_textureCubes.getResource(handle);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, texture->m_glTex.m_id);
+		bindTextureToUnit(0, GL_TEXTURE_CUBE_MAP, texture->m_glTex.m_id);
 
 		glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<uint32_t>(side),
 			0,
@@ -314,19 +430,26 @@ namespace Phoenix
 
 	void RIContextOpenGL::endPass()
 	{
-		m_boundState.activeTextures = 0;
+		m_stateFilter.releaseTextureUnits();
 		assert(!checkGlErrorOccured());
 	}
 
 	void RIContextOpenGL::bindRenderTarget(RenderTargetHandle handle)
 	{
 		const GlFramebuffer* framebuffer = m_resources->m_framebuffers.getResource(handle);
-		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->m_id);
+
+		if (m_stateFilter.bindRenderTarget(framebuffer->m_id))
+		{
+			applyFramebuffer(framebuffer);
+		}
 	}
 
 	void RIContextOpenGL::bindDefaultRenderTarget()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (m_stateFilter.bindRenderTarget(0))
+		{
+			applyFramebuffer(nullptr);
+		}
 	}
 
 	void RIContextOpenGL::clearColor()
@@ -341,6 +464,11 @@ namespace Phoenix
 
 	void RIContextOpenGL::setDepthTest(EDepth state)
 	{
+		if (!m_stateFilter.setDepthTest(state))
+		{
+			return;
+		}
+
 		if (EDepth::Enable == state)
 		{
 			glEnable(GL_DEPTH_TEST);
@@ -353,6 +481,11 @@ namespace Phoenix
 
 	void RIContextOpenGL::setDepthWrite(EDepth state)
 	{
+		if (!m_stateFilter.setDepthWrite(state))
+		{
+			return;
+		}
+
 		if (EDepth::Enable == state)
 		{
 			glDepthMask(GL_TRUE);
@@ -415,6 +548,11 @@ namespace Phoenix
 
 	void RIContextOpenGL::setBlendState(const BlendState& state)
 	{
+		if (!m_stateFilter.setBlendState(state))
+		{
+			return;
+		}
+
 		if (EBlend::Disable == state.m_enabeld)
 		{
 			glDisable(GL_BLEND);
@@ -436,9 +574,14 @@ namespace Phoenix
 		const GlConstantBuffer* cb = m_resources->m_constantBuffers.getResource(cbHandle);
 
 		GlUniform glUniform;
-		bool bIsActive = m_boundState.program->m_activeUniforms.getUniformIfExisting(cb->m_nameHash, m_boundState.program->m_id, glUniform);
+		bool bIsActive = m_program->m_activeUniforms.getUniformIfExisting(cb->m_nameHash, m_program->m_id, glUniform);
 		assert(cb->m_bufferSizeBytes == glUniform.m_numElements);
-	
+
+		if (!m_stateFilter.bindConstantBuffer(location, cb->m_id))
+		{
+			return;
+		}
+
 		glBindBufferBase(GL_UNIFORM_BUFFER, location, cb->m_id);
 	}
 
@@ -450,4 +593,28 @@ namespace Phoenix
 		glBufferSubData(GL_UNIFORM_BUFFER, offsetBytes, cb->m_bufferSizeBytes, data);
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	}
+
+	void RIContextOpenGL::bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location)
+	{
+		const GlStorageBuffer* sb = m_resources->m_storageBuffers.getResource(sbHandle);
+		assert(nullptr != sb);
+
+		if (!m_stateFilter.bindStorageBuffer(location, sb->m_id))
+		{
+			return;
+		}
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, location, sb->m_id);
+	}
+
+	void RIContextOpenGL::updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes)
+	{
+		const GlStorageBuffer* sb = m_resources->m_storageBuffers.getResource(sbHandle);
+
+		// Respecifying the whole store lets the driver orphan the storage still used by the last frame.
+		// The indexed binding keeps referring to the buffer object, so the filtered bind stays valid.
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, sb->m_id);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, numBytes, data, GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
 }
\ No newline at end of file
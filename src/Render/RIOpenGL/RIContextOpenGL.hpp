@@ -2,6 +2,8 @@
 
 #include <Render/RIContext.hpp>
 
+#include "GlStateFilter.hpp"
+
 namespace Phoenix
 {
 	struct RIOpenGLResourceStore;
@@ -9,6 +11,7 @@ namespace Phoenix
 	class GlVertexBuffer;
 	class GlIndexBuffer;
 	class GlProgram;
+	class GlFramebuffer;
 
 	class RIContextOpenGL : public IRIContext
 	{
@@ -65,23 +68,33 @@ namespace Phoenix
 
 		virtual void updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes = 0) override;
 
+		virtual void bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location) override;
+
+		virtual void updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes) override;
+
+		// Forgets the vertex array, index buffer, texture unit and framebuffer bindings. 
+		// Needs to be called whenever GL state is changed outside of the context, e.g. by the device.
+		void invalidateBoundState();
+
+		const GlStateFilterStats& getStateFilterStats() const;
+
+		void resetStateFilterStats();
+
 	private:
 		void bindTextureBase(UniformHandle samplerHandle, const TextureBind& binding);
 
-		const RIOpenGLResourceStore* m_resources;
+		void bindTextureToUnit(uint32_t unit, uint32_t textureType, uint32_t texID);
 
-		struct BoundState
-		{
-			const GlVertexBuffer* vertexbuffer = nullptr;
-			const GlIndexBuffer* indexbuffer = nullptr ;
-			const GlProgram* program = nullptr;
-			uint8_t activeTextures = 0;
+		void applyTexture(uint32_t unit, uint32_t textureType, uint32_t texID);
 
-			enum { MAX_ACTIVE_CONSTANT_BUFFERS = 64 };
+		void applyFramebuffer(const GlFramebuffer* framebuffer);
+
+		const RIOpenGLResourceStore* m_resources;
 
-			ConstantBufferHandle cbBindings[MAX_ACTIVE_CONSTANT_BUFFERS];
+		const GlProgram* m_program;
 
-		} m_boundState;
+		// Calls that would not change the GL state the context has set are skipped.
+		GlStateFilter m_stateFilter;
 
 		uint32_t m_maxTextureUnits;
 	};
@@ -2,6 +2,7 @@
 
 #include "RIOpenGLResourceStore.hpp"
 #include "RIDeviceOpenGL.hpp"
+#include "RIContextOpenGL.hpp"
 
 #include <Render/RIDefs.hpp>
 #include <Core/Logger.hpp>
@@ -11,8 +12,9 @@
 
 namespace Phoenix
 {
-	RIDeviceOpenGL::RIDeviceOpenGL(RIOpenGLResourceStore* resources)
+	RIDeviceOpenGL::RIDeviceOpenGL(RIOpenGLResourceStore* resources, RIContextOpenGL* context)
 		: m_resources(resources)
+		, m_context(context)
 	{
 	}
 
@@ -42,6 +44,12 @@ namespace Phoenix
 			return GL_UNSIGNED_INT;
 		case EAttributeType::Int:
 			return GL_INT;
+		case EAttributeType::Short:
+			return GL_SHORT;
+		case EAttributeType::Ushort:
+			return GL_UNSIGNED_SHORT;
+		case EAttributeType::HalfFloat:
+			return GL_HALF_FLOAT;
 
 		case EAttributeType::Count:
 		default:
@@ -57,6 +65,7 @@ namespace Phoenix
 
 		glGenVertexArrays(1, &buffer->m_id);
 		glBindVertexArray(buffer->m_id);
+		m_context->invalidateBoundState();
 
 		size_t attribCount = format.size();
 		for (GLuint location = 0; location < attribCount; ++location)
@@ -92,9 +101,13 @@ namespace Phoenix
 		IndexBufferHandle handle = m_resources->m_indexbuffers.allocateResource();
 		GlIndexBuffer* buffer = m_resources->m_indexbuffers.getResource(handle);
 		buffer->m_numElements = count;
+		buffer->m_elementSizeBytes = elementSizeBytes;
+
+		assert(elementSizeBytes == sizeof(uint16_t) || elementSizeBytes == sizeof(uint32_t));
 
 		glGenBuffers(1, &buffer->m_id);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->m_id);
+		m_context->invalidateBoundState();
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementSizeBytes * count, data, GL_STATIC_DRAW); // TODO(Phil): Add dynamic support
 
 		if (checkGlErrorOccured())
@@ -421,7 +434,7 @@ namespace Phoenix
 		}
 	}
 
-	void createTextureBase(RITexture& texture, GlTextureBase& glTex, const TextureDesc& desc, GLenum textureType)
+	void createTextureBase(RITexture& texture, GlTextureBase& glTex, const TextureDesc& desc, GLenum textureType, RIContextOpenGL* context)
 	{
 		glTex.m_components = toGlComponents(desc.pixelFormat);
 		glTex.m_dataType = toGlTexDatatype(desc.pixelFormat);
@@ -432,6 +445,7 @@ namespace Phoenix
 		glGenTextures(1, &glTex.m_id);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(textureType, glTex.m_id);
+		context->invalidateBoundState();
 
 		if (desc.width % 2 == 0)
 		{
@@ -467,7 +481,7 @@ namespace Phoenix
 		Texture2DHandle handle = m_resources->m_texture2Ds.allocateResource();
 		GlTexture2D* texture = m_resources->m_texture2Ds.getResource(handle);
 
-		createTextureBase(*texture, texture->m_glTex, desc, GL_TEXTURE_2D);
+		createTextureBase(*texture, texture->m_glTex, desc, GL_TEXTURE_2D, m_context);
 
 		texture->m_width = desc.width;
 		texture->m_height = desc.height;
@@ -491,7 +505,7 @@ namespace Phoenix
 		TextureCubeHandle handle = m_resources->m_textureCubes.allocateResource();
 		GlTextureCube* texture = m_resources->m_textureCubes.getResource(handle);
 
-		createTextureBase(*texture, texture->m_glTex, desc, GL_TEXTURE_CUBE_MAP);
+		createTextureBase(*texture, texture->m_glTex, desc, GL_TEXTURE_CUBE_MAP, m_context);
 
 		assert(desc.width == desc.height);
 		texture->m_size = desc.width;
@@ -555,6 +569,7 @@ namespace Phoenix
 
 		glGenFramebuffers(1, &framebuffer->m_id);
 		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->m_id);
+		m_context->invalidateBoundState();
 
 		bool bHasColor = attachColors(desc, framebuffer);
 		assert(bHasColor);
@@ -648,4 +663,29 @@ namespace Phoenix
 
 		return handle;
 	}
+
+	StorageBufferHandle RIDeviceOpenGL::createStorageBuffer(const char* name, size_t bufferSizeBytes)
+	{
+		StorageBufferHandle handle = m_resources->m_storageBuffers.allocateResource();
+		GlStorageBuffer* sb = m_resources->m_storageBuffers.getResource(handle);
+
+		glGenBuffers(1, &sb->m_id);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, sb->m_id);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSizeBytes, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		if (checkGlErrorOccured())
+		{
+			Logger::errorf("An error occured during creation of StorageBuffer %s.", name);
+			m_resources->m_storageBuffers.destroyResource(handle);
+			handle.invalidate();
+			return handle;
+		}
+
+		strncpy(sb->m_name, name, RIStorageBuffer::MAX_NAME_LEN);
+		sb->m_name[RIStorageBuffer::MAX_NAME_LEN - 1] = '\0';
+		sb->m_bufferSizeBytes = bufferSizeBytes;
+
+		return handle;
+	}
 }
\ No newline at end of file
@@ -9,11 +9,12 @@ namespace Phoenix
 	class RIWGlDetails;
 	class GlFramebuffer;
 	struct RIOpenGLResourceStore;
+	class RIContextOpenGL;
 	
 	class RIDeviceOpenGL : public IRIDevice
 	{
 	public:
-		RIDeviceOpenGL(RIOpenGLResourceStore* resources);
+		RIDeviceOpenGL(RIOpenGLResourceStore* resources, RIContextOpenGL* context);
 		
 		virtual ~RIDeviceOpenGL();
 
@@ -37,8 +38,11 @@ namespace Phoenix
 
 		virtual ConstantBufferHandle createConstantBuffer(const char* name, size_t bufferSizeBytes) override;
 
+		virtual StorageBufferHandle	 createStorageBuffer(const char* name, size_t bufferSizeBytes) override;
+
 	private:
 		RIOpenGLResourceStore* m_resources;
+		RIContextOpenGL* m_context; // Its bound state is invalidated whenever creation binds GL objects.
 
 		bool RIDeviceOpenGL::attachColors(const RenderTargetDesc& desc, GlFramebuffer* fb);	
 		bool attachifValid(Texture2DHandle tex, GlFramebuffer* fb, RenderTargetDesc::EAttachment attachment);
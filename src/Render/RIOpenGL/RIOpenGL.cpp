@@ -67,8 +67,8 @@ namespace Phoenix
 	public:
 		RIOpenGLImpl()
 			: resources()
-			, device(&resources)
 			, context(&resources)
+			, device(&resources, &context)
 		{
 		}
 
@@ -81,8 +81,8 @@ namespace Phoenix
 		}
 
 		RIOpenGLResourceStore resources;
-		RIDeviceOpenGL device;
 		RIContextOpenGL context;
+		RIDeviceOpenGL device;
 		std::vector<GlRenderWindow*> m_pWindows;
 	};
 
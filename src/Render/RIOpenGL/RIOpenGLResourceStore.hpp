@@ -20,5 +20,6 @@ namespace Phoenix
 		RIResourceContainer<RIUniform,		  UniformHandle,		2048> m_uniforms;
 		RIResourceContainer<GlTextureCube,	  TextureCubeHandle,	256>  m_textureCubes;
 		RIResourceContainer<GlConstantBuffer, ConstantBufferHandle, 1024> m_constantBuffers;
+		RIResourceContainer<GlStorageBuffer,  StorageBufferHandle,  256 > m_storageBuffers;
 	};
 }
\ No newline at end of file
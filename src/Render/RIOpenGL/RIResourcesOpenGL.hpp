@@ -76,7 +76,12 @@ namespace Phoenix
 		GlFramebuffer()
 			: m_id(0)
 			, m_colorAttachCount(0)
-		{}
+		{
+			for (size_t i = 0; i < RenderTargetDesc::NumAttachments; ++i)
+			{
+				m_attachedTextures[i] = nullptr;
+			}
+		}
 
 		const GlTexture2D* m_attachedTextures[RenderTargetDesc::NumAttachments];
 		GLenum m_colorAttachments[RenderTargetDesc::NumMaxColors];
@@ -93,4 +98,14 @@ namespace Phoenix
 	
 		GLuint m_id;
 	};
+
+	class GlStorageBuffer : public RIStorageBuffer
+	{
+	public:
+		GlStorageBuffer()
+			: m_id(0)
+		{}
+	
+		GLuint m_id;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,621 @@
+#include "RICommandLog.hpp"
+
+#include <assert.h>
+#include <string.h>
+
+#include <Core/Logger.hpp>
+#include <Core/SerialUtil.hpp>
+#include <Render/RIContext.hpp>
+
+namespace Phoenix
+{
+	RICommandLog::RICommandLog()
+		: m_bytes()
+		, m_frames()
+		, m_current()
+	{}
+
+	void RICommandLog::beginCommand(ERICommand command)
+	{
+		m_current.m_numCommands++;
+		writeU8(static_cast<uint8_t>(command));
+	}
+
+	void RICommandLog::writeU8(uint8_t value)
+	{
+		m_bytes.push_back(value);
+	}
+
+	void RICommandLog::writeU32(uint32_t value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(value));
+	}
+
+	void RICommandLog::writeF32(float value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(value));
+	}
+
+	void RICommandLog::writeHandle(size_t handleIdx)
+	{
+		writeU32(static_cast<uint32_t>(handleIdx));
+	}
+
+	void RICommandLog::writePayload(const void* data, size_t numBytes)
+	{
+		if (nullptr == data)
+		{
+			numBytes = 0;
+		}
+
+		writeU32(static_cast<uint32_t>(numBytes));
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		m_bytes.insert(m_bytes.end(), bytes, bytes + numBytes);
+	}
+
+	void RICommandLog::endFrame()
+	{
+		m_current.m_numBytes = m_bytes.size() - m_current.m_firstByte;
+		m_frames.push_back(m_current);
+
+		m_current = RIFrameStats();
+		m_current.m_firstByte = m_bytes.size();
+	}
+
+	void RICommandLog::clear()
+	{
+		m_bytes.clear();
+		m_frames.clear();
+		m_current = RIFrameStats();
+	}
+
+	RIFrameStats& RICommandLog::currentFrame()
+	{
+		return m_current;
+	}
+
+	size_t RICommandLog::getNumFrames() const
+	{
+		return m_frames.size();
+	}
+
+	const RIFrameStats& RICommandLog::getFrame(size_t frame) const
+	{
+		assert(frame < m_frames.size());
+		return m_frames[frame];
+	}
+
+	size_t RICommandLog::getNumBytes() const
+	{
+		return m_bytes.size();
+	}
+
+	namespace
+	{
+		// Reads arguments of recorded commands. Running past the end of the range marks the
+		// reader corrupt instead, every read after that returns zeros.
+		struct LogReader
+		{
+			const uint8_t* m_data;
+			size_t m_pos;
+			size_t m_end;
+			bool m_bCorrupt;
+
+			bool hasMore() const
+			{
+				return !m_bCorrupt && m_pos < m_end;
+			}
+
+			bool canRead(size_t numBytes)
+			{
+				if (m_bCorrupt || numBytes > m_end - m_pos)
+				{
+					m_bCorrupt = true;
+					return false;
+				}
+
+				return true;
+			}
+
+			uint8_t readU8()
+			{
+				if (!canRead(sizeof(uint8_t)))
+				{
+					return 0;
+				}
+
+				return m_data[m_pos++];
+			}
+
+			uint32_t readU32()
+			{
+				uint32_t value = 0;
+
+				if (!canRead(sizeof(value)))
+				{
+					return value;
+				}
+
+				memcpy(&value, &m_data[m_pos], sizeof(value));
+				m_pos += sizeof(value);
+				return value;
+			}
+
+			float readF32()
+			{
+				float value = 0.f;
+
+				if (!canRead(sizeof(value)))
+				{
+					return value;
+				}
+
+				memcpy(&value, &m_data[m_pos], sizeof(value));
+				m_pos += sizeof(value);
+				return value;
+			}
+
+			template <class Handle>
+			Handle readHandle()
+			{
+				return Handle(readU32());
+			}
+
+			// Returns a pointer into the log, nullptr for empty payloads.
+			const void* readPayload(uint32_t* outNumBytes = nullptr)
+			{
+				uint32_t numBytes = readU32();
+
+				if (!canRead(numBytes))
+				{
+					numBytes = 0;
+				}
+
+				if (outNumBytes)
+				{
+					*outNumBytes = numBytes;
+				}
+
+				const void* payload = numBytes > 0 ? &m_data[m_pos] : nullptr;
+				m_pos += numBytes;
+				return payload;
+			}
+		};
+
+		// Used to walk a loaded log once before anything is replayed from it.
+		class NullRIContext : public IRIContext
+		{
+		public:
+			virtual void drawLinear(EPrimitive primitives, uint32_t count, uint32_t start) override {}
+
+			virtual void drawLinear(VertexBufferHandle vbHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex = 0) override {}
+
+			virtual void drawIndexed(VertexBufferHandle vbHandle, IndexBufferHandle ibHandle, EPrimitive primitives, uint32_t count = 0, uint32_t startIndex = 0) override {}
+
+			virtual void bindShaderProgram(ProgramHandle programHandle) override {}
+
+			virtual void bindUniform(UniformHandle uniformHandle, const void* data) override {}
+
+			virtual void bindVertexBuffer(VertexBufferHandle vbHandle) override {}
+
+			virtual void bindIndexBuffer(IndexBufferHandle ibHandle) override {}
+
+			virtual void clearRenderTargetColor(RenderTargetHandle rtHandle, const RGBA& clearColor) override {}
+
+			virtual void clearRenderTargetDepth(RenderTargetHandle rtHandle) override {}
+
+			virtual void uploadTextureData(Texture2DHandle handle, const void* data) override {}
+
+			virtual void uploadTextureData(TextureCubeHandle handle, ETextureCubeSide side, const void* data) override {}
+
+			virtual void bindTexture(UniformHandle samplerHandle, Texture2DHandle texHandle) override {}
+
+			virtual void bindTexture(UniformHandle samplerHandle, TextureCubeHandle texHandle) override {}
+
+			virtual void unbindTextures() override {}
+
+			virtual void bindRenderTarget(RenderTargetHandle handle) override {}
+
+			virtual void bindDefaultRenderTarget() override {}
+
+			virtual void setDepthTest(EDepth state) override {}
+
+			virtual void setDepthWrite(EDepth state) override {}
+
+			virtual void setBlendState(const BlendState& state) override {}
+
+			virtual void clearColor() override {}
+
+			virtual void clearDepth() override {}
+
+			virtual void endPass() override {}
+
+			virtual uint32_t getMaxTextureUnits() const override { return 0; }
+
+			virtual void bindConstantBufferToLocation(ConstantBufferHandle cbHandle, uint32_t location) override {}
+
+			virtual void updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes = 0) override {}
+
+			virtual void bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location) override {}
+
+			virtual void updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes) override {}
+		};
+
+		// All arguments are read before the context is called, a command cut off by the end
+		// of the range is not issued. Returns false for such a command or an unknown one.
+		bool replayCommand(LogReader& reader, IRIContext* context)
+		{
+			ERICommand command = static_cast<ERICommand>(reader.readU8());
+
+			switch (command)
+			{
+			case ERICommand::DrawLinear:
+			{
+				EPrimitive primitive = static_cast<EPrimitive>(reader.readU8());
+				uint32_t count = reader.readU32();
+				uint32_t start = reader.readU32();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->drawLinear(primitive, count, start);
+				}
+			} break;
+			case ERICommand::DrawLinearVb:
+			{
+				VertexBufferHandle vb = reader.readHandle<VertexBufferHandle>();
+				EPrimitive primitive = static_cast<EPrimitive>(reader.readU8());
+				uint32_t count = reader.readU32();
+				uint32_t start = reader.readU32();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->drawLinear(vb, primitive, count, start);
+				}
+			} break;
+			case ERICommand::DrawIndexed:
+			{
+				VertexBufferHandle vb = reader.readHandle<VertexBufferHandle>();
+				IndexBufferHandle ib = reader.readHandle<IndexBufferHandle>();
+				EPrimitive primitive = static_cast<EPrimitive>(reader.readU8());
+				uint32_t count = reader.readU32();
+				uint32_t start = reader.readU32();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->drawIndexed(vb, ib, primitive, count, start);
+				}
+			} break;
+			case ERICommand::BindShaderProgram:
+			{
+				ProgramHandle program = reader.readHandle<ProgramHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindShaderProgram(program);
+				}
+			} break;
+			case ERICommand::BindUniform:
+			{
+				UniformHandle uniform = reader.readHandle<UniformHandle>();
+				const void* data = reader.readPayload();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindUniform(uniform, data);
+				}
+			} break;
+			case ERICommand::BindVertexBuffer:
+			{
+				VertexBufferHandle vb = reader.readHandle<VertexBufferHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindVertexBuffer(vb);
+				}
+			} break;
+			case ERICommand::BindIndexBuffer:
+			{
+				IndexBufferHandle ib = reader.readHandle<IndexBufferHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindIndexBuffer(ib);
+				}
+			} break;
+			case ERICommand::ClearRenderTargetColor:
+			{
+				RenderTargetHandle rt = reader.readHandle<RenderTargetHandle>();
+				RGBA color;
+				color.r = reader.readF32();
+				color.g = reader.readF32();
+				color.b = reader.readF32();
+				color.a = reader.readF32();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->clearRenderTargetColor(rt, color);
+				}
+			} break;
+			case ERICommand::ClearRenderTargetDepth:
+			{
+				RenderTargetHandle rt = reader.readHandle<RenderTargetHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->clearRenderTargetDepth(rt);
+				}
+			} break;
+			case ERICommand::UploadTexture2D:
+			{
+				Texture2DHandle texture = reader.readHandle<Texture2DHandle>();
+				const void* data = reader.readPayload();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->uploadTextureData(texture, data);
+				}
+			} break;
+			case ERICommand::UploadTextureCube:
+			{
+				TextureCubeHandle texture = reader.readHandle<TextureCubeHandle>();
+				ETextureCubeSide side = static_cast<ETextureCubeSide>(reader.readU8());
+				const void* data = reader.readPayload();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->uploadTextureData(texture, side, data);
+				}
+			} break;
+			case ERICommand::BindTexture2D:
+			{
+				UniformHandle sampler = reader.readHandle<UniformHandle>();
+				Texture2DHandle texture = reader.readHandle<Texture2DHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindTexture(sampler, texture);
+				}
+			} break;
+			case ERICommand::BindTextureCube:
+			{
+				UniformHandle sampler = reader.readHandle<UniformHandle>();
+				TextureCubeHandle texture = reader.readHandle<TextureCubeHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindTexture(sampler, texture);
+				}
+			} break;
+			case ERICommand::UnbindTextures:
+			{
+				context->unbindTextures();
+			} break;
+			case ERICommand::BindRenderTarget:
+			{
+				RenderTargetHandle rt = reader.readHandle<RenderTargetHandle>();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindRenderTarget(rt);
+				}
+			} break;
+			case ERICommand::BindDefaultRenderTarget:
+			{
+				context->bindDefaultRenderTarget();
+			} break;
+			case ERICommand::SetDepthTest:
+			{
+				EDepth state = static_cast<EDepth>(reader.readU8());
+
+				if (!reader.m_bCorrupt)
+				{
+					context->setDepthTest(state);
+				}
+			} break;
+			case ERICommand::SetDepthWrite:
+			{
+				EDepth state = static_cast<EDepth>(reader.readU8());
+
+				if (!reader.m_bCorrupt)
+				{
+					context->setDepthWrite(state);
+				}
+			} break;
+			case ERICommand::SetBlendState:
+			{
+				BlendState state;
+				state.m_enabeld = static_cast<EBlend>(reader.readU8());
+				state.m_blendOpRGB = static_cast<EBlendOp>(reader.readU8());
+				state.m_blendOpA = static_cast<EBlendOp>(reader.readU8());
+				state.m_factorSrcRGB = static_cast<EBlendFactor>(reader.readU8());
+				state.m_factorSrcA = static_cast<EBlendFactor>(reader.readU8());
+				state.m_factorDstRGB = static_cast<EBlendFactor>(reader.readU8());
+				state.m_factorDstA = static_cast<EBlendFactor>(reader.readU8());
+
+				if (!reader.m_bCorrupt)
+				{
+					context->setBlendState(state);
+				}
+			} break;
+			case ERICommand::ClearColor:
+			{
+				context->clearColor();
+			} break;
+			case ERICommand::ClearDepth:
+			{
+				context->clearDepth();
+			} break;
+			case ERICommand::EndPass:
+			{
+				context->endPass();
+			} break;
+			case ERICommand::BindConstantBufferToLocation:
+			{
+				ConstantBufferHandle cb = reader.readHandle<ConstantBufferHandle>();
+				uint32_t location = reader.readU32();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindConstantBufferToLocation(cb, location);
+				}
+			} break;
+			case ERICommand::UpdateConstantBuffer:
+			{
+				ConstantBufferHandle cb = reader.readHandle<ConstantBufferHandle>();
+				uint32_t offsetBytes = reader.readU32();
+				uint32_t numBytes = 0;
+				const void* data = reader.readPayload(&numBytes);
+
+				if (!reader.m_bCorrupt)
+				{
+					context->updateConstantBuffer(cb, data, numBytes, offsetBytes);
+				}
+			} break;
+			case ERICommand::BindStorageBufferToLocation:
+			{
+				StorageBufferHandle sb = reader.readHandle<StorageBufferHandle>();
+				uint32_t location = reader.readU32();
+
+				if (!reader.m_bCorrupt)
+				{
+					context->bindStorageBufferToLocation(sb, location);
+				}
+			} break;
+			case ERICommand::UpdateStorageBuffer:
+			{
+				StorageBufferHandle sb = reader.readHandle<StorageBufferHandle>();
+				uint32_t numBytes = 0;
+				const void* data = reader.readPayload(&numBytes);
+
+				if (!reader.m_bCorrupt)
+				{
+					context->updateStorageBuffer(sb, data, numBytes);
+				}
+			} break;
+			default:
+			{
+				reader.m_bCorrupt = true;
+			} break;
+			}
+
+			return !reader.m_bCorrupt;
+		}
+
+		size_t replayRange(const RICommandLog& log, size_t firstByte, size_t numBytes, IRIContext* context, bool* outbCorrupt = nullptr)
+		{
+			LogReader reader = { log.m_bytes.data(), firstByte, firstByte + numBytes, false };
+			size_t numCommands = 0;
+
+			if (firstByte > log.m_bytes.size() || numBytes > log.m_bytes.size() - firstByte)
+			{
+				reader.m_bCorrupt = true;
+			}
+
+			while (reader.hasMore())
+			{
+				if (!replayCommand(reader, context))
+				{
+					break;
+				}
+
+				numCommands++;
+			}
+
+			if (reader.m_bCorrupt)
+			{
+				Logger::errorf("Command log is corrupt at byte %zu, replay stopped after %zu commands.", reader.m_pos, numCommands);
+			}
+
+			if (outbCorrupt)
+			{
+				*outbCorrupt = reader.m_bCorrupt;
+			}
+
+			return numCommands;
+		}
+	}
+
+	size_t replayCommandLog(const RICommandLog& log, IRIContext* context)
+	{
+		return replayRange(log, 0, log.m_bytes.size(), context);
+	}
+
+	size_t replayFrame(const RICommandLog& log, size_t frame, IRIContext* context)
+	{
+		const RIFrameStats& stats = log.getFrame(frame);
+		return replayRange(log, static_cast<size_t>(stats.m_firstByte), static_cast<size_t>(stats.m_numBytes), context);
+	}
+
+	static const uint32_t g_commandLogVersion = 1;
+
+	void serialize(Archive* ar, RICommandLog& log)
+	{
+		uint32_t version = g_commandLogVersion;
+		ar->serialize(&version, sizeof(version));
+
+		if (version != g_commandLogVersion)
+		{
+			Logger::errorf("Command log version %u does not match expected version %u.", version, g_commandLogVersion);
+			assert(false);
+			return;
+		}
+
+		serialize(ar, log.m_bytes);
+		serialize(ar, log.m_frames);
+	}
+
+	EArchiveError saveCommandLog(const char* path, RICommandLog& log)
+	{
+		WriteArchive ar;
+		createWriteArchive(log.getNumBytes() + log.getNumFrames() * sizeof(RIFrameStats) + 64, &ar);
+
+		serialize(&ar, log);
+
+		EArchiveError err = writeArchiveToDisk(path, ar);
+		destroyArchive(ar);
+
+		return err;
+	}
+
+	EArchiveError loadCommandLog(const char* path, RICommandLog* outLog)
+	{
+		ReadArchive ar;
+		EArchiveError err = createReadArchive(path, &ar);
+
+		if (err != EArchiveError::NoError)
+		{
+			return err;
+		}
+
+		outLog->clear();
+		serialize(&ar, *outLog);
+		outLog->currentFrame().m_firstByte = outLog->getNumBytes();
+
+		destroyArchive(ar);
+
+		// Every command and frame is checked once here, so replays of the log do not run past its end.
+		NullRIContext nullContext;
+		bool bCorrupt = false;
+		replayRange(*outLog, 0, outLog->getNumBytes(), &nullContext, &bCorrupt);
+
+		for (const RIFrameStats& frame : outLog->m_frames)
+		{
+			if (frame.m_firstByte > outLog->getNumBytes() || frame.m_numBytes > outLog->getNumBytes() - frame.m_firstByte)
+			{
+				bCorrupt = true;
+			}
+		}
+
+		if (bCorrupt)
+		{
+			Logger::errorf("Command log \"%s\" is corrupt.", path);
+			outLog->clear();
+			return EArchiveError::Corrupt;
+		}
+
+		return err;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <Core/Serialize.hpp>
+
+namespace Phoenix
+{
+	class IRIContext;
+
+	enum class ERICommand : uint8_t
+	{
+		DrawLinear,
+		DrawLinearVb,
+		DrawIndexed,
+		BindShaderProgram,
+		BindUniform,
+		BindVertexBuffer,
+		BindIndexBuffer,
+		ClearRenderTargetColor,
+		ClearRenderTargetDepth,
+		UploadTexture2D,
+		UploadTextureCube,
+		BindTexture2D,
+		BindTextureCube,
+		UnbindTextures,
+		BindRenderTarget,
+		BindDefaultRenderTarget,
+		SetDepthTest,
+		SetDepthWrite,
+		SetBlendState,
+		ClearColor,
+		ClearDepth,
+		EndPass,
+		BindConstantBufferToLocation,
+		UpdateConstantBuffer,
+		BindStorageBufferToLocation,
+		UpdateStorageBuffer,
+		NumCommands
+	};
+
+	// Counters for a single recorded frame. m_firstByte and m_numBytes locate the 
+	// frame's commands inside RICommandLog::m_bytes so frames can be replayed on their own.
+	struct RIFrameStats
+	{
+		RIFrameStats()
+			: m_firstByte(0)
+			, m_numBytes(0)
+			, m_numCommands(0)
+			, m_numDraws(0)
+			, m_numBinds(0)
+			, m_uniformBytes(0)
+			, m_constantBufferBytes(0)
+			, m_storageBufferBytes(0)
+			, m_textureUploadBytes(0)
+		{}
+
+		uint64_t m_firstByte;
+		uint64_t m_numBytes;
+		uint32_t m_numCommands;
+		uint32_t m_numDraws;
+		uint32_t m_numBinds;
+		uint64_t m_uniformBytes;
+		uint64_t m_constantBufferBytes;
+		uint64_t m_storageBufferBytes;
+		uint64_t m_textureUploadBytes;
+	};
+
+	// A compact binary stream of IRIContext calls. Every entry is a one byte ERICommand 
+	// followed by its arguments, handles are stored as 32 bit indices and payloads 
+	// (uniform values, constant buffer, storage buffer and texture data) are stored inline with a 32 bit
+	// size prefix.
+	class RICommandLog
+	{
+	public:
+		RICommandLog();
+
+		void beginCommand(ERICommand command);
+
+		void writeU8(uint8_t value);
+
+		void writeU32(uint32_t value);
+
+		void writeF32(float value);
+
+		void writeHandle(size_t handleIdx);
+
+		void writePayload(const void* data, size_t numBytes);
+
+		// Closes the counters of the current frame and starts a new one.
+		void endFrame();
+
+		// Drops all recorded commands and frames.
+		void clear();
+
+		// Counters of the frame currently being recorded.
+		RIFrameStats& currentFrame();
+
+		size_t getNumFrames() const;
+
+		const RIFrameStats& getFrame(size_t frame) const;
+
+		size_t getNumBytes() const;
+
+		std::vector<uint8_t> m_bytes;
+		std::vector<RIFrameStats> m_frames;
+
+	private:
+		RIFrameStats m_current;
+	};
+
+	// Issues every recorded command on context. Handles are passed through unchanged, so
+	// the resources must have been created in the same order on the device backing context.
+	// Returns the number of commands replayed.
+	size_t replayCommandLog(const RICommandLog& log, IRIContext* context);
+
+	// Replays only the commands of a single finished frame.
+	size_t replayFrame(const RICommandLog& log, size_t frame, IRIContext* context);
+
+	void serialize(Archive* ar, RICommandLog& log);
+
+	EArchiveError saveCommandLog(const char* path, RICommandLog& log);
+
+	EArchiveError loadCommandLog(const char* path, RICommandLog* outLog);
+}
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "RIContextRecording.hpp"
+#include "RIRecordingResourceStore.hpp"
+
+#include <assert.h>
+
+#include <Core/Logger.hpp>
+
+namespace Phoenix
+{
+	static size_t getUniformSizeBytes(EUniformType type)
+	{
+		switch (type)
+		{
+		case EUniformType::Int:
+			return sizeof(int32_t);
+		case EUniformType::Float:
+			return sizeof(float);
+		case EUniformType::Vec3:
+			return 3 * sizeof(float);
+		case EUniformType::Vec4:
+			return 4 * sizeof(float);
+		case EUniformType::Mat3:
+			return 9 * sizeof(float);
+		case EUniformType::Mat4:
+			return 16 * sizeof(float);
+		default:
+			Logger::error("Invalid uniform type used to set value");
+			assert(false);
+			return 0;
+		}
+	}
+
+	static size_t getPixelSizeBytes(EPixelFormat format)
+	{
+		switch (format)
+		{
+		case EPixelFormat::R8:
+			return 1;
+		case EPixelFormat::RG8:
+		case EPixelFormat::Depth16I:
+		case EPixelFormat::Stencil8I:
+			return 2;
+		case EPixelFormat::R8G8B8:
+		case EPixelFormat::SRGB8:
+			return 3;
+		case EPixelFormat::R8G8B8A8:
+		case EPixelFormat::SRGBA8:
+		case EPixelFormat::Depth32F:
+			return 4;
+		// Half float formats are uploaded from float data, see toGlTexDatatype.
+		case EPixelFormat::RGB16F:
+		case EPixelFormat::RGB32F:
+			return 3 * sizeof(float);
+		case EPixelFormat::RGBA16F:
+		case EPixelFormat::RGBA32F:
+			return 4 * sizeof(float);
+		default:
+			assert(false);
+			return 0;
+		}
+	}
+
+	RIContextRecording::RIContextRecording(const RIRecordingResourceStore* resources, RICommandLog* log)
+		: m_resources(resources)
+		, m_log(log)
+		, m_bProgramBound(false)
+		, m_activeTextures(0)
+	{
+		assert(nullptr != log);
+		m_log->currentFrame().m_firstByte = m_log->getNumBytes();
+	}
+
+	void RIContextRecording::beginBind(ERICommand command)
+	{
+		m_log->beginCommand(command);
+		m_log->currentFrame().m_numBinds++;
+	}
+
+	void RIContextRecording::drawLinear(EPrimitive primitives, uint32_t count, uint32_t start)
+	{
+		m_log->beginCommand(ERICommand::DrawLinear);
+		m_log->writeU8(static_cast<uint8_t>(primitives));
+		m_log->writeU32(count);
+		m_log->writeU32(start);
+		m_log->currentFrame().m_numDraws++;
+	}
+
+	void RIContextRecording::drawLinear(VertexBufferHandle vbHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex)
+	{
+		assert(nullptr != m_resources->m_vertexbuffers.getResource(vbHandle));
+
+		m_log->beginCommand(ERICommand::DrawLinearVb);
+		m_log->writeHandle(vbHandle.m_idx);
+		m_log->writeU8(static_cast<uint8_t>(primitives));
+		m_log->writeU32(count);
+		m_log->writeU32(startIndex);
+		m_log->currentFrame().m_numDraws++;
+	}
+
+	void RIContextRecording::drawIndexed(VertexBufferHandle vbHandle, IndexBufferHandle ibHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex)
+	{
+		assert(nullptr != m_resources->m_vertexbuffers.getResource(vbHandle));
+		assert(nullptr != m_resources->m_indexbuffers.getResource(ibHandle));
+
+		m_log->beginCommand(ERICommand::DrawIndexed);
+		m_log->writeHandle(vbHandle.m_idx);
+		m_log->writeHandle(ibHandle.m_idx);
+		m_log->writeU8(static_cast<uint8_t>(primitives));
+		m_log->writeU32(count);
+		m_log->writeU32(startIndex);
+		m_log->currentFrame().m_numDraws++;
+	}
+
+	void RIContextRecording::bindShaderProgram(ProgramHandle programHandle)
+	{
+		assert(nullptr != m_resources->m_programs.getResource(programHandle));
+
+		beginBind(ERICommand::BindShaderProgram);
+		m_log->writeHandle(programHandle.m_idx);
+		m_bProgramBound = true;
+	}
+
+	void RIContextRecording::bindUniform(UniformHandle uniformHandle, const void* data)
+	{
+		assert(m_bProgramBound);
+
+		const RIUniform* uniform = m_resources->m_uniforms.getResource(uniformHandle);
+		assert(nullptr != uniform);
+
+		// NOTE(Phil): Array uniforms only record their first element, the element count
+		// is only known to a backend that can query the bound program.
+		size_t numBytes = getUniformSizeBytes(uniform->m_type);
+
+		beginBind(ERICommand::BindUniform);
+		m_log->writeHandle(uniformHandle.m_idx);
+		m_log->writePayload(data, numBytes);
+		m_log->currentFrame().m_uniformBytes += numBytes;
+	}
+
+	void RIContextRecording::bindVertexBuffer(VertexBufferHandle vbHandle)
+	{
+		assert(nullptr != m_resources->m_vertexbuffers.getResource(vbHandle));
+
+		beginBind(ERICommand::BindVertexBuffer);
+		m_log->writeHandle(vbHandle.m_idx);
+	}
+
+	void RIContextRecording::bindIndexBuffer(IndexBufferHandle ibHandle)
+	{
+		assert(nullptr != m_resources->m_indexbuffers.getResource(ibHandle));
+
+		beginBind(ERICommand::BindIndexBuffer);
+		m_log->writeHandle(ibHandle.m_idx);
+	}
+
+	void RIContextRecording::clearRenderTargetColor(RenderTargetHandle rtHandle, const RGBA& clearColor)
+	{
+		assert(nullptr != m_resources->m_framebuffers.getResource(rtHandle));
+
+		m_log->beginCommand(ERICommand::ClearRenderTargetColor);
+		m_log->writeHandle(rtHandle.m_idx);
+		m_log->writeF32(clearColor.r);
+		m_log->writeF32(clearColor.g);
+		m_log->writeF32(clearColor.b);
+		m_log->writeF32(clearColor.a);
+	}
+
+	void RIContextRecording::clearRenderTargetDepth(RenderTargetHandle rtHandle)
+	{
+		assert(nullptr != m_resources->m_framebuffers.getResource(rtHandle));
+
+		m_log->beginCommand(ERICommand::ClearRenderTargetDepth);
+		m_log->writeHandle(rtHandle.m_idx);
+	}
+
+	void RIContextRecording::uploadTextureData(Texture2DHandle handle, const void* data)
+	{
+		const RITexture2D* texture = m_resources->m_texture2Ds.getResource(handle);
+		assert(nullptr != texture);
+
+		size_t numBytes = texture->m_width * texture->m_height * getPixelSizeBytes(texture->m_pixelFormat);
+
+		m_log->beginCommand(ERICommand::UploadTexture2D);
+		m_log->writeHandle(handle.m_idx);
+		m_log->writePayload(data, numBytes);
+		m_log->currentFrame().m_textureUploadBytes += numBytes;
+	}
+
+	void RIContextRecording::uploadTextureData(TextureCubeHandle handle, ETextureCubeSide side, const void* data)
+	{
+		const RITextureCube* texture = m_resources->m_textureCubes.getResource(handle);
+		assert(nullptr != texture);
+
+		size_t numBytes = texture->m_size * texture->m_size * getPixelSizeBytes(texture->m_pixelFormat);
+
+		m_log->beginCommand(ERICommand::UploadTextureCube);
+		m_log->writeHandle(handle.m_idx);
+		m_log->writeU8(static_cast<uint8_t>(side));
+		m_log->writePayload(data, numBytes);
+		m_log->currentFrame().m_textureUploadBytes += numBytes;
+	}
+
+	void RIContextRecording::bindTexture(UniformHandle samplerHandle, Texture2DHandle texHandle)
+	{
+		assert(m_bProgramBound);
+		assert(m_activeTextures < NUM_TEXTURE_UNITS);
+		assert(nullptr != m_resources->m_texture2Ds.getResource(texHandle));
+
+		beginBind(ERICommand::BindTexture2D);
+		m_log->writeHandle(samplerHandle.m_idx);
+		m_log->writeHandle(texHandle.m_idx);
+		m_activeTextures++;
+	}
+
+	void RIContextRecording::bindTexture(UniformHandle samplerHandle, TextureCubeHandle texHandle)
+	{
+		assert(m_bProgramBound);
+		assert(m_activeTextures < NUM_TEXTURE_UNITS);
+		assert(nullptr != m_resources->m_textureCubes.getResource(texHandle));
+
+		beginBind(ERICommand::BindTextureCube);
+		m_log->writeHandle(samplerHandle.m_idx);
+		m_log->writeHandle(texHandle.m_idx);
+		m_activeTextures++;
+	}
+
+	void RIContextRecording::unbindTextures()
+	{
+		m_log->beginCommand(ERICommand::UnbindTextures);
+		m_activeTextures = 0;
+	}
+
+	void RIContextRecording::bindRenderTarget(RenderTargetHandle handle)
+	{
+		assert(nullptr != m_resources->m_framebuffers.getResource(handle));
+
+		beginBind(ERICommand::BindRenderTarget);
+		m_log->writeHandle(handle.m_idx);
+	}
+
+	void RIContextRecording::bindDefaultRenderTarget()
+	{
+		beginBind(ERICommand::BindDefaultRenderTarget);
+	}
+
+	void RIContextRecording::setDepthTest(EDepth state)
+	{
+		m_log->beginCommand(ERICommand::SetDepthTest);
+		m_log->writeU8(static_cast<uint8_t>(state));
+	}
+
+	void RIContextRecording::setDepthWrite(EDepth state)
+	{
+		m_log->beginCommand(ERICommand::SetDepthWrite);
+		m_log->writeU8(static_cast<uint8_t>(state));
+	}
+
+	void RIContextRecording::setBlendState(const BlendState& state)
+	{
+		m_log->beginCommand(ERICommand::SetBlendState);
+		m_log->writeU8(static_cast<uint8_t>(state.m_enabeld));
+		m_log->writeU8(static_cast<uint8_t>(state.m_blendOpRGB));
+		m_log->writeU8(static_cast<uint8_t>(state.m_blendOpA));
+		m_log->writeU8(static_cast<uint8_t>(state.m_factorSrcRGB));
+		m_log->writeU8(static_cast<uint8_t>(state.m_factorSrcA));
+		m_log->writeU8(static_cast<uint8_t>(state.m_factorDstRGB));
+		m_log->writeU8(static_cast<uint8_t>(state.m_factorDstA));
+	}
+
+	void RIContextRecording::clearColor()
+	{
+		m_log->beginCommand(ERICommand::ClearColor);
+	}
+
+	void RIContextRecording::clearDepth()
+	{
+		m_log->beginCommand(ERICommand::ClearDepth);
+	}
+
+	void RIContextRecording::endPass()
+	{
+		m_log->beginCommand(ERICommand::EndPass);
+		m_activeTextures = 0;
+	}
+
+	uint32_t RIContextRecording::getMaxTextureUnits() const
+	{
+		return NUM_TEXTURE_UNITS;
+	}
+
+	void RIContextRecording::bindConstantBufferToLocation(ConstantBufferHandle cbHandle, uint32_t location)
+	{
+		assert(nullptr != m_resources->m_constantBuffers.getResource(cbHandle));
+
+		beginBind(ERICommand::BindConstantBufferToLocation);
+		m_log->writeHandle(cbHandle.m_idx);
+		m_log->writeU32(location);
+	}
+
+	void RIContextRecording::updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes)
+	{
+		const RIConstantBuffer* cb = m_resources->m_constantBuffers.getResource(cbHandle);
+		assert(nullptr != cb);
+		assert(offsetBytes + numBytes <= cb->m_bufferSizeBytes);
+
+		m_log->beginCommand(ERICommand::UpdateConstantBuffer);
+		m_log->writeHandle(cbHandle.m_idx);
+		m_log->writeU32(static_cast<uint32_t>(offsetBytes));
+		m_log->writePayload(data, numBytes);
+		m_log->currentFrame().m_constantBufferBytes += numBytes;
+	}
+
+	void RIContextRecording::bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location)
+	{
+		assert(nullptr != m_resources->m_storageBuffers.getResource(sbHandle));
+
+		beginBind(ERICommand::BindStorageBufferToLocation);
+		m_log->writeHandle(sbHandle.m_idx);
+		m_log->writeU32(location);
+	}
+
+	void RIContextRecording::updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes)
+	{
+		assert(nullptr != m_resources->m_storageBuffers.getResource(sbHandle));
+
+		m_log->beginCommand(ERICommand::UpdateStorageBuffer);
+		m_log->writeHandle(sbHandle.m_idx);
+		m_log->writePayload(data, numBytes);
+		m_log->currentFrame().m_storageBufferBytes += numBytes;
+	}
+
+	void RIContextRecording::endFrame()
+	{
+		m_log->endFrame();
+	}
+
+	RICommandLog* RIContextRecording::getLog()
+	{
+		return m_log;
+	}
+}
\ No newline at end of file
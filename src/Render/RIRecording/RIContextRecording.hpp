@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Render/RIContext.hpp>
+#include "RICommandLog.hpp"
+
+namespace Phoenix
+{
+	struct RIRecordingResourceStore;
+
+	// Context that does not render anything, but appends every call to a RICommandLog
+	// and keeps per frame counters there. Allows running the renderer headless, e.g. 
+	// for tests or to measure how much work a frame submits.
+	class RIContextRecording : public IRIContext
+	{
+	public:
+		enum { NUM_TEXTURE_UNITS = 16 };
+
+		RIContextRecording(const RIRecordingResourceStore* resources, RICommandLog* log);
+
+		virtual void drawLinear(EPrimitive primitives, uint32_t count, uint32_t start) override;
+
+		virtual void drawLinear(VertexBufferHandle vbHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex = 0) override;
+
+		virtual void drawIndexed(VertexBufferHandle vbHandle, IndexBufferHandle ibHandle, EPrimitive primitives, uint32_t count = 0, uint32_t startIndex = 0) override;
+
+		virtual void bindShaderProgram(ProgramHandle programHandle) override;
+
+		virtual void bindUniform(UniformHandle uniformHandle, const void* data) override;
+
+		virtual void bindVertexBuffer(VertexBufferHandle vbHandle) override;
+
+		virtual void bindIndexBuffer(IndexBufferHandle ibHandle) override;
+
+		virtual void clearRenderTargetColor(RenderTargetHandle rtHandle, const RGBA& clearColor) override;
+
+		virtual void clearRenderTargetDepth(RenderTargetHandle rtHandle) override;
+
+		virtual void uploadTextureData(Texture2DHandle handle, const void* data) override;
+
+		virtual void uploadTextureData(TextureCubeHandle handle, ETextureCubeSide side, const void* data) override;
+
+		virtual void bindTexture(UniformHandle samplerHandle, Texture2DHandle texHandle) override;
+
+		virtual void bindTexture(UniformHandle samplerHandle, TextureCubeHandle texHandle) override;
+
+		virtual void unbindTextures() override;
+
+		virtual void bindRenderTarget(RenderTargetHandle handle) override;
+
+		virtual void bindDefaultRenderTarget() override;
+
+		virtual void setDepthTest(EDepth state) override;
+
+		virtual void setDepthWrite(EDepth state) override;
+
+		virtual void setBlendState(const BlendState& state) override;
+
+		virtual void clearColor() override;
+
+		virtual void clearDepth() override;
+
+		virtual void endPass() override;
+
+		virtual uint32_t getMaxTextureUnits() const override;
+
+		virtual void bindConstantBufferToLocation(ConstantBufferHandle cbHandle, uint32_t location) override;
+
+		virtual void updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes = 0) override;
+
+		virtual void bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location) override;
+
+		virtual void updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes) override;
+
+		// Takes the place of swapping buffers, closes the counters of the current frame.
+		void endFrame();
+
+		RICommandLog* getLog();
+
+	private:
+		void beginBind(ERICommand command);
+
+		const RIRecordingResourceStore* m_resources;
+		RICommandLog* m_log;
+
+		bool m_bProgramBound;
+		uint32_t m_activeTextures;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "RIDeviceRecording.hpp"
+#include "RIRecordingResourceStore.hpp"
+
+#include <assert.h>
+#include <string.h>
+#include <string>
+
+#include <Core/Logger.hpp>
+
+namespace Phoenix
+{
+	RIDeviceRecording::RIDeviceRecording(RIRecordingResourceStore* resources)
+		: m_resources(resources)
+	{}
+
+	RIDeviceRecording::~RIDeviceRecording()
+	{}
+
+	VertexBufferHandle RIDeviceRecording::createVertexBuffer(const VertexBufferFormat& format)
+	{
+		assert(format.size() > 0);
+		return m_resources->m_vertexbuffers.allocateResource();
+	}
+
+	IndexBufferHandle RIDeviceRecording::createIndexBuffer(size_t elementSizeBytes, size_t count, const void* data)
+	{
+		IndexBufferHandle handle = m_resources->m_indexbuffers.allocateResource();
+
+		if (handle.isValid())
+		{
+			RIIndexBuffer* ib = m_resources->m_indexbuffers.getResource(handle);
+			ib->m_numElements = count;
+			ib->m_elementSizeBytes = elementSizeBytes;
+		}
+
+		return handle;
+	}
+
+	VertexShaderHandle RIDeviceRecording::createVertexShader(const char* source)
+	{
+		assert(nullptr != source);
+		return m_resources->m_vertexshaders.allocateResource();
+	}
+
+	FragmentShaderHandle RIDeviceRecording::createFragmentShader(const char* source)
+	{
+		assert(nullptr != source);
+		return m_resources->m_fragmentshaders.allocateResource();
+	}
+
+	ProgramHandle RIDeviceRecording::createProgram(VertexShaderHandle vsHandle, FragmentShaderHandle fsHandle)
+	{
+		ProgramHandle handle;
+
+		if (!vsHandle.isValid() || !fsHandle.isValid())
+		{
+			Logger::error("Failed to create shader program, invalid shader handle.");
+			return handle;
+		}
+
+		return m_resources->m_programs.allocateResource();
+	}
+
+	Texture2DHandle RIDeviceRecording::createTexture2D(const TextureDesc& desc)
+	{
+		Texture2DHandle handle = m_resources->m_texture2Ds.allocateResource();
+
+		if (handle.isValid())
+		{
+			RITexture2D* texture = m_resources->m_texture2Ds.getResource(handle);
+			texture->m_pixelFormat = desc.pixelFormat;
+			texture->m_numMips = desc.numMips;
+			texture->m_width = desc.width;
+			texture->m_height = desc.height;
+		}
+
+		return handle;
+	}
+
+	TextureCubeHandle RIDeviceRecording::createTextureCube(const TextureDesc& desc)
+	{
+		assert(desc.width == desc.height);
+
+		TextureCubeHandle handle = m_resources->m_textureCubes.allocateResource();
+
+		if (handle.isValid())
+		{
+			RITextureCube* texture = m_resources->m_textureCubes.getResource(handle);
+			texture->m_pixelFormat = desc.pixelFormat;
+			texture->m_numMips = desc.numMips;
+			texture->m_size = desc.width;
+		}
+
+		return handle;
+	}
+
+	RenderTargetHandle RIDeviceRecording::createRenderTarget(const RenderTargetDesc& desc)
+	{
+		bool bHasAnyColors = false;
+
+		for (size_t i = 0; i < RenderTargetDesc::NumMaxColors; ++i)
+		{
+			bHasAnyColors |= desc.colorAttachs[i].isValid();
+		}
+
+		assert(bHasAnyColors);
+
+		return m_resources->m_framebuffers.allocateResource();
+	}
+
+	UniformHandle RIDeviceRecording::createUniform(const char* name, EUniformType type, EUniformIsArray isArray)
+	{
+		UniformHandle handle = m_resources->m_uniforms.allocateResource();
+
+		if (!handle.isValid())
+		{
+			return handle;
+		}
+
+		std::string	fullName(name);
+
+		if (isArray == EUniformIsArray::True)
+		{
+			fullName += "[0]";
+		}
+
+		RIUniform* uniform = m_resources->m_uniforms.getResource(handle);
+		uniform->m_type = type;
+		uniform->m_nameHash = HashFNV<const char*>()(fullName.c_str());
+		strncpy(uniform->m_debugName, fullName.c_str(), RIUniform::DBG_MAX_NAME_LEN);
+		uniform->m_debugName[RIUniform::DBG_MAX_NAME_LEN - 1] = '\0';
+		return handle;
+	}
+
+	ConstantBufferHandle RIDeviceRecording::createConstantBuffer(const char* name, size_t bufferSizeBytes)
+	{
+		ConstantBufferHandle handle = m_resources->m_constantBuffers.allocateResource();
+
+		if (!handle.isValid())
+		{
+			return handle;
+		}
+
+		RIConstantBuffer* cb = m_resources->m_constantBuffers.getResource(handle);
+		strncpy(cb->m_name, name, RIConstantBuffer::MAX_NAME_LEN);
+		cb->m_name[RIConstantBuffer::MAX_NAME_LEN - 1] = '\0';
+		cb->m_nameHash = HashFNV<const char*>()(name);
+		cb->m_bufferSizeBytes = bufferSizeBytes;
+		return handle;
+	}
+
+	StorageBufferHandle RIDeviceRecording::createStorageBuffer(const char* name, size_t bufferSizeBytes)
+	{
+		StorageBufferHandle handle = m_resources->m_storageBuffers.allocateResource();
+
+		if (!handle.isValid())
+		{
+			return handle;
+		}
+
+		RIStorageBuffer* sb = m_resources->m_storageBuffers.getResource(handle);
+		strncpy(sb->m_name, name, RIStorageBuffer::MAX_NAME_LEN);
+		sb->m_name[RIStorageBuffer::MAX_NAME_LEN - 1] = '\0';
+		sb->m_bufferSizeBytes = bufferSizeBytes;
+		return handle;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Render/RIDevice.hpp>
+#include <Render/RIResourceHandles.hpp>
+
+namespace Phoenix
+{
+	struct RIRecordingResourceStore;
+
+	// Device without a graphics api behind it. Handles are allocated from the store exactly
+	// like the OpenGL backend does, so the same sequence of create calls yields the same handles.
+	class RIDeviceRecording : public IRIDevice
+	{
+	public:
+		RIDeviceRecording(RIRecordingResourceStore* resources);
+
+		virtual ~RIDeviceRecording();
+
+		virtual VertexBufferHandle	 createVertexBuffer(const VertexBufferFormat& format) override;
+		
+		virtual IndexBufferHandle	 createIndexBuffer(size_t elementSizeBytes, size_t count, const void* data) override;
+		
+		virtual VertexShaderHandle	 createVertexShader(const char* source) override;
+		
+		virtual FragmentShaderHandle createFragmentShader(const char* source) override;
+		
+		virtual ProgramHandle		 createProgram(VertexShaderHandle vsHandle, FragmentShaderHandle fsHandle) override;
+		
+		virtual Texture2DHandle		 createTexture2D(const TextureDesc& desc) override;
+		
+		virtual TextureCubeHandle	 createTextureCube(const TextureDesc& desc) override;
+		
+		virtual RenderTargetHandle	 createRenderTarget(const RenderTargetDesc& desc) override;
+		
+		virtual UniformHandle		 createUniform(const char* name, EUniformType type, EUniformIsArray isArray) override;
+
+		virtual ConstantBufferHandle createConstantBuffer(const char* name, size_t bufferSizeBytes) override;
+
+		virtual StorageBufferHandle	 createStorageBuffer(const char* name, size_t bufferSizeBytes) override;
+
+	private:
+		RIRecordingResourceStore* m_resources;
+	};
+}
\ No newline at end of file
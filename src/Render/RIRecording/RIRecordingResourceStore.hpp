@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Render/RIResourceContainer.hpp>
+#include <Render/RIResourceHandles.hpp>
+#include <Render/RIResources.hpp>
+
+namespace Phoenix
+{
+	// Mirrors RIOpenGLResourceStore, but only keeps the api independent part of each resource. 
+	// This is all the recording backend needs to validate calls and size their payloads.
+	struct RIRecordingResourceStore
+	{
+		RIResourceContainer<RIVertexBuffer,   VertexBufferHandle,   1024> m_vertexbuffers;
+		RIResourceContainer<RIIndexBuffer,	  IndexBufferHandle,    1024> m_indexbuffers;
+		RIResourceContainer<RIVertexShader,	  VertexShaderHandle,   256 > m_vertexshaders;
+		RIResourceContainer<RIFragmentShader, FragmentShaderHandle, 256 > m_fragmentshaders;
+		RIResourceContainer<RIProgram,		  ProgramHandle,		256 > m_programs;
+		RIResourceContainer<RITexture2D,	  Texture2DHandle,		4096> m_texture2Ds;
+		RIResourceContainer<RIRenderTarget,	  RenderTargetHandle,   256 > m_framebuffers;
+		RIResourceContainer<RIUniform,		  UniformHandle,		2048> m_uniforms;
+		RIResourceContainer<RITextureCube,	  TextureCubeHandle,	256>  m_textureCubes;
+		RIResourceContainer<RIConstantBuffer, ConstantBufferHandle, 1024> m_constantBuffers;
+		RIResourceContainer<RIStorageBuffer,  StorageBufferHandle,  256 > m_storageBuffers;
+	};
+}
\ No newline at end of file
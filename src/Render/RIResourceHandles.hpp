@@ -13,6 +13,7 @@ namespace Phoenix
 		EProgram,
 		EUniform,
 		EConstantBuffer,
+		EStorageBuffer,
 		ETexture2D,
 		ETextureCube,
 		ERenderTarget,	
@@ -62,6 +63,7 @@ namespace Phoenix
 	using ProgramHandle =		  ResourceHandle<size_t, 65536, EResourceHandleType::EProgram>;
 	using UniformHandle =		  ResourceHandle<size_t, 65536, EResourceHandleType::EUniform>;
 	using ConstantBufferHandle =  ResourceHandle<size_t, 65536, EResourceHandleType::EConstantBuffer>;
+	using StorageBufferHandle =   ResourceHandle<size_t, 65536, EResourceHandleType::EStorageBuffer>;
 	using Texture2DHandle =		  ResourceHandle<size_t, 65536, EResourceHandleType::ETexture2D>;
 	using TextureCubeHandle =	  ResourceHandle<size_t, 65536, EResourceHandleType::ETextureCube>;
 	using RenderTargetHandle =	  ResourceHandle<size_t, 65536, EResourceHandleType::ERenderTarget>;
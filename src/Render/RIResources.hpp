@@ -27,9 +27,11 @@ namespace Phoenix
 	public:
 		RIIndexBuffer()
 			: m_numElements(0)
+			, m_elementSizeBytes(0)
 		{}
 
 		size_t m_numElements;
+		size_t m_elementSizeBytes;
 	};
 
 	class RIVertexShader : public RIResource
@@ -99,4 +101,14 @@ namespace Phoenix
 		FNVHash m_nameHash;
 		size_t m_bufferSizeBytes;
 	};
+
+	// Shader storage buffer, bound by index like a constant buffer but without its size limit.
+	// m_bufferSizeBytes is the size at creation, updates replace the whole buffer.
+	class RIStorageBuffer : public RIResource
+	{
+	public:
+		enum {MAX_NAME_LEN = 128};
+		char m_name[128];
+		size_t m_bufferSizeBytes;
+	};
 }
\ No newline at end of file
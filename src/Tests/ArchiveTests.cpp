@@ -0,0 +1,497 @@
+#include "ArchiveTests.hpp"
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <Core/Compression.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Serialize.hpp>
+#include <Core/SerialUtil.hpp>
+#include <Core/StaticSerialize.hpp>
+#include <Core/Texture.hpp>
+#include <Core/WorkerPool.hpp>
+#include <Core/Components/CTransform.hpp>
+#include <Render/RIDefs.hpp>
+#include <Render/RIDefsSerialize.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	void runArchiveTests()
+	{
+		staticArchiveTest();
+	}
+
+	void runArchiveFileTests()
+	{
+		compressionTest();
+	}
+
+	void runArchiveBenchmarks()
+	{
+		staticArchiveBenchmark();
+	}
+
+	struct ArchiveTestAsset
+	{
+		std::string m_name;
+		TextureDesc m_desc;
+		std::vector<LocalTransform> m_transforms;
+		std::vector<std::string> m_tags;
+
+		PHI_SERIALIZE(m_name, m_desc, m_transforms, m_tags)
+	};
+
+	void staticArchiveTest()
+	{
+		static_assert(HasSerializeFields<ArchiveTestAsset>::value, "");
+		static_assert(HasSerializeFields<TextureDesc>::value, "");
+
+		ArchiveTestAsset asset;
+		asset.m_name = "brick";
+		asset.m_desc.width = 512;
+		asset.m_desc.height = 256;
+		asset.m_desc.pixelFormat = EPixelFormat::R8G8B8A8;
+		asset.m_desc.numMips = 10;
+		asset.m_transforms.resize(3);
+		asset.m_transforms[2].m_translation = Vec3(1.f, 2.f, 3.f);
+		asset.m_tags = { "wall", "red" };
+
+		// Grows the buffer from nothing.
+		WriteArchive staticAr;
+		createWriteArchive(0, &staticAr);
+		{
+			StaticWriteArchive writer(&staticAr);
+			serializeValue(writer, asset);
+		}
+
+		WriteArchive dynamicAr;
+		createWriteArchive(0, &dynamicAr);
+		DynamicArchive dynamicWriter(&dynamicAr);
+		serializeValue(dynamicWriter, asset);
+
+		assert(staticAr.m_numBytesWritten == dynamicAr.m_numBytesWritten);
+		assert(memcmp(staticAr.m_data, dynamicAr.m_data, staticAr.m_numBytesWritten) == 0);
+
+		// TextureDesc goes field by field, without its padding.
+		const size_t descBytes = 2 * sizeof(uint32_t) + sizeof(EPixelFormat) + 3 * sizeof(ETextureFilter) + 3 * sizeof(ETextureWrap) + sizeof(uint8_t);
+		const size_t expectedBytes = sizeof(size_t) + 6 + descBytes + sizeof(size_t) + 3 * sizeof(LocalTransform)
+			+ sizeof(size_t) + sizeof(size_t) + 5 + sizeof(size_t) + 4;
+		assert(staticAr.m_numBytesWritten == expectedBytes);
+
+		ReadArchive readAr;
+		readAr.m_data = staticAr.m_data;
+		readAr.m_size = staticAr.m_numBytesWritten;
+
+		ArchiveTestAsset loaded;
+		{
+			StaticReadArchive reader(&readAr);
+			serializeValue(reader, loaded);
+		}
+
+		assert(readAr.m_numBytesRead == readAr.m_size);
+		assert(loaded.m_name == "brick" && loaded.m_tags == asset.m_tags);
+		assert(loaded.m_desc.width == 512 && loaded.m_desc.pixelFormat == EPixelFormat::R8G8B8A8 && loaded.m_desc.numMips == 10);
+		assert(loaded.m_transforms.size() == 3 && loaded.m_transforms[2].m_translation == Vec3(1.f, 2.f, 3.f));
+		assert(loaded.m_transforms[0].m_scale == Vec3(1.f));
+
+		// Strings keep the layout of serialize(Archive*, std::string&).
+		readAr.m_numBytesRead = 0;
+		std::string name;
+		serialize(&readAr, name);
+		assert(name == "brick");
+
+		destroyArchive(staticAr);
+		destroyArchive(dynamicAr);
+	}
+
+	struct ArchiveBenchmarkRecord
+	{
+		TextureDesc m_desc;
+		TextureCreationHints m_hints;
+		LocalTransform m_transform;
+		uint32_t m_id;
+
+		PHI_SERIALIZE(m_desc, m_hints, m_transform, m_id)
+	};
+
+	// How every field went through the archive before, one virtual call each.
+	static void serializeFieldwise(Archive* ar, ArchiveBenchmarkRecord& record)
+	{
+		TextureDesc& desc = record.m_desc;
+		ar->serialize(&desc.width, sizeof(uint32_t));
+		ar->serialize(&desc.height, sizeof(uint32_t));
+		ar->serialize(&desc.pixelFormat, sizeof(EPixelFormat));
+		ar->serialize(&desc.minFilter, sizeof(ETextureFilter));
+		ar->serialize(&desc.magFilter, sizeof(ETextureFilter));
+		ar->serialize(&desc.mipFilter, sizeof(ETextureFilter));
+		ar->serialize(&desc.wrapU, sizeof(ETextureWrap));
+		ar->serialize(&desc.wrapV, sizeof(ETextureWrap));
+		ar->serialize(&desc.wrapW, sizeof(ETextureWrap));
+		ar->serialize(&desc.numMips, sizeof(uint8_t));
+
+		TextureCreationHints& hints = record.m_hints;
+		ar->serialize(&hints.colorSpace, sizeof(ETextrueColorSpace));
+		ar->serialize(&hints.magFilter, sizeof(ETextureFilter));
+		ar->serialize(&hints.minFilter, sizeof(ETextureFilter));
+		ar->serialize(&hints.mipFilter, sizeof(ETextureFilter));
+		ar->serialize(&hints.wrapU, sizeof(ETextureWrap));
+		ar->serialize(&hints.wrapV, sizeof(ETextureWrap));
+		ar->serialize(&hints.wrapW, sizeof(ETextureWrap));
+		ar->serialize(&hints.bGenMipMaps, sizeof(bool));
+
+		serialize(ar, record.m_transform.m_translation);
+		serialize(ar, record.m_transform.m_rotation);
+		serialize(ar, record.m_transform.m_scale);
+		ar->serialize(&record.m_id, sizeof(uint32_t));
+	}
+
+	void staticArchiveBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t numRecords = 1 << 20;
+		const int numRuns = 5;
+
+		std::vector<ArchiveBenchmarkRecord> records(numRecords);
+
+		for (size_t i = 0; i < numRecords; ++i)
+		{
+			records[i].m_desc.width = static_cast<uint32_t>(i);
+			records[i].m_transform.m_translation = Vec3(static_cast<float>(i));
+			records[i].m_id = static_cast<uint32_t>(i);
+		}
+
+		std::vector<ArchiveBenchmarkRecord> loaded(numRecords);
+
+		Logger::logf("Archive throughput, %zu records of %zu bytes, best of %d:", numRecords, sizeof(ArchiveBenchmarkRecord), numRuns);
+
+		const char* pathNames[] = { "virtual, per field", "virtual, per record", "static, per record" };
+
+		for (int path = 0; path < 3; ++path)
+		{
+			double bestWriteMs = 1e30;
+			double bestReadMs = 1e30;
+			double totalMB = 0.0;
+
+			for (int run = 0; run < numRuns; ++run)
+			{
+				WriteArchive writeAr;
+				createWriteArchive(numRecords * sizeof(ArchiveBenchmarkRecord), &writeAr);
+
+				Clock::time_point start = Clock::now();
+
+				if (path == 0)
+				{
+					for (ArchiveBenchmarkRecord& record : records)
+					{
+						serializeFieldwise(&writeAr, record);
+					}
+				}
+				else if (path == 1)
+				{
+					DynamicArchive writer(&writeAr);
+
+					for (ArchiveBenchmarkRecord& record : records)
+					{
+						serializeValue(writer, record);
+					}
+				}
+				else
+				{
+					StaticWriteArchive writer(&writeAr);
+
+					for (ArchiveBenchmarkRecord& record : records)
+					{
+						serializeValue(writer, record);
+					}
+				}
+
+				bestWriteMs = std::min(bestWriteMs, Ms(Clock::now() - start).count());
+				totalMB = writeAr.m_numBytesWritten / (1024.0 * 1024.0);
+
+				ReadArchive readAr;
+				readAr.m_data = writeAr.m_data;
+				readAr.m_size = writeAr.m_numBytesWritten;
+
+				start = Clock::now();
+
+				if (path == 0)
+				{
+					for (ArchiveBenchmarkRecord& record : loaded)
+					{
+						serializeFieldwise(&readAr, record);
+					}
+				}
+				else if (path == 1)
+				{
+					DynamicArchive reader(&readAr);
+
+					for (ArchiveBenchmarkRecord& record : loaded)
+					{
+						serializeValue(reader, record);
+					}
+				}
+				else
+				{
+					StaticReadArchive reader(&readAr);
+
+					for (ArchiveBenchmarkRecord& record : loaded)
+					{
+						serializeValue(reader, record);
+					}
+				}
+
+				bestReadMs = std::min(bestReadMs, Ms(Clock::now() - start).count());
+				assert(loaded[numRecords - 1].m_id == numRecords - 1 && loaded[7].m_transform.m_translation.x == 7.f);
+
+				destroyArchive(writeAr);
+			}
+
+			// Per field and per record write the same bytes, records per second compare the paths as well.
+			Logger::logf("  %s: write %.0f MB/s (%.1f M records/s), read %.0f MB/s (%.1f M records/s)", pathNames[path],
+				totalMB / (bestWriteMs / 1000.0), numRecords / (bestWriteMs * 1000.0), totalMB / (bestReadMs / 1000.0), numRecords / (bestReadMs * 1000.0));
+		}
+	}
+
+	// Compresses at both levels, checks the blocks decompress to the input and returns the sizes.
+	static void compressRoundTrip(const std::vector<uint8_t>& data, size_t* outFastSize, size_t* outStrongSize)
+	{
+		const ECompression levels[] = { ECompression::Fast, ECompression::Strong };
+		size_t* sizes[] = { outFastSize, outStrongSize };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			std::vector<uint8_t> packed(getCompressBound(data.size()));
+			const size_t packedSize = compressBlock(data.data(), data.size(), packed.data(), packed.size(), levels[i]);
+			assert(packedSize > 0 && packedSize <= packed.size());
+
+			// One byte more than the data would not fit, one less is corrupt, and so is a cut off block.
+			std::vector<uint8_t> unpacked(data.size() + 1, 0xcd);
+			const bool bDecompressed = decompressBlock(packed.data(), packedSize, unpacked.data(), data.size());
+			assert(bDecompressed);
+			assert(memcmp(unpacked.data(), data.data(), data.size()) == 0);
+			assert(unpacked[data.size()] == 0xcd);
+			assert(!decompressBlock(packed.data(), packedSize, unpacked.data(), data.size() + 1));
+			assert(data.empty() || !decompressBlock(packed.data(), packedSize, unpacked.data(), data.size() - 1));
+			assert(!decompressBlock(packed.data(), packedSize - 1, unpacked.data(), data.size()));
+
+			*sizes[i] = packedSize;
+		}
+	}
+
+	static std::vector<uint8_t> readWholeArchive(const char* path, EReadMode mode)
+	{
+		ReadArchive ar;
+		EArchiveError err = createReadArchive(path, &ar, mode);
+		assert(err == EArchiveError::NoError);
+
+		std::vector<uint8_t> bytes(ar.m_data, ar.m_data + ar.m_size);
+		destroyArchive(ar);
+		return bytes;
+	}
+
+	void compressionTest()
+	{
+		std::mt19937 rng(3);
+		size_t fastSize = 0;
+		size_t strongSize = 0;
+
+		// Too short for a match, and just long enough for one.
+		for (size_t size = 0; size < 40; ++size)
+		{
+			std::vector<uint8_t> data(size, 'a');
+			compressRoundTrip(data, &fastSize, &strongSize);
+		}
+
+		std::vector<uint8_t> zeros(COMPRESSED_BLOCK_SIZE, 0);
+		compressRoundTrip(zeros, &fastSize, &strongSize);
+		assert(fastSize < zeros.size() / 200 && strongSize < zeros.size() / 200);
+
+		// Nothing to find, grows by the length bytes of the literals only.
+		std::vector<uint8_t> noise(100000);
+		std::generate(noise.begin(), noise.end(), [&rng]() { return static_cast<uint8_t>(rng()); });
+		compressRoundTrip(noise, &fastSize, &strongSize);
+		assert(fastSize <= getCompressBound(noise.size()) && fastSize > noise.size());
+
+		// Words from a small vocabulary, matches of all lengths and offsets below 8 and 16.
+		std::vector<uint8_t> text;
+		const char* words[] = { "mesh ", "material ", "texture ", "a", "ab", "abcabcabcabc", "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz " };
+
+		while (text.size() < 200000)
+		{
+			const char* word = words[rng() % 7];
+			text.insert(text.end(), word, word + strlen(word));
+		}
+
+		compressRoundTrip(text, &fastSize, &strongSize);
+		assert(strongSize <= fastSize && fastSize < text.size() / 2);
+
+		{
+			// Shuffling, through the SSE path and the rest.
+			std::vector<uint8_t> bytes(4 * 37 + 3);
+			std::generate(bytes.begin(), bytes.end(), [&rng]() { return static_cast<uint8_t>(rng()); });
+
+			for (size_t elementSize : { 4u, 3u })
+			{
+				const size_t numElements = bytes.size() / elementSize;
+				std::vector<uint8_t> shuffled(bytes.size(), 0), unshuffled(bytes.size(), 0);
+				shuffleBytes(bytes.data(), shuffled.data(), numElements, elementSize);
+				assert(shuffled[numElements] == bytes[1]);
+				unshuffleBytes(shuffled.data(), unshuffled.data(), numElements, elementSize);
+				assert(memcmp(unshuffled.data(), bytes.data(), numElements * elementSize) == 0);
+			}
+		}
+
+		{
+			// Garbage must not read or write out of bounds, whatever it decodes to.
+			std::vector<uint8_t> packed(getCompressBound(text.size()));
+			const size_t packedSize = compressBlock(text.data(), text.size(), packed.data(), packed.size(), ECompression::Fast);
+			std::vector<uint8_t> unpacked(text.size());
+
+			for (int i = 0; i < 200; ++i)
+			{
+				std::vector<uint8_t> broken(packed.begin(), packed.begin() + packedSize);
+				broken[rng() % broken.size()] = static_cast<uint8_t>(rng());
+				broken.resize(rng() % 2 ? broken.size() : rng() % broken.size());
+				decompressBlock(broken.data(), broken.size(), unpacked.data(), unpacked.size());
+			}
+		}
+
+		// An archive of several blocks: floats of a smooth curve, text, zeros and a short last block of noise.
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+
+		for (int i = 0; i < 100000; ++i)
+		{
+			float value = sinf(i * 0.001f) * 100.f;
+			writeAr.serialize(&value, sizeof(value));
+		}
+
+		writeAr.serialize(text.data(), text.size());
+		writeAr.serialize(zeros.data(), COMPRESSED_BLOCK_SIZE - writeAr.m_numBytesWritten % COMPRESSED_BLOCK_SIZE);
+		writeAr.serialize(noise.data(), 1001);
+
+		const std::vector<uint8_t> expected(writeAr.m_data, writeAr.m_data + writeAr.m_numBytesWritten);
+		const char* path = "phoenix_compressed_archive_test.bin";
+
+		for (ECompression level : { ECompression::Fast, ECompression::Strong })
+		{
+			EArchiveError err = writeArchiveToDisk(path, writeAr, level);
+			assert(err == EArchiveError::NoError);
+
+			bool bSame = readWholeArchive(path, EReadMode::Mapped) == expected;
+			assert(bSame);
+			bSame = readWholeArchive(path, EReadMode::Copy) == expected;
+			assert(bSame);
+
+			{
+				WorkerPool pool(4);
+				setDecompressionPool(&pool);
+				bSame = readWholeArchive(path, EReadMode::Mapped) == expected;
+				assert(bSame);
+				setDecompressionPool(nullptr);
+			}
+
+			// Blocks read back to front.
+			CompressedArchive compressed;
+			err = openCompressedArchive(path, &compressed);
+			assert(err == EArchiveError::NoError);
+			assert(compressed.m_header.m_rawSize == expected.size());
+			assert(compressed.m_header.m_numBlocks == (expected.size() + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE);
+			assert(compressed.m_blocks[0].m_flags == BLOCK_SHUFFLED);
+			assert(compressed.m_blocks[compressed.m_header.m_numBlocks - 1].m_flags == BLOCK_STORED);
+			assert(compressed.m_file.m_size < expected.size() / 2);
+
+			std::vector<uint8_t> block(COMPRESSED_BLOCK_SIZE);
+
+			for (size_t i = compressed.m_header.m_numBlocks; i-- > 0;)
+			{
+				const size_t blockSize = getCompressedBlockSize(compressed, i);
+				const bool bRead = readCompressedBlock(compressed, i, block.data());
+				assert(bRead);
+				assert(memcmp(block.data(), expected.data() + i * COMPRESSED_BLOCK_SIZE, blockSize) == 0);
+			}
+
+			closeCompressedArchive(compressed);
+		}
+
+		{
+			// Default compression, and a cut off file.
+			setDefaultCompression(ECompression::Fast);
+			writeArchiveToDisk(path, writeAr);
+			setDefaultCompression(ECompression::None);
+
+			ReadArchive ar;
+			EArchiveError err = createReadArchive(path, &ar, EReadMode::Copy);
+			assert(err == EArchiveError::NoError);
+			const size_t numBytes = ar.m_size;
+			destroyArchive(ar);
+			assert(numBytes == expected.size());
+
+			CompressedArchive compressed;
+			openCompressedArchive(path, &compressed);
+			WriteArchive cutAr;
+			createWriteArchive(0, &cutAr);
+			cutAr.serialize(compressed.m_file.m_data, compressed.m_file.m_size / 2);
+			closeCompressedArchive(compressed);
+
+			writeArchiveToDisk(path, cutAr, ECompression::None);
+			destroyArchive(cutAr);
+
+			err = createReadArchive(path, &ar);
+			assert(err == EArchiveError::Corrupt);
+			err = openCompressedArchive(path, &compressed);
+			assert(err == EArchiveError::Corrupt);
+		}
+
+		{
+			// A header asking for more than any block could hold is not allocated for.
+			writeArchiveToDisk(path, writeAr, ECompression::Fast);
+
+			CompressedArchive compressed;
+			EArchiveError err = openCompressedArchive(path, &compressed);
+			assert(err == EArchiveError::NoError);
+
+			CompressedArchiveHeader header = compressed.m_header;
+			header.m_blockSize = 0xFFFFFFFF;
+			header.m_rawSize = uint64_t(header.m_numBlocks) * header.m_blockSize;
+
+			WriteArchive patchedAr;
+			createWriteArchive(0, &patchedAr);
+			patchedAr.serialize(&header, sizeof(header));
+			patchedAr.serialize(compressed.m_file.m_data + sizeof(header), compressed.m_file.m_size - sizeof(header));
+			closeCompressedArchive(compressed);
+
+			writeArchiveToDisk(path, patchedAr, ECompression::None);
+			destroyArchive(patchedAr);
+
+			ReadArchive ar;
+			err = createReadArchive(path, &ar);
+			assert(err == EArchiveError::Corrupt);
+			err = openCompressedArchive(path, &compressed);
+			assert(err == EArchiveError::Corrupt);
+		}
+
+		{
+			// Archives written plain still load as they are.
+			writeArchiveToDisk(path, writeAr, ECompression::None);
+			const bool bSame = readWholeArchive(path, EReadMode::Mapped) == expected;
+			assert(bSame);
+
+			CompressedArchive compressed;
+			const EArchiveError err = openCompressedArchive(path, &compressed);
+			assert(err == EArchiveError::NotCompressed);
+		}
+
+		destroyArchive(writeAr);
+		remove(path);
+	}
+} }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Phoenix { namespace Tests
+{
+	void runArchiveTests();
+
+	void runArchiveFileTests();
+
+	void runArchiveBenchmarks();
+
+	void staticArchiveTest();
+
+	void staticArchiveBenchmark();
+
+	void compressionTest();
+} }
\ No newline at end of file
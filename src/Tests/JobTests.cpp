@@ -0,0 +1,474 @@
+#include "JobTests.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <Core/Logger.hpp>
+#include <Core/WorkerPool.hpp>
+#include <Core/WorkStealingDeque.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	void runJobTests()
+	{
+		workStealingDequeTest();
+	}
+
+	void runJobStressTests()
+	{
+		workStealingDequeStressTest();
+		workerPoolStressTest();
+	}
+
+	void runJobBenchmarks()
+	{
+		fibBenchmark();
+		nbodyBenchmark();
+		parallelForBenchmark();
+	}
+
+	// 1, 2, 4 ... up to the number of hardware threads, and that number itself.
+	static std::vector<size_t> getThreadCounts()
+	{
+		const size_t numCores = std::max(std::thread::hardware_concurrency(), 1u);
+		std::vector<size_t> counts;
+
+		for (size_t n = 1; n < numCores; n *= 2)
+		{
+			counts.push_back(n);
+		}
+
+		counts.push_back(numCores);
+		return counts;
+	}
+
+	static uint64_t fibSerial(int n)
+	{
+		return n < 2 ? n : fibSerial(n - 1) + fibSerial(n - 2);
+	}
+
+	// One job per call down to the cutoff, the caller computes the other half and then waits.
+	static void fibJob(WorkerPool* pool, int n, int cutoff, uint64_t* outResult)
+	{
+		if (n <= cutoff)
+		{
+			*outResult = fibSerial(n);
+			return;
+		}
+
+		uint64_t a = 0;
+		uint64_t b = 0;
+		std::atomic<int32_t> counter(0);
+
+		pool->submit([pool, n, cutoff, &a]() { fibJob(pool, n - 1, cutoff, &a); }, &counter);
+		fibJob(pool, n - 2, cutoff, &b);
+		pool->wait(&counter);
+
+		*outResult = a + b;
+	}
+
+	void workStealingDequeTest()
+	{
+		WorkStealingDeque<int> deque(4);
+		assert(deque.capacity() == 4);
+
+		int item = -1;
+		bool bPopped = deque.pop(&item);
+		bool bStolen = deque.steal(&item);
+		assert(!bPopped && !bStolen);
+
+		// Grows past the initial ring while items are at both ends.
+		for (int i = 0; i < 3000; ++i)
+		{
+			deque.push(i);
+		}
+
+		assert(deque.size() == 3000 && deque.capacity() == 4096);
+
+		bPopped = deque.pop(&item);
+		assert(bPopped && item == 2999);
+		bStolen = deque.steal(&item);
+		assert(bStolen && item == 0);
+		bStolen = deque.steal(&item);
+		assert(bStolen && item == 1);
+		bPopped = deque.pop(&item);
+		assert(bPopped && item == 2998);
+
+		for (int i = 0; i < 10; ++i)
+		{
+			deque.push(10000 + i);
+		}
+
+		bPopped = deque.pop(&item);
+		assert(bPopped && item == 10009);
+
+		int expected = 2;
+
+		while (deque.steal(&item))
+		{
+			if (expected == 2998)
+			{
+				expected = 10000;
+			}
+
+			assert(item == expected);
+			++expected;
+		}
+
+		assert(expected == 10009 && deque.size() == 0);
+		bPopped = deque.pop(&item);
+		assert(!bPopped);
+	}
+
+	void workStealingDequeStressTest()
+	{
+		const int numItems = 200000;
+		const int numThieves = 3;
+
+		for (int round = 0; round < 4; ++round)
+		{
+			WorkStealingDeque<int> deque(16);
+			std::vector<std::atomic<int>> taken(numItems);
+			std::atomic<bool> bDone(false);
+
+			for (std::atomic<int>& t : taken)
+			{
+				t = 0;
+			}
+
+			std::vector<std::thread> thieves;
+
+			for (int t = 0; t < numThieves; ++t)
+			{
+				thieves.emplace_back([&]()
+				{
+					int item;
+
+					while (!bDone || deque.size() > 0)
+					{
+						if (deque.steal(&item))
+						{
+							++taken[item];
+						}
+					}
+				});
+			}
+
+			// The owner pushes in bursts and pops some back, fighting the thieves for the last items.
+			std::mt19937 rng(round);
+			int item;
+			int next = 0;
+
+			while (next < numItems)
+			{
+				const int burst = std::min(static_cast<int>(rng() % 64) + 1, numItems - next);
+
+				for (int i = 0; i < burst; ++i)
+				{
+					deque.push(next++);
+				}
+
+				const int numPops = static_cast<int>(rng() % 64);
+
+				for (int i = 0; i < numPops && deque.pop(&item); ++i)
+				{
+					++taken[item];
+				}
+			}
+
+			while (deque.pop(&item))
+			{
+				++taken[item];
+			}
+
+			bDone = true;
+
+			for (std::thread& thief : thieves)
+			{
+				thief.join();
+			}
+
+			for (const std::atomic<int>& t : taken)
+			{
+				assert(t == 1);
+			}
+		}
+	}
+
+	void workerPoolStressTest()
+	{
+		WorkerPool pool(4);
+
+		uint64_t fib = 0;
+		fibJob(&pool, 22, 4, &fib);
+		assert(fib == 17711);
+
+		// Tiny ranges, so most of the time goes into splitting and stealing.
+		const size_t count = 1 << 18;
+		std::vector<uint8_t> visits(count, 0);
+		std::atomic<uint64_t> sum(0);
+
+		pool.parallelFor(count, 3, [&](size_t begin, size_t end)
+		{
+			uint64_t partial = 0;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				++visits[i];
+				partial += i;
+			}
+
+			sum += partial;
+		});
+
+		assert(sum == uint64_t(count) * (count - 1) / 2);
+		assert(std::all_of(visits.begin(), visits.end(), [](uint8_t v) { return v == 1; }));
+
+		// Threads outside of the pool submit through the shared queue and help while they wait.
+		const int numOutside = 3;
+		const int jobsPerThread = 2000;
+		std::atomic<int> numRan(0);
+		std::vector<std::thread> outside;
+
+		for (int t = 0; t < numOutside; ++t)
+		{
+			outside.emplace_back([&]()
+			{
+				std::atomic<int32_t> counter(0);
+
+				for (int i = 0; i < jobsPerThread; ++i)
+				{
+					pool.submit([&numRan]() { ++numRan; }, &counter);
+				}
+
+				pool.wait(&counter);
+				assert(counter == 0);
+			});
+		}
+
+		// Meanwhile nested waits on the pool's own threads.
+		std::atomic<int> numInner(0);
+		pool.parallelFor(64, 1, [&](size_t, size_t)
+		{
+			pool.parallelFor(64, 4, [&](size_t begin, size_t end) { numInner += static_cast<int>(end - begin); });
+		});
+
+		for (std::thread& thread : outside)
+		{
+			thread.join();
+		}
+
+		assert(numRan == numOutside * jobsPerThread);
+		assert(numInner == 64 * 64);
+
+		// A pool of one runs everything on the caller.
+		WorkerPool single(1);
+		uint64_t singleFib = 0;
+		fibJob(&single, 15, 2, &singleFib);
+		assert(single.getNumThreads() == 1 && singleFib == 610 && single.getNumSteals() == 0);
+	}
+
+	void fibBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const int n = 32;
+		const int cutoff = 16;
+
+		const uint64_t expected = fibSerial(n);
+
+		// Volatile in and out, so the timed call is neither dropped nor folded into the one above.
+		volatile int serialN = n;
+		Clock::time_point start = Clock::now();
+		volatile uint64_t serialResult = fibSerial(serialN);
+		const double serialMs = Ms(Clock::now() - start).count();
+		assert(serialResult == expected);
+
+		Logger::logf("Job system fib(%d), jobs down to fib(%d), serial %.2f ms:", n, cutoff, serialMs);
+
+		for (size_t numThreads : getThreadCounts())
+		{
+			WorkerPool pool(numThreads);
+			uint64_t result = 0;
+
+			start = Clock::now();
+			fibJob(&pool, n, cutoff, &result);
+			const double ms = Ms(Clock::now() - start).count();
+
+			assert(result == expected);
+			Logger::logf("  %zu threads: %.2f ms, %.2fx serial, %llu steals", numThreads, ms, serialMs / ms,
+				static_cast<unsigned long long>(pool.getNumSteals()));
+		}
+	}
+
+	struct Bodies
+	{
+		std::vector<float> m_x, m_y, m_z;
+		std::vector<float> m_vx, m_vy, m_vz;
+	};
+
+	// Velocities of the bodies in [begin, end) from the pull of all bodies, positions are read only.
+	static void nbodyAccelerate(Bodies* bodies, size_t begin, size_t end, float dt)
+	{
+		const size_t count = bodies->m_x.size();
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			float ax = 0.f;
+			float ay = 0.f;
+			float az = 0.f;
+
+			for (size_t j = 0; j < count; ++j)
+			{
+				const float dx = bodies->m_x[j] - bodies->m_x[i];
+				const float dy = bodies->m_y[j] - bodies->m_y[i];
+				const float dz = bodies->m_z[j] - bodies->m_z[i];
+				const float distSq = dx * dx + dy * dy + dz * dz + 0.01f;
+				const float invDist = 1.f / sqrtf(distSq);
+				const float invDist3 = invDist * invDist * invDist;
+
+				ax += dx * invDist3;
+				ay += dy * invDist3;
+				az += dz * invDist3;
+			}
+
+			bodies->m_vx[i] += ax * dt;
+			bodies->m_vy[i] += ay * dt;
+			bodies->m_vz[i] += az * dt;
+		}
+	}
+
+	static void nbodyMove(Bodies* bodies, size_t begin, size_t end, float dt)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			bodies->m_x[i] += bodies->m_vx[i] * dt;
+			bodies->m_y[i] += bodies->m_vy[i] * dt;
+			bodies->m_z[i] += bodies->m_vz[i] * dt;
+		}
+	}
+
+	static Bodies makeBodies(size_t count)
+	{
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+
+		Bodies bodies;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			bodies.m_x.push_back(position(rng));
+			bodies.m_y.push_back(position(rng));
+			bodies.m_z.push_back(position(rng));
+		}
+
+		bodies.m_vx.assign(count, 0.f);
+		bodies.m_vy.assign(count, 0.f);
+		bodies.m_vz.assign(count, 0.f);
+		return bodies;
+	}
+
+	void nbodyBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 4096;
+		const int numSteps = 4;
+		const float dt = 0.01f;
+
+		Bodies serial = makeBodies(count);
+		Clock::time_point start = Clock::now();
+
+		for (int step = 0; step < numSteps; ++step)
+		{
+			nbodyAccelerate(&serial, 0, count, dt);
+			nbodyMove(&serial, 0, count, dt);
+		}
+
+		const double serialMs = Ms(Clock::now() - start).count();
+		Logger::logf("Job system n-body, %zu bodies, %d steps, serial %.2f ms:", count, numSteps, serialMs);
+
+		for (size_t numThreads : getThreadCounts())
+		{
+			WorkerPool pool(numThreads);
+			Bodies bodies = makeBodies(count);
+
+			start = Clock::now();
+
+			for (int step = 0; step < numSteps; ++step)
+			{
+				pool.parallelFor(count, 32, [&bodies, dt](size_t begin, size_t end) { nbodyAccelerate(&bodies, begin, end, dt); });
+				pool.parallelFor(count, 1024, [&bodies, dt](size_t begin, size_t end) { nbodyMove(&bodies, begin, end, dt); });
+			}
+
+			const double ms = Ms(Clock::now() - start).count();
+
+			// Every body sums the same terms in the same order, so the results match exactly.
+			assert(bodies.m_x == serial.m_x && bodies.m_vz == serial.m_vz);
+			Logger::logf("  %zu threads: %.2f ms, %.2fx serial", numThreads, ms, serialMs / ms);
+		}
+	}
+
+	void parallelForBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 1 << 22;
+		const int numRuns = 10;
+
+		std::vector<float> input(count);
+		std::vector<float> output(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			input[i] = static_cast<float>(i % 1000);
+		}
+
+		auto kernel = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				output[i] = sqrtf(input[i]) * sinf(input[i]);
+			}
+		};
+
+		Clock::time_point start = Clock::now();
+
+		for (int run = 0; run < numRuns; ++run)
+		{
+			kernel(0, count);
+		}
+
+		const double serialMs = Ms(Clock::now() - start).count() / numRuns;
+		Logger::logf("Job system parallel for, %zu elements, serial %.2f ms:", count, serialMs);
+
+		const size_t grainSizes[] = { 1024, 16384 };
+
+		for (size_t numThreads : getThreadCounts())
+		{
+			WorkerPool pool(numThreads);
+
+			for (size_t grainSize : grainSizes)
+			{
+				start = Clock::now();
+
+				for (int run = 0; run < numRuns; ++run)
+				{
+					pool.parallelFor(count, grainSize, kernel);
+				}
+
+				const double ms = Ms(Clock::now() - start).count() / numRuns;
+				Logger::logf("  %zu threads, %zu per job: %.2f ms, %.2fx serial", numThreads, grainSize, ms, serialMs / ms);
+			}
+		}
+	}
+} }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace Phoenix { namespace Tests
+{
+	void runJobTests();
+
+	void runJobStressTests();
+
+	void runJobBenchmarks();
+
+	void workStealingDequeTest();
+
+	void workStealingDequeStressTest();
+
+	void workerPoolStressTest();
+
+	void fibBenchmark();
+
+	void nbodyBenchmark();
+
+	void parallelForBenchmark();
+} }
\ No newline at end of file
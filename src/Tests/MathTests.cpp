@@ -3,7 +3,12 @@
 #include <iostream>
 #include <Math/PhiMath.hpp>
 #include <Math/MathStreamOverloads.hpp>
+#include <Math/TransformBatch.hpp>
 #include <Core/Clock.hpp>
+#include <Core/Logger.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
 
 namespace Phoenix { namespace Tests
 {
@@ -12,6 +17,13 @@ namespace Phoenix { namespace Tests
 		vec3Tests();
 		matrix4Tests();
 		planeTests();
+		rayTests();
+		transformBatchTest();
+	}
+
+	void runMathBenchmarks()
+	{
+		transformBatchBenchmark();
 	}
 
 	void vec3Tests()
@@ -90,5 +102,153 @@ namespace Phoenix { namespace Tests
 		assert(p1.intersect(p2).first == true);
 		assert(p2.intersect(p1).first == true);
 	}
+
+	void rayTests()
+	{
+		Ray r{ { 0,0,-5 }, { 0,0,2 } };
+
+		assert(r.pointAt(2) == Vec3(0, 0, -3));
+
+		assert(r.intersect(Vec3(-1, -1, -1), Vec3(1, 1, 1)).first == true);
+		assert(r.intersect(Vec3(-1, -1, -1), Vec3(1, 1, 1)).second == 4);
+		assert(r.intersect(Vec3(2, -1, -1), Vec3(3, 1, 1)).first == false);
+		assert(r.intersect(Vec3(-1, -1, -9), Vec3(1, 1, -8)).first == false);
+
+		// Starting inside the box.
+		assert(r.intersect(Vec3(-1, -1, -6), Vec3(1, 1, 1)).second == 0);
+
+		assert(r.intersect(Vec3(-1, -1, 0), Vec3(1, -1, 0), Vec3(0, 1, 0)).first == true);
+		assert(r.intersect(Vec3(-1, -1, 0), Vec3(1, -1, 0), Vec3(0, 1, 0)).second == 5);
+		assert(r.intersect(Vec3(1, 1, 0), Vec3(3, 1, 0), Vec3(2, 3, 0)).first == false);
+		assert(r.intersect(Vec3(-1, -1, -6), Vec3(1, -1, -6), Vec3(0, 1, -6)).first == false);
+	}
+
+	static float maxMatrixDifference(const Matrix4& a, const Matrix4& b)
+	{
+		float maxDifference = 0.f;
+
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int col = 0; col < 4; ++col)
+			{
+				maxDifference = std::max(maxDifference, std::abs(a(row, col) - b(row, col)));
+			}
+		}
+
+		return maxDifference;
+	}
+
+	void transformBatchTest()
+	{
+		// sin and cos over many periods, including exact multiples of pi / 2.
+		std::vector<float> angles;
+		for (int i = -20000; i <= 20000; ++i)
+		{
+			angles.push_back(i * 0.01f);
+		}
+		for (int i = -8; i <= 8; ++i)
+		{
+			angles.push_back(i * PI * 0.5f);
+		}
+
+		std::vector<float> sines(angles.size());
+		std::vector<float> cosines(angles.size());
+		sinCosBatch(angles.data(), angles.size(), sines.data(), cosines.data());
+
+		for (size_t i = 0; i < angles.size(); ++i)
+		{
+			assert(std::abs(sines[i] - std::sin(angles[i])) < 1e-6f);
+			assert(std::abs(cosines[i] - std::cos(angles[i])) < 1e-6f);
+		}
+
+		// Sizes with and without a partial group of four, angles past a full turn.
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+		std::uniform_real_distribution<float> angle(-720.f, 720.f);
+		std::uniform_real_distribution<float> scale(0.01f, 10.f);
+
+		for (size_t count : { 1, 4, 7, 1001 })
+		{
+			TrsBatch batch;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				batch.add(Vec3(position(rng), position(rng), position(rng)), Vec3(angle(rng), angle(rng), angle(rng)), Vec3(scale(rng), scale(rng), scale(rng)));
+			}
+
+			std::vector<Matrix4> simd(count);
+			std::vector<Matrix4> scalar(count);
+			batch.compose(simd.data());
+			batch.composeScalar(scalar.data());
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				// Translations and the last row are copied, rotation times scale is relative to the scale.
+				for (int row = 0; row < 4; ++row)
+				{
+					assert(simd[i](row, 3) == scalar[i](row, 3));
+					assert(simd[i](3, row) == scalar[i](3, row));
+				}
+
+				for (int col = 0; col < 3; ++col)
+				{
+					float columnScale = std::abs(scalar[i](0, col)) + std::abs(scalar[i](1, col)) + std::abs(scalar[i](2, col));
+
+					for (int row = 0; row < 3; ++row)
+					{
+						assert(std::abs(simd[i](row, col) - scalar[i](row, col)) <= 1e-5f * columnScale);
+					}
+				}
+			}
+		}
+	}
+
+	void transformBatchBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 100000;
+		const int numPasses = 20;
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+		std::uniform_real_distribution<float> angle(-180.f, 180.f);
+		std::uniform_real_distribution<float> scale(0.5f, 2.f);
+
+		TrsBatch batch;
+		batch.reserve(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			batch.add(Vec3(position(rng), position(rng), position(rng)), Vec3(angle(rng), angle(rng), angle(rng)), Vec3(scale(rng), scale(rng), scale(rng)));
+		}
+
+		std::vector<Matrix4> simd(count);
+		std::vector<Matrix4> scalar(count);
+
+		Clock::time_point start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			batch.composeScalar(scalar.data());
+		}
+		double scalarMs = Ms(Clock::now() - start).count() / numPasses;
+
+		start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			batch.compose(simd.data());
+		}
+		double simdMs = Ms(Clock::now() - start).count() / numPasses;
+
+		float maxDifference = 0.f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			maxDifference = std::max(maxDifference, maxMatrixDifference(simd[i], scalar[i]));
+		}
+
+		Logger::logf("TRS composition of %zu transforms: scalar %.3f ms (%.1fM matrices/s), SSE SoA %.3f ms (%.1fM matrices/s, %.1fx), max difference %g",
+			count, scalarMs, count / scalarMs / 1000.0, simdMs, count / simdMs / 1000.0, scalarMs / simdMs, maxDifference);
+	}
 }
 }
\ No newline at end of file
@@ -39,9 +39,13 @@ namespace Phoenix { namespace Tests
 	}*/
 
 	void runMathTests();
+	void runMathBenchmarks();
 	void legacyTests();
 	void vec3Tests();
 	void matrix4Tests();
 	void planeTests();
+	void rayTests();
+	void transformBatchTest();
+	void transformBatchBenchmark();
 }
 }
\ No newline at end of file
@@ -1,14 +1,40 @@
 #include "MemoryTests.hpp"
 
+#include <Core/Logger.hpp>
+#include <Memory/MpmcQueue.hpp>
 #include <Memory/PoolAllocator.hpp>
+#include <Memory/SpscRing.hpp>
 #include <Memory/StackAllocator.hpp>
 
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
 namespace Phoenix { namespace Tests
 {
 	void runMemoryTests()
 	{
 		poolTest();
 		stackTest();
+		spscRingTest();
+		mpmcQueueTest();
+	}
+
+	void runMemoryStressTests()
+	{
+		spscRingStressTest();
+		mpmcQueueStressTest();
+	}
+
+	void runMemoryBenchmarks()
+	{
+		queueThroughputBenchmark();
+		queueLatencyBenchmark();
 	}
 
 	void poolTest()
@@ -45,4 +71,438 @@ namespace Phoenix { namespace Tests
 			stack.allocate(32, 2);
 		}*/
 	}
+
+	void spscRingTest()
+	{
+		SpscRing<int, 8> ring;
+		int item = -1;
+
+		bool bPopped = ring.pop(&item);
+		assert(ring.isEmpty() && ring.capacity() == 8 && !bPopped);
+
+		// Full means full, the oldest items stay.
+		for (int i = 0; i < 8; ++i)
+		{
+			bool bPushed = ring.push(i);
+			assert(bPushed);
+		}
+
+		bool bPushed = ring.push(8);
+		assert(!bPushed && ring.size() == 8);
+		bPopped = ring.pop(&item);
+		assert(bPopped && item == 0);
+		bPushed = ring.push(8);
+		bool bPushedFull = ring.push(9);
+		assert(bPushed && !bPushedFull);
+
+		int items[16];
+		size_t numPopped = ring.popBatch(items, 16);
+		assert(numPopped == 8);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			assert(items[i] == i + 1);
+		}
+
+		numPopped = ring.popBatch(items, 16);
+		assert(ring.isEmpty() && numPopped == 0);
+
+		// Batches across the end of the buffer, cut to what fits.
+		for (int round = 0; round < 10; ++round)
+		{
+			int batch[6];
+
+			for (int i = 0; i < 6; ++i)
+			{
+				batch[i] = round * 6 + i;
+			}
+
+			size_t numPushed = ring.pushBatch(batch, 6);
+			size_t numPushedFull = ring.pushBatch(batch, 6);
+			assert(numPushed == 6 && numPushedFull == 2);
+			numPopped = ring.popBatch(items, 8);
+			assert(numPopped == 8);
+			assert(items[0] == round * 6 && items[5] == round * 6 + 5 && items[6] == round * 6 && items[7] == round * 6 + 1);
+		}
+	}
+
+	void mpmcQueueTest()
+	{
+		MpmcQueue<int, 8> queue;
+		int item = -1;
+
+		bool bPopped = queue.pop(&item);
+		assert(queue.isEmpty() && queue.capacity() == 8 && !bPopped);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			bool bPushed = queue.push(i);
+			assert(bPushed);
+		}
+
+		bool bPushed = queue.push(8);
+		assert(!bPushed && queue.size() == 8);
+		bPopped = queue.pop(&item);
+		assert(bPopped && item == 0);
+		bPushed = queue.push(8);
+		bool bPushedFull = queue.push(9);
+		assert(bPushed && !bPushedFull);
+
+		int items[16];
+		size_t numPopped = queue.popBatch(items, 16);
+		assert(numPopped == 8);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			assert(items[i] == i + 1);
+		}
+
+		numPopped = queue.popBatch(items, 16);
+		assert(queue.isEmpty() && numPopped == 0);
+
+		for (int round = 0; round < 10; ++round)
+		{
+			int batch[6];
+
+			for (int i = 0; i < 6; ++i)
+			{
+				batch[i] = round * 6 + i;
+			}
+
+			size_t numPushed = queue.pushBatch(batch, 6);
+			size_t numPushedFull = queue.pushBatch(batch, 6);
+			assert(numPushed == 6 && numPushedFull == 2);
+			numPopped = queue.popBatch(items, 3);
+			size_t numPoppedRest = queue.popBatch(items + 3, 8);
+			assert(numPopped == 3 && numPoppedRest == 5);
+			assert(items[0] == round * 6 && items[5] == round * 6 + 5 && items[6] == round * 6 && items[7] == round * 6 + 1);
+		}
+	}
+
+	void spscRingStressTest()
+	{
+		const uint32_t numItems = 1000000;
+		std::unique_ptr<SpscRing<uint32_t, 256>> ring(new SpscRing<uint32_t, 256>());
+
+		std::thread producer([&ring]()
+		{
+			std::mt19937 rng(1);
+			uint32_t batch[64];
+			uint32_t next = 0;
+
+			while (next < numItems)
+			{
+				const uint32_t count = std::min<uint32_t>(rng() % 64 + 1, numItems - next);
+
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					batch[i] = next + i;
+				}
+
+				const size_t numPushed = ring->pushBatch(batch, count);
+				next += static_cast<uint32_t>(numPushed);
+
+				if (numPushed == 0)
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		std::mt19937 rng(2);
+		uint32_t batch[64];
+		uint32_t expected = 0;
+
+		while (expected < numItems)
+		{
+			const size_t numPopped = ring->popBatch(batch, rng() % 64 + 1);
+
+			for (size_t i = 0; i < numPopped; ++i)
+			{
+				assert(batch[i] == expected);
+				++expected;
+			}
+
+			if (numPopped == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		producer.join();
+		assert(ring->isEmpty());
+	}
+
+	void mpmcQueueStressTest()
+	{
+		const int numProducers = 3;
+		const int numConsumers = 3;
+		const uint32_t itemsPerProducer = 300000;
+
+		typedef MpmcQueue<uint64_t, 128> Queue;
+		std::unique_ptr<Queue> queue(new Queue());
+
+		std::vector<std::atomic<uint8_t>> seen(numProducers * itemsPerProducer);
+
+		for (std::atomic<uint8_t>& s : seen)
+		{
+			s = 0;
+		}
+
+		std::atomic<uint32_t> numConsumed(0);
+		std::vector<std::thread> threads;
+
+		// Items are the producer in the high bits and its counter in the low ones.
+		for (int p = 0; p < numProducers; ++p)
+		{
+			threads.emplace_back([&queue, p]()
+			{
+				std::mt19937 rng(p);
+				uint64_t batch[16];
+				uint32_t next = 0;
+
+				while (next < itemsPerProducer)
+				{
+					const uint32_t count = std::min<uint32_t>(rng() % 16 + 1, itemsPerProducer - next);
+
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						batch[i] = (uint64_t(p) << 32) | (next + i);
+					}
+
+					const size_t numPushed = queue->pushBatch(batch, count);
+					next += static_cast<uint32_t>(numPushed);
+
+					if (numPushed == 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		// Each consumer sees the items of a producer in the order they were pushed.
+		for (int c = 0; c < numConsumers; ++c)
+		{
+			threads.emplace_back([&queue, &seen, &numConsumed, c]()
+			{
+				std::mt19937 rng(100 + c);
+				int64_t lastOf[numProducers];
+				uint64_t batch[16];
+
+				for (int p = 0; p < numProducers; ++p)
+				{
+					lastOf[p] = -1;
+				}
+
+				while (numConsumed < numProducers * itemsPerProducer)
+				{
+					const size_t numPopped = queue->popBatch(batch, rng() % 16 + 1);
+
+					for (size_t i = 0; i < numPopped; ++i)
+					{
+						const int producer = static_cast<int>(batch[i] >> 32);
+						const int64_t index = static_cast<int64_t>(batch[i] & 0xffffffff);
+
+						assert(producer < numProducers && index > lastOf[producer]);
+						lastOf[producer] = index;
+						++seen[producer * itemsPerProducer + index];
+					}
+
+					numConsumed += static_cast<uint32_t>(numPopped);
+
+					if (numPopped == 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (const std::atomic<uint8_t>& s : seen)
+		{
+			assert(s == 1);
+		}
+
+		assert(queue->isEmpty());
+	}
+
+	// Moves numItems from the producers to the consumers, batchSize at a time. Returns milliseconds.
+	template <typename Queue>
+	static double runQueueThroughput(Queue* queue, int numProducers, int numConsumers, uint64_t numItems, size_t batchSize)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		std::atomic<uint64_t> numConsumed(0);
+		std::atomic<uint64_t> checksum(0);
+		std::vector<std::thread> threads;
+
+		const Clock::time_point start = Clock::now();
+
+		for (int p = 0; p < numProducers; ++p)
+		{
+			threads.emplace_back([=]()
+			{
+				std::vector<uint64_t> batch(batchSize);
+				const uint64_t count = numItems / numProducers + (p == 0 ? numItems % numProducers : 0);
+				uint64_t next = 0;
+
+				while (next < count)
+				{
+					const size_t n = static_cast<size_t>(std::min<uint64_t>(batchSize, count - next));
+
+					for (size_t i = 0; i < n; ++i)
+					{
+						batch[i] = next + i;
+					}
+
+					const size_t numPushed = queue->pushBatch(batch.data(), n);
+					next += numPushed;
+
+					if (numPushed == 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (int c = 0; c < numConsumers; ++c)
+		{
+			threads.emplace_back([=, &numConsumed, &checksum]()
+			{
+				std::vector<uint64_t> batch(batchSize);
+				uint64_t sum = 0;
+
+				while (numConsumed < numItems)
+				{
+					const size_t numPopped = queue->popBatch(batch.data(), batchSize);
+
+					for (size_t i = 0; i < numPopped; ++i)
+					{
+						sum += batch[i];
+					}
+
+					numConsumed += numPopped;
+
+					if (numPopped == 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+
+				checksum += sum;
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		return Ms(Clock::now() - start).count();
+	}
+
+	void queueThroughputBenchmark()
+	{
+		const uint64_t numItems = 4000000;
+		typedef SpscRing<uint64_t, 4096> Ring;
+		typedef MpmcQueue<uint64_t, 4096> Queue;
+
+		Logger::logf("Queue throughput, %llu items of 8 bytes, %u hardware threads:",
+			static_cast<unsigned long long>(numItems), std::thread::hardware_concurrency());
+
+		const size_t batchSizes[] = { 1, 32 };
+
+		for (size_t batchSize : batchSizes)
+		{
+			std::unique_ptr<Ring> ring(new Ring());
+			const double ms = runQueueThroughput(ring.get(), 1, 1, numItems, batchSize);
+			Logger::logf("  SPSC ring 1:1, batches of %zu: %.1f M items/s", batchSize, numItems / ms / 1000.0);
+		}
+
+		const int counts[][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 1, 4 }, { 4, 1 } };
+
+		for (size_t batchSize : batchSizes)
+		{
+			for (const int* count : counts)
+			{
+				std::unique_ptr<Queue> queue(new Queue());
+				const double ms = runQueueThroughput(queue.get(), count[0], count[1], numItems, batchSize);
+				Logger::logf("  MPMC queue %d:%d, batches of %zu: %.1f M items/s", count[0], count[1], batchSize, numItems / ms / 1000.0);
+			}
+		}
+	}
+
+	// Round trips of one item through a queue there and another one back.
+	template <typename Queue>
+	static double runQueuePingPong(Queue* there, Queue* back, int numRoundTrips)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ns = std::chrono::duration<double, std::nano>;
+
+		std::thread echo([=]()
+		{
+			uint64_t item;
+
+			for (int i = 0; i < numRoundTrips; ++i)
+			{
+				while (!there->pop(&item))
+				{
+					std::this_thread::yield();
+				}
+
+				while (!back->push(item))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		const Clock::time_point start = Clock::now();
+		uint64_t item;
+
+		for (int i = 0; i < numRoundTrips; ++i)
+		{
+			while (!there->push(static_cast<uint64_t>(i)))
+			{
+				std::this_thread::yield();
+			}
+
+			while (!back->pop(&item))
+			{
+				std::this_thread::yield();
+			}
+
+			assert(item == static_cast<uint64_t>(i));
+		}
+
+		const double ns = Ns(Clock::now() - start).count();
+		echo.join();
+		return ns / numRoundTrips;
+	}
+
+	void queueLatencyBenchmark()
+	{
+		const int numRoundTrips = 100000;
+		typedef SpscRing<uint64_t, 64> Ring;
+		typedef MpmcQueue<uint64_t, 64> Queue;
+
+		std::unique_ptr<Ring> ringThere(new Ring());
+		std::unique_ptr<Ring> ringBack(new Ring());
+		const double ringNs = runQueuePingPong(ringThere.get(), ringBack.get(), numRoundTrips);
+
+		std::unique_ptr<Queue> queueThere(new Queue());
+		std::unique_ptr<Queue> queueBack(new Queue());
+		const double queueNs = runQueuePingPong(queueThere.get(), queueBack.get(), numRoundTrips);
+
+		Logger::logf("Queue latency, %d round trips between two threads: SPSC ring %.0f ns, MPMC queue %.0f ns",
+			numRoundTrips, ringNs, queueNs);
+	}
 } }
\ No newline at end of file
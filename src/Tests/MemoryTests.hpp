@@ -4,7 +4,23 @@ namespace Phoenix { namespace Tests
 {
 	void runMemoryTests();
 
+	void runMemoryStressTests();
+
+	void runMemoryBenchmarks();
+
 	void poolTest();
 
 	void stackTest();
+
+	void spscRingTest();
+
+	void mpmcQueueTest();
+
+	void spscRingStressTest();
+
+	void mpmcQueueStressTest();
+
+	void queueThroughputBenchmark();
+
+	void queueLatencyBenchmark();
 } }
\ No newline at end of file
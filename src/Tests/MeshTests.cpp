@@ -0,0 +1,1244 @@
+#include "MeshTests.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <array>
+#include <set>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <Core/Mesh.hpp>
+#include <Core/MeshOptimize.hpp>
+#include <Core/MeshQuantize.hpp>
+#include <Core/MeshSimplify.hpp>
+#include <Core/MeshLod.hpp>
+#include <Core/Logger.hpp>
+#include <Math/PhiMath.hpp>
+#include <Core/Serialize.hpp>
+#include <Core/Compression.hpp>
+#include <Core/Windows/PlatformWindows.hpp>
+#include <Render/RIRecording/RIDeviceRecording.hpp>
+#include <Render/RIRecording/RIRecordingResourceStore.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	void runMeshTests()
+	{
+		weldVerticesTest();
+		meshIndexSerializeTest();
+		vertexCacheOptimizeTest();
+		vertexFetchOptimizeTest();
+		halfFloatTest();
+		vertexQuantizeTest();
+		packedMeshSerializeTest();
+		meshSimplifyTest();
+		lodSelectionTest();
+	}
+
+	void runMeshFileTests()
+	{
+		mappedArchiveTest();
+		meshViewSerializeTest();
+	}
+
+	void runMeshBenchmarks()
+	{
+		vertexQuantizeBenchmark();
+		archiveLoadBenchmark();
+		meshViewLoadBenchmark();
+		compressedMeshLoadBenchmark();
+	}
+
+	// Adds one face corner to a mesh that is not indexed yet.
+	static void addCorner(MeshData& data, const Vec3& position, const Vec2& uv, const Vec3& tangent, float handedness)
+	{
+		data.m_vertices.push_back(position);
+		data.m_normals.push_back(Vec3(0.f, 0.f, 1.f));
+		data.m_texCoords.push_back(uv);
+		data.m_tangents.push_back(Vec4(tangent, handedness));
+		data.m_numVertices++;
+	}
+
+	void weldVerticesTest()
+	{
+		MeshData data;
+
+		// A quad made from two triangles shares two corners.
+		addCorner(data, Vec3(0.f, 0.f, 0.f), Vec2(0.f, 0.f), Vec3(1.f, 0.f, 0.f), 1.f);
+		addCorner(data, Vec3(1.f, 0.f, 0.f), Vec2(1.f, 0.f), Vec3(1.f, 0.f, 0.f), 1.f);
+		addCorner(data, Vec3(1.f, 1.f, 0.f), Vec2(1.f, 1.f), Vec3(1.f, 0.f, 0.f), 1.f);
+
+		addCorner(data, Vec3(0.f, 0.f, 0.f), Vec2(0.f, 0.f), Vec3(0.f, 1.f, 0.f), 1.f);
+		addCorner(data, Vec3(1.f, 1.f, 0.f), Vec2(1.f, 1.f), Vec3(0.f, 1.f, 0.f), 1.f);
+		addCorner(data, Vec3(0.f, 1.f, 0.f), Vec2(0.f, 1.f), Vec3(0.f, 1.f, 0.f), 1.f);
+
+		// Same position and uv but mirrored tangent space must stay separate.
+		addCorner(data, Vec3(0.f, 1.f, 0.f), Vec2(0.f, 1.f), Vec3(1.f, 0.f, 0.f), -1.f);
+
+		weldVertices(&data);
+
+		assert(data.m_numVertices == 5);
+		assert(data.m_vertices.size() == 5);
+		assert(data.m_tangents.size() == 5);
+		assert(data.m_indices.size() == 7);
+
+		const uint32_t expected[7] = { 0, 1, 2, 0, 2, 3, 4 };
+		for (size_t i = 0; i < 7; ++i)
+		{
+			assert(data.m_indices[i] == expected[i]);
+		}
+
+		// Shared corners average the tangents of their faces.
+		const Vec4& shared = data.m_tangents[0];
+		float invSqrt2 = 1.f / sqrtf(2.f);
+		assert(fabsf(shared.x - invSqrt2) < 1e-5f);
+		assert(fabsf(shared.y - invSqrt2) < 1e-5f);
+		assert(fabsf(shared.z) < 1e-5f);
+		assert(data.m_tangents[4].w == -1.f);
+
+		assert(data.getIndexSizeBytes() == sizeof(uint16_t));
+	}
+
+	static void serializeRoundTrip(MeshData& data, MeshData* outData, size_t* outNumBytes)
+	{
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+		serialize(&writeAr, data);
+
+		ReadArchive readAr;
+		readAr.m_data = writeAr.m_data;
+		readAr.m_size = writeAr.m_numBytesWritten;
+		readAr.m_numBytesRead = 0;
+
+		serialize(&readAr, *outData);
+		*outNumBytes = writeAr.m_numBytesWritten;
+
+		destroyArchive(writeAr);
+	}
+
+	void meshIndexSerializeTest()
+	{
+		MeshData small;
+		small.setSize(3);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			small.m_vertices.push_back(Vec3(static_cast<float>(i)));
+			small.m_normals.push_back(Vec3(0.f, 1.f, 0.f));
+			small.m_tangents.push_back(Vec4(1.f, 0.f, 0.f, 1.f));
+			small.m_texCoords.push_back(Vec2(0.f));
+			small.m_indices.push_back(static_cast<uint32_t>(2 - i));
+		}
+
+		MeshData loaded;
+		size_t smallBytes = 0;
+		serializeRoundTrip(small, &loaded, &smallBytes);
+
+		assert(loaded.m_numVertices == 3);
+		assert(loaded.m_indices == small.m_indices);
+
+		// Meshes with more vertices than 16 bit indices can address keep 32 bit indices.
+		MeshData large;
+		large.m_numVertices = UINT16_MAX + 2;
+		large.m_indices.push_back(UINT16_MAX + 1);
+		large.m_indices.push_back(0);
+		large.m_indices.push_back(1);
+		assert(large.getIndexSizeBytes() == sizeof(uint32_t));
+
+		MeshData loadedLarge;
+		size_t largeBytes = 0;
+		serializeRoundTrip(large, &loadedLarge, &largeBytes);
+
+		assert(loadedLarge.m_indices == large.m_indices);
+
+		// Compared without vertex streams, their padding depends on the number of vertices.
+		MeshData smallIndices;
+		smallIndices.m_numVertices = 3;
+		smallIndices.m_indices = large.m_indices;
+		smallIndices.m_indices[0] = 2;
+
+		MeshData loadedSmallIndices;
+		size_t smallIndexBytes = 0;
+		serializeRoundTrip(smallIndices, &loadedSmallIndices, &smallIndexBytes);
+
+		assert(smallBytes > smallIndexBytes);
+		assert(largeBytes == smallIndexBytes + 3 * (sizeof(uint32_t) - sizeof(uint16_t)));
+	}
+
+	// Builds a gridSize x gridSize vertex grid with its triangles in random order.
+	static void createShuffledGrid(MeshData& data, size_t gridSize, uint32_t seed)
+	{
+		data.setSize(gridSize * gridSize);
+
+		for (size_t y = 0; y < gridSize; ++y)
+		{
+			for (size_t x = 0; x < gridSize; ++x)
+			{
+				data.m_vertices.push_back(Vec3(static_cast<float>(x), static_cast<float>(y), 0.f));
+				data.m_normals.push_back(Vec3(0.f, 0.f, 1.f));
+				data.m_tangents.push_back(Vec4(1.f, 0.f, 0.f, 1.f));
+				data.m_texCoords.push_back(Vec2(static_cast<float>(x), static_cast<float>(y)));
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (uint32_t y = 0; y + 1 < gridSize; ++y)
+		{
+			for (uint32_t x = 0; x + 1 < gridSize; ++x)
+			{
+				uint32_t v = y * static_cast<uint32_t>(gridSize) + x;
+				uint32_t up = v + static_cast<uint32_t>(gridSize);
+				triangles.push_back({ { v, v + 1, up + 1 } });
+				triangles.push_back({ { v, up + 1, up } });
+			}
+		}
+
+		std::mt19937 rng(seed);
+		std::shuffle(triangles.begin(), triangles.end(), rng);
+
+		for (const std::array<uint32_t, 3>& triangle : triangles)
+		{
+			data.m_indices.insert(data.m_indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	// Sorted triangles of an index range with their corners rotated to start at the smallest index.
+	static std::vector<std::array<uint32_t, 3>> getTriangleSet(const uint32_t* indices, size_t numIndices)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+
+		for (size_t i = 0; i < numIndices; i += 3)
+		{
+			std::array<uint32_t, 3> triangle = { { indices[i], indices[i + 1], indices[i + 2] } };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	void vertexCacheOptimizeTest()
+	{
+		MeshData data;
+		createShuffledGrid(data, 64, 1234);
+
+		std::vector<uint32_t> original = data.m_indices;
+		size_t numIndices = original.size();
+		uint32_t* indices = data.m_indices.data();
+
+		float acmrBefore = computeACMR(indices, numIndices, data.m_numVertices);
+		optimizeVertexCache(indices, numIndices, data.m_numVertices);
+		float acmrAfter = computeACMR(indices, numIndices, data.m_numVertices);
+
+		// Random order barely reuses anything, an optimized grid gets close to one vertex per two triangles.
+		assert(acmrBefore > 2.f);
+		assert(acmrAfter < 0.9f);
+		assert(getTriangleSet(indices, numIndices) == getTriangleSet(original.data(), numIndices));
+
+		// Two material ranges, the split point has to be a multiple of three.
+		data.m_indices = original;
+		indices = data.m_indices.data();
+		size_t split = (numIndices / 3 / 3) * 3;
+
+		optimizeVertexCache(indices, split, data.m_numVertices);
+		optimizeVertexCache(indices + split, numIndices - split, data.m_numVertices);
+
+		// Triangles never leave their range and keep their winding.
+		assert(getTriangleSet(indices, split) == getTriangleSet(original.data(), split));
+		assert(getTriangleSet(indices + split, numIndices - split) == getTriangleSet(original.data() + split, numIndices - split));
+
+		// A triangle list without reuse misses three times per triangle.
+		const uint32_t unshared[6] = { 0, 1, 2, 3, 4, 5 };
+		assert(computeACMR(unshared, 6, 6) == 3.f);
+	}
+
+	void vertexFetchOptimizeTest()
+	{
+		MeshData data;
+		createShuffledGrid(data, 16, 42);
+
+		// An unreferenced vertex ends up behind all referenced ones.
+		data.m_vertices.push_back(Vec3(-1.f));
+		data.m_normals.push_back(Vec3(0.f, 0.f, 1.f));
+		data.m_tangents.push_back(Vec4(1.f, 0.f, 0.f, 1.f));
+		data.m_texCoords.push_back(Vec2(-1.f));
+		data.m_numVertices++;
+
+		std::vector<uint32_t> original = data.m_indices;
+
+		size_t rangeStart = 0;
+		MeshOptimizeStats stats = optimizeMesh(&data, &rangeStart, 1);
+
+		assert(stats.m_acmrAfter < stats.m_acmrBefore);
+		assert(data.m_vertices.size() == data.m_numVertices);
+		assert(data.m_texCoords.size() == data.m_numVertices);
+
+		// Grid positions identify the original vertex, so the remapped triangles have to match the original ones.
+		std::vector<uint32_t> gridIndices;
+		for (uint32_t index : data.m_indices)
+		{
+			const Vec3& position = data.m_vertices[index];
+			assert(data.m_texCoords[index].x == position.x);
+			gridIndices.push_back(static_cast<uint32_t>(position.y) * 16 + static_cast<uint32_t>(position.x));
+		}
+
+		assert(getTriangleSet(gridIndices.data(), gridIndices.size()) == getTriangleSet(original.data(), original.size()));
+
+		// Vertices are stored in the order of first use.
+		uint32_t nextNew = 0;
+		for (uint32_t index : data.m_indices)
+		{
+			assert(index <= nextNew);
+			if (index == nextNew)
+			{
+				nextNew++;
+			}
+		}
+
+		assert(data.m_vertices.back().x == -1.f);
+	}
+
+	void halfFloatTest()
+	{
+		assert(floatToHalf(0.f) == 0x0000);
+		assert(floatToHalf(-0.f) == 0x8000);
+		assert(floatToHalf(1.f) == 0x3C00);
+		assert(floatToHalf(-2.f) == 0xC000);
+		assert(floatToHalf(0.5f) == 0x3800);
+		assert(floatToHalf(65504.f) == 0x7BFF);
+
+		// Values that round past the largest half become infinity.
+		assert(floatToHalf(65520.f) == 0x7C00);
+		assert(floatToHalf(1e10f) == 0x7C00);
+
+		// Smallest denormal and a tie that rounds to even.
+		assert(floatToHalf(ldexpf(1.f, -24)) == 0x0001);
+		assert(floatToHalf(1.f + ldexpf(1.f, -11)) == 0x3C00);
+		assert(floatToHalf(1.f + 3.f * ldexpf(1.f, -11)) == 0x3C02);
+
+		for (uint32_t half = 0; half < 0x7C00; ++half)
+		{
+			uint16_t value = static_cast<uint16_t>(half);
+			assert(floatToHalf(halfToFloat(value)) == value);
+			assert(floatToHalf(-halfToFloat(value)) == (value | 0x8000));
+		}
+	}
+
+	// UV sphere with alternating tangent handedness, rings x segments vertices.
+	static void createSphere(MeshData& data, size_t rings, size_t segments, float radius)
+	{
+		data.setSize(rings * segments);
+
+		for (size_t ring = 0; ring < rings; ++ring)
+		{
+			float v = static_cast<float>(ring) / (rings - 1);
+			float theta = v * PI;
+
+			for (size_t segment = 0; segment < segments; ++segment)
+			{
+				float u = static_cast<float>(segment) / (segments - 1);
+				float phi = u * 2.f * PI;
+
+				Vec3 normal(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+				Vec3 tangent(-sinf(phi), 0.f, cosf(phi));
+				float handedness = (segment & 1) ? -1.f : 1.f;
+
+				data.m_vertices.push_back(normal * radius + Vec3(3.f, -1.f, 0.5f));
+				data.m_normals.push_back(normal);
+				data.m_tangents.push_back(Vec4(tangent, handedness));
+				data.m_texCoords.push_back(Vec2(u, v));
+			}
+		}
+
+		for (uint32_t ring = 0; ring + 1 < rings; ++ring)
+		{
+			for (uint32_t segment = 0; segment + 1 < segments; ++segment)
+			{
+				uint32_t v = ring * static_cast<uint32_t>(segments) + segment;
+				uint32_t below = v + static_cast<uint32_t>(segments);
+				data.m_indices.insert(data.m_indices.end(), { v, below, v + 1, v + 1, below, below + 1 });
+			}
+		}
+	}
+
+	void vertexQuantizeTest()
+	{
+		assert(toSnorm16(1.f) == INT16_MAX && toSnorm16(-1.f) == -INT16_MAX && toSnorm16(2.f) == INT16_MAX);
+		assert(toUnorm16(1.f) == UINT16_MAX && toUnorm16(-1.f) == 0);
+
+		// The six axes land on corners and edge midpoints of the octahedron and decode exactly.
+		const Vec3 axes[6] = { Vec3(1.f, 0.f, 0.f), Vec3(-1.f, 0.f, 0.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, -1.f, 0.f), Vec3(0.f, 0.f, 1.f), Vec3(0.f, 0.f, -1.f) };
+		for (const Vec3& axis : axes)
+		{
+			Vec3 decoded = octDecode(octEncode(axis));
+			assert(decoded.x == axis.x && decoded.y == axis.y && decoded.z == axis.z);
+		}
+
+		const float radius = 10.f;
+
+		MeshData reference;
+		createSphere(reference, 128, 128, radius);
+
+		MeshData packed = reference;
+		VertexQuantizeError error = quantizeVertices(&packed, EVertexFormat::Packed);
+
+		assert(packed.m_vertexFormat == EVertexFormat::Packed);
+		assert(packed.getVertexSizeBytes() == 24);
+		assert(packed.m_packedPositions.empty());
+		assert(error.m_maxPositionError == 0.f);
+		assert(error.m_maxNormalErrorDeg < 0.01f);
+		assert(error.m_maxTangentErrorDeg < 0.02f);
+		assert(error.m_maxTexCoordError <= ldexpf(1.f, -12));
+		assert(error.m_numHandednessErrors == 0);
+
+		MeshData packedPositions = reference;
+		error = quantizeVertices(&packedPositions, EVertexFormat::PackedPositions);
+
+		assert(packedPositions.getVertexSizeBytes() == 20);
+		assert(reference.getVertexSizeBytes() == 48);
+		assert(error.m_numHandednessErrors == 0);
+
+		// Half a quantization step along each axis of the bounds.
+		float maxPositionError = 0.5f * sqrtf(3.f) * (2.f * radius) / UINT16_MAX;
+		assert(error.m_maxPositionError > 0.f && error.m_maxPositionError <= maxPositionError);
+
+		float minX = reference.m_vertices[0].x;
+		for (const Vec3& position : reference.m_vertices)
+		{
+			minX = std::min(minX, position.x);
+		}
+		assert(packedPositions.m_boundsMin.x == minX);
+
+		// The returned error matches the float streams left behind for the CPU.
+		for (size_t i = 0; i < reference.m_numVertices; ++i)
+		{
+			assert((packedPositions.m_vertices[i] - reference.m_vertices[i]).length() <= error.m_maxPositionError);
+			assert(packedPositions.m_tangents[i].w == reference.m_tangents[i].w);
+		}
+	}
+
+	void packedMeshSerializeTest()
+	{
+		MeshData data;
+		createSphere(data, 16, 16, 1.f);
+		quantizeVertices(&data, EVertexFormat::PackedPositions);
+
+		MeshData loaded;
+		size_t numBytes = 0;
+		serializeRoundTrip(data, &loaded, &numBytes);
+
+		assert(loaded.m_vertexFormat == EVertexFormat::PackedPositions);
+		assert(loaded.m_packedPositions == data.m_packedPositions);
+		assert(loaded.m_packedNormalTangents == data.m_packedNormalTangents);
+		assert(loaded.m_packedTexCoords == data.m_packedTexCoords);
+		assert(loaded.m_indices == data.m_indices);
+
+		// Decoding on load gives the same float streams as the encoder left behind.
+		for (size_t i = 0; i < data.m_numVertices; ++i)
+		{
+			assert(loaded.m_vertices[i] == data.m_vertices[i]);
+			assert(loaded.m_normals[i] == data.m_normals[i]);
+			assert(loaded.m_texCoords[i].x == data.m_texCoords[i].x && loaded.m_texCoords[i].y == data.m_texCoords[i].y);
+		}
+
+		// Only the packed streams are stored.
+		assert(numBytes < data.m_numVertices * 24 + data.m_indices.size() * sizeof(uint16_t) + 128);
+	}
+
+	void vertexQuantizeBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		MeshData reference;
+		createSphere(reference, 512, 512, 100.f);
+
+		const EVertexFormat formats[2] = { EVertexFormat::Packed, EVertexFormat::PackedPositions };
+		const char* formatNames[2] = { "Packed", "PackedPositions" };
+
+		Logger::logf("Vertex quantization, %zu vertices, Float: %zu vertex bytes (%zu per vertex)",
+			reference.m_numVertices, reference.m_numVertices * reference.getVertexSizeBytes(), reference.getVertexSizeBytes());
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			MeshData data = reference;
+
+			Clock::time_point start = Clock::now();
+			VertexQuantizeError error = quantizeVertices(&data, formats[i]);
+			double encodeMs = Ms(Clock::now() - start).count();
+
+			size_t vertexBytes = data.m_numVertices * data.getVertexSizeBytes();
+			double ratio = static_cast<double>(vertexBytes) / (reference.m_numVertices * reference.getVertexSizeBytes());
+
+			Logger::logf("  %s: %zu vertex bytes (%zu per vertex, %.1f%%), encode %.2f ms", 
+				formatNames[i], vertexBytes, data.getVertexSizeBytes(), ratio * 100.0, encodeMs);
+			Logger::logf("    max error position %f, normal %.4f deg, tangent %.4f deg, uv %f, %zu flipped handedness", 
+				error.m_maxPositionError, error.m_maxNormalErrorDeg, error.m_maxTangentErrorDeg, error.m_maxTexCoordError, error.m_numHandednessErrors);
+		}
+	}
+
+	// Vertices used by the triangles of an index range.
+	static std::set<uint32_t> getUsedVertices(const std::vector<uint32_t>& indices, size_t from, size_t count)
+	{
+		return std::set<uint32_t>(indices.begin() + from, indices.begin() + from + count);
+	}
+
+	void meshSimplifyTest()
+	{
+		// A flat grid simplifies without error down to the locked border.
+		MeshData grid;
+		createShuffledGrid(grid, 32, 7);
+
+		std::vector<uint32_t> simplified(grid.m_indices.size());
+		float error = -1.f;
+		size_t numSimplified = simplifyMesh(grid.m_vertices.data(), grid.m_numVertices, grid.m_indices.data(), grid.m_indices.size(),
+											0, 1e-4f, simplified.data(), &error);
+
+		assert(numSimplified < grid.m_indices.size() / 4);
+		assert(error < 1e-4f);
+
+		// The 124 border vertices of the grid are locked and stay in the result.
+		std::set<uint32_t> used = getUsedVertices(simplified, 0, numSimplified);
+		for (uint32_t i = 0; i < 32; ++i)
+		{
+			assert(used.count(i) && used.count(31 * 32 + i) && used.count(i * 32) && used.count(i * 32 + 31));
+		}
+
+		// A curved surface stops at the error limit.
+		MeshData sphere;
+		createSphere(sphere, 64, 64, 1.f);
+		simplified.resize(sphere.m_indices.size());
+
+		numSimplified = simplifyMesh(sphere.m_vertices.data(), sphere.m_numVertices, sphere.m_indices.data(), sphere.m_indices.size(),
+									 0, 0.01f, simplified.data(), &error);
+
+		assert(numSimplified > 0 && numSimplified < sphere.m_indices.size());
+		assert(error > 0.f && error <= 0.01f);
+
+		// LOD chain with two materials.
+		StaticMesh mesh;
+		mesh.m_name = "lodTest";
+		mesh.m_data = sphere;
+		mesh.m_numMaterials = 2;
+		mesh.m_indexFrom[0] = 0;
+		mesh.m_indexFrom[1] = (sphere.m_indices.size() / 3 / 2) * 3;
+
+		computeMeshBounds(&mesh);
+		assert(fabsf(mesh.m_boundsRadius - 1.f) < 1e-3f);
+
+		generateLods(&mesh);
+		assert(mesh.m_numLods == StaticMesh::MAX_LODS);
+
+		size_t previousNumIndices = mesh.m_data.m_indices.size();
+		float previousError = 0.f;
+
+		std::set<uint32_t> baseVertices[2];
+		for (uint8_t material = 0; material < 2; ++material)
+		{
+			size_t from = 0;
+			size_t count = 0;
+			getLodIndexRange(mesh, 0, material, &from, &count);
+			baseVertices[material] = getUsedVertices(mesh.m_data.m_indices, from, count);
+		}
+
+		std::vector<uint32_t> allIndices = mesh.m_data.m_indices;
+		allIndices.insert(allIndices.end(), mesh.m_lodIndices.begin(), mesh.m_lodIndices.end());
+
+		for (uint8_t lod = 1; lod < mesh.m_numLods; ++lod)
+		{
+			const StaticMesh::Lod& lodData = mesh.m_lods[lod - 1];
+
+			assert(lodData.m_numIndices < previousNumIndices);
+			assert(lodData.m_error >= previousError);
+			previousNumIndices = lodData.m_numIndices;
+			previousError = lodData.m_error;
+
+			size_t numLodIndices = 0;
+			const uint32_t* lodIndices = getLodIndices(mesh, lod, &numLodIndices);
+			assert(numLodIndices == lodData.m_numIndices);
+			assert(std::equal(lodIndices, lodIndices + numLodIndices, allIndices.begin() + lodData.m_indexFrom[0]));
+
+			// Triangles stay within their material and keep the vertices shared with the other material.
+			std::set<uint32_t> lodVertices[2];
+			for (uint8_t material = 0; material < 2; ++material)
+			{
+				size_t from = 0;
+				size_t count = 0;
+				getLodIndexRange(mesh, lod, material, &from, &count);
+				assert(count > 0 && count % 3 == 0);
+
+				lodVertices[material] = getUsedVertices(allIndices, from, count);
+
+				for (uint32_t vertex : lodVertices[material])
+				{
+					assert(baseVertices[material].count(vertex));
+				}
+			}
+
+			for (uint32_t vertex : baseVertices[0])
+			{
+				if (baseVertices[1].count(vertex))
+				{
+					assert(lodVertices[0].count(vertex) && lodVertices[1].count(vertex));
+				}
+			}
+		}
+
+		// LODs round trip through the mesh archive.
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+		serialize(&writeAr, mesh);
+
+		ReadArchive readAr;
+		readAr.m_data = writeAr.m_data;
+		readAr.m_size = writeAr.m_numBytesWritten;
+		readAr.m_numBytesRead = 0;
+
+		StaticMesh loaded;
+		serialize(&readAr, loaded);
+		destroyArchive(writeAr);
+
+		assert(loaded.m_numLods == mesh.m_numLods);
+		assert(loaded.m_lodIndices == mesh.m_lodIndices);
+		assert(loaded.m_lods[2].m_indexFrom[1] == mesh.m_lods[2].m_indexFrom[1]);
+		assert(loaded.m_lods[2].m_error == mesh.m_lods[2].m_error);
+	}
+
+	void lodSelectionTest()
+	{
+		// LOD 1 may be drawn up to 200 pixels, LOD 2 up to 50.
+		StaticMesh mesh;
+		mesh.m_numMaterials = 1;
+		mesh.m_numLods = 3;
+		mesh.m_boundsRadius = 1.f;
+		mesh.m_lods[0].m_error = 0.01f;
+		mesh.m_lods[1].m_error = 0.04f;
+
+		const float maxPixelError = 1.f;
+		const float hysteresis = 0.15f;
+
+		assert(getLodMaxScreenSize(mesh, 1, maxPixelError) == 200.f);
+		assert(getLodMaxScreenSize(mesh, 2, maxPixelError) == 50.f);
+
+		Vec3 up(0.f, 1.f, 0.f);
+		Vec3 target(0.f, 0.f, 0.f);
+		Matrix4 projection = perspectiveRH(60.f, 16.f / 9.f, 0.1f, 1000.f);
+		const float viewportHeight = 1080.f;
+
+		// Walks the camera away from the mesh and back, one step per frame.
+		std::vector<float> distances;
+		for (float distance = 2.f; distance < 80.f; distance *= 1.02f)
+		{
+			distances.push_back(distance);
+		}
+
+		std::vector<float> backwards(distances.rbegin(), distances.rend());
+		distances.insert(distances.end(), backwards.begin(), backwards.end());
+
+		uint8_t lod = 0;
+		uint8_t maxLod = 0;
+		size_t numSwitches = 0;
+		float switchDistances[2][2] = {};
+
+		for (size_t frame = 0; frame < distances.size(); ++frame)
+		{
+			Vec3 cameraPos(0.f, 0.f, distances[frame]);
+			Matrix4 view = lookAtRH(cameraPos, target, up);
+			Vec3 viewCenter(view * Vec4(0.f, 0.f, 0.f, 1.f));
+
+			float screenSize = getProjectedSize(viewCenter, mesh.m_boundsRadius, projection(1, 1), viewportHeight);
+			assert(fabsf(screenSize - projection(1, 1) * viewportHeight / distances[frame]) < 1e-2f);
+
+			uint8_t newLod = selectLod(mesh, screenSize, lod, maxPixelError, hysteresis);
+
+			if (newLod != lod)
+			{
+				// One level per switch, coarser while moving away and finer while coming back.
+				bool bMovingAway = frame < distances.size() / 2;
+				assert(bMovingAway ? newLod == lod + 1 : newLod + 1 == lod);
+
+				switchDistances[bMovingAway ? 0 : 1][bMovingAway ? lod : newLod] = distances[frame];
+				numSwitches++;
+			}
+
+			lod = newLod;
+			maxLod = std::max(maxLod, lod);
+
+			// The selected LOD never shows more than the allowed error plus the hysteresis band.
+			assert(screenSize <= getLodMaxScreenSize(mesh, lod, maxPixelError) * (1.f + hysteresis));
+		}
+
+		assert(maxLod == 2 && lod == 0);
+		assert(numSwitches == 4);
+
+		// Switching back to a finer LOD happens closer than switching away did.
+		assert(switchDistances[1][0] < switchDistances[0][0]);
+		assert(switchDistances[1][1] < switchDistances[0][1]);
+
+		// Sizes inside the hysteresis band keep the current LOD.
+		assert(selectLod(mesh, 190.f, 0, maxPixelError, hysteresis) == 0);
+		assert(selectLod(mesh, 190.f, 1, maxPixelError, hysteresis) == 1);
+		assert(selectLod(mesh, 220.f, 1, maxPixelError, hysteresis) == 1);
+		assert(selectLod(mesh, 240.f, 1, maxPixelError, hysteresis) == 0);
+		assert(selectLod(mesh, 10.f, 0, maxPixelError, hysteresis) == 2);
+	}
+
+	void mappedArchiveTest()
+	{
+		const char* path = "phoenix_mapped_archive_test.sm";
+
+		MeshData data;
+		createSphere(data, 40, 30, 2.f);
+
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+		serialize(&writeAr, data);
+		const EArchiveError writeErr = writeArchiveToDisk(path, writeAr);
+		assert(writeErr == EArchiveError::NoError);
+
+		const EReadMode modes[] = { EReadMode::Copy, EReadMode::Mapped };
+
+		for (EReadMode mode : modes)
+		{
+			ReadArchive readAr;
+			const EArchiveError err = createReadArchive(path, &readAr, mode);
+			assert(err == EArchiveError::NoError);
+			assert(readAr.m_size == writeAr.m_numBytesWritten && memcmp(readAr.m_data, writeAr.m_data, readAr.m_size) == 0);
+			assert((readAr.m_mappedFile.m_data != nullptr) == (mode == EReadMode::Mapped));
+
+			MeshData loaded;
+			serialize(&readAr, loaded);
+			assert(readAr.m_numBytesRead == readAr.m_size);
+			assert(loaded.m_numVertices == data.m_numVertices && loaded.m_indices == data.m_indices);
+			assert(memcmp(loaded.m_tangents.data(), data.m_tangents.data(), data.m_tangents.size() * sizeof(Vec4)) == 0);
+
+			destroyArchive(readAr);
+			assert(readAr.m_data == nullptr && readAr.m_mappedFile.m_data == nullptr);
+		}
+
+		destroyArchive(writeAr);
+
+		// Empty files cannot be mapped and are reported as empty either way.
+		WriteArchive emptyAr;
+		createWriteArchive(0, &emptyAr);
+		writeArchiveToDisk(path, emptyAr);
+		destroyArchive(emptyAr);
+
+		for (EReadMode mode : modes)
+		{
+			ReadArchive readAr;
+			const EArchiveError err = createReadArchive(path, &readAr, mode);
+			assert(err == EArchiveError::ReadEmpty);
+		}
+
+		remove(path);
+	}
+
+	void archiveLoadBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const int numMeshes = 8;
+
+		MeshData data;
+		createSphere(data, 512, 512, 100.f);
+
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+		serialize(&writeAr, data);
+
+		std::vector<std::string> paths;
+
+		for (int i = 0; i < numMeshes; ++i)
+		{
+			paths.push_back("phoenix_archive_benchmark_" + std::to_string(i) + ".sm");
+			writeArchiveToDisk(paths.back().c_str(), writeAr);
+		}
+
+		const double totalMB = numMeshes * writeAr.m_numBytesWritten / (1024.0 * 1024.0);
+		destroyArchive(writeAr);
+
+		Logger::logf("Archive loads, %d cooked meshes of %.1f MB:", numMeshes, totalMB / numMeshes);
+
+		const EReadMode modes[] = { EReadMode::Copy, EReadMode::Mapped };
+		const char* modeNames[] = { "copy", "mapped" };
+
+		for (int m = 0; m < 2; ++m)
+		{
+			for (int warm = 0; warm < 2; ++warm)
+			{
+				if (!warm)
+				{
+					for (const std::string& path : paths)
+					{
+						Platform::evictFileFromCache(path.c_str());
+					}
+				}
+
+				double openMs = 0.0;
+				size_t numVertices = 0;
+				const Clock::time_point start = Clock::now();
+
+				for (const std::string& path : paths)
+				{
+					const Clock::time_point openStart = Clock::now();
+					ReadArchive readAr;
+					createReadArchive(path.c_str(), &readAr, modes[m]);
+					openMs += Ms(Clock::now() - openStart).count();
+
+					MeshData loaded;
+					serialize(&readAr, loaded);
+					numVertices += loaded.m_numVertices;
+
+					destroyArchive(readAr);
+				}
+
+				const double ms = Ms(Clock::now() - start).count();
+				assert(numVertices == numMeshes * data.m_numVertices);
+
+				Logger::logf("  %s, %s cache: %.2f ms (%.0f MB/s), %.2f ms of it creating the archives",
+					modeNames[m], warm ? "warm" : "cold", ms, totalMB / (ms / 1000.0), openMs);
+			}
+		}
+
+		for (const std::string& path : paths)
+		{
+			remove(path.c_str());
+		}
+	}
+
+	// Reads every vertex like a driver filling a GPU buffer, and measures the memory of the process at
+	// that point of a mesh load.
+	class UploadTestDevice : public RIDeviceRecording
+	{
+	public:
+		UploadTestDevice(RIRecordingResourceStore* resources)
+			: RIDeviceRecording(resources)
+			, m_checksum(0)
+			, m_residentBytes(0)
+		{}
+
+		virtual VertexBufferHandle createVertexBuffer(const VertexBufferFormat& format) override
+		{
+			for (size_t i = 0; i < format.size(); ++i)
+			{
+				const VertexAttrib::Data& attrib = format.at(i)->m_data;
+				const uint8_t* bytes = static_cast<const uint8_t*>(attrib.m_data);
+
+				for (size_t b = 0; b < attrib.m_size * attrib.m_count; ++b)
+				{
+					m_checksum = m_checksum * 31 + bytes[b];
+				}
+			}
+
+			m_residentBytes = Platform::getResidentBytes();
+			return RIDeviceRecording::createVertexBuffer(format);
+		}
+
+		uint64_t m_checksum;
+		size_t m_residentBytes;
+	};
+
+	static bool isInArchive(const void* data, const ReadArchive& ar)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		return bytes >= ar.m_data && bytes < ar.m_data + ar.m_size;
+	}
+
+	void meshViewSerializeTest()
+	{
+		const char* path = "phoenix_mesh_view_test.sm";
+		const EVertexFormat formats[] = { EVertexFormat::Float, EVertexFormat::PackedPositions };
+
+		RIRecordingResourceStore* store = new RIRecordingResourceStore;
+		UploadTestDevice device(store);
+
+		for (EVertexFormat format : formats)
+		{
+			StaticMesh mesh;
+			createSphere(mesh.m_data, 20, 20, 1.f);
+			mesh.m_name = "viewTest";
+			mesh.m_numMaterials = 0;
+
+			if (format != EVertexFormat::Float)
+			{
+				quantizeVertices(&mesh.m_data, format);
+			}
+
+			const MeshData& data = mesh.m_data;
+
+			WriteArchive writeAr;
+			createWriteArchive(0, &writeAr);
+			writeStaticMeshHeader(&writeAr);
+			serialize(&writeAr, mesh);
+			EArchiveError err = writeArchiveToDisk(path, writeAr);
+			assert(err == EArchiveError::NoError);
+
+			// Uploads of the copying path to compare with.
+			ReadArchive copyAr;
+			err = createReadArchive(path, &copyAr, EReadMode::Copy);
+			assert(err == EArchiveError::NoError);
+			bool bHeader = readStaticMeshHeader(&copyAr);
+			assert(bHeader);
+			StaticMesh copied;
+			serialize(&copyAr, copied);
+			destroyArchive(copyAr);
+
+			device.m_checksum = 0;
+			createMeshBuffers(&copied, &device);
+			const uint64_t copiedChecksum = device.m_checksum;
+
+			ReadArchive readAr;
+			err = createReadArchive(path, &readAr, EReadMode::Mapped);
+			assert(err == EArchiveError::NoError);
+
+			StaticMesh loaded;
+			bHeader = readStaticMeshHeader(&readAr);
+			assert(bHeader);
+			deserializeWithViews(&readAr, loaded);
+			assert(readAr.m_numBytesRead == readAr.m_size);
+			assert(loaded.m_data.m_indices == data.m_indices && loaded.m_data.m_vertices == data.m_vertices);
+
+			const MeshData& viewed = loaded.m_data;
+
+			if (format == EVertexFormat::Float)
+			{
+				assert(viewed.m_normals.empty() && viewed.m_tangents.empty() && viewed.m_texCoords.empty());
+				assert(isInArchive(viewed.m_normalsView.data(), readAr) && isInArchive(viewed.m_tangentsView.data(), readAr));
+				assert(isInArchive(viewed.m_texCoordsView.data(), readAr));
+				assert(memcmp(viewed.m_tangentsView.data(), data.m_tangents.data(), data.m_tangents.size() * sizeof(Vec4)) == 0);
+			}
+			else
+			{
+				assert(viewed.m_packedPositions.empty() && viewed.m_packedNormalTangents.empty() && viewed.m_packedTexCoords.empty());
+				assert(isInArchive(viewed.m_packedPositionsView.data(), readAr) && isInArchive(viewed.m_packedNormalTangentsView.data(), readAr));
+				assert(memcmp(viewed.m_packedNormalTangentsView.data(), data.m_packedNormalTangents.data(), data.m_packedNormalTangents.size() * sizeof(int16_t)) == 0);
+
+				// Decoded from the views.
+				assert(viewed.m_normals.size() == data.m_numVertices && viewed.m_normals[7] == copied.m_data.m_normals[7]);
+			}
+
+			device.m_checksum = 0;
+			createMeshBuffers(&loaded, &device);
+			assert(device.m_checksum == copiedChecksum);
+
+			clearStreamViews(&loaded.m_data);
+			assert(viewed.m_normalsView.empty() && viewed.m_packedNormalTangentsView.empty());
+			destroyArchive(readAr);
+
+			// Streams not aligned in memory are copied.
+			std::vector<uint8_t> unaligned(writeAr.m_numBytesWritten + 1);
+			memcpy(&unaligned[1], writeAr.m_data, writeAr.m_numBytesWritten);
+
+			ReadArchive unalignedAr;
+			unalignedAr.m_data = &unaligned[1];
+			unalignedAr.m_size = writeAr.m_numBytesWritten;
+
+			StaticMesh fallback;
+			bHeader = readStaticMeshHeader(&unalignedAr);
+			assert(bHeader);
+			deserializeWithViews(&unalignedAr, fallback);
+
+			if (format == EVertexFormat::Float)
+			{
+				assert(fallback.m_data.m_normalsView.data() == fallback.m_data.m_normals.data());
+				assert(fallback.m_data.m_normals == data.m_normals);
+			}
+			else
+			{
+				assert(fallback.m_data.m_packedNormalTangentsView.data() == fallback.m_data.m_packedNormalTangents.data());
+				assert(fallback.m_data.m_packedNormalTangents == data.m_packedNormalTangents);
+			}
+
+			device.m_checksum = 0;
+			createMeshBuffers(&fallback, &device);
+			assert(device.m_checksum == copiedChecksum);
+
+			destroyArchive(writeAr);
+		}
+
+		{
+			// Files without the header or with another version are refused.
+			StaticMesh mesh;
+			createSphere(mesh.m_data, 4, 4, 1.f);
+			mesh.m_name = "headerTest";
+			mesh.m_numMaterials = 0;
+
+			WriteArchive writeAr;
+			createWriteArchive(0, &writeAr);
+			serialize(&writeAr, mesh);
+
+			ReadArchive readAr;
+			readAr.m_data = writeAr.m_data;
+			readAr.m_size = writeAr.m_numBytesWritten;
+			assert(!readStaticMeshHeader(&readAr));
+			destroyArchive(writeAr);
+
+			createWriteArchive(0, &writeAr);
+			writeStaticMeshHeader(&writeAr);
+			reinterpret_cast<uint32_t*>(writeAr.m_data)[1] = STATIC_MESH_FILE_VERSION + 1;
+
+			readAr = ReadArchive();
+			readAr.m_data = writeAr.m_data;
+			readAr.m_size = writeAr.m_numBytesWritten;
+			assert(!readStaticMeshHeader(&readAr));
+
+			// Too short for a header.
+			readAr = ReadArchive();
+			readAr.m_data = writeAr.m_data;
+			readAr.m_size = 4;
+			assert(!readStaticMeshHeader(&readAr));
+			destroyArchive(writeAr);
+		}
+
+		delete store;
+		remove(path);
+	}
+
+	void meshViewLoadBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const int numMeshes = 4;
+
+		StaticMesh mesh;
+		createSphere(mesh.m_data, 768, 768, 100.f);
+		mesh.m_name = "viewBenchmark";
+		mesh.m_numMaterials = 0;
+
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+		writeStaticMeshHeader(&writeAr);
+		serialize(&writeAr, mesh);
+
+		std::vector<std::string> paths;
+
+		for (int i = 0; i < numMeshes; ++i)
+		{
+			paths.push_back("phoenix_view_benchmark_" + std::to_string(i) + ".sm");
+			writeArchiveToDisk(paths.back().c_str(), writeAr);
+		}
+
+		const double fileMB = writeAr.m_numBytesWritten / (1024.0 * 1024.0);
+		destroyArchive(writeAr);
+
+		Logger::logf("Static mesh loads with buffer creation, %d meshes of %.1f MB, %zu vertices:", numMeshes, fileMB, mesh.m_data.m_numVertices);
+
+		struct Config
+		{
+			const char* m_name;
+			EReadMode m_mode;
+			bool m_bViews;
+		};
+
+		const Config configs[] = {
+			{ "copied archive, copied streams", EReadMode::Copy, false },
+			{ "mapped archive, copied streams", EReadMode::Mapped, false },
+			{ "mapped archive, viewed streams", EReadMode::Mapped, true }
+		};
+
+		for (const Config& config : configs)
+		{
+			for (int warm = 0; warm < 2; ++warm)
+			{
+				if (!warm)
+				{
+					for (const std::string& path : paths)
+					{
+						Platform::evictFileFromCache(path.c_str());
+					}
+				}
+
+				RIRecordingResourceStore* store = new RIRecordingResourceStore;
+				UploadTestDevice device(store);
+
+				double maxLoadMB = 0.0;
+				const Clock::time_point start = Clock::now();
+
+				for (const std::string& path : paths)
+				{
+					const size_t residentBefore = Platform::getResidentBytes();
+
+					ReadArchive readAr;
+					createReadArchive(path.c_str(), &readAr, config.m_mode);
+					readStaticMeshHeader(&readAr);
+
+					StaticMesh loaded;
+
+					if (config.m_bViews)
+					{
+						deserializeWithViews(&readAr, loaded);
+					}
+					else
+					{
+						serialize(&readAr, loaded);
+					}
+
+					computeMeshBounds(&loaded);
+					createMeshBuffers(&loaded, &device);
+					clearStreamViews(&loaded.m_data);
+					destroyArchive(readAr);
+
+					const double loadMB = (static_cast<double>(device.m_residentBytes) - static_cast<double>(residentBefore)) / (1024.0 * 1024.0);
+					maxLoadMB = std::max(maxLoadMB, loadMB);
+				}
+
+				const double ms = Ms(Clock::now() - start).count();
+				delete store;
+
+				Logger::logf("  %s, %s cache: %.2f ms per mesh, resident memory grew by up to %.1f MB during a load",
+					config.m_name, warm ? "warm" : "cold", ms / numMeshes, maxLoadMB);
+			}
+		}
+
+		Logger::logf("  Peak resident memory of the process: %.1f MB", Platform::getPeakResidentBytes() / (1024.0 * 1024.0));
+
+		for (const std::string& path : paths)
+		{
+			remove(path.c_str());
+		}
+	}
+
+	void compressedMeshLoadBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		// Slow disk the load times are estimated for, roughly a hard disk or a cheap SD card.
+		const double slowDiskMBps = 100.0;
+
+		// The same sphere with float and with packed vertices, like imported meshes.
+		StaticMesh meshes[2];
+		createSphere(meshes[0].m_data, 512, 512, 100.f);
+		meshes[1].m_data = meshes[0].m_data;
+		quantizeVertices(&meshes[1].m_data, EVertexFormat::Packed);
+
+		const char* formatNames[2] = { "float", "packed" };
+		std::vector<std::string> paths;
+
+		for (int i = 0; i < 2; ++i)
+		{
+			meshes[i].m_name = formatNames[i];
+			meshes[i].m_numMaterials = 0;
+			paths.push_back(std::string("phoenix_compressed_benchmark_") + formatNames[i] + ".sm");
+		}
+
+		Logger::logf("Compressed static mesh archives, %zu vertices, %d byte blocks, load estimated at %.0f MB/s:",
+			meshes[0].m_data.m_numVertices, COMPRESSED_BLOCK_SIZE, slowDiskMBps);
+
+		const ECompression levels[] = { ECompression::None, ECompression::Fast, ECompression::Strong };
+		const char* levelNames[] = { "none", "fast", "strong" };
+
+		for (int level = 0; level < 3; ++level)
+		{
+			size_t fileBytes = 0;
+			double writeMs = 0.0;
+
+			for (int i = 0; i < 2; ++i)
+			{
+				WriteArchive writeAr;
+				createWriteArchive(0, &writeAr);
+				writeStaticMeshHeader(&writeAr);
+				serialize(&writeAr, meshes[i]);
+
+				const Clock::time_point start = Clock::now();
+				writeArchiveToDisk(paths[i].c_str(), writeAr, levels[level]);
+				writeMs += Ms(Clock::now() - start).count();
+
+				const size_t archiveBytes = writeAr.m_numBytesWritten;
+				destroyArchive(writeAr);
+
+				CompressedArchive compressed;
+
+				if (openCompressedArchive(paths[i].c_str(), &compressed) == EArchiveError::NoError)
+				{
+					fileBytes += compressed.m_file.m_size;
+
+					// Decompression alone, best of a few runs on one thread.
+					std::vector<uint8_t> block(COMPRESSED_BLOCK_SIZE);
+					double bestMs = 1e9;
+
+					for (int run = 0; run < 5; ++run)
+					{
+						const Clock::time_point decodeStart = Clock::now();
+
+						for (size_t b = 0; b < compressed.m_header.m_numBlocks; ++b)
+						{
+							readCompressedBlock(compressed, b, block.data());
+						}
+
+						bestMs = std::min(bestMs, Ms(Clock::now() - decodeStart).count());
+					}
+
+					size_t numShuffled = 0;
+
+					for (size_t b = 0; b < compressed.m_header.m_numBlocks; ++b)
+					{
+						numShuffled += (compressed.m_blocks[b].m_flags & BLOCK_SHUFFLED) ? 1 : 0;
+					}
+
+					Logger::logf("  %s, %s vertices: %.1f MB -> %.1f MB (%.1f%%), %zu of %u blocks shuffled, decompresses at %.2f GB/s",
+						levelNames[level], formatNames[i], compressed.m_header.m_rawSize / 1e6, compressed.m_file.m_size / 1e6,
+						100.0 * compressed.m_file.m_size / compressed.m_header.m_rawSize, numShuffled, compressed.m_header.m_numBlocks,
+						compressed.m_header.m_rawSize / (bestMs * 1e6));
+
+					closeCompressedArchive(compressed);
+				}
+				else
+				{
+					fileBytes += archiveBytes;
+				}
+			}
+
+			// What loadStaticMesh() does for the asset registry, short of the registry itself.
+			double loadMs[2] = { 0.0, 0.0 };
+
+			for (int warm = 0; warm < 2; ++warm)
+			{
+				if (!warm)
+				{
+					for (const std::string& path : paths)
+					{
+						Platform::evictFileFromCache(path.c_str());
+					}
+				}
+
+				RIRecordingResourceStore* store = new RIRecordingResourceStore;
+				RIDeviceRecording device(store);
+				const Clock::time_point start = Clock::now();
+
+				for (const std::string& path : paths)
+				{
+					ReadArchive readAr;
+					createReadArchive(path.c_str(), &readAr);
+					readStaticMeshHeader(&readAr);
+
+					StaticMesh loaded;
+					deserializeWithViews(&readAr, loaded);
+					computeMeshBounds(&loaded);
+					createMeshBuffers(&loaded, &device);
+					clearStreamViews(&loaded.m_data);
+					destroyArchive(readAr);
+				}
+
+				loadMs[warm] = Ms(Clock::now() - start).count();
+				delete store;
+			}
+
+			Logger::logf("  %s: %.1f MB on disk, written in %.0f ms, loads in %.1f ms from the file cache, %.1f ms cold, ~%.0f ms at %.0f MB/s",
+				levelNames[level], fileBytes / 1e6, writeMs, loadMs[1], loadMs[0], loadMs[1] + fileBytes / (slowDiskMBps * 1e3), slowDiskMBps);
+		}
+
+		for (const std::string& path : paths)
+		{
+			remove(path.c_str());
+		}
+	}
+} }
\ No newline at end of file
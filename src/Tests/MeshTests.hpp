@@ -0,0 +1,40 @@
+#pragma once
+
+namespace Phoenix { namespace Tests
+{
+	void runMeshTests();
+
+	void runMeshFileTests();
+
+	void runMeshBenchmarks();
+
+	void weldVerticesTest();
+
+	void meshIndexSerializeTest();
+
+	void vertexCacheOptimizeTest();
+
+	void vertexFetchOptimizeTest();
+
+	void halfFloatTest();
+
+	void vertexQuantizeTest();
+
+	void packedMeshSerializeTest();
+
+	void meshSimplifyTest();
+
+	void lodSelectionTest();
+
+	void mappedArchiveTest();
+
+	void meshViewSerializeTest();
+
+	void vertexQuantizeBenchmark();
+
+	void archiveLoadBenchmark();
+
+	void meshViewLoadBenchmark();
+
+	void compressedMeshLoadBenchmark();
+} }
\ No newline at end of file
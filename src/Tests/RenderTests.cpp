@@ -0,0 +1,1499 @@
+#include "RenderTests.hpp"
+#include "TestUtil.hpp"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <Core/RadixSort.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Material.hpp>
+#include <Core/Mesh.hpp>
+#include <Core/SystemScheduler.hpp>
+#include <Core/Texture.hpp>
+#include <Core/WorkerPool.hpp>
+#include <Core/World.hpp>
+#include <Core/Components/CDirectionalLight.hpp>
+#include <Core/Components/CPointLight.hpp>
+#include <Core/Components/CStaticMesh.hpp>
+#include <Core/Components/CTransform.hpp>
+#include <Core/Systems/LightSystem.hpp>
+#include <Core/Systems/StaticMeshSystem.hpp>
+#include <Core/Systems/TransformSystem.hpp>
+#include <Math/Matrix4.hpp>
+#include <Math/PhiMath.hpp>
+#include <Render/CommandBucket.hpp>
+#include <Render/ClusteredLighting.hpp>
+#include <Render/CommandKey.hpp>
+#include <Render/Commands.hpp>
+#include <Render/DeferredRenderer.hpp>
+#include <Render/LightBuffer.hpp>
+#include <Render/FrustumCulling.hpp>
+#include <Render/OcclusionCulling.hpp>
+#include <Render/RIContext.hpp>
+#include <Render/RIOpenGL/GlStateFilter.hpp>
+#include <Render/RIRecording/RICommandLog.hpp>
+#include <Render/RIRecording/RIContextRecording.hpp>
+#include <Render/RIRecording/RIDeviceRecording.hpp>
+#include <Render/RIRecording/RIRecordingResourceStore.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	// Stand-in for a real context that only counts the calls it receives. Binds are
+	// counted twice, once for every call and once for every call that actually 
+	// changes the bound state, which is the work a GPU driver would have to do.
+	class CountingRIContext : public IRIContext
+	{
+	public:
+		CountingRIContext()
+			: m_numDraws(0)
+			, m_numProgramBinds(0)
+			, m_numProgramChanges(0)
+			, m_numTextureBinds(0)
+			, m_numTextureChanges(0)
+			, m_numUniformBinds(0)
+			, m_lastProgram(ProgramHandle::invalidValue())
+			, m_activeTextures(0)
+		{
+			for (size_t i = 0; i < MAX_UNITS; ++i)
+			{
+				m_boundTextures[i] = Texture2DHandle::invalidValue();
+			}
+		}
+
+		virtual void drawLinear(EPrimitive primitives, uint32_t count, uint32_t start) override { m_numDraws++; }
+
+		virtual void drawLinear(VertexBufferHandle vbHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex = 0) override { m_numDraws++; }
+
+		virtual void drawIndexed(VertexBufferHandle vbHandle, IndexBufferHandle ibHandle, EPrimitive primitives, uint32_t count = 0, uint32_t startIndex = 0) override { m_numDraws++; }
+
+		virtual void bindShaderProgram(ProgramHandle programHandle) override 
+		{
+			m_numProgramBinds++;
+
+			if (programHandle.m_idx != m_lastProgram)
+			{
+				m_numProgramChanges++;
+				m_lastProgram = programHandle.m_idx;
+			}
+		}
+
+		virtual void bindUniform(UniformHandle uniformHandle, const void* data) override { m_numUniformBinds++; }
+
+		virtual void bindVertexBuffer(VertexBufferHandle vbHandle) override {}
+
+		virtual void bindIndexBuffer(IndexBufferHandle ibHandle) override {}
+
+		virtual void clearRenderTargetColor(RenderTargetHandle rtHandle, const RGBA& clearColor) override {}
+
+		virtual void clearRenderTargetDepth(RenderTargetHandle rtHandle) override {}
+
+		virtual void uploadTextureData(Texture2DHandle handle, const void* data) override {}
+
+		virtual void uploadTextureData(TextureCubeHandle handle, ETextureCubeSide side, const void* data) override {}
+
+		virtual void bindTexture(UniformHandle samplerHandle, Texture2DHandle texHandle) override 
+		{
+			assert(m_activeTextures < MAX_UNITS);
+			m_numTextureBinds++;
+
+			if (m_boundTextures[m_activeTextures] != texHandle.m_idx)
+			{
+				m_numTextureChanges++;
+				m_boundTextures[m_activeTextures] = texHandle.m_idx;
+			}
+
+			m_activeTextures++;
+		}
+
+		virtual void bindTexture(UniformHandle samplerHandle, TextureCubeHandle texHandle) override {}
+
+		virtual void unbindTextures() override { m_activeTextures = 0; }
+
+		virtual void bindRenderTarget(RenderTargetHandle handle) override {}
+
+		virtual void bindDefaultRenderTarget() override {}
+
+		virtual void setDepthTest(EDepth state) override {}
+
+		virtual void setDepthWrite(EDepth state) override {}
+
+		virtual void setBlendState(const BlendState& state) override {}
+
+		virtual void clearColor() override {}
+
+		virtual void clearDepth() override {}
+
+		virtual void endPass() override {}
+
+		virtual uint32_t getMaxTextureUnits() const override { return MAX_UNITS; }
+
+		virtual void bindConstantBufferToLocation(ConstantBufferHandle cbHandle, uint32_t location) override {}
+
+		virtual void updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes = 0) override {}
+
+		virtual void bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location) override {}
+
+		virtual void updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes) override {}
+
+		enum { MAX_UNITS = 16 };
+
+		size_t m_numDraws;
+		size_t m_numProgramBinds;
+		size_t m_numProgramChanges;
+		size_t m_numTextureBinds;
+		size_t m_numTextureChanges;
+		size_t m_numUniformBinds;
+
+		size_t m_lastProgram;
+		size_t m_boundTextures[MAX_UNITS];
+		size_t m_activeTextures;
+	};
+
+	// Drives a GlStateFilter the way RIContextOpenGL does, with handle indices standing in 
+	// for GL ids. Id 0 is the default framebuffer, sampler locations are the uniform indices.
+	class StateFilterRIContext : public IRIContext
+	{
+	public:
+		enum { TEXTURE_2D = 1, TEXTURE_CUBE = 2 };
+
+		virtual void drawLinear(EPrimitive primitives, uint32_t count, uint32_t start) override {}
+
+		virtual void drawLinear(VertexBufferHandle vbHandle, EPrimitive primitives, uint32_t count, uint32_t startIndex = 0) override 
+		{
+			m_filter.changeVertexArray(vbHandle.m_idx + 1);
+		}
+
+		virtual void drawIndexed(VertexBufferHandle vbHandle, IndexBufferHandle ibHandle, EPrimitive primitives, uint32_t count = 0, uint32_t startIndex = 0) override
+		{
+			m_filter.changeVertexArray(vbHandle.m_idx + 1);
+			m_filter.changeIndexBuffer(ibHandle.m_idx + 1);
+		}
+
+		virtual void bindShaderProgram(ProgramHandle programHandle) override { m_filter.bindProgram(programHandle.m_idx + 1); }
+
+		virtual void bindUniform(UniformHandle uniformHandle, const void* data) override { m_filter.bindUniform(); }
+
+		virtual void bindVertexBuffer(VertexBufferHandle vbHandle) override { m_filter.bindVertexBuffer(vbHandle.m_idx + 1); }
+
+		virtual void bindIndexBuffer(IndexBufferHandle ibHandle) override { m_filter.bindIndexBuffer(ibHandle.m_idx + 1); }
+
+		virtual void clearRenderTargetColor(RenderTargetHandle rtHandle, const RGBA& clearColor) override { m_filter.changeFramebuffer(rtHandle.m_idx + 1); }
+
+		virtual void clearRenderTargetDepth(RenderTargetHandle rtHandle) override { m_filter.changeFramebuffer(rtHandle.m_idx + 1); }
+
+		virtual void uploadTextureData(Texture2DHandle handle, const void* data) override { m_filter.changeTexture(0, TEXTURE_2D, handle.m_idx + 1); }
+
+		virtual void uploadTextureData(TextureCubeHandle handle, ETextureCubeSide side, const void* data) override { m_filter.changeTexture(0, TEXTURE_CUBE, handle.m_idx + 1); }
+
+		virtual void bindTexture(UniformHandle samplerHandle, Texture2DHandle texHandle) override 
+		{
+			m_filter.bindTexture(TEXTURE_2D, texHandle.m_idx + 1, static_cast<int32_t>(samplerHandle.m_idx));
+		}
+
+		virtual void bindTexture(UniformHandle samplerHandle, TextureCubeHandle texHandle) override
+		{
+			m_filter.bindTexture(TEXTURE_CUBE, texHandle.m_idx + 1, static_cast<int32_t>(samplerHandle.m_idx));
+		}
+
+		virtual void unbindTextures() override { m_filter.releaseTextureUnits(); }
+
+		virtual void bindRenderTarget(RenderTargetHandle handle) override { m_filter.bindRenderTarget(handle.m_idx + 1); }
+
+		virtual void bindDefaultRenderTarget() override { m_filter.bindRenderTarget(0); }
+
+		virtual void setDepthTest(EDepth state) override { m_filter.setDepthTest(state); }
+
+		virtual void setDepthWrite(EDepth state) override { m_filter.setDepthWrite(state); }
+
+		virtual void setBlendState(const BlendState& state) override { m_filter.setBlendState(state); }
+
+		virtual void clearColor() override {}
+
+		virtual void clearDepth() override {}
+
+		virtual void endPass() override { m_filter.releaseTextureUnits(); }
+
+		virtual uint32_t getMaxTextureUnits() const override { return GlStateFilter::MAX_TEXTURE_UNITS; }
+
+		virtual void bindConstantBufferToLocation(ConstantBufferHandle cbHandle, uint32_t location) override { m_filter.bindConstantBuffer(location, cbHandle.m_idx + 1); }
+
+		virtual void updateConstantBuffer(ConstantBufferHandle cbHandle, const void* data, size_t numBytes, size_t offsetBytes = 0) override {}
+
+		virtual void bindStorageBufferToLocation(StorageBufferHandle sbHandle, uint32_t location) override { m_filter.bindStorageBuffer(location, sbHandle.m_idx + 1); }
+
+		virtual void updateStorageBuffer(StorageBufferHandle sbHandle, const void* data, size_t numBytes) override {}
+
+		GlStateFilter m_filter;
+	};
+
+	void runRenderTests()
+	{
+		radixSortTest();
+		commandKeyTest();
+		commandBucketOrderTest();
+		recordingContextTest();
+		deferredFrameTest();
+		glStateFilterTest();
+		frustumCullingTest();
+		occlusionCullingTest();
+		clusteredLightingTest();
+	}
+
+	void radixSortTest()
+	{
+		const size_t count = 4096;
+
+		std::vector<uint64_t> keys(count);
+		std::vector<uint32_t> values(count);
+		std::vector<uint64_t> tempKeys(count);
+		std::vector<uint32_t> tempValues(count);
+
+		srand(1337);
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Only a few distinct keys, so the sort has to be stable to pass.
+			keys[i] = (uint64_t(rand() % 16) << 48) | uint64_t(rand() % 4);
+			values[i] = static_cast<uint32_t>(i);
+		}
+
+		std::vector<std::pair<uint64_t, uint32_t>> expected(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			expected[i] = { keys[i], values[i] };
+		}
+
+		std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b)
+		{
+			return a.first < b.first;
+		});
+
+		radixSort(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert(keys[i] == expected[i].first);
+			assert(values[i] == expected[i].second);
+		}
+	}
+
+	void commandKeyTest()
+	{
+		CommandKey near = commandKey::create(0, ETranslucency::Opaque, 10, 3, 7);
+		CommandKey far = commandKey::create(0, ETranslucency::Opaque, 500, 1, 1);
+		CommandKey translucent = commandKey::create(0, ETranslucency::Translucent, 10, 0, 0);
+		CommandKey laterPass = commandKey::create(1, ETranslucency::Opaque, 0, 0, 0);
+
+		assert(near < far);
+		assert(far < translucent);
+		assert(translucent < laterPass);
+
+		assert(commandKey::getPass(laterPass) == 1);
+		assert(commandKey::getDepth(near) == 10);
+		assert(commandKey::getProgram(near) == 3);
+		assert(commandKey::getMaterial(near) == 7);
+
+		// Translucent draws sort back-to-front.
+		assert(commandKey::create(0, ETranslucency::Translucent, 500, 0, 0) < translucent);
+
+		assert(commandKey::quantizeDepth(0.0f, 0.1f, 1000.0f) == 0);
+		assert(commandKey::quantizeDepth(2000.0f, 0.1f, 1000.0f) == (1 << commandKey::DEPTH_BITS) - 1);
+		assert(commandKey::quantizeDepth(1.0f, 0.1f, 1000.0f) < commandKey::quantizeDepth(10.0f, 0.1f, 1000.0f));
+	}
+
+	void commandBucketOrderTest()
+	{
+		CommandBucket bucket(16, 4096);
+		CountingRIContext context;
+
+		// Added back-to-front, submitted front-to-back.
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			RIDrawLinearCommand* draw = bucket.addCommand<RIDrawLinearCommand>(commandKey::create(0, ETranslucency::Opaque, 100 - i, 0, 0));
+			draw->start = 0;
+			draw->count = 3;
+			draw->primitives = EPrimitive::Triangles;
+
+			RIBindTexture2DCommand* tex = bucket.appendCommand<RIBindTexture2DCommand>(draw);
+			tex->usingProgram = ProgramHandle(0);
+			tex->texture = Texture2DHandle(i);
+
+			bucket.appendCommand<RIUnbindTexturesCommand>(tex);
+		}
+
+		bucket.submit(&context);
+
+		assert(context.m_numDraws == 4);
+		assert(context.m_numTextureBinds == 4);
+		assert(context.m_numProgramChanges == 1);
+		assert(context.m_boundTextures[0] == 0);
+
+		// Commands past the capacity are dropped, a submit makes room again.
+		CommandBucket small(2, 4096);
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			RIDrawLinearCommand* draw = small.addCommand<RIDrawLinearCommand>(commandKey::create(0, ETranslucency::Opaque, i, 0, 0));
+			assert((draw != nullptr) == (i < 2));
+
+			if (draw)
+			{
+				draw->start = 0;
+				draw->count = 3;
+				draw->primitives = EPrimitive::Triangles;
+			}
+		}
+
+		CountingRIContext smallContext;
+		small.submit(&smallContext);
+		assert(smallContext.m_numDraws == 2);
+		RIDrawLinearCommand* afterSubmit = small.addCommand<RIDrawLinearCommand>(0);
+		assert(afterSubmit != nullptr);
+	}
+
+	struct RecordingTestResources
+	{
+		ProgramHandle program;
+		UniformHandle modelView;
+		UniformHandle sampler;
+		Texture2DHandle texture;
+		VertexBufferHandle vb;
+		IndexBufferHandle ib;
+		ConstantBufferHandle cb;
+		StorageBufferHandle sb;
+	};
+
+	static RecordingTestResources createRecordingTestResources(IRIDevice* device)
+	{
+		RecordingTestResources res;
+
+		res.program = device->createProgram(device->createVertexShader(""), device->createFragmentShader(""));
+		res.modelView = device->createUniform("modelView", EUniformType::Mat4);
+		res.sampler = device->createUniform("diffuse", EUniformType::Sampler2D);
+
+		TextureDesc desc;
+		desc.width = 4;
+		desc.height = 4;
+		desc.pixelFormat = EPixelFormat::R8G8B8A8;
+		res.texture = device->createTexture2D(desc);
+
+		float positions[9] = {};
+		VertexBufferFormat format;
+		format.add({ EAttributeProperty::Position, EAttributeType::Float, 3 }, { sizeof(float) * 3, 3, positions });
+		res.vb = device->createVertexBuffer(format);
+
+		uint32_t indices[6] = { 0, 1, 2, 2, 1, 0 };
+		res.ib = device->createIndexBuffer(sizeof(uint32_t), 6, indices);
+
+		res.cb = device->createConstantBuffer("TestBuffer", 64);
+		res.sb = device->createStorageBuffer("TestStorage", 16);
+
+		return res;
+	}
+
+	void recordingContextTest()
+	{
+		RIRecordingResourceStore* store = new RIRecordingResourceStore;
+		RIDeviceRecording device(store);
+		RICommandLog log;
+		RIContextRecording context(store, &log);
+
+		RecordingTestResources res = createRecordingTestResources(&device);
+		assert(res.program.isValid() && res.texture.isValid() && res.cb.isValid() && res.sb.isValid());
+
+		uint8_t pixels[4 * 4 * 4] = {};
+		float matrix[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+		uint8_t cbData[32] = {};
+		uint32_t sbData[100] = {}; // Larger than the buffer was created with.
+
+		context.uploadTextureData(res.texture, pixels);
+		context.bindShaderProgram(res.program);
+		context.bindUniform(res.modelView, matrix);
+		context.bindTexture(res.sampler, res.texture);
+		context.drawIndexed(res.vb, res.ib, EPrimitive::Triangles);
+		context.unbindTextures();
+		context.updateConstantBuffer(res.cb, cbData, sizeof(cbData), 16);
+		context.bindConstantBufferToLocation(res.cb, 1);
+		context.endFrame();
+
+		context.bindShaderProgram(res.program);
+		context.setBlendState(BlendState(EBlendOp::Add, EBlendFactor::One, EBlendFactor::One));
+		context.drawLinear(res.vb, EPrimitive::Triangles, 3);
+		context.drawLinear(EPrimitive::Points, 1, 0);
+		context.updateStorageBuffer(res.sb, sbData, sizeof(sbData));
+		context.bindStorageBufferToLocation(res.sb, 2);
+		context.endFrame();
+
+		assert(log.getNumFrames() == 2);
+
+		const RIFrameStats& first = log.getFrame(0);
+		assert(first.m_numCommands == 8);
+		assert(first.m_numDraws == 1);
+		assert(first.m_numBinds == 4);
+		assert(first.m_uniformBytes == sizeof(matrix));
+		assert(first.m_constantBufferBytes == sizeof(cbData));
+		assert(first.m_textureUploadBytes == sizeof(pixels));
+
+		const RIFrameStats& second = log.getFrame(1);
+		assert(second.m_numCommands == 6);
+		assert(second.m_numDraws == 2);
+		assert(second.m_numBinds == 2);
+		assert(second.m_storageBufferBytes == sizeof(sbData));
+		assert(second.m_firstByte == first.m_numBytes);
+
+		// Round trip through an archive.
+		WriteArchive writeAr;
+		createWriteArchive(0, &writeAr);
+		serialize(&writeAr, log);
+
+		ReadArchive readAr;
+		readAr.m_data = writeAr.m_data;
+		readAr.m_size = writeAr.m_numBytesWritten;
+		readAr.m_numBytesRead = 0;
+
+		RICommandLog loaded;
+		serialize(&readAr, loaded);
+		destroyArchive(writeAr);
+
+		assert(loaded.m_bytes == log.m_bytes);
+		assert(loaded.getNumFrames() == 2);
+		assert(loaded.getFrame(1).m_numDraws == 2);
+
+		// Replaying into an identically set up backend records the same stream again.
+		RIRecordingResourceStore* replayStore = new RIRecordingResourceStore;
+		RIDeviceRecording replayDevice(replayStore);
+		RICommandLog replayLog;
+		RIContextRecording replayContext(replayStore, &replayLog);
+		createRecordingTestResources(&replayDevice);
+
+		for (size_t i = 0; i < loaded.getNumFrames(); ++i)
+		{
+			replayFrame(loaded, i, &replayContext);
+			replayContext.endFrame();
+		}
+
+		assert(replayLog.m_bytes == log.m_bytes);
+		assert(replayLog.getFrame(0).m_uniformBytes == first.m_uniformBytes);
+
+		CountingRIContext counting;
+		size_t numReplayed = replayCommandLog(loaded, &counting);
+		assert(numReplayed == 14);
+		assert(counting.m_numDraws == 3);
+		assert(counting.m_numProgramBinds == 2);
+
+		// A cut off command and an unknown one stop the replay without being issued.
+		RICommandLog cut = loaded;
+		cut.m_bytes.pop_back();
+		CountingRIContext cutCounting;
+		numReplayed = replayCommandLog(cut, &cutCounting);
+		assert(numReplayed == 13);
+
+		cut.m_bytes = loaded.m_bytes;
+		cut.m_bytes.push_back(static_cast<uint8_t>(ERICommand::NumCommands));
+		numReplayed = replayCommandLog(cut, &cutCounting);
+		assert(numReplayed == 14);
+
+		delete replayStore;
+		delete store;
+	}
+
+	// Frames of the deferred renderer with the systems of the game, recorded on the recording
+	// backend. The camera sits at the origin looking down -z, entities are added by the test.
+	// Shaders are read from the working directory like the game does.
+	struct DeferredTestScene
+	{
+		enum
+		{
+			WIDTH = 320,
+			HEIGHT = 180
+		};
+
+		DeferredTestScene()
+			: store(new RIRecordingResourceStore)
+			, device(store)
+			, context(store, &log)
+			, renderer(&device, &context, WIDTH, HEIGHT)
+			, smSystem(&pool)
+			, scheduler(&world, &pool)
+		{
+			renderer.setViewMatrix(Matrix4::identity());
+			renderer.setProjectionMatrix(perspectiveRH(70.f, static_cast<float>(WIDTH) / HEIGHT, 0.1f, 1000.f));
+
+			TextureDesc desc;
+			desc.width = 1;
+			desc.height = 1;
+			desc.pixelFormat = EPixelFormat::R8G8B8A8;
+
+			for (Texture2D& texture : textures)
+			{
+				texture.m_resourceHandle = device.createTexture2D(desc);
+			}
+
+			material.m_name = "testMaterial";
+			material.m_diffuseTex = &textures[0];
+			material.m_roughnessTex = &textures[1];
+			material.m_metallicTex = &textures[2];
+			material.m_normalTex = &textures[3];
+
+			createBox();
+
+			world.registerComponentType<CTransform>();
+			world.registerComponentType<CStaticMesh>();
+			world.registerComponentType<CDirectionalLight>();
+			world.registerComponentType<CPointLight>();
+
+			// Registered like the game does.
+			scheduler.addSystem("Transforms", 0, makeComponentMask<CTransform>(), [this](World* world, WorkerPool*)
+			{
+				tfSystem.updateTransforms(world);
+			});
+
+			scheduler.addSystem("Static mesh bounds", makeComponentMask<CTransform>(), makeComponentMask<CStaticMesh>(), [this](World* world, WorkerPool*)
+			{
+				smSystem.updateBounds(world);
+			});
+
+			scheduler.addSystem("Lights", makeComponentMask<CTransform, CDirectionalLight, CPointLight>(), 0, [this](World* world, WorkerPool*)
+			{
+				lightSystem.gatherLights(world, renderer.getViewMatrix());
+			});
+
+			scheduler.addSystem("Clear dirty transforms", 0, makeComponentMask<CTransform>(), [this](World* world, WorkerPool* pool)
+			{
+				tfSystem.clearDirtyFlags(world, pool);
+			});
+		}
+
+		~DeferredTestScene()
+		{
+			delete store;
+		}
+
+		// Unit cube around the origin with a single material.
+		void createBox()
+		{
+			MeshData& data = box.m_data;
+			data.setSize(8);
+
+			for (uint32_t i = 0; i < 8; ++i)
+			{
+				Vec3 corner((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f);
+				data.m_vertices.push_back(corner);
+				data.m_normals.push_back(corner.normalized());
+				data.m_tangents.push_back(Vec4(1.f, 0.f, 0.f, 1.f));
+				data.m_texCoords.push_back(Vec2(0.f, 0.f));
+			}
+
+			const uint32_t indices[36] = 
+			{ 
+				0, 4, 6, 0, 6, 2, 
+				1, 3, 7, 1, 7, 5, 
+				0, 1, 5, 0, 5, 4, 
+				2, 6, 7, 2, 7, 3, 
+				0, 2, 3, 0, 3, 1, 
+				4, 5, 7, 4, 7, 6 
+			};
+
+			data.m_indices.assign(indices, indices + 36);
+
+			box.m_name = "testBox";
+			box.m_materials[0] = &material;
+			box.m_indexFrom[0] = 0;
+			box.m_numMaterials = 1;
+
+			computeMeshBounds(&box);
+			createMeshBuffers(&box, &device);
+		}
+
+		EntityHandle addBox(const Vec3& position, float scale)
+		{
+			EntityHandle entity = world.createEntity();
+			CTransform* tf = world.addComponent<CTransform>(entity);
+			tf->setTranslation(position);
+			tf->setScale(Vec3(scale, scale, scale));
+			world.addComponent<CStaticMesh>(entity)->m_mesh = &box;
+			return entity;
+		}
+
+		EntityHandle addPointLight(const Vec3& position, float radius)
+		{
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity)->setTranslation(position);
+
+			CPointLight* light = world.addComponent<CPointLight>(entity);
+			light->m_color = Vec3(1.f, 1.f, 1.f);
+			light->m_radius = radius;
+			light->m_intensity = 1.f;
+			return entity;
+		}
+
+		void addDirectionalLight(const Vec3& direction)
+		{
+			CDirectionalLight* light = world.addComponent<CDirectionalLight>(world.createEntity());
+			light->m_direction = direction;
+			light->m_color = Vec3(0.3f, 0.3f, 0.3f);
+		}
+
+		// Same order as the frame of the game.
+		void recordFrame()
+		{
+			scheduler.run();
+			world.advanceChangeVersion();
+
+			renderer.setupGBufferPass();
+			smSystem.renderMeshes(&world, &renderer);
+			renderer.runGBufferPass();
+			lightSystem.renderLights(&renderer);
+			renderer.copyFinalColorToBackBuffer();
+			context.endFrame();
+		}
+
+		RIRecordingResourceStore* store;
+		RIDeviceRecording device;
+		RICommandLog log;
+		RIContextRecording context;
+		DeferredRenderer renderer;
+
+		WorkerPool pool;
+		World world;
+		TransformSystem tfSystem;
+		StaticMeshSystem smSystem;
+		LightSystem lightSystem;
+		SystemScheduler scheduler;
+
+		Texture2D textures[4];
+		Material material;
+		StaticMesh box;
+	};
+
+	void deferredFrameTest()
+	{
+		DeferredTestScene scene;
+
+		// Boxes 20 in front of the camera, too small on screen to occlude anything, and one behind it.
+		std::vector<EntityHandle> boxes;
+
+		for (int32_t y = 0; y < 4; ++y)
+		{
+			for (int32_t x = 0; x < 8; ++x)
+			{
+				boxes.push_back(scene.addBox(Vec3(-7.f + 2.f * x, -3.f + 2.f * y, -20.f), 1.f));
+			}
+		}
+
+		scene.addBox(Vec3(0.f, 0.f, 20.f), 1.f);
+
+		scene.addDirectionalLight(Vec3(-0.5f, -0.5f, 0.f));
+
+		std::vector<EntityHandle> lights;
+
+		for (int32_t i = 0; i < 4; ++i)
+		{
+			lights.push_back(scene.addPointLight(Vec3(-6.f + 4.f * i, 0.f, -18.f), 5.f));
+		}
+
+		const size_t numVisible = boxes.size();
+		const size_t mat4Bytes = 16 * sizeof(float);
+		const size_t mat3Bytes = 9 * sizeof(float);
+
+		scene.recordFrame();
+
+		assert(scene.smSystem.getCullStats().m_numVisible == numVisible);
+		assert(scene.smSystem.getCullStats().m_numCulled == 1);
+		assert(scene.smSystem.getOcclusionStats().m_numOccluded == 0);
+		assert(scene.renderer.getLightClusterStats().m_numLights == lights.size());
+
+		// A draw per box, then the lights and the copy to the back buffer. Every box binds its model
+		// view and normal transform, the projection is bound for both gbuffer programs and the lights.
+		const RIFrameStats first = scene.log.getFrame(0); // Copied, later frames grow the log.
+		assert(first.m_numDraws == numVisible + 2);
+		assert(first.m_uniformBytes == 3 * mat4Bytes + numVisible * (mat4Bytes + mat3Bytes));
+		assert(first.m_constantBufferBytes == sizeof(GpuLightPassParams));
+		assert(first.m_storageBufferBytes == sizeof(GpuDirectionalLight) + lights.size() * sizeof(GpuPointLight)
+			+ ClusteredLightCuller::NUM_CLUSTERS * sizeof(ClusterLightRange) + scene.renderer.getLightClusterStats().m_numIndices * sizeof(uint32_t));
+		assert(first.m_textureUploadBytes == 0);
+		assert(scene.log.m_bytes[first.m_firstByte] == static_cast<uint8_t>(ERICommand::ClearRenderTargetColor));
+
+		CountingRIContext counting;
+		replayFrame(scene.log, 0, &counting);
+		assert(counting.m_numDraws == first.m_numDraws);
+		assert(counting.m_numUniformBinds == 3 + 2 * numVisible);
+		assert(counting.m_numTextureBinds == 4 * numVisible + 4);
+
+		// Nothing changed, so the next frame submits the same commands.
+		scene.recordFrame();
+
+		const RIFrameStats second = scene.log.getFrame(1);
+		assert(second.m_numBytes == first.m_numBytes);
+		assert(memcmp(&scene.log.m_bytes[first.m_firstByte], &scene.log.m_bytes[second.m_firstByte], first.m_numBytes) == 0);
+
+		// A box moved behind the camera and a destroyed light drop out once the systems saw them.
+		scene.world.getComponent<CTransform>(boxes[0])->setTranslation(Vec3(0.f, 0.f, 30.f));
+		scene.world.destroyEntity(lights[0]);
+		scene.recordFrame();
+
+		const RIFrameStats& third = scene.log.getFrame(2);
+		assert(scene.smSystem.getCullStats().m_numCulled == 2);
+		assert(third.m_numDraws == first.m_numDraws - 1);
+		assert(third.m_uniformBytes == first.m_uniformBytes - mat4Bytes - mat3Bytes);
+		assert(scene.renderer.getLightClusterStats().m_numLights == lights.size() - 1);
+	}
+
+	void glStateFilterTest()
+	{
+		DeferredTestScene scene;
+
+		for (int32_t x = 0; x < 8; ++x)
+		{
+			scene.addBox(Vec3(-7.f + 2.f * x, 0.f, -20.f), 1.f);
+		}
+
+		scene.addDirectionalLight(Vec3(-0.5f, -0.5f, 0.f));
+		scene.addPointLight(Vec3(0.f, 0.f, -18.f), 5.f);
+
+		scene.recordFrame();
+		scene.recordFrame();
+
+		const RIFrameStats first = scene.log.getFrame(0);
+		const RIFrameStats second = scene.log.getFrame(1);
+
+		StateFilterRIContext filtering;
+		size_t numReplayed = replayFrame(scene.log, 0, &filtering);
+		assert(numReplayed == first.m_numCommands);
+
+		const GlStateFilterStats& stats = filtering.m_filter.getStats();
+		const size_t uniform = static_cast<size_t>(EGlStateCall::Uniform);
+		const size_t texture = static_cast<size_t>(EGlStateCall::Texture);
+		const size_t program = static_cast<size_t>(EGlStateCall::Program);
+
+		// Every bind of the frame is counted once, binds done by draws and clears are not.
+		assert(stats.getNumBindCalls() == first.m_numBinds);
+		assert(stats.m_skipped[uniform] == 0);
+
+		// The boxes share their material, only the first one binds its textures.
+		assert(stats.m_issued[texture] + stats.m_skipped[texture] == 4 * 8 + 4);
+		assert(stats.m_skipped[texture] == 4 * 7);
+		assert(stats.m_skipped[program] > 0);
+
+		// The second frame starts where the first left off, so it skips at least as much.
+		uint32_t firstIssued = stats.getTotalIssued();
+		filtering.m_filter.resetStats();
+		replayFrame(scene.log, 1, &filtering);
+
+		assert(stats.getNumBindCalls() == second.m_numBinds);
+		assert(stats.getTotalIssued() <= firstIssued);
+	}
+
+	void runRenderBenchmarks()
+	{
+		commandBucketBenchmark();
+		recordingContextBenchmark();
+		deferredFrameBenchmark();
+		frustumCullingBenchmark();
+		occlusionCullingBenchmark();
+		clusteredLightingBenchmark();
+	}
+
+	struct BucketBenchResult
+	{
+		double addMs;
+		double sortMs;
+		double submitMs;
+		CountingRIContext context;
+	};
+
+	enum 
+	{
+		BENCH_NUM_PROGRAMS = 8,
+		BENCH_NUM_MATERIALS = 256
+	};
+
+	// Fills bucket with numPackets draws using vertex buffer 0, BENCH_NUM_PROGRAMS programs, 
+	// uniforms 0-2 and 2 * BENCH_NUM_MATERIALS textures.
+	static void fillBenchBucket(CommandBucket& bucket, bool bSortKeys, size_t numPackets)
+	{
+		const uint32_t numPrograms = BENCH_NUM_PROGRAMS;
+		const uint32_t numMaterials = BENCH_NUM_MATERIALS;
+
+		srand(42);
+
+		for (size_t i = 0; i < numPackets; ++i)
+		{
+			uint32_t program = rand() % numPrograms;
+			uint32_t material = rand() % numMaterials;
+			float depth = 0.1f + static_cast<float>(rand() % 10000) * 0.1f;
+
+			CommandKey key = 0;
+			if (bSortKeys)
+			{
+				key = commandKey::create(0, ETranslucency::Opaque, commandKey::quantizeDepth(depth, 0.1f, 1000.0f), program, material);
+			}
+
+			RISetUniformMatrix4Command* modelView = bucket.addCommand<RISetUniformMatrix4Command>(key);
+			modelView->usingProgram = ProgramHandle(program);
+			modelView->uniform = UniformHandle(0);
+
+			RIBindTexture2DCommand* diffuse = bucket.appendCommand<RIBindTexture2DCommand>(modelView);
+			diffuse->usingProgram = ProgramHandle(program);
+			diffuse->sampler = UniformHandle(1);
+			diffuse->texture = Texture2DHandle(material);
+
+			RIBindTexture2DCommand* normal = bucket.appendCommand<RIBindTexture2DCommand>(diffuse);
+			normal->usingProgram = ProgramHandle(program);
+			normal->sampler = UniformHandle(2);
+			normal->texture = Texture2DHandle(numMaterials + material);
+
+			RIDrawLinearCommand* draw = bucket.appendCommand<RIDrawLinearCommand>(normal);
+			draw->vertexBuffer = VertexBufferHandle(0);
+			draw->start = 0;
+			draw->count = 36;
+			draw->primitives = EPrimitive::Triangles;
+
+			bucket.appendCommand<RIUnbindTexturesCommand>(draw);
+		}
+	}
+
+	static void runBucketBench(bool bSortKeys, size_t numPackets, BucketBenchResult* outResult)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		CommandBucket bucket(static_cast<uint32_t>(numPackets), numPackets * 512);
+
+		Clock::time_point start = Clock::now();
+		fillBenchBucket(bucket, bSortKeys, numPackets);
+		Clock::time_point added = Clock::now();
+		bucket.sort();
+		Clock::time_point sorted = Clock::now();
+
+		bucket.submit(&outResult->context);
+		Clock::time_point submitted = Clock::now();
+
+		outResult->addMs = Ms(added - start).count();
+		outResult->sortMs = Ms(sorted - added).count();
+		outResult->submitMs = Ms(submitted - sorted).count();
+	}
+
+	void commandBucketBenchmark()
+	{
+		const size_t numPackets = 100000;
+
+		BucketBenchResult unsorted;
+		runBucketBench(false, numPackets, &unsorted);
+
+		BucketBenchResult sorted;
+		runBucketBench(true, numPackets, &sorted);
+
+		Logger::logf("CommandBucket, %zu packets:", numPackets);
+		Logger::logf("  insertion order: add %.2f ms, submit %.2f ms, program changes %zu, texture changes %zu / %zu binds",
+			unsorted.addMs, unsorted.submitMs, unsorted.context.m_numProgramChanges, unsorted.context.m_numTextureChanges, unsorted.context.m_numTextureBinds);
+		Logger::logf("  key order:       add %.2f ms, sort %.2f ms, submit %.2f ms, program changes %zu, texture changes %zu / %zu binds",
+			sorted.addMs, sorted.sortMs, sorted.submitMs, sorted.context.m_numProgramChanges, sorted.context.m_numTextureChanges, sorted.context.m_numTextureBinds);
+	}
+
+	void recordingContextBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t numPackets = 100000;
+		const char* logPath = "RenderBenchmark.ricl";
+
+		RIRecordingResourceStore* store = new RIRecordingResourceStore;
+		RIDeviceRecording recordingDevice(store);
+		IRIDevice* device = &recordingDevice;
+		RICommandLog log;
+		RIContextRecording context(store, &log);
+
+		for (size_t i = 0; i < BENCH_NUM_PROGRAMS; ++i)
+		{
+			device->createProgram(device->createVertexShader(""), device->createFragmentShader(""));
+		}
+
+		device->createUniform("modelView", EUniformType::Mat4);
+		device->createUniform("diffuse", EUniformType::Sampler2D);
+		device->createUniform("normal", EUniformType::Sampler2D);
+
+		TextureDesc desc;
+		desc.width = 1;
+		desc.height = 1;
+		desc.pixelFormat = EPixelFormat::R8G8B8A8;
+
+		for (size_t i = 0; i < 2 * BENCH_NUM_MATERIALS; ++i)
+		{
+			device->createTexture2D(desc);
+		}
+
+		float positions[3] = {};
+		VertexBufferFormat format;
+		format.add({ EAttributeProperty::Position, EAttributeType::Float, 3 }, { sizeof(float) * 3, 1, positions });
+		device->createVertexBuffer(format);
+
+		CommandBucket bucket(static_cast<uint32_t>(numPackets), numPackets * 512);
+		fillBenchBucket(bucket, true, numPackets);
+
+		Clock::time_point start = Clock::now();
+		bucket.submit(&context);
+		context.endFrame();
+		Clock::time_point recorded = Clock::now();
+
+		EArchiveError err = saveCommandLog(logPath, log);
+		assert(err == EArchiveError::NoError);
+		Clock::time_point saved = Clock::now();
+
+		RICommandLog loaded;
+		err = loadCommandLog(logPath, &loaded);
+		assert(err == EArchiveError::NoError);
+		Clock::time_point loadedTime = Clock::now();
+
+		CountingRIContext counting;
+		size_t numReplayed = replayFrame(loaded, 0, &counting);
+		Clock::time_point replayed = Clock::now();
+
+		const RIFrameStats& stats = loaded.getFrame(0);
+
+		Logger::logf("Recording context, %zu packets:", numPackets);
+		Logger::logf("  record %.2f ms, save %.2f ms, load %.2f ms, replay %.2f ms (%zu commands)",
+			Ms(recorded - start).count(), Ms(saved - recorded).count(), Ms(loadedTime - saved).count(), Ms(replayed - loadedTime).count(), numReplayed);
+		Logger::logf("  log %.2f MB, draws %u, binds %u, uniform bytes %llu, constant buffer bytes %llu",
+			static_cast<double>(loaded.getNumBytes()) / (1024.0 * 1024.0), stats.m_numDraws, stats.m_numBinds, 
+			static_cast<unsigned long long>(stats.m_uniformBytes), static_cast<unsigned long long>(stats.m_constantBufferBytes));
+
+		assert(counting.m_numDraws == stats.m_numDraws);
+
+		remove(logPath);
+		delete store;
+	}
+
+	static float randomRange(float min, float max)
+	{
+		return min + (max - min) * (static_cast<float>(rand()) / RAND_MAX);
+	}
+
+	void deferredFrameBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t numBoxes = 4000;
+		const size_t numPointLights = 256;
+		const size_t numMovedPerFrame = 40;
+		const size_t numFrames = 30;
+
+		DeferredTestScene scene;
+		srand(42);
+
+		// Boxes of all sizes in front of the camera, the large ones close to it become occluders.
+		std::vector<EntityHandle> boxes;
+
+		for (size_t i = 0; i < numBoxes; ++i)
+		{
+			Vec3 position(randomRange(-60.f, 60.f), randomRange(-30.f, 30.f), randomRange(-300.f, -10.f));
+			boxes.push_back(scene.addBox(position, randomRange(0.5f, 6.f)));
+		}
+
+		for (size_t i = 0; i < numPointLights; ++i)
+		{
+			Vec3 position(randomRange(-60.f, 60.f), randomRange(-30.f, 30.f), randomRange(-300.f, -10.f));
+			scene.addPointLight(position, randomRange(10.f, 30.f));
+		}
+
+		scene.addDirectionalLight(Vec3(-0.5f, -0.5f, 0.f));
+
+		double systemsMs = 0.0;
+		double meshesMs = 0.0;
+		double gBufferMs = 0.0;
+		double lightsMs = 0.0;
+
+		for (size_t frame = 0; frame < numFrames; ++frame)
+		{
+			for (size_t i = 0; i < numMovedPerFrame; ++i)
+			{
+				CTransform* tf = scene.world.getComponent<CTransform>(boxes[rand() % boxes.size()]);
+				tf->setTranslation(tf->getTranslation() + Vec3(0.f, 0.1f, 0.f));
+			}
+
+			// recordFrame(), timed step by step.
+			Clock::time_point start = Clock::now();
+			scene.scheduler.run();
+			scene.world.advanceChangeVersion();
+			Clock::time_point systemsDone = Clock::now();
+
+			scene.renderer.setupGBufferPass();
+			scene.smSystem.renderMeshes(&scene.world, &scene.renderer);
+			Clock::time_point meshesDone = Clock::now();
+
+			scene.renderer.runGBufferPass();
+			Clock::time_point gBufferDone = Clock::now();
+
+			scene.lightSystem.renderLights(&scene.renderer);
+			scene.renderer.copyFinalColorToBackBuffer();
+			scene.context.endFrame();
+			Clock::time_point lightsDone = Clock::now();
+
+			systemsMs += Ms(systemsDone - start).count();
+			meshesMs += Ms(meshesDone - systemsDone).count();
+			gBufferMs += Ms(gBufferDone - meshesDone).count();
+			lightsMs += Ms(lightsDone - gBufferDone).count();
+		}
+
+		const RIFrameStats& last = scene.log.getFrame(numFrames - 1);
+		const OcclusionCullStats& occlusion = scene.smSystem.getOcclusionStats();
+
+		Logger::logf("Deferred frame, %zu boxes, %zu point lights, %zu frames on the recording backend:", numBoxes, numPointLights, numFrames);
+		Logger::logf("  per frame: systems %.2f ms, cull and queue meshes %.2f ms, gbuffer submit %.2f ms, lights %.2f ms",
+			systemsMs / numFrames, meshesMs / numFrames, gBufferMs / numFrames, lightsMs / numFrames);
+		Logger::logf("  %zu visible, %zu occluded by %zu meshes", scene.smSystem.getCullStats().m_numVisible, occlusion.m_numOccluded, occlusion.m_numOccluders);
+		Logger::logf("  last frame: %u commands, draws %u, binds %u, uniform bytes %llu, storage buffer bytes %llu, log %.2f MB",
+			last.m_numCommands, last.m_numDraws, last.m_numBinds, static_cast<unsigned long long>(last.m_uniformBytes),
+			static_cast<unsigned long long>(last.m_storageBufferBytes), static_cast<double>(scene.log.getNumBytes()) / (1024.0 * 1024.0));
+
+		assert(last.m_numDraws == scene.smSystem.getCullStats().m_numVisible - occlusion.m_numOccluded + 2);
+	}
+
+	void frustumCullingTest()
+	{
+		Plane planes[NUM_FRUSTUM_PLANES];
+		createTestFrustum(Vec3(0.f), Vec3(0.f, 0.f, -1.f), 90.f, 1.f, 1.f, 100.f, planes);
+
+		for (const Plane& plane : planes)
+		{
+			assert(fabsf(plane.n.length() - 1.f) < 1e-5f);
+			assert(plane.getSideOn(Vec3(0.f, 0.f, -10.f)) == Plane::ESide::FRONT);
+		}
+
+		// Near plane at z = -1, far plane at z = -100 and the side planes at 45 degrees.
+		assert(fabsf(planes[4].distance(Vec3(0.f, 0.f, -3.f)) - 2.f) < 1e-3f);
+		assert(fabsf(planes[5].distance(Vec3(0.f, 0.f, -90.f)) - 10.f) < 1e-2f);
+		assert(planes[1].getSideOn(Vec3(20.f, 0.f, -10.f)) == Plane::ESide::BACK);
+
+		FrustumCuller culler;
+		Vec3 unitExtent(1.f);
+
+		uint32_t inside = culler.addBounds(Vec3(0.f, 0.f, -10.f), 1.f, Vec3(0.f, 0.f, -10.f), unitExtent);
+		culler.addBounds(Vec3(0.f, 0.f, 5.f), 1.f, Vec3(0.f, 0.f, 5.f), unitExtent);
+		uint32_t nearStraddle = culler.addBounds(Vec3(0.f, 0.f, -0.5f), 1.f, Vec3(0.f, 0.f, -0.5f), unitExtent);
+		culler.addBounds(Vec3(0.f, 0.f, -200.f), 1.f, Vec3(0.f, 0.f, -200.f), unitExtent);
+
+		// The sphere reaches into the frustum, the tighter box does not.
+		culler.addBounds(Vec3(20.f, 0.f, -10.f), 8.f, Vec3(20.f, 0.f, -10.f), unitExtent);
+		uint32_t sphereAndBox = culler.addBounds(Vec3(20.f, 0.f, -10.f), 8.f, Vec3(20.f, 0.f, -10.f), Vec3(12.f, 1.f, 1.f));
+
+		std::vector<uint32_t> visible;
+		FrustumCullStats stats = culler.cull(planes, &visible);
+
+		assert(stats.m_numVisible == 3 && stats.m_numCulled == 3);
+		assert(visible[0] == inside && visible[1] == nearStraddle && visible[2] == sphereAndBox);
+
+		// Random bounds, with a count that leaves a partial batch.
+		srand(7);
+		culler.clear();
+		for (size_t i = 0; i < 1003; ++i)
+		{
+			Vec3 center(randomRange(-120.f, 120.f), randomRange(-120.f, 120.f), randomRange(-150.f, 50.f));
+			Vec3 extent(randomRange(0.1f, 5.f), randomRange(0.1f, 5.f), randomRange(0.1f, 5.f));
+			culler.addBounds(center, extent.length(), center, extent);
+		}
+
+		std::vector<uint32_t> visibleScalar;
+		FrustumCullStats simdStats = culler.cull(planes, &visible);
+		FrustumCullStats scalarStats = culler.cullScalar(planes, &visibleScalar);
+
+		assert(visible == visibleScalar);
+		assert(simdStats.m_numVisible > 0 && simdStats.m_numCulled > 0);
+		assert(simdStats.m_numVisible + simdStats.m_numCulled == 1003);
+		assert(scalarStats.m_numCulled == simdStats.m_numCulled);
+
+		// Bounds transforms.
+		Vec3 center;
+		Vec3 extent;
+		Matrix4 rotation = Matrix4::rotation(radians(45.f), Vec3(0.f, 0.f, 1.f));
+		rotation(3, 3) = 1.f;
+
+		transformAabb(Matrix4::translation(Vec3(5.f, 0.f, 0.f)) * rotation, Vec3(-1.f), Vec3(1.f), &center, &extent);
+
+		assert(fabsf(center.x - 5.f) < 1e-5f && fabsf(center.y) < 1e-5f);
+		assert(fabsf(extent.x - sqrtf(2.f)) < 1e-5f && fabsf(extent.y - sqrtf(2.f)) < 1e-5f && fabsf(extent.z - 1.f) < 1e-5f);
+		assert(fabsf(getMaxScale(Matrix4::scale(Vec3(1.f, 3.f, 2.f))) - 3.f) < 1e-6f);
+	}
+
+	void frustumCullingBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t counts[2] = { 10000, 100000 };
+		const size_t numIterations = 100;
+
+		Plane planes[NUM_FRUSTUM_PLANES];
+		createTestFrustum(Vec3(0.f), Vec3(0.f, 0.f, -1.f), 70.f, 1.f, 1.f, 1000.f, planes);
+
+		for (size_t count : counts)
+		{
+			srand(42);
+
+			FrustumCuller culler;
+			culler.reserve(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				Vec3 center(randomRange(-500.f, 500.f), randomRange(-500.f, 500.f), randomRange(-500.f, 500.f));
+				Vec3 extent(randomRange(0.5f, 10.f), randomRange(0.5f, 10.f), randomRange(0.5f, 10.f));
+				culler.addBounds(center, extent.length(), center, extent);
+			}
+
+			std::vector<uint32_t> visible;
+			visible.reserve(count);
+
+			FrustumCullStats stats;
+			Clock::time_point start = Clock::now();
+			for (size_t i = 0; i < numIterations; ++i)
+			{
+				stats = culler.cullScalar(planes, &visible);
+			}
+			double scalarMs = Ms(Clock::now() - start).count() / numIterations;
+
+			start = Clock::now();
+			for (size_t i = 0; i < numIterations; ++i)
+			{
+				stats = culler.cull(planes, &visible);
+			}
+			double simdMs = Ms(Clock::now() - start).count() / numIterations;
+
+			Logger::logf("Frustum culling, %zu instances: %zu visible, %zu culled", count, stats.m_numVisible, stats.m_numCulled);
+			Logger::logf("  scalar %.3f ms (%.2f ns per instance), SSE %.3f ms (%.2f ns per instance), %.2fx", 
+				scalarMs, scalarMs * 1e6 / count, simdMs, simdMs * 1e6 / count, scalarMs / simdMs);
+		}
+	}
+
+	// Camera at the origin looking down -z with the aspect of the occlusion buffer.
+	static Matrix4 createOcclusionTestViewProjection()
+	{
+		Vec3 eye(0.f, 0.f, 0.f);
+		Vec3 target(0.f, 0.f, -1.f);
+		Vec3 up(0.f, 1.f, 0.f);
+
+		return perspectiveRH(90.f, 2.f, 0.1f, 100.f) * lookAtRH(eye, target, up);
+	}
+
+	static void addBoxOccluder(OcclusionCuller* culler, const Vec3& boxMin, const Vec3& boxMax)
+	{
+		Vec3 vertices[8];
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			vertices[corner] = Vec3((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z);
+		}
+
+		const uint32_t indices[36] =
+		{
+			0, 1, 3, 0, 3, 2,	4, 6, 7, 4, 7, 5, // -z, +z
+			0, 4, 5, 0, 5, 1,	2, 3, 7, 2, 7, 6, // -y, +y
+			0, 2, 6, 0, 6, 4,	1, 5, 7, 1, 7, 3  // -x, +x
+		};
+
+		culler->addOccluder(vertices, 8, indices, 36, Matrix4::identity());
+	}
+
+	void occlusionCullingTest()
+	{
+		Matrix4 viewProjection = createOcclusionTestViewProjection();
+
+		OcclusionCuller culler;
+		culler.begin(viewProjection);
+
+		// Quad at z = -10, covering the middle half of the buffer width and all of its height.
+		const Vec3 quad[4] = { Vec3(-5.f, -5.f, -10.f), Vec3(5.f, -5.f, -10.f), Vec3(5.f, 5.f, -10.f), Vec3(-5.f, 5.f, -10.f) };
+		const uint32_t quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+		culler.addOccluder(quad, 4, quadIndices, 6, Matrix4::identity());
+		culler.rasterize();
+
+		assert(culler.getNumTriangles() == 2);
+
+		Vec4 quadClip = viewProjection * Vec4(0.f, 0.f, -10.f, 1.f);
+		assert(fabsf(culler.getDepth(OcclusionCuller::WIDTH / 2, OcclusionCuller::HEIGHT / 2) - quadClip.z / quadClip.w) < 1e-5f);
+		assert(culler.getDepth(100, 40) < 1.f && culler.getDepth(155, 90) < 1.f);
+		assert(culler.getDepth(0, 0) == 1.f && culler.getDepth(60, 64) == 1.f && culler.getDepth(196, 100) == 1.f);
+
+		// Behind the quad, in front of it, partly beside it and crossing the near plane.
+		assert(!culler.isVisible(Vec3(-1.f, -1.f, -20.f), Vec3(1.f, 1.f, -18.f)));
+		assert(culler.isVisible(Vec3(-1.f, -1.f, -5.f), Vec3(1.f, 1.f, -3.f)));
+		assert(culler.isVisible(Vec3(8.f, -1.f, -20.f), Vec3(14.f, 1.f, -18.f)));
+		assert(culler.isVisible(Vec3(-1.f, -1.f, -1.f), Vec3(1.f, 1.f, 1.f)));
+
+		// A floor reaching behind the camera is clipped at the near plane and hides what is below it.
+		culler.begin(viewProjection);
+
+		const Vec3 floor[4] = { Vec3(-50.f, -1.f, 10.f), Vec3(50.f, -1.f, 10.f), Vec3(50.f, -1.f, -90.f), Vec3(-50.f, -1.f, -90.f) };
+		culler.addOccluder(floor, 4, quadIndices, 6, Matrix4::identity());
+		culler.rasterize();
+
+		assert(culler.getNumTriangles() >= 2);
+		assert(culler.getDepth(OcclusionCuller::WIDTH / 2, OcclusionCuller::HEIGHT - 1) < 1.f);
+		assert(culler.getDepth(OcclusionCuller::WIDTH / 2, OcclusionCuller::HEIGHT / 2 - 2) == 1.f);
+		assert(!culler.isVisible(Vec3(-1.f, -3.f, -20.f), Vec3(1.f, -2.f, -18.f)));
+		assert(culler.isVisible(Vec3(-1.f, -0.5f, -20.f), Vec3(1.f, 0.5f, -18.f)));
+
+		// Tiles rasterized on a pool of several threads give the same buffer as the calling thread.
+		srand(3);
+
+		WorkerPool pool(4);
+		OcclusionCuller pooled(&pool);
+		culler.begin(viewProjection);
+		pooled.begin(viewProjection);
+
+		for (int i = 0; i < 200; ++i)
+		{
+			Vec3 boxMin(randomRange(-30.f, 30.f), randomRange(-15.f, 15.f), randomRange(-60.f, -2.f));
+			Vec3 boxMax = boxMin + Vec3(randomRange(0.1f, 4.f), randomRange(0.1f, 4.f), randomRange(0.1f, 4.f));
+
+			addBoxOccluder(&culler, boxMin, boxMax);
+			addBoxOccluder(&pooled, boxMin, boxMax);
+		}
+
+		// Repeatedly, the pool's threads stay up between frames.
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			culler.rasterize();
+			pooled.rasterize();
+
+			for (uint32_t y = 0; y < OcclusionCuller::HEIGHT; ++y)
+			{
+				for (uint32_t x = 0; x < OcclusionCuller::WIDTH; ++x)
+				{
+					assert(culler.getDepth(x, y) == pooled.getDepth(x, y));
+				}
+			}
+		}
+	}
+
+	void occlusionCullingBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t numOccludees = 10000;
+		const size_t numIterations = 50;
+
+		Matrix4 viewProjection = createOcclusionTestViewProjection();
+
+		// A street of walls on both sides and a wall across its end, small objects all around.
+		srand(42);
+
+		std::vector<Vec3> wallMins;
+		std::vector<Vec3> wallMaxs;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			float z = -5.f - i * 8.f;
+			wallMins.push_back(Vec3(-30.f, -2.f, z - 6.f));
+			wallMaxs.push_back(Vec3(-3.f, 12.f, z));
+			wallMins.push_back(Vec3(3.f, -2.f, z - 6.f));
+			wallMaxs.push_back(Vec3(30.f, 12.f, z));
+		}
+
+		wallMins.push_back(Vec3(-30.f, -2.f, -75.f));
+		wallMaxs.push_back(Vec3(30.f, 30.f, -70.f));
+
+		std::vector<Vec3> boxMins(numOccludees);
+		std::vector<Vec3> boxMaxs(numOccludees);
+
+		for (size_t i = 0; i < numOccludees; ++i)
+		{
+			boxMins[i] = Vec3(randomRange(-40.f, 40.f), randomRange(-2.f, 10.f), randomRange(-95.f, -3.f));
+			boxMaxs[i] = boxMins[i] + Vec3(randomRange(0.2f, 2.f), randomRange(0.2f, 2.f), randomRange(0.2f, 2.f));
+		}
+
+		const uint32_t threadCounts[3] = { 1, 2, 4 };
+
+		for (uint32_t numThreads : threadCounts)
+		{
+			WorkerPool pool(numThreads);
+			OcclusionCuller culler(&pool);
+
+			Clock::time_point start = Clock::now();
+			for (size_t iteration = 0; iteration < numIterations; ++iteration)
+			{
+				culler.begin(viewProjection);
+
+				for (size_t i = 0; i < wallMins.size(); ++i)
+				{
+					addBoxOccluder(&culler, wallMins[i], wallMaxs[i]);
+				}
+
+				culler.rasterize();
+			}
+			double rasterMs = Ms(Clock::now() - start).count() / numIterations;
+
+			size_t numOccluded = 0;
+
+			start = Clock::now();
+			for (size_t iteration = 0; iteration < numIterations; ++iteration)
+			{
+				numOccluded = 0;
+
+				for (size_t i = 0; i < numOccludees; ++i)
+				{
+					numOccluded += culler.isVisible(boxMins[i], boxMaxs[i]) ? 0 : 1;
+				}
+			}
+			double testMs = Ms(Clock::now() - start).count() / numIterations;
+
+			Logger::logf("Occlusion culling, %u threads: %zu occluders (%zu triangles) rasterized in %.3f ms", 
+				numThreads, wallMins.size(), culler.getNumTriangles(), rasterMs);
+			Logger::logf("  %zu of %zu boxes occluded, tested in %.3f ms (%.1f ns per box)", 
+				numOccluded, numOccludees, testMs, testMs * 1e6 / numOccludees);
+		}
+	}
+	// Point in view space at distance d in front of the camera with the given NDC x and y.
+	static Vec3 viewPointFromNdc(const Matrix4& projection, float ndcX, float ndcY, float d)
+	{
+		return Vec3(ndcX * d / projection(0, 0), ndcY * d / projection(1, 1), -d);
+	}
+
+	static std::vector<GpuPointLight> createClusterTestLights(const Matrix4& projection, size_t numLights, float maxDistance, float minRadius, float maxRadius)
+	{
+		std::vector<GpuPointLight> lights(numLights);
+
+		for (GpuPointLight& light : lights)
+		{
+			// Some lights are partly or completely outside the frustum.
+			Vec3 position = viewPointFromNdc(projection, randomRange(-1.2f, 1.2f), randomRange(-1.2f, 1.2f), randomRange(-2.f, maxDistance));
+			light.m_positionEyeRadius = GpuVec4(position, randomRange(minRadius, maxRadius));
+			light.m_colorIntensity = GpuVec4(Vec3(1.f, 1.f, 1.f), 1.f);
+		}
+
+		return lights;
+	}
+
+	void clusteredLightingTest()
+	{
+		const float nearPlane = 0.1f;
+		const float farPlane = 500.f;
+		Matrix4 projection = perspectiveRH(70.f, 16.f / 9.f, nearPlane, farPlane);
+
+		ClusteredLightCuller culler;
+		culler.setProjection(projection, nearPlane, farPlane);
+
+		assert(culler.getSlice(nearPlane * 0.5f) == 0);
+		assert(culler.getSlice(farPlane * 2.f) == ClusteredLightCuller::NUM_Z - 1);
+
+		// The cluster found the way the shader does contains the point.
+		srand(7);
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			float ndcX = randomRange(-0.999f, 0.999f);
+			float ndcY = randomRange(-0.999f, 0.999f);
+			float d = randomRange(nearPlane, farPlane);
+			Vec3 point = viewPointFromNdc(projection, ndcX, ndcY, d);
+
+			uint32_t x = static_cast<uint32_t>((ndcX + 1.f) * 0.5f * ClusteredLightCuller::NUM_X);
+			uint32_t y = static_cast<uint32_t>((ndcY + 1.f) * 0.5f * ClusteredLightCuller::NUM_Y);
+			uint32_t cluster = (culler.getSlice(d) * ClusteredLightCuller::NUM_Y + y) * ClusteredLightCuller::NUM_X + x;
+
+			Vec3 boxMin;
+			Vec3 boxMax;
+			culler.getClusterBounds(cluster, &boxMin, &boxMax);
+
+			const float eps = 1e-3f * d;
+			assert(point.x >= boxMin.x - eps && point.x <= boxMax.x + eps);
+			assert(point.y >= boxMin.y - eps && point.y <= boxMax.y + eps);
+			assert(point.z >= boxMin.z - eps && point.z <= boxMax.z + eps);
+		}
+
+		// A light behind the camera touches no cluster, one in the middle of the view the cluster it is in.
+		GpuPointLight single[2];
+		single[0].m_positionEyeRadius = GpuVec4(Vec3(0.f, 0.f, 5.f), 1.f);
+		single[1].m_positionEyeRadius = GpuVec4(Vec3(0.f, 0.f, -20.f), 0.5f);
+
+		ClusteredLightStats stats = culler.build(single, 2);
+		assert(stats.m_numLights == 2);
+		assert(stats.m_numIndices > 0 && stats.m_numIndices == stats.m_numOccupiedClusters);
+		assert(stats.m_maxLightsPerCluster == 1);
+
+		uint32_t center = (culler.getSlice(20.f) * ClusteredLightCuller::NUM_Y + ClusteredLightCuller::NUM_Y / 2) * ClusteredLightCuller::NUM_X + ClusteredLightCuller::NUM_X / 2;
+		const ClusterLightRange& centerRange = culler.getRanges()[center];
+		assert(centerRange.m_count == 1 && culler.getLightIndices()[centerRange.m_offset] == 1);
+
+		// The SIMD build matches testing every light against every cluster.
+		std::vector<GpuPointLight> lights = createClusterTestLights(projection, 500, 100.f, 0.5f, 8.f);
+
+		stats = culler.build(lights.data(), lights.size());
+		std::vector<ClusterLightRange> ranges(culler.getRanges(), culler.getRanges() + ClusteredLightCuller::NUM_CLUSTERS);
+		std::vector<uint32_t> indices = culler.getLightIndices();
+
+		ClusteredLightStats scalarStats = culler.buildScalar(lights.data(), lights.size());
+		assert(scalarStats.m_numIndices == stats.m_numIndices);
+		assert(scalarStats.m_numOccupiedClusters == stats.m_numOccupiedClusters);
+		assert(scalarStats.m_maxLightsPerCluster == stats.m_maxLightsPerCluster);
+		assert(indices == culler.getLightIndices());
+
+		size_t numIndices = 0;
+
+		for (uint32_t c = 0; c < ClusteredLightCuller::NUM_CLUSTERS; ++c)
+		{
+			assert(ranges[c].m_offset == culler.getRanges()[c].m_offset);
+			assert(ranges[c].m_count == culler.getRanges()[c].m_count);
+			assert(ranges[c].m_offset == numIndices);
+			numIndices += ranges[c].m_count;
+
+			// Ascending light order within a cluster.
+			for (uint32_t i = 1; i < ranges[c].m_count; ++i)
+			{
+				assert(indices[ranges[c].m_offset + i - 1] < indices[ranges[c].m_offset + i]);
+			}
+		}
+
+		assert(numIndices == indices.size());
+	}
+
+	void clusteredLightingBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const float nearPlane = 0.1f;
+		const float farPlane = 10000.f;
+		Matrix4 projection = perspectiveRH(70.f, 16.f / 9.f, nearPlane, farPlane);
+
+		ClusteredLightCuller culler;
+		culler.setProjection(projection, nearPlane, farPlane);
+
+		const size_t lightCounts[4] = { 256, 1024, 4096, 16384 };
+
+		srand(42);
+
+		for (size_t numLights : lightCounts)
+		{
+			std::vector<GpuPointLight> lights = createClusterTestLights(projection, numLights, 200.f, 1.f, 6.f);
+
+			const size_t numIterations = 20;
+
+			Clock::time_point start = Clock::now();
+			for (size_t iteration = 0; iteration < numIterations; ++iteration)
+			{
+				culler.build(lights.data(), lights.size());
+			}
+			double simdMs = Ms(Clock::now() - start).count() / numIterations;
+
+			ClusteredLightStats stats = culler.getStats();
+
+			start = Clock::now();
+			culler.buildScalar(lights.data(), lights.size());
+			double scalarMs = Ms(Clock::now() - start).count();
+
+			size_t uploadBytes = numLights * sizeof(GpuPointLight) + ClusteredLightCuller::NUM_CLUSTERS * sizeof(ClusterLightRange) + stats.m_numIndices * sizeof(uint32_t);
+
+			Logger::logf("Clustered lighting, %zu lights, %u clusters: SIMD build %.3f ms, all pairs scalar %.3f ms (%.1fx)", 
+				numLights, static_cast<uint32_t>(ClusteredLightCuller::NUM_CLUSTERS), simdMs, scalarMs, scalarMs / simdMs);
+			Logger::logf("  %zu clusters used, %.1f avg / %u max lights per used cluster, %zu indices, %.1f KB uploaded", 
+				stats.m_numOccupiedClusters, stats.m_avgLightsPerOccupiedCluster, stats.m_maxLightsPerCluster, 
+				stats.m_numIndices, uploadBytes / 1024.0);
+		}
+	}
+} }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace Phoenix { namespace Tests
+{
+	void runRenderTests();
+
+	void radixSortTest();
+
+	void commandKeyTest();
+
+	void commandBucketOrderTest();
+
+	void recordingContextTest();
+
+	void deferredFrameTest();
+
+	void glStateFilterTest();
+
+	void frustumCullingTest();
+
+	void occlusionCullingTest();
+
+	void clusteredLightingTest();
+
+	void runRenderBenchmarks();
+
+	void commandBucketBenchmark();
+
+	void recordingContextBenchmark();
+
+	void deferredFrameBenchmark();
+
+	void frustumCullingBenchmark();
+
+	void occlusionCullingBenchmark();
+
+	void clusteredLightingBenchmark();
+} }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "TestUtil.hpp"
+
+#include <Math/Matrix4.hpp>
+#include <Math/PhiMath.hpp>
+#include <Render/FrustumCulling.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	void createTestFrustum(const Vec3& eye, const Vec3& target, float yFov, float aspect, float nearPlane, float farPlane, Plane* outPlanes)
+	{
+		Vec3 eyePos = eye;
+		Vec3 targetPos = target;
+		Vec3 up(0.f, 1.f, 0.f);
+
+		Matrix4 view = lookAtRH(eyePos, targetPos, up);
+		Matrix4 projection = perspectiveRH(yFov, aspect, nearPlane, farPlane);
+
+		extractFrustumPlanes(projection * view, outPlanes);
+	}
+} }
\ No newline at end of file
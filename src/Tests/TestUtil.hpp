@@ -0,0 +1,10 @@
+#pragma once
+
+#include <Math/Plane.hpp>
+#include <Math/Vec3.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	// Frustum planes of a camera at eye looking at target with y up, see extractFrustumPlanes().
+	void createTestFrustum(const Vec3& eye, const Vec3& target, float yFov, float aspect, float nearPlane, float farPlane, Plane* outPlanes);
+} }
\ No newline at end of file
@@ -0,0 +1,2108 @@
+#include "WorldTests.hpp"
+#include "TestUtil.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <unordered_map>
+
+#include <Core/AabbTree.hpp>
+#include <Core/Archetype.hpp>
+#include <Core/Mesh.hpp>
+#include <Core/SystemScheduler.hpp>
+#include <Core/TransformHierarchy.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Serialize.hpp>
+#include <Core/SerialUtil.hpp>
+#include <Core/World.hpp>
+#include <Core/WorldFile.hpp>
+#include <Core/WorkerPool.hpp>
+#include <Core/Components/CStaticMesh.hpp>
+#include <Core/Components/CTransform.hpp>
+#include <Math/PhiMath.hpp>
+#include <Math/Vec4.hpp>
+#include <Render/FrustumCulling.hpp>
+
+namespace Phoenix { namespace Tests
+{
+	void runWorldTests()
+	{
+		aabbTreeTest();
+		staticMeshRaycastTest();
+		archetypeTest();
+		entityHandleTest();
+		viewTest();
+		transformHierarchyTest();
+		changeVersionTest();
+		systemSchedulerTest();
+	}
+
+	void runWorldFileTests()
+	{
+		worldFileTest();
+		worldFileHierarchyTest();
+	}
+
+	void runWorldBenchmarks()
+	{
+		aabbTreeBenchmark();
+		archetypeIterationBenchmark();
+		entityChurnBenchmark();
+		viewBenchmark();
+		transformHierarchyBenchmark();
+		changeVersionBenchmark();
+		systemSchedulerBenchmark();
+		worldFileBenchmark();
+	}
+
+	// Stands in for the light components, which live with their system in main.cpp. Counts its
+	// instances to check the archetypes construct and destruct every component exactly once.
+	class TestLight : public Component
+	{
+	public:
+		TestLight() : m_value(0) { ++s_numAlive; }
+		TestLight(const TestLight& other) : Component(other), m_value(other.m_value) { ++s_numAlive; }
+		~TestLight() { --s_numAlive; }
+
+		virtual void save(Archive* ar) override { ar->serialize(&m_value, sizeof(m_value)); }
+		virtual void load(Archive* ar, LoadResources* resources) override { ar->serialize(&m_value, sizeof(m_value)); }
+
+		int m_value;
+		static int s_numAlive;
+
+		IMPL_EC_TYPE_ID(ECType::CT_PointLight, "TestLight");
+	};
+
+	int TestLight::s_numAlive = 0;
+
+	static Aabb createRandomBox(std::mt19937& rng, float worldSize, float maxBoxSize)
+	{
+		std::uniform_real_distribution<float> position(-worldSize, worldSize);
+		std::uniform_real_distribution<float> size(0.1f * maxBoxSize, maxBoxSize);
+
+		Vec3 min(position(rng), position(rng), position(rng));
+		return Aabb(min, min + Vec3(size(rng), size(rng), size(rng)));
+	}
+
+	static bool isBehindPlane(const Aabb& box, const Plane& plane)
+	{
+		Vec3 center = (box.m_min + box.m_max) * 0.5f;
+		Vec3 extent = (box.m_max - box.m_min) * 0.5f;
+		float radius = fabsf(plane.n.x) * extent.x + fabsf(plane.n.y) * extent.y + fabsf(plane.n.z) * extent.z;
+
+		return plane.dot(center) + radius < 0.f;
+	}
+
+	// Compares all queries of the tree with testing every live proxy.
+	static void checkTreeQueries(const AabbTree& tree, const std::vector<int32_t>& proxies, std::mt19937& rng)
+	{
+		tree.validate();
+		assert(tree.getNumProxies() == std::count_if(proxies.begin(), proxies.end(), [](int32_t p) { return p != AabbTree::NULL_NODE; }));
+
+		std::vector<uint32_t> result;
+		std::vector<uint32_t> expected;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			Aabb queryBox = createRandomBox(rng, 100.f, 60.f);
+			tree.queryAabb(queryBox, &result);
+
+			expected.clear();
+			for (size_t j = 0; j < proxies.size(); ++j)
+			{
+				if (proxies[j] != AabbTree::NULL_NODE && tree.getFatBounds(proxies[j]).overlaps(queryBox))
+				{
+					expected.push_back(static_cast<uint32_t>(j));
+				}
+			}
+
+			std::sort(result.begin(), result.end());
+			assert(result == expected);
+		}
+
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			Plane planes[NUM_FRUSTUM_PLANES];
+			createTestFrustum(Vec3(position(rng), position(rng), position(rng)), Vec3(position(rng), position(rng), position(rng)), 70.f, 16.f / 9.f, 0.1f, 150.f, planes);
+
+			tree.queryFrustum(planes, &result);
+
+			expected.clear();
+			for (size_t j = 0; j < proxies.size(); ++j)
+			{
+				if (proxies[j] == AabbTree::NULL_NODE)
+				{
+					continue;
+				}
+
+				const Aabb& box = tree.getFatBounds(proxies[j]);
+				bool bCulled = false;
+
+				for (const Plane& plane : planes)
+				{
+					bCulled = bCulled || isBehindPlane(box, plane);
+				}
+
+				if (!bCulled)
+				{
+					expected.push_back(static_cast<uint32_t>(j));
+				}
+			}
+
+			std::sort(result.begin(), result.end());
+			assert(result == expected);
+		}
+
+		// The callback accepts every box the ray enters, so the closest box must be reported.
+		auto hitBox = [&tree, &proxies](uint32_t userData, const Ray& ray, float maxDistance) -> float
+		{
+			const Aabb& box = tree.getFatBounds(proxies[userData]);
+			std::pair<bool, float> hit = ray.intersect(box.m_min, box.m_max);
+
+			return hit.first ? hit.second : -1.f;
+		};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			Ray ray(Vec3(position(rng), position(rng), position(rng)), Vec3(position(rng), position(rng), position(rng)));
+
+			float expectedDistance = std::numeric_limits<float>::max();
+			bool bExpectedHit = false;
+
+			for (size_t j = 0; j < proxies.size(); ++j)
+			{
+				if (proxies[j] == AabbTree::NULL_NODE)
+				{
+					continue;
+				}
+
+				float distance = hitBox(static_cast<uint32_t>(j), ray, expectedDistance);
+
+				if (distance >= 0.f && distance <= expectedDistance)
+				{
+					expectedDistance = distance;
+					bExpectedHit = true;
+				}
+			}
+
+			uint32_t hitUserData = 0;
+			float hitDistance = 0.f;
+			bool bHit = tree.raycast(ray, std::numeric_limits<float>::max(), hitBox, &hitUserData, &hitDistance);
+
+			assert(bHit == bExpectedHit);
+			assert(!bHit || (hitDistance == expectedDistance && hitBox(hitUserData, ray, hitDistance) == hitDistance));
+		}
+	}
+
+	void aabbTreeTest()
+	{
+		std::mt19937 rng(11);
+		AabbTree tree(0.5f);
+
+		assert(tree.getNumProxies() == 0 && tree.getHeight() == 0);
+
+		std::vector<int32_t> proxies;
+		std::vector<Aabb> boxes;
+
+		for (uint32_t i = 0; i < 1000; ++i)
+		{
+			boxes.push_back(createRandomBox(rng, 100.f, 8.f));
+			proxies.push_back(tree.createProxy(boxes.back(), i));
+
+			assert(tree.getUserData(proxies.back()) == i);
+			assert(tree.getFatBounds(proxies.back()).contains(boxes.back()));
+		}
+
+		checkTreeQueries(tree, proxies, rng);
+
+		// Balanced to a height close to log2(1000).
+		assert(tree.getHeight() < 20);
+
+		// Small moves stay inside the enlarged bounds, large ones reinsert the leaf.
+		for (size_t i = 0; i < proxies.size(); i += 2)
+		{
+			Aabb moved(boxes[i].m_min + Vec3(0.25f), boxes[i].m_max + Vec3(0.25f));
+			assert(!tree.moveProxy(proxies[i], moved));
+		}
+
+		for (size_t i = 1; i < proxies.size(); i += 2)
+		{
+			boxes[i] = createRandomBox(rng, 100.f, 8.f);
+			assert(tree.moveProxy(proxies[i], boxes[i]));
+		}
+
+		checkTreeQueries(tree, proxies, rng);
+
+		for (size_t i = 0; i < proxies.size(); i += 3)
+		{
+			tree.destroyProxy(proxies[i]);
+			proxies[i] = AabbTree::NULL_NODE;
+		}
+
+		checkTreeQueries(tree, proxies, rng);
+
+		// Freed nodes are reused.
+		for (size_t i = 0; i < proxies.size(); i += 3)
+		{
+			proxies[i] = tree.createProxy(createRandomBox(rng, 100.f, 8.f), static_cast<uint32_t>(i));
+		}
+
+		checkTreeQueries(tree, proxies, rng);
+
+		tree.clear();
+		assert(tree.getNumProxies() == 0);
+		tree.validate();
+	}
+
+	void staticMeshRaycastTest()
+	{
+		// Unit quad in the xy plane, facing +z.
+		StaticMesh mesh;
+		mesh.m_data.setSize(4);
+		mesh.m_data.m_vertices = { Vec3(-1.f, -1.f, 0.f), Vec3(1.f, -1.f, 0.f), Vec3(1.f, 1.f, 0.f), Vec3(-1.f, 1.f, 0.f) };
+		mesh.m_data.m_indices = { 0, 1, 2, 0, 2, 3 };
+		computeMeshBounds(&mesh);
+
+		Matrix4 transform = Matrix4::translation(Vec3(0.f, 0.f, -10.f)) * Matrix4::scale(Vec3(2.f, 2.f, 2.f));
+
+		float distance = raycastStaticMesh(mesh, transform, Ray(Vec3(1.5f, 1.5f, 0.f), Vec3(0.f, 0.f, -1.f)), 100.f);
+		assert(fabsf(distance - 10.f) < 1e-4f);
+
+		// From behind and at an angle.
+		distance = raycastStaticMesh(mesh, transform, Ray(Vec3(-10.f, 0.f, -20.f), Vec3(1.f, 0.f, 1.f)), 100.f);
+		assert(fabsf(distance - 10.f * sqrtf(2.f)) < 1e-4f);
+
+		// Outside the scaled quad, pointing away and out of range.
+		assert(raycastStaticMesh(mesh, transform, Ray(Vec3(2.5f, 0.f, 0.f), Vec3(0.f, 0.f, -1.f)), 100.f) < 0.f);
+		assert(raycastStaticMesh(mesh, transform, Ray(Vec3(0.f, 0.f, 0.f), Vec3(0.f, 0.f, 1.f)), 100.f) < 0.f);
+		assert(raycastStaticMesh(mesh, transform, Ray(Vec3(0.f, 0.f, 0.f), Vec3(0.f, 0.f, -1.f)), 9.f) < 0.f);
+	}
+
+	void aabbTreeBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t counts[3] = { 1000, 10000, 100000 };
+		const size_t numQueries = 1000;
+
+		for (size_t count : counts)
+		{
+			std::mt19937 rng(42);
+
+			// Constant density, the world grows with the number of objects.
+			const float worldSize = 10.f * cbrtf(static_cast<float>(count));
+
+			std::vector<Aabb> boxes(count);
+			for (Aabb& box : boxes)
+			{
+				box = createRandomBox(rng, worldSize, 4.f);
+			}
+
+			AabbTree tree(0.1f);
+			std::vector<int32_t> proxies(count);
+
+			Clock::time_point start = Clock::now();
+			for (size_t i = 0; i < count; ++i)
+			{
+				proxies[i] = tree.createProxy(boxes[i], static_cast<uint32_t>(i));
+			}
+			double buildMs = Ms(Clock::now() - start).count();
+
+			// A tenth of the objects moves a little, another tenth far enough to be reinserted.
+			start = Clock::now();
+			for (size_t i = 0; i < count; i += 10)
+			{
+				tree.moveProxy(proxies[i], Aabb(boxes[i].m_min + Vec3(0.05f), boxes[i].m_max + Vec3(0.05f)));
+			}
+			double smallMoveMs = Ms(Clock::now() - start).count();
+
+			start = Clock::now();
+			for (size_t i = 5; i < count; i += 10)
+			{
+				tree.moveProxy(proxies[i], Aabb(boxes[i].m_min + Vec3(5.f), boxes[i].m_max + Vec3(5.f)));
+			}
+			double largeMoveMs = Ms(Clock::now() - start).count();
+
+			// Frustums looking across the whole world from one corner and a short way from its center,
+			// against testing every box.
+			Plane wideFrustum[NUM_FRUSTUM_PLANES];
+			createTestFrustum(Vec3(-worldSize), Vec3(0.f), 70.f, 16.f / 9.f, 0.1f, 2.f * worldSize, wideFrustum);
+
+			Plane nearFrustum[NUM_FRUSTUM_PLANES];
+			createTestFrustum(Vec3(0.f), Vec3(0.f, 0.f, -1.f), 70.f, 16.f / 9.f, 0.1f, 0.25f * worldSize, nearFrustum);
+
+			FrustumCuller culler;
+			culler.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Aabb& box = tree.getFatBounds(proxies[i]);
+				Vec3 center = (box.m_min + box.m_max) * 0.5f;
+				Vec3 extent = (box.m_max - box.m_min) * 0.5f;
+				culler.addBounds(center, extent.length(), center, extent);
+			}
+
+			std::vector<uint32_t> visible;
+			const size_t numFrustumQueries = 20;
+
+			const Plane* frustums[2] = { wideFrustum, nearFrustum };
+			size_t numVisible[2];
+			double treeFrustumMs[2];
+			double flatFrustumMs[2];
+
+			for (int f = 0; f < 2; ++f)
+			{
+				start = Clock::now();
+				for (size_t i = 0; i < numFrustumQueries; ++i)
+				{
+					tree.queryFrustum(frustums[f], &visible);
+				}
+				treeFrustumMs[f] = Ms(Clock::now() - start).count() / numFrustumQueries;
+				numVisible[f] = visible.size();
+
+				start = Clock::now();
+				for (size_t i = 0; i < numFrustumQueries; ++i)
+				{
+					culler.cull(frustums[f], &visible);
+				}
+				flatFrustumMs[f] = Ms(Clock::now() - start).count() / numFrustumQueries;
+			}
+
+			std::vector<uint32_t> overlapping;
+			size_t numOverlapping = 0;
+
+			start = Clock::now();
+			for (size_t i = 0; i < numQueries; ++i)
+			{
+				tree.queryAabb(createRandomBox(rng, worldSize, 20.f), &overlapping);
+				numOverlapping += overlapping.size();
+			}
+			double aabbQueryUs = Ms(Clock::now() - start).count() * 1000.0 / numQueries;
+
+			auto hitBox = [&tree, &proxies](uint32_t userData, const Ray& ray, float maxDistance) -> float
+			{
+				const Aabb& box = tree.getFatBounds(proxies[userData]);
+				std::pair<bool, float> hit = ray.intersect(box.m_min, box.m_max);
+
+				return hit.first ? hit.second : -1.f;
+			};
+
+			std::uniform_real_distribution<float> position(-worldSize, worldSize);
+			size_t numHits = 0;
+
+			start = Clock::now();
+			for (size_t i = 0; i < numQueries; ++i)
+			{
+				Ray ray(Vec3(position(rng), position(rng), position(rng)), Vec3(position(rng), position(rng), position(rng)));
+
+				uint32_t hitUserData;
+				float distance;
+				numHits += tree.raycast(ray, std::numeric_limits<float>::max(), hitBox, &hitUserData, &distance) ? 1 : 0;
+			}
+			double rayQueryUs = Ms(Clock::now() - start).count() * 1000.0 / numQueries;
+
+			Logger::logf("AABB tree, %zu objects: height %d, build %.2f ms (%.0f ns per object)", count, tree.getHeight(), buildMs, buildMs * 1e6 / count);
+			Logger::logf("  moving 10%% inside the margin %.3f ms, moving 10%% out of it %.3f ms", smallMoveMs, largeMoveMs);
+			Logger::logf("  whole world frustum, %zu visible: tree %.3f ms, flat SSE %.3f ms", numVisible[0], treeFrustumMs[0], flatFrustumMs[0]);
+			Logger::logf("  near frustum, %zu visible: tree %.3f ms, flat SSE %.3f ms", numVisible[1], treeFrustumMs[1], flatFrustumMs[1]);
+			Logger::logf("  aabb query %.2f us (%.1f results), ray query %.2f us (%zu of %zu hit)",
+				aabbQueryUs, static_cast<double>(numOverlapping) / numQueries, rayQueryUs, numHits, numQueries);
+		}
+	}
+
+	void archetypeTest()
+	{
+		{
+			// Removing a row moves the last one into it.
+			ComponentTypeInfo typeInfos[ECType::CT_Max] = {};
+			typeInfos[ECType::CT_PointLight] = makeComponentTypeInfo<TestLight>();
+
+			Archetype archetype(makeComponentMask<TestLight>(), typeInfos);
+
+			for (EntityHandle entity = 1; entity <= 3; ++entity)
+			{
+				size_t row = archetype.addRow(entity, 1);
+				archetype.getColumn<TestLight>(0)[row].m_value = entity * 10;
+			}
+
+			assert(archetype.getComponent(ECType::CT_Transform, 0) == nullptr);
+			assert(archetype.removeRow(0) == 3);
+			assert(archetype.size() == 2);
+			assert(archetype.getEntity(0) == 3 && archetype.getColumn<TestLight>(0)[0].m_value == 30);
+			assert(archetype.removeRow(1) == 2);
+			assert(archetype.size() == 1 && TestLight::s_numAlive == 1);
+		}
+
+		assert(TestLight::s_numAlive == 0);
+
+		{
+			World world;
+			world.registerComponentType<CTransform>();
+			world.registerComponentType<CStaticMesh>();
+			world.registerComponentType<TestLight>();
+
+			// More than two chunks, adding the same types in different orders and setting values
+			// in between, so components are moved with live data and the last rows are swapped around.
+			const int numEntities = 3 * Archetype::ENTITIES_PER_CHUNK + 17;
+			std::vector<EntityHandle> entities;
+
+			for (int i = 0; i < numEntities; ++i)
+			{
+				EntityHandle entity = world.createEntity();
+				entities.push_back(entity);
+
+				if (i % 3 == 1)
+				{
+					world.addComponent<CStaticMesh>(entity)->m_lod = static_cast<uint8_t>(i);
+				}
+
+				world.addComponent<CTransform>(entity)->setTranslation(Vec3(static_cast<float>(i), 0.f, 0.f));
+
+				if (i % 3 == 0)
+				{
+					world.addComponent<CStaticMesh>(entity)->m_lod = static_cast<uint8_t>(i);
+				}
+
+				if (i % 5 == 0)
+				{
+					world.addComponent<TestLight>(entity)->m_value = i;
+				}
+			}
+
+			const size_t numArchetypes = world.getNumArchetypes();
+			assert(numArchetypes <= 8);
+			assert(TestLight::s_numAlive == (numEntities + 4) / 5);
+
+			size_t numMeshes = 0;
+			for (int i = 0; i < numEntities; ++i)
+			{
+				EntityHandle entity = entities[i];
+				CTransform* tf = world.getComponent<CTransform>(entity);
+				CStaticMesh* sm = world.getComponent<CStaticMesh>(entity);
+				TestLight* light = world.getComponent<TestLight>(entity);
+
+				assert(tf && tf->m_owner == entity && tf->getTranslation().x == static_cast<float>(i));
+				assert((sm != nullptr) == (i % 3 != 2));
+				assert(!sm || (sm->m_owner == entity && sm->m_lod == static_cast<uint8_t>(i)));
+				assert((light != nullptr) == (i % 5 == 0));
+				assert(!light || light->m_value == i);
+
+				// Adding a type the entity has returns the existing component.
+				assert(world.addComponent<CTransform>(entity) == tf);
+
+				numMeshes += sm ? 1 : 0;
+			}
+
+			size_t numVisited = 0;
+			world.forEach<CTransform, CStaticMesh>([&](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+			{
+				assert(world.getComponent<CTransform>(entity) == &tf);
+				assert(world.getComponent<CStaticMesh>(entity) == &sm);
+				++numVisited;
+			});
+			assert(numVisited == numMeshes);
+
+			numVisited = 0;
+			world.forEach<TestLight>([&](EntityHandle entity, TestLight& light)
+			{
+				assert(entities[light.m_value] == entity);
+				++numVisited;
+			});
+			assert(numVisited == static_cast<size_t>(TestLight::s_numAlive));
+
+			// Another entity taking the same path reuses the archetypes and the cached edges.
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CStaticMesh>(entity);
+			world.addComponent<CTransform>(entity);
+			world.addComponent<TestLight>(entity);
+			assert(world.getNumArchetypes() == numArchetypes);
+		}
+
+		assert(TestLight::s_numAlive == 0);
+	}
+
+	void archetypeIterationBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 100000;
+		const int numPasses = 20;
+
+		StaticMesh mesh;
+		mesh.m_aabbMin = Vec3(-1.f, -2.f, -3.f);
+		mesh.m_aabbMax = Vec3(3.f, 2.f, 1.f);
+		const Vec4 center((mesh.m_aabbMin + mesh.m_aabbMax) * 0.5f, 1.f);
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+
+		// The layout before archetypes: systems own arrays of components, entities map types to
+		// them and the transform of a mesh is found through the entity of the mesh.
+		struct OldEntity
+		{
+			std::unordered_map<ECType, Component*> m_components;
+		};
+
+		std::vector<OldEntity> oldEntities(count + 1);
+		std::vector<CTransform> oldTransforms(count);
+		std::vector<CStaticMesh> oldMeshes(count);
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Matrix4 transform = Matrix4::translation(Vec3(position(rng), position(rng), position(rng)));
+
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity)->m_transform = transform;
+			world.addComponent<CStaticMesh>(entity)->m_mesh = &mesh;
+
+			OldEntity& oldEntity = oldEntities[entity];
+			oldTransforms[i].m_transform = transform;
+			oldTransforms[i].m_owner = entity;
+			oldMeshes[i].m_mesh = &mesh;
+			oldMeshes[i].m_owner = entity;
+			oldEntity.m_components.emplace(ECType::CT_Transform, &oldTransforms[i]);
+			oldEntity.m_components.emplace(ECType::CT_StaticMesh, &oldMeshes[i]);
+		}
+
+		// Each pass moves the bounds center of every mesh to world space.
+		float sums[3] = { 0.f, 0.f, 0.f };
+
+		Clock::time_point start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			for (CStaticMesh& sm : oldMeshes)
+			{
+				CTransform* tf = static_cast<CTransform*>(oldEntities[sm.m_owner].m_components[ECType::CT_Transform]);
+				sums[0] += (tf->m_transform * center).x;
+			}
+		}
+		double oldMs = Ms(Clock::now() - start).count() / numPasses;
+
+		start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			world.forEach<CStaticMesh>([&](EntityHandle entity, CStaticMesh& sm)
+			{
+				sums[1] += (world.getComponent<CTransform>(entity)->m_transform * center).x;
+			});
+		}
+		double lookupMs = Ms(Clock::now() - start).count() / numPasses;
+
+		start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			world.forEach<CTransform, CStaticMesh>([&](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+			{
+				sums[2] += (tf.m_transform * center).x;
+			});
+		}
+		double columnsMs = Ms(Clock::now() - start).count() / numPasses;
+
+		assert(sums[0] == sums[1] && sums[1] == sums[2]);
+
+		Logger::logf("Iterating %zu CTransform+CStaticMesh entities, %d passes (checksum %.1f):", count, numPasses, sums[2]);
+		Logger::logf("  system arrays with per entity type map: %.3f ms", oldMs);
+		Logger::logf("  archetype mesh column, World::getComponent for the transform: %.3f ms", lookupMs);
+		Logger::logf("  archetype forEach over both columns: %.3f ms (%.1fx)", columnsMs, oldMs / columnsMs);
+	}
+
+	void entityHandleTest()
+	{
+		assert(entityIndex(makeEntityHandle(12345, 678)) == 12345);
+		assert(entityGeneration(makeEntityHandle(12345, 678)) == 678);
+		assert(entityGeneration(makeEntityHandle(ENTITY_INDEX_MASK, ENTITY_GENERATION_MASK)) == ENTITY_GENERATION_MASK);
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<TestLight>();
+
+		assert(!world.handleIsValid(World::INVALID_ENTITY));
+
+		// Enough entities for several pages of slots. The components of the first one have to stay
+		// where they are while more are added to its archetype.
+		const size_t count = 3 * World::ENTITIES_PER_PAGE;
+		std::vector<EntityHandle> entities;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			entities.push_back(world.createEntity());
+			world.addComponent<CTransform>(entities.back())->setTranslation(Vec3(static_cast<float>(i), 0.f, 0.f));
+		}
+
+		world.addComponent<TestLight>(entities[0]);
+		CTransform* first = world.getComponent<CTransform>(entities[0]);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity);
+			world.addComponent<TestLight>(entity);
+		}
+
+		assert(world.getComponent<CTransform>(entities[0]) == first);
+		assert(world.getNumEntities() == 2 * count);
+
+		// Destroying every other entity moves the last rows of the archetype into the freed ones.
+		for (size_t i = 1; i < count; i += 2)
+		{
+			world.destroyEntity(entities[i]);
+			assert(!world.handleIsValid(entities[i]));
+		}
+
+		for (size_t i = 0; i < count; i += 2)
+		{
+			assert(world.handleIsValid(entities[i]));
+			assert(world.getComponent<CTransform>(entities[i])->getTranslation().x == static_cast<float>(i));
+		}
+
+		assert(world.getNumEntities() == 2 * count - count / 2);
+
+		size_t numVisited = 0;
+		world.forEachEntity([&](EntityHandle entity)
+		{
+			assert(world.handleIsValid(entity));
+			++numVisited;
+		});
+		assert(numVisited == world.getNumEntities());
+
+		// Freed slots are reused oldest first, with the next generation, once enough of them are free.
+		EntityHandle reused = world.createEntity();
+		assert(entityIndex(reused) == entityIndex(entities[1]));
+		assert(entityGeneration(reused) == entityGeneration(entities[1]) + 1);
+		assert(world.handleIsValid(reused) && !world.handleIsValid(entities[1]));
+		assert(world.getComponent<CTransform>(reused) == nullptr);
+
+		// Destroying entities from forEachEntity, including their components.
+		world.forEachEntity([&](EntityHandle entity)
+		{
+			world.destroyEntity(entity);
+		});
+
+		assert(world.getNumEntities() == 0);
+		assert(TestLight::s_numAlive == 0);
+
+		for (EntityHandle entity : entities)
+		{
+			assert(!world.handleIsValid(entity));
+		}
+	}
+
+	void entityChurnBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+
+		// A steady population where a tenth of the entities is replaced every frame.
+		const size_t population = 100000;
+		const size_t churnPerFrame = population / 10;
+		const int numFrames = 100;
+
+		std::mt19937 rng(42);
+		std::vector<EntityHandle> live;
+
+		for (size_t i = 0; i < population; ++i)
+		{
+			live.push_back(world.createEntity());
+		}
+
+		Clock::time_point start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (size_t i = 0; i < churnPerFrame; ++i)
+			{
+				size_t victim = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+				world.destroyEntity(live[victim]);
+
+				EntityHandle entity = world.createEntity();
+				world.addComponent<CTransform>(entity);
+				world.addComponent<CStaticMesh>(entity);
+				live[victim] = entity;
+			}
+		}
+		double churnMs = Ms(Clock::now() - start).count();
+
+		// Bare create and destroy without components.
+		const size_t numBare = 1000000;
+		std::vector<EntityHandle> bare(numBare);
+
+		start = Clock::now();
+		for (size_t i = 0; i < numBare; ++i)
+		{
+			bare[i] = world.createEntity();
+		}
+		for (size_t i = 0; i < numBare; ++i)
+		{
+			world.destroyEntity(bare[i]);
+		}
+		double bareMs = Ms(Clock::now() - start).count();
+
+		const double numChurned = static_cast<double>(churnPerFrame) * numFrames;
+
+		Logger::logf("Entity churn, %zu live, %zu replaced per frame with CTransform+CStaticMesh: %.2f ms per frame, %.2fM create+destroy per second",
+			population, churnPerFrame, churnMs / numFrames, numChurned / churnMs / 1000.0);
+		Logger::logf("  %zu bare entities created and destroyed in %.2f ms, %.2fM create+destroy per second",
+			numBare, bareMs, numBare / bareMs / 1000.0);
+	}
+
+	void viewTest()
+	{
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+		world.registerComponentType<TestLight>();
+
+		// Made before any matching archetype exists.
+		View<CTransform, CStaticMesh> meshes = world.view<CTransform, CStaticMesh>();
+		assert(meshes.size() == 0 && meshes.getArchetypes().empty());
+
+		const size_t count = 1000;
+		size_t numMeshes = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity)->setTranslation(Vec3(static_cast<float>(i), 0.f, 0.f));
+
+			if (i % 2 == 0)
+			{
+				world.addComponent<CStaticMesh>(entity);
+				++numMeshes;
+			}
+
+			if (i % 3 == 0)
+			{
+				world.addComponent<TestLight>(entity);
+			}
+		}
+
+		// Transform+mesh with and without a light, the transform only ones do not match.
+		assert(meshes.getArchetypes().size() == 2);
+		assert(meshes.size() == numMeshes);
+		View<CTransform, CStaticMesh> again = world.view<CTransform, CStaticMesh>();
+		assert(&again.getArchetypes() == &meshes.getArchetypes());
+
+		float sum = 0.f;
+		meshes.forEach([&](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+		{
+			assert(world.getComponent<CStaticMesh>(entity) == &sm);
+			sum += tf.getTranslation().x;
+		});
+
+		float chunkSum = 0.f;
+		size_t numVisited = 0;
+		meshes.forEachChunk([&](size_t chunkSize, const EntityHandle* entities, CTransform* transforms, CStaticMesh* staticMeshes)
+		{
+			assert(chunkSize > 0 && chunkSize <= Archetype::ENTITIES_PER_CHUNK);
+
+			for (size_t i = 0; i < chunkSize; ++i)
+			{
+				assert(world.getComponent<CTransform>(entities[i]) == &transforms[i]);
+				chunkSum += transforms[i].getTranslation().x;
+			}
+
+			numVisited += chunkSize;
+		});
+
+		assert(numVisited == numMeshes && sum == chunkSum);
+		assert(world.view<TestLight>().size() == (count + 2) / 3);
+		assert(world.view<>().size() == count);
+	}
+
+	void viewBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 100000;
+		const int numPasses = 20;
+
+		StaticMesh mesh;
+		mesh.m_aabbMin = Vec3(-1.f, -2.f, -3.f);
+		mesh.m_aabbMax = Vec3(3.f, 2.f, 1.f);
+		const Vec4 center((mesh.m_aabbMin + mesh.m_aabbMax) * 0.5f, 1.f);
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+		world.registerComponentType<TestLight>();
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+
+		// A quarter of the meshes also have a light, and as many entities again only have a
+		// transform, so the view spans two archetypes and has to skip a third.
+		std::vector<CStaticMesh*> meshes;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity)->m_transform = Matrix4::translation(Vec3(position(rng), position(rng), position(rng)));
+
+			if (i % 4 == 0)
+			{
+				world.addComponent<TestLight>(entity);
+			}
+
+			world.addComponent<CStaticMesh>(entity)->m_mesh = &mesh;
+			world.addComponent<CTransform>(world.createEntity());
+		}
+
+		// Component pointers are stable from here on, like the system owned arrays were.
+		world.forEach<CStaticMesh>([&meshes](EntityHandle, CStaticMesh& sm)
+		{
+			meshes.push_back(&sm);
+		});
+
+		float sums[3] = { 0.f, 0.f, 0.f };
+
+		Clock::time_point start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			for (CStaticMesh* sm : meshes)
+			{
+				CTransform* tf = world.getComponent<CTransform>(sm->m_owner);
+				sums[0] += (tf->m_transform * center).x;
+			}
+		}
+		double lookupMs = Ms(Clock::now() - start).count() / numPasses;
+
+		start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			world.view<CTransform, CStaticMesh>().forEach([&](EntityHandle, CTransform& tf, CStaticMesh& sm)
+			{
+				sums[1] += (tf.m_transform * center).x;
+			});
+		}
+		double viewMs = Ms(Clock::now() - start).count() / numPasses;
+
+		start = Clock::now();
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			world.view<CTransform, CStaticMesh>().forEachChunk([&](size_t chunkSize, const EntityHandle*, CTransform* transforms, CStaticMesh*)
+			{
+				for (size_t i = 0; i < chunkSize; ++i)
+				{
+					sums[2] += (transforms[i].m_transform * center).x;
+				}
+			});
+		}
+		double chunkMs = Ms(Clock::now() - start).count() / numPasses;
+
+		assert(sums[1] == sums[2]);
+
+		Logger::logf("View over %zu CTransform+CStaticMesh entities in 2 of 3 archetypes, %d passes (checksum %.1f):", count, numPasses, sums[1]);
+		Logger::logf("  mesh list with World::getComponent<CTransform>(owner): %.3f ms", lookupMs);
+		Logger::logf("  view<CTransform, CStaticMesh>().forEach: %.3f ms (%.1fx)", viewMs, lookupMs / viewMs);
+		Logger::logf("  view<CTransform, CStaticMesh>().forEachChunk: %.3f ms (%.1fx)", chunkMs, lookupMs / chunkMs);
+	}
+
+	static Matrix4 createRandomLocal(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> offset(-2.f, 2.f);
+		std::uniform_real_distribution<float> angle(-180.f, 180.f);
+		std::uniform_real_distribution<float> scale(0.8f, 1.2f);
+
+		return Matrix4::translation(Vec3(offset(rng), offset(rng), offset(rng)))
+			 * Matrix4::rotation(Vec3(angle(rng), angle(rng), angle(rng)))
+			 * Matrix4::scale(Vec3(scale(rng), scale(rng), scale(rng)));
+	}
+
+	static void checkHierarchyWorlds(const TransformHierarchy& hierarchy, const std::vector<int32_t>& nodes)
+	{
+		for (int32_t node : nodes)
+		{
+			if (node == TransformHierarchy::NULL_NODE)
+			{
+				continue;
+			}
+
+			Matrix4 expected = hierarchy.getLocal(node);
+
+			for (int32_t parent = hierarchy.getParent(node); parent != TransformHierarchy::NULL_NODE; parent = hierarchy.getParent(parent))
+			{
+				expected = hierarchy.getLocal(parent) * expected;
+			}
+
+			const Matrix4& world = hierarchy.getWorld(node);
+
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int col = 0; col < 4; ++col)
+				{
+					assert(fabsf(world(row, col) - expected(row, col)) < 1e-3f * (1.f + fabsf(expected(row, col))));
+				}
+			}
+		}
+	}
+
+	void transformHierarchyTest()
+	{
+		std::mt19937 rng(7);
+		TransformHierarchy hierarchy;
+		std::vector<int32_t> nodes;
+
+		// Random forest, each node below one of the nodes before it or a root.
+		for (uint32_t i = 0; i < 2000; ++i)
+		{
+			int32_t parent = TransformHierarchy::NULL_NODE;
+
+			if (i > 0 && rng() % 8 != 0)
+			{
+				parent = nodes[rng() % nodes.size()];
+			}
+
+			nodes.push_back(hierarchy.createNode(i, parent));
+			hierarchy.setLocal(nodes.back(), createRandomLocal(rng));
+		}
+
+		TransformHierarchyStats stats = hierarchy.update();
+		assert(stats.m_bReordered && stats.m_numUpdated == nodes.size());
+		hierarchy.validate();
+		checkHierarchyWorlds(hierarchy, nodes);
+
+		// Nothing changed, nothing updated.
+		stats = hierarchy.update();
+		assert(!stats.m_bReordered && stats.m_numUpdated == 0);
+
+		// A node updates itself and its descendants only.
+		int32_t root = nodes[0];
+		size_t numDescendants = 0;
+
+		for (int32_t node : nodes)
+		{
+			for (int32_t ancestor = node; ancestor != TransformHierarchy::NULL_NODE; ancestor = hierarchy.getParent(ancestor))
+			{
+				numDescendants += ancestor == root ? 1 : 0;
+			}
+		}
+
+		hierarchy.setLocal(root, createRandomLocal(rng));
+		stats = hierarchy.update();
+		assert(stats.m_numUpdated == numDescendants);
+		assert(hierarchy.getUpdatedNodes()[0] == root);
+		checkHierarchyWorlds(hierarchy, nodes);
+
+		// Rounds of local changes, reparenting and destruction.
+		for (int round = 0; round < 20; ++round)
+		{
+			for (int i = 0; i < 50; ++i)
+			{
+				int32_t node = nodes[rng() % nodes.size()];
+
+				if (node != TransformHierarchy::NULL_NODE)
+				{
+					hierarchy.setLocal(node, createRandomLocal(rng));
+				}
+			}
+
+			for (int i = 0; i < 10; ++i)
+			{
+				int32_t node = nodes[rng() % nodes.size()];
+				int32_t parent = nodes[rng() % nodes.size()];
+
+				if (node == TransformHierarchy::NULL_NODE || parent == TransformHierarchy::NULL_NODE)
+				{
+					continue;
+				}
+
+				// Only parents outside the subtree of the node.
+				bool bInSubtree = false;
+
+				for (int32_t ancestor = parent; ancestor != TransformHierarchy::NULL_NODE; ancestor = hierarchy.getParent(ancestor))
+				{
+					bInSubtree |= ancestor == node;
+				}
+
+				hierarchy.setParent(node, bInSubtree ? TransformHierarchy::NULL_NODE : parent);
+			}
+
+			for (int i = 0; i < 5; ++i)
+			{
+				size_t index = rng() % nodes.size();
+
+				if (nodes[index] != TransformHierarchy::NULL_NODE)
+				{
+					hierarchy.destroyNode(nodes[index]);
+					nodes[index] = TransformHierarchy::NULL_NODE;
+				}
+			}
+
+			// Recycled ids.
+			for (int i = 0; i < 3; ++i)
+			{
+				nodes.push_back(hierarchy.createNode(0, nodes[0]));
+			}
+
+			hierarchy.update();
+			hierarchy.validate();
+			checkHierarchyWorlds(hierarchy, nodes);
+		}
+	}
+
+	void transformHierarchyBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 100000;
+		const int numFrames = 20;
+
+		// Deep: 100 chains of 1000 nodes. Wide: 100 roots with 999 children each.
+		const char* names[2] = { "deep, 100 chains of 1000", "wide, 100 roots with 999 children" };
+
+		for (int shape = 0; shape < 2; ++shape)
+		{
+			std::mt19937 rng(42);
+			TransformHierarchy hierarchy;
+			std::vector<int32_t> nodes;
+			std::vector<Matrix4> locals;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				int32_t parent = TransformHierarchy::NULL_NODE;
+
+				if (i % 1000 != 0)
+				{
+					parent = shape == 0 ? nodes.back() : nodes[i - i % 1000];
+				}
+
+				nodes.push_back(hierarchy.createNode(static_cast<uint32_t>(i), parent));
+				locals.push_back(createRandomLocal(rng));
+			}
+
+			Clock::time_point start = Clock::now();
+			for (size_t i = 0; i < count; ++i)
+			{
+				hierarchy.setLocal(nodes[i], locals[i]);
+			}
+			hierarchy.update();
+			double buildMs = Ms(Clock::now() - start).count();
+
+			// Steady state, 1% of the nodes move each frame.
+			size_t numSteadyUpdated = 0;
+
+			start = Clock::now();
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				for (size_t i = 0; i < count / 100; ++i)
+				{
+					size_t index = rng() % count;
+					hierarchy.setLocal(nodes[index], locals[index]);
+				}
+
+				numSteadyUpdated += hierarchy.update().m_numUpdated;
+			}
+			double steadyMs = Ms(Clock::now() - start).count() / numFrames;
+
+			// Steady state, 1% of the leaves move each frame.
+			size_t numLeafUpdated = 0;
+
+			start = Clock::now();
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				for (size_t i = 0; i < count / 100; ++i)
+				{
+					size_t index = shape == 0 ? (rng() % (count / 1000)) * 1000 + 999 : rng() % count;
+					index = index % 1000 == 0 ? index + 1 : index;
+					hierarchy.setLocal(nodes[index], locals[index]);
+				}
+
+				numLeafUpdated += hierarchy.update().m_numUpdated;
+			}
+			double leafMs = Ms(Clock::now() - start).count() / numFrames;
+
+			// Everything moves.
+			start = Clock::now();
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					hierarchy.setLocal(nodes[i], locals[i]);
+				}
+
+				hierarchy.update();
+			}
+			double allMs = Ms(Clock::now() - start).count() / numFrames;
+
+			// Nothing moves.
+			start = Clock::now();
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				hierarchy.update();
+			}
+			double idleMs = Ms(Clock::now() - start).count() / numFrames;
+
+			Logger::logf("Transform hierarchy, %zu nodes %s: first update with reorder %.2f ms", count, names[shape], buildMs);
+			Logger::logf("  1%% random nodes move: %.3f ms per frame, %zu world transforms updated", steadyMs, numSteadyUpdated / numFrames);
+			Logger::logf("  1%% leaves move: %.3f ms per frame, %zu world transforms updated", leafMs, numLeafUpdated / numFrames);
+			Logger::logf("  all move: %.3f ms per frame (%.1fM matrices/s), nothing moves: %.3f ms", allMs, count / allMs / 1000.0, idleMs);
+		}
+	}
+
+	void changeVersionTest()
+	{
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+		world.registerComponentType<TestLight>();
+
+		View<CTransform> transforms = world.view<CTransform>();
+		auto countChanged = [&transforms](uint32_t sinceVersion)
+		{
+			size_t count = 0;
+			transforms.forEachChangedSince<CTransform>(sinceVersion, [&count](EntityHandle, CTransform&) { ++count; });
+			return count;
+		};
+
+		const size_t count = 3 * Archetype::ENTITIES_PER_CHUNK;
+		std::vector<EntityHandle> entities;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			entities.push_back(world.createEntity());
+			world.addComponent<CTransform>(entities.back());
+		}
+
+		// Everything is new to a system that has not looked yet.
+		assert(countChanged(0) == count);
+		uint32_t seen = world.advanceChangeVersion();
+		assert(countChanged(seen) == 0);
+
+		// Marked changes, and changes moving with their entity to another archetype or row.
+		world.markChanged<CTransform>(entities[5]);
+		world.markChanged<CTransform>(entities[300]);
+		world.addComponent<TestLight>(entities[5]);
+		world.destroyEntity(entities[100]);
+
+		std::vector<EntityHandle> changed;
+		transforms.forEachChangedSince<CTransform>(seen, [&changed](EntityHandle entity, CTransform&)
+		{
+			changed.push_back(entity);
+		});
+
+		std::sort(changed.begin(), changed.end());
+		assert(changed.size() == 2 && changed[0] == entities[5] && changed[1] == entities[300]);
+
+		// Adding a component changes only that one.
+		world.addComponent<CStaticMesh>(entities[7]);
+
+		size_t numNewMeshes = 0;
+		world.view<CTransform, CStaticMesh>().forEachChangedSince<CStaticMesh>(seen, [&](EntityHandle entity, CTransform&, CStaticMesh&)
+		{
+			assert(entity == entities[7]);
+			++numNewMeshes;
+		});
+		assert(numNewMeshes == 1);
+		assert(world.getEntity(entities[7])->m_archetype->getChangeVersion(ECType::CT_Transform, world.getEntity(entities[7])->m_row) < world.getChangeVersion());
+
+		// Two systems with their own last seen versions.
+		uint32_t seenByFirst = world.advanceChangeVersion();
+		world.markChanged<CTransform>(entities[1]);
+		uint32_t seenBySecond = world.advanceChangeVersion();
+		world.markChanged<CTransform>(entities[2]);
+
+		assert(countChanged(seenByFirst) == 2);
+		assert(countChanged(seenBySecond) == 1);
+	}
+
+	void changeVersionBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 100000;
+		const size_t numChangedPerFrame = count / 100;
+		const int numFrames = 20;
+
+		StaticMesh mesh;
+		mesh.m_aabbMin = Vec3(-1.f, -2.f, -3.f);
+		mesh.m_aabbMax = Vec3(3.f, 2.f, 1.f);
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+
+		std::mt19937 rng(42);
+		std::vector<EntityHandle> entities;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			entities.push_back(world.createEntity());
+			world.addComponent<CTransform>(entities.back());
+			world.addComponent<CStaticMesh>(entities.back())->m_mesh = &mesh;
+		}
+
+		View<CTransform, CStaticMesh> meshes = world.view<CTransform, CStaticMesh>();
+
+		// Downstream work: the world bounds of a mesh, as the mesh system recomputes them for the tree.
+		Vec3 boundsSum(0.f);
+		auto updateBounds = [&boundsSum](EntityHandle, CTransform& tf, CStaticMesh& sm)
+		{
+			Vec3 center;
+			Vec3 extent;
+			transformAabb(tf.m_transform, sm.m_mesh->m_aabbMin, sm.m_mesh->m_aabbMax, &center, &extent);
+			boundsSum += center + extent;
+		};
+
+		double fullMs = 0.0;
+		double changedMs = 0.0;
+		size_t numFullVisited = 0;
+		size_t numChangedVisited = 0;
+		uint32_t lastSeen = world.advanceChangeVersion();
+
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (size_t i = 0; i < numChangedPerFrame; ++i)
+			{
+				EntityHandle entity = entities[rng() % count];
+				world.getComponent<CTransform>(entity)->m_transform = Matrix4::translation(Vec3(static_cast<float>(frame)));
+				world.markChanged<CTransform>(entity);
+			}
+
+			// Without versions every bounds has to be assumed changed.
+			Clock::time_point start = Clock::now();
+			meshes.forEach([&](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+			{
+				updateBounds(entity, tf, sm);
+				++numFullVisited;
+			});
+			fullMs += Ms(Clock::now() - start).count();
+
+			start = Clock::now();
+			meshes.forEachChangedSince<CTransform>(lastSeen, [&](EntityHandle entity, CTransform& tf, CStaticMesh& sm)
+			{
+				updateBounds(entity, tf, sm);
+				++numChangedVisited;
+			});
+			lastSeen = world.advanceChangeVersion();
+			changedMs += Ms(Clock::now() - start).count();
+		}
+
+		Logger::logf("Change versions, %zu transforms with 1%% changing per frame (checksum %.1f):", count, boundsSum.x);
+		Logger::logf("  all bounds: %.3f ms per frame, %zu updated", fullMs / numFrames, numFullVisited / numFrames);
+		Logger::logf("  changed since last frame: %.3f ms per frame, %zu updated (%.1fx less work)",
+			changedMs / numFrames, numChangedVisited / numFrames, fullMs / changedMs);
+	}
+
+	void systemSchedulerTest()
+	{
+		// Nested parallel for, the waiting tasks run the inner ranges.
+		{
+			WorkerPool pool(4);
+			std::vector<int> hits(10000, 0);
+
+			pool.parallelFor(100, 7, [&](size_t begin, size_t end)
+			{
+				for (size_t outer = begin; outer < end; ++outer)
+				{
+					pool.parallelFor(100, 16, [&](size_t innerBegin, size_t innerEnd)
+					{
+						for (size_t inner = innerBegin; inner < innerEnd; ++inner)
+						{
+							++hits[outer * 100 + inner];
+						}
+					});
+				}
+			});
+
+			assert(std::all_of(hits.begin(), hits.end(), [](int n) { return n == 1; }));
+		}
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+		world.registerComponentType<TestLight>();
+
+		const size_t count = 3000;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity);
+
+			if (i % 2 == 0)
+			{
+				world.addComponent<CStaticMesh>(entity);
+			}
+
+			if (i % 3 == 0)
+			{
+				world.addComponent<TestLight>(entity);
+			}
+		}
+
+		WorkerPool pool(4);
+		SystemScheduler scheduler(&world, &pool);
+
+		const ComponentMask transformMask = makeComponentMask<CTransform>();
+		const ComponentMask meshMask = makeComponentMask<CStaticMesh>();
+		const ComponentMask lightMask = makeComponentMask<TestLight>();
+
+		int frame = 0;
+		std::atomic<int32_t> numMovedChecked(0);
+		std::atomic<int32_t> numLightsChecked(0);
+
+		// Moves every transform to the frame number, chunk by chunk on the pool.
+		const int32_t move = scheduler.addSystem("Move", 0, transformMask, [&frame](World* w, WorkerPool* p)
+		{
+			parallelForEachChunk(p, w->view<CTransform>(), [&frame](size_t n, const EntityHandle*, CTransform* transforms)
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					transforms[i].setTranslation(Vec3(static_cast<float>(frame), 0.f, 0.f));
+				}
+			});
+		});
+
+		// Has to see the transforms of this frame.
+		const int32_t meshes = scheduler.addSystem("Meshes", transformMask, meshMask, [&](World* w, WorkerPool* p)
+		{
+			parallelForEachChunk(p, w->view<CTransform, CStaticMesh>(), [&](size_t n, const EntityHandle*, CTransform* transforms, CStaticMesh* sm)
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					assert(transforms[i].getTranslation().x == static_cast<float>(frame));
+					sm[i].m_proxy = frame;
+				}
+
+				numMovedChecked += static_cast<int32_t>(n);
+			}, 2);
+		});
+
+		// Independent of both.
+		const int32_t lights = scheduler.addSystem("Lights", 0, lightMask, [&frame](World* w, WorkerPool*)
+		{
+			w->forEach<TestLight>([&frame](EntityHandle, TestLight& light) { light.m_value = frame; });
+		});
+
+		// Reads what the first and third write, not what the second does.
+		const int32_t readBoth = scheduler.addSystem("Read both", transformMask | lightMask, 0, [&](World* w, WorkerPool*)
+		{
+			w->forEach<CTransform, TestLight>([&](EntityHandle, CTransform& tf, TestLight& light)
+			{
+				assert(light.m_value == frame && tf.getTranslation().x == static_cast<float>(frame));
+				++numLightsChecked;
+			});
+		});
+
+		const int32_t structural = scheduler.addSystem("Structural", 0, SystemScheduler::ALL_COMPONENTS, [](World*, WorkerPool*) {});
+
+		const int numFrames = 20;
+
+		for (frame = 1; frame <= numFrames; ++frame)
+		{
+			scheduler.run();
+		}
+
+		assert(scheduler.getDependencies(move).empty());
+		assert(scheduler.getDependencies(meshes) == std::vector<int32_t>(1, move));
+		assert(scheduler.getDependencies(lights).empty());
+
+		std::vector<int32_t> expected;
+		expected.push_back(move);
+		expected.push_back(lights);
+		assert(scheduler.getDependencies(readBoth) == expected);
+		assert(scheduler.getDependencies(structural).size() == 4);
+
+		assert(numMovedChecked == static_cast<int32_t>((count + 1) / 2 * numFrames));
+		assert(numLightsChecked == static_cast<int32_t>((count + 2) / 3 * numFrames));
+
+		world.forEach<CStaticMesh>([numFrames](EntityHandle, CStaticMesh& sm) { assert(sm.m_proxy == numFrames); });
+
+		const std::vector<SystemTiming>& timings = scheduler.getTimings();
+		assert(timings.size() == 5 && timings[meshes].m_bRan && timings[meshes].m_startMs + 1e-3 >= timings[move].m_startMs + timings[move].m_durationMs);
+
+		const SchedulerStats& stats = scheduler.getStats();
+		assert(stats.m_numThreads == 4 && stats.m_numDependencies == 7);
+		assert(stats.m_utilisation >= 0.0 && stats.m_utilisation <= 1.0);
+
+		// Disabled systems are not waited for and do not run, the transforms stay where they are.
+		frame = numFrames;
+		scheduler.setEnabled(move, false);
+		scheduler.run();
+		assert(scheduler.getDependencies(meshes).empty() && !scheduler.getTimings()[move].m_bRan);
+		assert(scheduler.getDependencies(structural).size() == 3);
+	}
+
+	void systemSchedulerBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const size_t count = 200000;
+		const int numFrames = 10;
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<CStaticMesh>();
+		world.registerComponentType<TestLight>();
+
+		StaticMesh mesh;
+		mesh.m_aabbMin = Vec3(-1.f, -2.f, -3.f);
+		mesh.m_aabbMax = Vec3(3.f, 2.f, 1.f);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			EntityHandle entity = world.createEntity();
+			world.addComponent<CTransform>(entity);
+			world.addComponent<TestLight>(entity)->m_value = static_cast<int>(i);
+
+			if (i % 2 == 0)
+			{
+				world.addComponent<CStaticMesh>(entity)->m_mesh = &mesh;
+			}
+		}
+
+		const ComponentMask transformMask = makeComponentMask<CTransform>();
+		const ComponentMask lightMask = makeComponentMask<TestLight>();
+		const ComponentMask meshMask = makeComponentMask<CStaticMesh>();
+
+		// Animation and lights are independent, bounds and flicker each wait for one of them.
+		std::vector<float> chunkBounds;
+		std::atomic<int32_t> numBright(0);
+		float time = 0.f;
+
+		const unsigned numCores = std::max(std::thread::hardware_concurrency(), 1u);
+		double oneThreadMs = 0.0;
+
+		Logger::logf("System scheduler, %zu entities, 4 systems in two chains, %d frames:", count, numFrames);
+
+		for (unsigned numThreads = 1; numThreads <= numCores; numThreads = numThreads < numCores ? std::min(numThreads * 2, numCores) : numThreads + 1)
+		{
+			WorkerPool pool(numThreads);
+			SystemScheduler scheduler(&world, &pool);
+
+			scheduler.addSystem("Animate", 0, transformMask, [&time](World* w, WorkerPool* p)
+			{
+				parallelForEachChunk(p, w->view<CTransform>(), [&time](size_t n, const EntityHandle*, CTransform* transforms)
+				{
+					for (size_t i = 0; i < n; ++i)
+					{
+						const float angle = time + static_cast<float>(i);
+						transforms[i].m_transform = Matrix4::translation(Vec3(sinf(angle), cosf(angle), 0.f)) * Matrix4::rotation(Vec3(angle, 0.f, 0.f));
+					}
+				});
+			});
+
+			scheduler.addSystem("Lights", 0, lightMask, [](World* w, WorkerPool* p)
+			{
+				parallelForEachChunk(p, w->view<TestLight>(), [](size_t n, const EntityHandle*, TestLight* lights)
+				{
+					for (size_t i = 0; i < n; ++i)
+					{
+						uint32_t x = static_cast<uint32_t>(lights[i].m_value);
+
+						for (int k = 0; k < 64; ++k)
+						{
+							x = x * 1664525u + 1013904223u;
+						}
+
+						lights[i].m_value = static_cast<int>(x >> 1);
+					}
+				});
+			});
+
+			scheduler.addSystem("Bounds", transformMask | meshMask, 0, [&chunkBounds](World* w, WorkerPool* p)
+			{
+				View<CTransform, CStaticMesh> meshes = w->view<CTransform, CStaticMesh>();
+				size_t numChunks = 0;
+
+				for (const Archetype* archetype : meshes.getArchetypes())
+				{
+					numChunks += archetype->getNumChunks();
+				}
+
+				chunkBounds.resize(numChunks);
+				std::atomic<size_t> nextChunk(0);
+
+				parallelForEachChunk(p, meshes, [&](size_t n, const EntityHandle*, CTransform* transforms, CStaticMesh* sm)
+				{
+					float sum = 0.f;
+
+					for (size_t i = 0; i < n; ++i)
+					{
+						Vec3 center;
+						Vec3 extent;
+						transformAabb(transforms[i].m_transform, sm[i].m_mesh->m_aabbMin, sm[i].m_mesh->m_aabbMax, &center, &extent);
+						sum += center.x + extent.x;
+					}
+
+					chunkBounds[nextChunk++] = sum;
+				});
+			});
+
+			scheduler.addSystem("Flicker", lightMask, 0, [&numBright](World* w, WorkerPool* p)
+			{
+				parallelForEachChunk(p, w->view<TestLight>(), [&numBright](size_t n, const EntityHandle*, TestLight* lights)
+				{
+					int32_t bright = 0;
+
+					for (size_t i = 0; i < n; ++i)
+					{
+						bright += (lights[i].m_value & 0xff) > 128;
+					}
+
+					numBright += bright;
+				});
+			});
+
+			std::vector<double> systemMs(4, 0.0);
+			double utilisation = 0.0;
+
+			const Clock::time_point start = Clock::now();
+
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				time += 0.1f;
+				scheduler.run();
+
+				for (size_t i = 0; i < systemMs.size(); ++i)
+				{
+					systemMs[i] += scheduler.getTimings()[i].m_durationMs;
+				}
+
+				utilisation += scheduler.getStats().m_utilisation;
+			}
+
+			const double frameMs = Ms(Clock::now() - start).count() / numFrames;
+
+			if (numThreads == 1)
+			{
+				oneThreadMs = frameMs;
+			}
+
+			Logger::logf("  %u threads: %.3f ms per frame, %.2fx, %.0f%% utilisation (animate %.2f, lights %.2f, bounds %.2f, flicker %.2f ms)",
+				numThreads, frameMs, oneThreadMs / frameMs, 100.0 * utilisation / numFrames,
+				systemMs[0] / numFrames, systemMs[1] / numFrames, systemMs[2] / numFrames, systemMs[3] / numFrames);
+		}
+
+		Logger::logf("  (checksum %d)", numBright.load());
+	}
+
+	// Every entity has a CTransform at a random position, every fourth a TestLight with a value
+	// of its index plus one as well.
+	static void createFileTestWorld(World* world, size_t count, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const bool bLight = i % 4 == 0;
+			const EntityHandle entity = world->createEntity(bLight ? makeComponentMask<CTransform, TestLight>() : makeComponentMask<CTransform>());
+
+			CTransform* transform = world->getComponent<CTransform>(entity);
+			assert(transform->m_owner == entity);
+			transform->setTranslation(Vec3(position(rng), position(rng), position(rng)));
+
+			if (bLight)
+			{
+				world->getComponent<TestLight>(entity)->m_value = static_cast<int>(i + 1);
+			}
+		}
+	}
+
+	// The flat format the world was saved in before the chunked one.
+	static void saveLegacyWorld(World* world, const char* path)
+	{
+		WriteArchive ar;
+		createWriteArchive(0, &ar);
+
+		size_t numEntities = world->getNumEntities();
+		serialize(&ar, numEntities);
+
+		world->forEachEntity([world, &ar](EntityHandle entity)
+		{
+			Component* components[ECType::CT_Max];
+			size_t numComponents = 0;
+
+			for (size_t type = 0; type < ECType::CT_Max; ++type)
+			{
+				if (Component* component = world->getComponent(entity, static_cast<ECType>(type)))
+				{
+					components[numComponents++] = component;
+				}
+			}
+
+			serialize(&ar, numComponents);
+
+			for (size_t i = 0; i < numComponents; ++i)
+			{
+				ECType type = components[i]->type();
+				ar.serialize(&type, sizeof(ECType));
+			}
+
+			for (size_t i = 0; i < numComponents; ++i)
+			{
+				components[i]->save(&ar);
+			}
+		});
+
+		writeArchiveToDisk(path, ar);
+		destroyArchive(ar);
+	}
+
+	struct FileTestEntity
+	{
+		float m_x, m_y, m_z;
+		int m_light; // -1 without TestLight.
+
+		bool operator<(const FileTestEntity& other) const
+		{
+			if (m_light != other.m_light)
+			{
+				return m_light < other.m_light;
+			}
+
+			if (m_x != other.m_x)
+			{
+				return m_x < other.m_x;
+			}
+
+			return m_y != other.m_y ? m_y < other.m_y : m_z < other.m_z;
+		}
+
+		bool operator==(const FileTestEntity& other) const
+		{
+			return m_x == other.m_x && m_y == other.m_y && m_z == other.m_z && m_light == other.m_light;
+		}
+	};
+
+	// Entities with a CTransform, sorted so worlds can be compared whatever order they were loaded in.
+	static std::vector<FileTestEntity> getFileTestEntities(World* world)
+	{
+		std::vector<FileTestEntity> entities;
+
+		world->forEachEntity([world, &entities](EntityHandle entity)
+		{
+			if (CTransform* transform = world->getComponent<CTransform>(entity))
+			{
+				assert(transform->m_owner == entity);
+				TestLight* light = world->getComponent<TestLight>(entity);
+				const Vec3& t = transform->getTranslation();
+				entities.push_back({ t.x, t.y, t.z, light ? light->m_value : -1 });
+			}
+		});
+
+		std::sort(entities.begin(), entities.end());
+		return entities;
+	}
+
+	static bool isInRegion(const FileTestEntity& entity, const Vec3& min, const Vec3& max)
+	{
+		return entity.m_x >= min.x && entity.m_x <= max.x
+			&& entity.m_y >= min.y && entity.m_y <= max.y
+			&& entity.m_z >= min.z && entity.m_z <= max.z;
+	}
+
+	void worldFileTest()
+	{
+		const char* path = "phoenix_world_file_test.world";
+		const char* legacyPath = "phoenix_world_file_test_legacy.world";
+		const size_t count = 16 * ENTITIES_PER_WORLD_CHUNK + 100;
+
+		World world;
+		world.registerComponentType<CTransform>();
+		world.registerComponentType<TestLight>();
+		createFileTestWorld(&world, count, 7);
+
+		// Entities without components are saved too.
+		world.createEntity();
+		world.createEntity();
+
+		const std::vector<FileTestEntity> expected = getFileTestEntities(&world);
+		saveWorld(&world, path);
+		saveLegacyWorld(&world, legacyPath);
+
+		auto loadWith = [](const WorldLoadOptions& options, const char* from, World* outWorld)
+		{
+			outWorld->registerComponentType<CTransform>();
+			outWorld->registerComponentType<TestLight>();
+			loadWorld(from, outWorld, nullptr, options);
+		};
+
+		WorldLoadOptions options;
+
+		{
+			World loaded;
+			loadWith(options, path, &loaded);
+			assert(loaded.getNumEntities() == world.getNumEntities());
+			assert(getFileTestEntities(&loaded) == expected);
+		}
+
+		{
+			World loaded;
+			loadWith(options, legacyPath, &loaded);
+			assert(loaded.getNumEntities() == world.getNumEntities());
+			assert(getFileTestEntities(&loaded) == expected);
+		}
+
+		{
+			WorkerPool pool(4);
+			options.m_pool = &pool;
+			options.m_parallelTypes = makeComponentMask<CTransform, TestLight>();
+
+			World loaded;
+			loadWith(options, path, &loaded);
+			assert(getFileTestEntities(&loaded) == expected);
+			options = WorldLoadOptions();
+		}
+
+		{
+			// Only the types asked for.
+			options.m_types = makeComponentMask<CTransform>();
+
+			World loaded;
+			loadWith(options, path, &loaded);
+			assert(loaded.getNumEntities() == world.getNumEntities());
+
+			size_t numLights = 0;
+			loaded.forEach<TestLight>([&numLights](EntityHandle, TestLight&) { ++numLights; });
+			assert(numLights == 0);
+
+			std::vector<FileTestEntity> transforms = getFileTestEntities(&loaded);
+			assert(transforms.size() == expected.size());
+			options = WorldLoadOptions();
+		}
+
+		{
+			// Everything in the region, and thanks to the sorting not much else.
+			options.m_bRegion = true;
+			options.m_regionMin = Vec3(20.f, 20.f, 20.f);
+			options.m_regionMax = Vec3(100.f, 100.f, 100.f);
+
+			World loaded;
+			loadWith(options, path, &loaded);
+
+			const std::vector<FileTestEntity> inRegion = getFileTestEntities(&loaded);
+			const auto countInRegion = [&options](const std::vector<FileTestEntity>& entities)
+			{
+				return std::count_if(entities.begin(), entities.end(), [&options](const FileTestEntity& e) { return isInRegion(e, options.m_regionMin, options.m_regionMax); });
+			};
+
+			assert(countInRegion(inRegion) == countInRegion(expected));
+			assert(inRegion.size() < expected.size() / 2);
+			assert(loaded.getNumEntities() == inRegion.size());
+			options = WorldLoadOptions();
+		}
+
+		{
+			// Chunk by chunk in reverse, lights pulled in after the transforms.
+			WorldFile file;
+			const EWorldFileError err = file.open(path);
+			assert(err == EWorldFileError::NoError);
+			assert(file.getHeader().m_numEntities == world.getNumEntities());
+
+			World loaded;
+			loaded.registerComponentType<CTransform>();
+			loaded.registerComponentType<TestLight>();
+
+			std::vector<std::vector<EntityHandle>> chunkEntities(file.getNumEntityChunks());
+
+			for (size_t chunk = file.getNumEntityChunks(); chunk-- > 0;)
+			{
+				const WorldEntityChunk& entityChunk = file.getEntityChunk(chunk);
+				assert(entityChunk.m_numEntities <= ENTITIES_PER_WORLD_CHUNK);
+				assert((file.findColumnChunk(chunk, ECType::CT_Transform) != nullptr) == ((entityChunk.m_mask & makeComponentMask<CTransform>()) != 0));
+
+				file.loadEntityChunk(chunk, makeComponentMask<CTransform>(), &loaded, nullptr, &chunkEntities[chunk]);
+			}
+
+			for (size_t chunk = 0; chunk < file.getNumEntityChunks(); ++chunk)
+			{
+				file.loadComponents(chunk, makeComponentMask<TestLight>(), chunkEntities[chunk].data(), &loaded, nullptr);
+			}
+
+			assert(getFileTestEntities(&loaded) == expected);
+		}
+
+		// Rewrites the file with one change made to it.
+		auto patchFile = [path](const char* patchedPath, size_t offset, const void* data, size_t size)
+		{
+			ReadArchive ar;
+			const EArchiveError err = createReadArchive(path, &ar, EReadMode::Copy);
+			assert(err == EArchiveError::NoError);
+			memcpy(ar.m_data + offset, data, size);
+
+			WriteArchive writeAr;
+			createWriteArchive(0, &writeAr);
+			writeAr.serialize(ar.m_data, ar.m_size);
+			writeArchiveToDisk(patchedPath, writeAr);
+			destroyArchive(writeAr);
+			destroyArchive(ar);
+		};
+
+		const char* patchedPath = "phoenix_world_file_test_patched.world";
+
+		{
+			// Entity chunks with columns outside of the table of contents are refused.
+			WorldFile file;
+			EWorldFileError err = file.open(path);
+			assert(err == EWorldFileError::NoError);
+			const size_t lastChunk = file.getNumEntityChunks() - 1;
+			const size_t chunkOffset = size_t(file.getHeader().m_tocOffset) + lastChunk * sizeof(WorldEntityChunk);
+			WorldEntityChunk chunk = file.getEntityChunk(lastChunk);
+			file.close();
+
+			chunk.m_numColumns += 1;
+			patchFile(patchedPath, chunkOffset, &chunk, sizeof(chunk));
+			err = file.open(patchedPath);
+			assert(err == EWorldFileError::Corrupt);
+
+			chunk.m_numColumns -= 1;
+			chunk.m_firstColumn = 0xffffffff;
+			patchFile(patchedPath, chunkOffset, &chunk, sizeof(chunk));
+			err = file.open(patchedPath);
+			assert(err == EWorldFileError::Corrupt);
+		}
+
+		{
+			// A newer version is refused.
+			const uint32_t version = WORLD_FILE_VERSION + 1;
+			patchFile(patchedPath, offsetof(WorldFileHeader, m_version), &version, sizeof(version));
+
+			WorldFile file;
+			const EWorldFileError err = file.open(patchedPath);
+			assert(err == EWorldFileError::Version);
+		}
+
+		remove(patchedPath);
+
+		remove(path);
+		remove(legacyPath);
+	}
+
+	// Parent of the transform at the local translation, -1 for roots, by the local translations of
+	// all transforms, which are unique in the hierarchy test.
+	static std::vector<std::pair<float, float>> getFileTestParents(World* world)
+	{
+		std::vector<std::pair<float, float>> parents;
+
+		world->forEach<CTransform>([world, &parents](EntityHandle, CTransform& transform)
+		{
+			CTransform* parent = world->handleIsValid(transform.getParent()) ? world->getComponent<CTransform>(transform.getParent()) : nullptr;
+			parents.push_back(std::make_pair(transform.getTranslation().x, parent ? parent->getTranslation().x : -1.f));
+		});
+
+		std::sort(parents.begin(), parents.end());
+		return parents;
+	}
+
+	void worldFileHierarchyTest()
+	{
+		const char* path = "phoenix_world_file_hierarchy_test.world";
+		const size_t numRoots = 3 * ENTITIES_PER_WORLD_CHUNK;
+
+		World world;
+		world.registerComponentType<CTransform>();
+
+		// Roots along the negative x axis and a chain far from it. The child is created before its
+		// parent, and the grandchild only sits far away through the scale of the parent.
+		for (size_t i = 0; i < numRoots; ++i)
+		{
+			const EntityHandle root = world.createEntity(makeComponentMask<CTransform>());
+			world.getComponent<CTransform>(root)->setTranslation(Vec3(-1.f - static_cast<float>(i) * 0.01f, 0.f, 0.f));
+		}
+
+		const EntityHandle child = world.createEntity(makeComponentMask<CTransform>());
+		const EntityHandle parent = world.createEntity(makeComponentMask<CTransform>());
+		const EntityHandle grandchild = world.createEntity(makeComponentMask<CTransform>());
+
+		world.getComponent<CTransform>(parent)->setTranslation(Vec3(1000.f, 0.f, 0.f));
+		world.getComponent<CTransform>(parent)->setScale(Vec3(2.f));
+		world.getComponent<CTransform>(child)->setTranslation(Vec3(10.f, 0.f, 0.f));
+		world.getComponent<CTransform>(child)->setParent(parent);
+		world.getComponent<CTransform>(grandchild)->setTranslation(Vec3(20.f, 5.f, 0.f));
+		world.getComponent<CTransform>(grandchild)->setParent(child);
+
+		// A parent that is gone leaves a root.
+		const EntityHandle orphan = world.createEntity(makeComponentMask<CTransform>());
+		const EntityHandle gone = world.createEntity(makeComponentMask<CTransform>());
+		world.getComponent<CTransform>(orphan)->setTranslation(Vec3(30.f, 0.f, 0.f));
+		world.getComponent<CTransform>(orphan)->setParent(gone);
+		world.destroyEntity(gone);
+
+		const std::vector<std::pair<float, float>> expected = getFileTestParents(&world);
+		assert(std::count(expected.begin(), expected.end(), std::make_pair(10.f, 1000.f)) == 1);
+		assert(std::count(expected.begin(), expected.end(), std::make_pair(20.f, 10.f)) == 1);
+		assert(std::count(expected.begin(), expected.end(), std::make_pair(30.f, -1.f)) == 1);
+
+		saveWorld(&world, path);
+
+		{
+			World loaded;
+			loaded.registerComponentType<CTransform>();
+			loadWorld(path, &loaded, nullptr);
+			assert(getFileTestParents(&loaded) == expected);
+		}
+
+		{
+			WorkerPool pool(4);
+			WorldLoadOptions options;
+			options.m_pool = &pool;
+
+			World loaded;
+			loaded.registerComponentType<CTransform>();
+			loadWorld(path, &loaded, nullptr, options);
+			assert(getFileTestParents(&loaded) == expected);
+		}
+
+		WorldFile file;
+		const EWorldFileError err = file.open(path);
+		assert(err == EWorldFileError::NoError);
+
+		// Bounds cover the world translations, (1060, 10, 0) for the grandchild, not the local ones.
+		const FileTestEntity grandchildWorld = { 1060.f, 10.f, 0.f, -1 };
+		bool bGrandchildInBounds = false;
+
+		for (size_t chunk = 0; chunk < file.getNumEntityChunks(); ++chunk)
+		{
+			const WorldEntityChunk& entityChunk = file.getEntityChunk(chunk);
+			assert(entityChunk.m_boundsMax.x <= 1060.f);
+			bGrandchildInBounds |= isInRegion(grandchildWorld, entityChunk.m_boundsMin, entityChunk.m_boundsMax);
+		}
+
+		assert(bGrandchildInBounds);
+
+		{
+			// Chunks loaded one by one, in reverse, and linked once all of them are there.
+			World loaded;
+			loaded.registerComponentType<CTransform>();
+
+			std::vector<std::vector<EntityHandle>> chunkEntities(file.getNumEntityChunks());
+			std::vector<EntityHandle> fileEntities(static_cast<size_t>(file.getHeader().m_numEntities), World::INVALID_ENTITY);
+
+			for (size_t chunk = file.getNumEntityChunks(); chunk-- > 0;)
+			{
+				file.loadEntityChunk(chunk, ~0u, &loaded, nullptr, &chunkEntities[chunk]);
+				std::copy(chunkEntities[chunk].begin(), chunkEntities[chunk].end(), fileEntities.begin() + file.getFirstEntity(chunk));
+			}
+
+			for (size_t chunk = 0; chunk < file.getNumEntityChunks(); ++chunk)
+			{
+				file.linkParents(chunk, chunkEntities[chunk].data(), fileEntities.data(), &loaded);
+			}
+
+			assert(getFileTestParents(&loaded) == expected);
+		}
+
+		file.close();
+		remove(path);
+	}
+
+	void worldFileBenchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Ms = std::chrono::duration<double, std::milli>;
+
+		const char* path = "phoenix_world_file_benchmark.world";
+		const char* legacyPath = "phoenix_world_file_benchmark_legacy.world";
+		const size_t count = 1000000;
+
+		size_t fileBytes = 0;
+		size_t legacyBytes = 0;
+
+		{
+			World world;
+			world.registerComponentType<CTransform>();
+			world.registerComponentType<TestLight>();
+			createFileTestWorld(&world, count, 11);
+
+			Clock::time_point start = Clock::now();
+			saveWorld(&world, path);
+			const double saveMs = Ms(Clock::now() - start).count();
+
+			start = Clock::now();
+			saveLegacyWorld(&world, legacyPath);
+			const double legacySaveMs = Ms(Clock::now() - start).count();
+
+			ReadArchive ar;
+			createReadArchive(path, &ar);
+			fileBytes = ar.m_size;
+			destroyArchive(ar);
+			createReadArchive(legacyPath, &ar);
+			legacyBytes = ar.m_size;
+			destroyArchive(ar);
+
+			Logger::logf("World file, %u entities: save %.1f ms (%.1f MB), legacy save %.1f ms (%.1f MB)",
+				static_cast<uint32_t>(count), saveMs, fileBytes / 1e6, legacySaveMs, legacyBytes / 1e6);
+		}
+
+		auto timeLoad = [](const char* name, const char* from, const WorldLoadOptions& options)
+		{
+			World world;
+			world.registerComponentType<CTransform>();
+			world.registerComponentType<TestLight>();
+
+			const Clock::time_point start = Clock::now();
+			loadWorld(from, &world, nullptr, options);
+			const double ms = Ms(Clock::now() - start).count();
+
+			Logger::logf("  %-28s %8.1f ms, %u entities", name, ms, static_cast<uint32_t>(world.getNumEntities()));
+		};
+
+		WorldLoadOptions options;
+		timeLoad("legacy flat", legacyPath, options);
+		timeLoad("chunked", path, options);
+
+		options.m_types = makeComponentMask<CTransform>();
+		timeLoad("chunked, transforms only", path, options);
+		options.m_types = WorldLoadOptions().m_types;
+
+		options.m_bRegion = true;
+		options.m_regionMin = Vec3(-100.f, -100.f, -100.f);
+		options.m_regionMax = Vec3(-50.f, -50.f, -50.f);
+		timeLoad("chunked, 1/64 region", path, options);
+		options.m_bRegion = false;
+
+		for (size_t numThreads : { 2u, 4u })
+		{
+			WorkerPool pool(numThreads);
+			options.m_pool = &pool;
+			options.m_parallelTypes = makeComponentMask<CTransform, TestLight>();
+
+			char name[64];
+			snprintf(name, sizeof(name), "chunked, %u threads", static_cast<uint32_t>(numThreads));
+			timeLoad(name, path, options);
+		}
+
+		{
+			// What streaming in one chunk costs.
+			World world;
+			world.registerComponentType<CTransform>();
+			world.registerComponentType<TestLight>();
+
+			const Clock::time_point start = Clock::now();
+			WorldFile file;
+			file.open(path);
+			std::vector<EntityHandle> entities;
+			file.loadEntityChunk(file.getNumEntityChunks() / 2, ~0u, &world, nullptr, &entities);
+			const double ms = Ms(Clock::now() - start).count();
+
+			Logger::logf("  %-28s %8.3f ms, %u entities", "chunked, open + one chunk", ms, static_cast<uint32_t>(entities.size()));
+		}
+
+		remove(path);
+		remove(legacyPath);
+	}
+} }
\ No newline at end of file
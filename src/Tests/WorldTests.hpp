@@ -0,0 +1,46 @@
+#pragma once
+
+namespace Phoenix { namespace Tests
+{
+	void runWorldTests();
+
+	void runWorldFileTests();
+
+	void runWorldBenchmarks();
+
+	void aabbTreeTest();
+
+	void staticMeshRaycastTest();
+
+	void aabbTreeBenchmark();
+
+	void archetypeTest();
+
+	void archetypeIterationBenchmark();
+
+	void entityHandleTest();
+
+	void entityChurnBenchmark();
+
+	void viewTest();
+
+	void viewBenchmark();
+
+	void transformHierarchyTest();
+
+	void transformHierarchyBenchmark();
+
+	void changeVersionTest();
+
+	void changeVersionBenchmark();
+
+	void systemSchedulerTest();
+
+	void systemSchedulerBenchmark();
+
+	void worldFileTest();
+
+	void worldFileHierarchyTest();
+
+	void worldFileBenchmark();
+} }
\ No newline at end of file
@@ -123,12 +123,15 @@ namespace Phoenix
 		drawEntityFilter();
 
 		const bool bCreatedEntity = ImGui::Button("Create Entity");
+		EntityHandle createdEntity = World::INVALID_ENTITY;
+		EntityHandle destroyedEntity = World::INVALID_ENTITY;
+
 		if (bCreatedEntity)
 		{
-			world->createEntity();
+			createdEntity = world->createEntity();
 		}
 
-		for (size_t handle = World::FIRST_VALID_ENTITY; handle <= world->m_lastEntityIdx; ++handle)
+		world->forEachEntity([this, world, &destroyedEntity](EntityHandle handle)
 		{
 			bool bShowEntity = false;
 
@@ -142,22 +145,22 @@ namespace Phoenix
 
 			if (!bShowEntity)
 			{
-				continue;
+				return;
 			}
 
 			bool bSelected = ImGui::MenuItem("Entity");
 
 			ImGui::SameLine();
-			ImGui::Text("%lld", handle);
+			ImGui::Text("%u (generation %u)", entityIndex(handle), entityGeneration(handle));
 
 			char bufCtx[32];
-			sprintf(bufCtx, "Ctx%d", handle);
+			sprintf(bufCtx, "Ctx%u", handle);
 
 			if (ImGui::BeginPopupContextWindow(bufCtx))
 			{
 				if (ImGui::Button("Destroy"))
 				{
-					//world->destroyEntity(m_selectedEntity);
+					destroyedEntity = handle;
 				}
 
 				ImGui::EndPopup();
@@ -166,16 +169,26 @@ namespace Phoenix
 			{
 				m_selectedEntity = handle;
 			}
+		});
+
+		if (destroyedEntity != World::INVALID_ENTITY)
+		{
+			world->destroyEntity(destroyedEntity);
 		}
 
 		if (bCreatedEntity)
 		{
-			m_selectedEntity = world->m_lastEntityIdx;
+			m_selectedEntity = createdEntity;
 		}
 
 		ImGui::End();
 	}
 
+	void Inspector::selectEntity(EntityHandle handle)
+	{
+		m_selectedEntity = handle;
+	}
+
 	void Inspector::applyEditorCommands()
 	{
 		while (m_cmdhead)
@@ -219,14 +232,17 @@ namespace Phoenix
 			return;
 		}
 
-		Entity* entity = world->getEntity(m_selectedEntity);
-
 		ImGui::Begin("Inspector");
-		ImGui::Text("Entity %lld", m_selectedEntity);
+		ImGui::Text("Entity %u (generation %u)", entityIndex(m_selectedEntity), entityGeneration(m_selectedEntity));
 
-		for (auto& kvp : entity->m_components)
+		for (size_t type = 0; type < ECType::CT_Max; ++type)
 		{
-			Component* component = kvp.second;
+			Component* component = world->getComponent(m_selectedEntity, static_cast<ECType>(type));
+
+			if (!component)
+			{
+				continue;
+			}
 
 			ImGui::BeginGroup();
 			ImGui::Text(component->typeName());
@@ -55,6 +55,8 @@ namespace Phoenix
 			, m_selectedEntity(0)
 		{}
 
+		void selectEntity(EntityHandle handle);
+
 		void drawDemoReference();
 		void drawEntityList(World* world);
 		void drawEntityEditor(World* world);
@@ -1,10 +1,18 @@
+#include <algorithm>
 #include <chrono>
 
+#include "Tests/ArchiveTests.hpp"
+#include "Tests/JobTests.hpp"
 #include "Tests/MathTests.hpp"
 #include "Tests/MemoryTests.hpp"
+#include "Tests/RenderTests.hpp"
+#include "Tests/MeshTests.hpp"
+#include "Tests/WorldTests.hpp"
 #include "Render/RIOpenGL/RIOpenGL.hpp"
 
 #include "Core/ObjImport.hpp"
+#include "Core/Mesh.hpp"
+#include "Core/MeshLod.hpp"
 #include "Core/AssetRegistry.hpp"
 
 #include "Core/Logger.hpp"
@@ -18,9 +26,17 @@
 #include "Core/Material.hpp"
 
 #include "Core/World.hpp"
+#include "Core/WorldFile.hpp"
 #include "Core/Component.hpp"
 #include "Core/Components/CTransform.hpp"
 #include "Core/Components/CStaticMesh.hpp"
+#include "Core/Components/CDirectionalLight.hpp"
+#include "Core/Components/CPointLight.hpp"
+#include "Core/Systems/TransformSystem.hpp"
+#include "Core/Systems/StaticMeshSystem.hpp"
+#include "Core/Systems/LightSystem.hpp"
+#include "Core/SystemScheduler.hpp"
+#include "Core/WorkerPool.hpp"
 
 #include "Math/PhiMath.hpp"
 
@@ -94,213 +110,31 @@ namespace Phoenix
 			camera->pitch(dy);
 		}
 	}
-}
 
-namespace Phoenix
-{
-	template <typename C, size_t maxComponents>
-	struct ComponentArray
+	// World space ray through a point of the window, in pixels from the top left.
+	Ray getPickRay(const Matrix4& viewProjection, float x, float y, float width, float height)
 	{
-		ComponentArray() : m_active(0) {}
+		Matrix4 invViewProjection = viewProjection.inverse();
 
-		C m_components[maxComponents];
-		size_t m_active;
+		float ndcX = 2.f * x / width - 1.f;
+		float ndcY = 1.f - 2.f * y / height;
 
-		C* alloc()
-		{
-			assert(m_active < maxComponents);
-			if (m_active >= maxComponents)
-			{
-				return nullptr;
-			}
+		Vec4 nearPoint = invViewProjection * Vec4(ndcX, ndcY, -1.f, 1.f);
+		Vec4 farPoint = invViewProjection * Vec4(ndcX, ndcY, 1.f, 1.f);
 
-			return &m_components[m_active++];
-		}
+		Vec3 origin = Vec3(nearPoint) / nearPoint.w;
+		Vec3 target = Vec3(farPoint) / farPoint.w;
 
-		C& operator[](size_t index)
-		{
-			return m_components[index];
-		}
-	};
-
-	class TransformSystem
-	{
-	public:
-		TransformSystem();
-
-		void updateTransforms();
-
-		Component* allocComponent();
-
-	private:
-		enum { MAX_COMPONENTS = 1024 };
-
-		ComponentArray<CTransform, MAX_COMPONENTS> m_components;
-		Matrix4 m_transforms[MAX_COMPONENTS];
-	};
-
-	TransformSystem::TransformSystem()
-	{
-		for (size_t i = 0; i < MAX_COMPONENTS; ++i)
-		{
-			m_components[i].m_transform = &m_transforms[i];
-		}
-	}
-
-	Component* TransformSystem::allocComponent()
-	{
-		return m_components.alloc();
-	}
-
-	void TransformSystem::updateTransforms()
-	{
-		const size_t active = m_components.m_active;
-		
-		for (size_t i = 0; i < active; ++i)
-		{
-			CTransform& c = m_components[i];
-
-			if (c.m_bDirty)
-			{
-				m_transforms[i] = Matrix4::translation(c.getTranslation())
-								* Matrix4::rotation(c.getRotation())
-								* Matrix4::scale(c.getScale());
-
-				c.m_bDirty = false;
-			}
-		}
+		return Ray(origin, target - origin);
 	}
 
-	class StaticMeshSystem
+	void objImportToWorld(const char* objPath, World* outworld, LoadResources* resources, EVertexFormat vertexFormat)
 	{
-	public:
-		Component* allocComponent();
-		void renderMeshes(World* world, DeferredRenderer* renderer);
-
-	private:
-		enum { MAX_COMPONENTS = 1024 };
-		ComponentArray<CStaticMesh, MAX_COMPONENTS> m_components;
-	};
-
-	Component* StaticMeshSystem::allocComponent()
-	{
-		return m_components.alloc();
-	}
-	
-	void StaticMeshSystem::renderMeshes(World* world, DeferredRenderer* renderer)
-	{
-		const size_t active = m_components.m_active;
-		
-		for (size_t i = 0; i < active; ++i)
-		{
-			CStaticMesh& sm = m_components[i];
-			CTransform* tf = world->getComponent<CTransform>(sm.m_owner);
-
-			renderer->drawStaticMesh(*sm.m_mesh, *tf->m_transform);
-		}
-	}
-
-	class CDirectionalLight : public Component
-	{
-	public:
-		Vec3 m_direction;
-		Vec3 m_color;
-
-		virtual void save(Archive* ar) override
-		{
-			serialize(ar, m_direction);
-			serialize(ar, m_color);
-		}
-
-		virtual void load(Archive* ar, LoadResources* resources) override
-		{
-			serialize(ar, m_direction);
-			serialize(ar, m_color);
-		}
-
-		IMPL_EC_TYPE_ID(ECType::CT_DirectionalLight, "DirectionalLight")
-	};
-
-	class CPointLight : public Component
-	{
-	public:
-		Vec3 m_color;
-		float m_radius;
-		float m_intensity;
-
-		virtual void save(Archive* ar) override
-		{
-			serialize(ar, m_color);
-			serialize(ar, m_radius);
-			serialize(ar, m_intensity);
-		}
-
-		virtual void load(Archive* ar, LoadResources* resources) override
-		{
-			serialize(ar, m_color);
-			serialize(ar, m_radius);
-			serialize(ar, m_intensity);
-		}
-
-		IMPL_EC_TYPE_ID(ECType::CT_PointLight, "PointLight")
-	};
-
-	class LightSystem
-	{
-	public:
-
-		Component* allocDirLight();	
-		Component* allocPointLight();
-
-		void renderLights(World* world, DeferredRenderer* renderer, const Matrix4& viewTf);
-
-	private:
-		enum { MAX_COMPONENTS = 256 };
-
-		ComponentArray<CDirectionalLight, MAX_COMPONENTS> m_dirLights;
-		ComponentArray<CPointLight, MAX_COMPONENTS> m_pointLights;
-		LightBuffer m_lightBuffer;
-	};
-
-	Component* LightSystem::allocDirLight()
-	{
-		return m_dirLights.alloc();
-	}
-	
-	Component* LightSystem::allocPointLight()
-	{
-		return m_pointLights.alloc();
-	}
-
-	void LightSystem::renderLights(World* world, DeferredRenderer* renderer, const Matrix4& viewTf)
-	{
-		renderer->setupDirectLightingPass();
-		m_lightBuffer.clear();
-
-		for (size_t i = 0; i < m_dirLights.m_active; ++i)
-		{
-			CDirectionalLight& dl = m_dirLights[i];
-			m_lightBuffer.addDirectional(viewTf * dl.m_direction, dl.m_color);
-		}
-
-		for (size_t i = 0; i < m_pointLights.m_active; ++i)
-		{
-			CPointLight& pl = m_pointLights[i];
-			CTransform* tf = world->getComponent<CTransform>(pl.m_owner);
-
-			Vec4 eyePos(tf->getTranslation(), 1.0);
-			eyePos *= viewTf;
-
-			m_lightBuffer.addPointLight(eyePos, pl.m_radius, pl.m_color, pl.m_intensity);
-		}
-
-		renderer->runLightsPass(m_lightBuffer);
-	}
-
-
-	void objImportToWorld(const char* objPath, World* outworld, LoadResources* resources)
-	{
-		std::vector<StaticMesh*> import = importObj(objPath, resources->device, resources->context, resources->assets);
+		// Imported assets are written once and loaded on every start, so they get the strong compression.
+		const ECompression compression = getDefaultCompression();
+		setDefaultCompression(ECompression::Strong);
+		std::vector<StaticMesh*> import = importObj(objPath, resources->device, resources->context, resources->assets, vertexFormat);
+		setDefaultCompression(compression);
 
 		for (StaticMesh* mesh : import)
 		{
@@ -314,7 +148,7 @@ namespace Phoenix
 	}
 }
 
-void run()
+void run(bool bRunBenchmarks, bool bRunFullTests)
 {
 	using namespace Phoenix;
 
@@ -323,7 +157,33 @@ void run()
 
 	Tests::runMathTests();
 	Tests::runMemoryTests();
+	Tests::runJobTests();
 	Tests::runSerializeTests();
+	Tests::runArchiveTests();
+	Tests::runRenderTests();
+	Tests::runMeshTests();
+	Tests::runWorldTests();
+
+	// Stress tests take a while and the file tests write to the working directory.
+	if (bRunFullTests)
+	{
+		Tests::runMemoryStressTests();
+		Tests::runJobStressTests();
+		Tests::runArchiveFileTests();
+		Tests::runMeshFileTests();
+		Tests::runWorldFileTests();
+	}
+
+	if (bRunBenchmarks)
+	{
+		Tests::runMathBenchmarks();
+		Tests::runMemoryBenchmarks();
+		Tests::runJobBenchmarks();
+		Tests::runArchiveBenchmarks();
+		Tests::runRenderBenchmarks();
+		Tests::runMeshBenchmarks();
+		Tests::runWorldBenchmarks();
+	}
 
 	bool bRIstarted = RI::init();
 
@@ -366,6 +226,10 @@ void run()
 
 	AssetRegistry assets;
 
+	// Blocks of compressed assets decompress on all cores.
+	WorkerPool workerPool;
+	setDecompressionPool(&workerPool);
+
 	loadAssetRegistry(&assets, "phoenix.assets", renderDevice, renderContext);
 
 	importTexture(g_defaultWhiteTexPath, nullptr, renderDevice, renderContext, &assets);
@@ -389,45 +253,52 @@ void run()
 	LightBuffer lightBuffer;
 
 	TransformSystem tfSystem;
-	StaticMeshSystem smSystem;
+	StaticMeshSystem smSystem(&workerPool);
 	LightSystem lightSystem;
 
 	World newWorld;
 
-	auto transformFactory = [system = &tfSystem]() -> Component*
-	{
-		return system->allocComponent();
-	};
-	newWorld.addComponentFactory(CTransform::staticType(), transformFactory);
-
-	auto smFactory = [system = &smSystem]() -> Component*
-	{
-		return system->allocComponent();
-	};
-	newWorld.addComponentFactory(CStaticMesh::staticType(), smFactory);
-
-	auto dlFactory = [system = &lightSystem]() -> Component*
-	{
-		return system->allocDirLight();
-	};
-	newWorld.addComponentFactory(CDirectionalLight::staticType(), dlFactory);
-
-	auto plFactory = [system = &lightSystem]() -> Component*
-	{
-		return system->allocPointLight();
-	};
-	newWorld.addComponentFactory(CPointLight::staticType(), plFactory);
+	newWorld.registerComponentType<CTransform>();
+	newWorld.registerComponentType<CStaticMesh>();
+	newWorld.registerComponentType<CDirectionalLight>();
+	newWorld.registerComponentType<CPointLight>();
 
  	loadWorld(newWorldPath, &newWorld, &resources);
 					  
-	//objImportToWorld("Models/sponza/sponza.obj", &newWorld, &resources);
+	//objImportToWorld("Models/sponza/sponza.obj", &newWorld, &resources, EVertexFormat::Packed);
 	//EntityHandle dirLightEntity = newWorld.createEntity();
 	//CDirectionalLight* light = newWorld.addComponent<CDirectionalLight>(dirLightEntity);
 	//light->m_color = Vec3(0.3f, 0.3f, 0.3f);
 	//light->m_direction = Vec3(-0.5f, -0.5f, 0.f);
 
+	// Lights are gathered next to the mesh bounds once the transforms are updated, clearing the
+	// dirty flags waits for both.
+	SystemScheduler scheduler(&newWorld, &workerPool);
+
+	scheduler.addSystem("Transforms", 0, makeComponentMask<CTransform>(), [&tfSystem](World* world, WorkerPool*)
+	{
+		tfSystem.updateTransforms(world);
+	});
+
+	scheduler.addSystem("Static mesh bounds", makeComponentMask<CTransform>(), makeComponentMask<CStaticMesh>(), [&smSystem](World* world, WorkerPool*)
+	{
+		smSystem.updateBounds(world);
+	});
+
+	scheduler.addSystem("Lights", makeComponentMask<CTransform, CDirectionalLight, CPointLight>(), 0, [&lightSystem, &viewTf](World* world, WorkerPool*)
+	{
+		lightSystem.gatherLights(world, viewTf);
+	});
+
+	scheduler.addSystem("Clear dirty transforms", 0, makeComponentMask<CTransform>(), [&tfSystem](World* world, WorkerPool* pool)
+	{
+		tfSystem.clearDirtyFlags(world, pool);
+	});
+
 	const size_t editorCmdMemoryBytes = 2048;
 	Inspector inspector(editorCmdMemoryBytes);
+
+	bool bPickWasPressed = false;
 	
 	while (!gameWindow->wantsToClose())
 	{
@@ -455,18 +326,60 @@ void run()
 		moveCamera(&camera, gameWindow->m_keyStates, dt);
 		lookCamera(&camera, gameWindow->m_mouseState, dt);
 
-		tfSystem.updateTransforms();
-
-		Matrix4 viewTf = camera.getUpdatedViewMatrix();
+		viewTf = camera.getUpdatedViewMatrix();
 		renderer.setViewMatrix(viewTf);
+
+		scheduler.run();
+
+		// Changes made from here on are seen by the systems next frame.
+		newWorld.advanceChangeVersion();
+
+		// Right click selects the entity under the cursor in the inspector.
+		const MouseState& mouseState = gameWindow->m_mouseState;
+		bool bPickPressed = mouseState.m_buttonStates[MouseButton::Right] == Input::Press;
+
+		if (bPickPressed && !bPickWasPressed)
+		{
+			Ray pickRay = getPickRay(projTf * viewTf, mouseState.m_x, mouseState.m_y, (float)config.width, (float)config.height);
+			EntityHandle picked = smSystem.pickEntity(&newWorld, pickRay);
+
+			if (picked != World::INVALID_ENTITY)
+			{
+				inspector.selectEntity(picked);
+			}
+		}
+
+		bPickWasPressed = bPickPressed;
 		renderer.setupGBufferPass();
 
 		smSystem.renderMeshes(&newWorld, &renderer);
-		lightSystem.renderLights(&newWorld, &renderer, viewTf);
+		renderer.runGBufferPass();
+		lightSystem.renderLights(&renderer);
 	
 		renderer.copyFinalColorToBackBuffer();
 
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+		ImGui::Text("Transforms: %zu of %zu updated", tfSystem.getStats().m_numUpdated, tfSystem.getStats().m_numNodes);
+
+		const SchedulerStats& schedulerStats = scheduler.getStats();
+		ImGui::Text("Systems: %.2f ms on %zu threads, %.0f%% utilisation", schedulerStats.m_frameMs, schedulerStats.m_numThreads, 100.0 * schedulerStats.m_utilisation);
+
+		for (const SystemTiming& timing : scheduler.getTimings())
+		{
+			ImGui::Text("  %s: %.2f ms at %.2f ms on thread %zu", timing.m_name, timing.m_durationMs, timing.m_startMs, timing.m_thread);
+		}
+
+		ImGui::Text("Static meshes: %zu visible, %zu culled", smSystem.getCullStats().m_numVisible, smSystem.getCullStats().m_numCulled);
+
+		const OcclusionCullStats& occlusionStats = smSystem.getOcclusionStats();
+		ImGui::Text("Occlusion: %zu of %zu occluded by %zu meshes (%zu triangles), raster %.2f ms, test %.2f ms",
+			occlusionStats.m_numOccluded, occlusionStats.m_numTested, occlusionStats.m_numOccluders, 
+			occlusionStats.m_numOccluderTriangles, occlusionStats.m_rasterMs, occlusionStats.m_testMs);
+
+		const ClusteredLightStats& clusterStats = renderer.getLightClusterStats();
+		ImGui::Text("Light clusters: %zu point lights, %zu clusters used, %.1f avg / %u max lights, %zu indices, build %.2f ms",
+			clusterStats.m_numLights, clusterStats.m_numOccupiedClusters, clusterStats.m_avgLightsPerOccupiedCluster,
+			clusterStats.m_maxLightsPerCluster, clusterStats.m_numIndices, clusterStats.m_buildMs);
 
 		inspector.drawEntityList(&newWorld);
 		inspector.drawEntityEditor(&newWorld);
@@ -479,6 +392,7 @@ void run()
 	}
 
 	saveWorld(&newWorld, newWorldPath);
+	setDecompressionPool(nullptr);
 
 	exitImGui();
 	RI::destroyWindow(gameWindow);
@@ -488,11 +402,10 @@ void run()
 
 int main(int argc, char** argv)
 {
-#define UNUSED(x) (void)x
-	UNUSED(argc);
-	UNUSED(argv);
+	bool bRunBenchmarks = Phoenix::Platform::hasCMDFlag(argv, argv + argc, "-benchmark");
+	bool bRunFullTests = Phoenix::Platform::hasCMDFlag(argv, argv + argc, "-fulltests");
 
-	run();
+	run(bRunBenchmarks, bRunFullTests);
 
 	return 0;
-}
+}
\ No newline at end of file